@@ -28,11 +28,16 @@
  * The #GtkSourceCompletionWords is an example of an implementation of
  * the #GtkSourceCompletionProvider interface. The proposals are words
  * appearing in the registered #GtkTextBuffer<!-- -->s.
+ *
+ * The proposals begin with the first character of the word being completed,
+ * and the other characters are fuzzy matched, see
+ * gtk_source_completion_matcher_fuzzy_match().
  */
 
 #include "gtksourcecompletionwords.h"
 #include "gtksourcecompletionwordslibrary.h"
 #include "gtksourcecompletionwordsbuffer.h"
+#include "gtksourcecompletionwordsindex.h"
 #include "gtksourcecompletionwordsutils.h"
 #include "gtksourceview/gtksource.h"
 #include "gtksourceview/gtksourceview-typebuiltins.h"
@@ -42,6 +47,11 @@
 
 #define BUFFER_KEY "GtkSourceCompletionWordsBufferKey"
 
+/* The minimum word size of the words indexes, the smallest allowed value of
+ * the minimum-word-size property.
+ */
+#define INDEX_MINIMUM_WORD_SIZE 2
+
 enum
 {
 	PROP_0,
@@ -49,6 +59,7 @@ enum
 	PROP_NAME,
 	PROP_ICON,
 	PROP_PROPOSALS_BATCH_SIZE,
+	PROP_MAXIMUM_PROPOSALS,
 	PROP_SCAN_BATCH_SIZE,
 	PROP_MINIMUM_WORD_SIZE,
 	PROP_INTERACTIVE_DELAY,
@@ -62,21 +73,52 @@ struct _GtkSourceCompletionWordsPrivate
 	GdkPixbuf *icon;
 
 	gchar *word;
-	gint word_len;
 	guint idle_id;
 
+	/* The length in bytes of the first character of the word. Only the
+	 * words beginning with it are fuzzy matched.
+	 */
+	gint prefix_len;
+
+	/* Buffer for the library word being matched. */
+	GString *candidate;
+
 	GtkSourceCompletionContext *context;
-	GSequenceIter *populate_iter;
+	GtkSourceCompletionWordsLibraryIter *populate_iter;
+
+	/* The indexes are searched after the library. populate_indexes is a
+	 * copy of the indexes list, populate_index_item is the index being
+	 * searched, between the positions populate_index_pos and
+	 * populate_index_end.
+	 */
+	GList *populate_indexes;
+	GList *populate_index_item;
+	guint populate_index_pos;
+	guint populate_index_end;
+
+	/* The best words found so far by the population, in a binary heap with
+	 * the worst one at the top. Only the best maximum_proposals words are
+	 * kept, the proposals are created at the end.
+	 */
+	GArray *ranked_words;
+	guint nb_matches;
 
 	guint cancel_id;
 
+	/* Whether the last population had to drop some words. */
+	guint truncated : 1;
+
 	guint proposals_batch_size;
+	guint maximum_proposals;
 	guint scan_batch_size;
 	guint minimum_word_size;
 
 	GtkSourceCompletionWordsLibrary *library;
 	GList *buffers;
 
+	/* GtkSourceCompletionWordsIndex objects. */
+	GList *indexes;
+
 	gint interactive_delay;
 	gint priority;
 	GtkSourceCompletionActivation activation;
@@ -88,6 +130,21 @@ typedef struct
 	GtkSourceCompletionWordsBuffer *buffer;
 } BufferBinding;
 
+/* A word of the library (@iter is set) or of an index. */
+typedef struct
+{
+	GtkSourceCompletionWordsLibraryIter *iter;
+	GtkSourceCompletionWordsIndex *index;
+	guint index_pos;
+
+	guint score;
+
+	/* Position in the order of the matches (alphabetical for each source),
+	 * for the words with the same score.
+	 */
+	guint order;
+} RankedWord;
+
 static void gtk_source_completion_words_iface_init (GtkSourceCompletionProviderIface *iface);
 
 G_DEFINE_TYPE_WITH_CODE (GtkSourceCompletionWords,
@@ -97,6 +154,17 @@ G_DEFINE_TYPE_WITH_CODE (GtkSourceCompletionWords,
 			 G_IMPLEMENT_INTERFACE (GTK_SOURCE_TYPE_COMPLETION_PROVIDER,
 				 		gtk_source_completion_words_iface_init))
 
+/* Like the completion core when it refilters the proposals, an exact match is
+ * not kept: activating it would not change the text.
+ */
+static gboolean
+word_matches (GtkSourceCompletionWords *words,
+	      const gchar              *candidate)
+{
+	return (strcmp (candidate, words->priv->word) != 0 &&
+		gtk_source_completion_matcher_fuzzy_match (words->priv->word, candidate, NULL));
+}
+
 static gchar *
 gtk_source_completion_words_get_name (GtkSourceCompletionProvider *self)
 {
@@ -112,12 +180,24 @@ gtk_source_completion_words_get_icon (GtkSourceCompletionProvider *self)
 static void
 population_finished (GtkSourceCompletionWords *words)
 {
+	/* The library is locked while the population continues in an idle. */
 	if (words->priv->idle_id != 0)
 	{
 		g_source_remove (words->priv->idle_id);
 		words->priv->idle_id = 0;
+
+		gtk_source_completion_words_library_unlock (words->priv->library);
 	}
 
+	/* The iters are invalid once the library is unlocked. */
+	words->priv->populate_iter = NULL;
+
+	g_list_free_full (words->priv->populate_indexes, g_object_unref);
+	words->priv->populate_indexes = NULL;
+	words->priv->populate_index_item = NULL;
+	g_array_set_size (words->priv->ranked_words, 0);
+	words->priv->nb_matches = 0;
+
 	g_free (words->priv->word);
 	words->priv->word = NULL;
 
@@ -135,57 +215,324 @@ population_finished (GtkSourceCompletionWords *words)
 }
 
 static gboolean
-add_in_idle (GtkSourceCompletionWords *words)
+ranked_word_is_worse (const RankedWord *word,
+		      const RankedWord *other)
 {
-	guint idx = 0;
+	if (word->score != other->score)
+	{
+		return word->score < other->score;
+	}
+
+	return word->order > other->order;
+}
+
+static gint
+compare_ranked_words (const RankedWord *word,
+		      const RankedWord *other)
+{
+	if (ranked_word_is_worse (word, other))
+	{
+		return 1;
+	}
+
+	return ranked_word_is_worse (other, word) ? -1 : 0;
+}
+
+static void
+swap_ranked_words (GArray *heap,
+		   guint   pos1,
+		   guint   pos2)
+{
+	RankedWord tmp = g_array_index (heap, RankedWord, pos1);
+
+	g_array_index (heap, RankedWord, pos1) = g_array_index (heap, RankedWord, pos2);
+	g_array_index (heap, RankedWord, pos2) = tmp;
+}
+
+static void
+heap_sift_up (GArray *heap,
+	      guint   pos)
+{
+	while (pos > 0)
+	{
+		guint parent = (pos - 1) / 2;
+
+		if (!ranked_word_is_worse (&g_array_index (heap, RankedWord, pos),
+					   &g_array_index (heap, RankedWord, parent)))
+		{
+			break;
+		}
+
+		swap_ranked_words (heap, pos, parent);
+		pos = parent;
+	}
+}
+
+static void
+heap_sift_down (GArray *heap,
+		guint   pos)
+{
+	while (TRUE)
+	{
+		guint worst = pos;
+		guint child;
+
+		for (child = 2 * pos + 1; child <= 2 * pos + 2 && child < heap->len; child++)
+		{
+			if (ranked_word_is_worse (&g_array_index (heap, RankedWord, child),
+						  &g_array_index (heap, RankedWord, worst)))
+			{
+				worst = child;
+			}
+		}
+
+		if (worst == pos)
+		{
+			break;
+		}
+
+		swap_ranked_words (heap, pos, worst);
+		pos = worst;
+	}
+}
+
+/* Keeps the maximum_proposals best words. */
+static void
+add_ranked_word (GtkSourceCompletionWords *words,
+		 RankedWord               *word)
+{
+	GArray *heap = words->priv->ranked_words;
+
+	word->order = words->priv->nb_matches++;
+
+	if (heap->len < words->priv->maximum_proposals)
+	{
+		g_array_append_val (heap, *word);
+		heap_sift_up (heap, heap->len - 1);
+	}
+	else if (ranked_word_is_worse (&g_array_index (heap, RankedWord, 0), word))
+	{
+		g_array_index (heap, RankedWord, 0) = *word;
+		heap_sift_down (heap, 0);
+	}
+}
+
+/* Returns the number of occurrences of @word in @index, 0 if @word is not in
+ * @index.
+ */
+static guint
+get_index_count (GtkSourceCompletionWordsIndex *index,
+		 const gchar                   *word)
+{
+	guint end;
+	guint pos = gtk_source_completion_words_index_find_prefix (index, word, -1, &end);
+
+	/* The word itself comes first among the words beginning with it. */
+	if (pos < end &&
+	    strcmp (gtk_source_completion_words_index_get_word (index, pos), word) == 0)
+	{
+		return gtk_source_completion_words_index_get_count (index, pos);
+	}
+
+	return 0;
+}
+
+/* Returns the number of occurrences of @word in the indexes of the population
+ * from @item to the last one.
+ */
+static guint
+get_indexes_count (GList       *item,
+		   const gchar *word)
+{
+	guint count = 0;
+
+	for (; item != NULL; item = item->next)
+	{
+		count += get_index_count (item->data, word);
+	}
+
+	return count;
+}
+
+/* The occurrences of the word in the indexes are added to its score. */
+static void
+add_library_word (GtkSourceCompletionWords            *words,
+		  GtkSourceCompletionWordsLibraryIter *iter,
+		  const gchar                         *library_word)
+{
+	RankedWord word = { NULL };
+
+	word.iter = iter;
+	word.score = gtk_source_completion_words_library_get_score (words->priv->library, iter);
+	word.score += get_indexes_count (words->priv->populate_indexes, library_word);
+
+	add_ranked_word (words, &word);
+}
+
+/* A word is ranked once, with its occurrences in all the sources. So the words
+ * already found in the library or in a previous index are skipped, their
+ * occurrences in this index are already counted.
+ */
+static void
+add_index_word (GtkSourceCompletionWords      *words,
+		GtkSourceCompletionWordsIndex *index,
+		guint                          pos)
+{
+	const gchar *index_word = gtk_source_completion_words_index_get_word (index, pos);
+	RankedWord word = { NULL };
+	GList *l;
+
+	/* The index is built with a smaller minimum word size. */
+	if (g_utf8_strlen (index_word, -1) < words->priv->minimum_word_size)
+	{
+		return;
+	}
+
+	if (gtk_source_completion_words_library_find (words->priv->library, index_word) != NULL)
+	{
+		return;
+	}
+
+	for (l = words->priv->populate_indexes; l != words->priv->populate_index_item; l = l->next)
+	{
+		if (get_index_count (l->data, index_word) > 0)
+		{
+			return;
+		}
+	}
+
+	word.index = index;
+	word.index_pos = pos;
+	word.score = gtk_source_completion_words_index_get_count (index, pos);
+	word.score += get_indexes_count (words->priv->populate_index_item->next, index_word);
+
+	add_ranked_word (words, &word);
+}
+
+/* Goes to the next index with some matching words, from @item. */
+static void
+set_populate_index_item (GtkSourceCompletionWords *words,
+			 GList                    *item)
+{
+	while (item != NULL)
+	{
+		words->priv->populate_index_pos =
+			gtk_source_completion_words_index_find_prefix (item->data,
+								       words->priv->word,
+								       words->priv->prefix_len,
+								       &words->priv->populate_index_end);
+
+		if (words->priv->populate_index_pos < words->priv->populate_index_end)
+		{
+			break;
+		}
+
+		item = item->next;
+	}
+
+	words->priv->populate_index_item = item;
+}
+
+/* Returns the proposals of the best words, the best first. */
+static GList *
+get_ranked_proposals (GtkSourceCompletionWords *words)
+{
+	GArray *ranked_words = words->priv->ranked_words;
 	GList *ret = NULL;
-	gboolean finished;
+	gint i;
 
-	if (words->priv->populate_iter == NULL)
+	g_array_sort (ranked_words, (GCompareFunc)compare_ranked_words);
+
+	for (i = ranked_words->len - 1; i >= 0; i--)
 	{
-		words->priv->populate_iter =
-			gtk_source_completion_words_library_find_first (words->priv->library,
-			                                                words->priv->word,
-			                                                words->priv->word_len);
+		RankedWord *word = &g_array_index (ranked_words, RankedWord, i);
+		GtkSourceCompletionWordsProposal *proposal;
+
+		if (word->iter != NULL)
+		{
+			proposal = gtk_source_completion_words_library_get_proposal (word->iter);
+		}
+		else
+		{
+			const gchar *index_word = gtk_source_completion_words_index_get_word (word->index,
+											      word->index_pos);
+
+			proposal = gtk_source_completion_words_proposal_new (index_word);
+		}
+
+		ret = g_list_prepend (ret, proposal);
 	}
 
+	return ret;
+}
+
+static gboolean
+add_in_idle (GtkSourceCompletionWords *words)
+{
+	guint idx = 0;
+	GList *ret;
+
 	while (idx < words->priv->proposals_batch_size &&
 	       words->priv->populate_iter)
 	{
-		GtkSourceCompletionWordsProposal *proposal =
-				gtk_source_completion_words_library_get_proposal (words->priv->populate_iter);
+		gtk_source_completion_words_library_get_word (words->priv->populate_iter,
+		                                              words->priv->candidate);
 
-		/* Only add non-exact matches */
-		if (strcmp (gtk_source_completion_words_proposal_get_word (proposal),
-		            words->priv->word) != 0)
+		if (word_matches (words, words->priv->candidate->str))
 		{
-			ret = g_list_prepend (ret, proposal);
+			add_library_word (words,
+					  words->priv->populate_iter,
+					  words->priv->candidate->str);
 		}
 
 		words->priv->populate_iter =
 				gtk_source_completion_words_library_find_next (words->priv->populate_iter,
 		                                                               words->priv->word,
-		                                                               words->priv->word_len);
+		                                                               words->priv->prefix_len);
 		++idx;
 	}
 
-	ret = g_list_reverse (ret);
-	finished = words->priv->populate_iter == NULL;
+	while (idx < words->priv->proposals_batch_size &&
+	       words->priv->populate_index_item != NULL)
+	{
+		GtkSourceCompletionWordsIndex *index = words->priv->populate_index_item->data;
+		guint pos = words->priv->populate_index_pos;
+
+		if (word_matches (words, gtk_source_completion_words_index_get_word (index, pos)))
+		{
+			add_index_word (words, index, pos);
+		}
+
+		if (++words->priv->populate_index_pos == words->priv->populate_index_end)
+		{
+			set_populate_index_item (words, words->priv->populate_index_item->next);
+		}
+
+		++idx;
+	}
+
+	if (words->priv->populate_iter != NULL ||
+	    words->priv->populate_index_item != NULL)
+	{
+		return G_SOURCE_CONTINUE;
+	}
+
+	/* All the matching words have been ranked. The proposal objects are
+	 * created only for the best ones.
+	 */
+	ret = get_ranked_proposals (words);
+	words->priv->truncated = words->priv->nb_matches > words->priv->ranked_words->len;
 
 	gtk_source_completion_context_add_proposals (words->priv->context,
 	                                             GTK_SOURCE_COMPLETION_PROVIDER (words),
 	                                             ret,
-	                                             finished);
+	                                             TRUE);
 
-	g_list_free (ret);
+	g_list_free_full (ret, g_object_unref);
 
-	if (finished)
-	{
-		gtk_source_completion_words_library_unlock (words->priv->library);
-		population_finished (words);
-	}
+	population_finished (words);
 
-	return !finished;
+	return G_SOURCE_REMOVE;
 }
 
 static gchar *
@@ -216,12 +563,15 @@ gtk_source_completion_words_populate (GtkSourceCompletionProvider *provider,
 	GtkSourceCompletionActivation activation;
 	GtkTextIter iter;
 	gchar *word;
+	GList *l;
 
 	gtk_source_completion_context_get_iter (context, &iter);
 
 	g_free (words->priv->word);
 	words->priv->word = NULL;
 
+	words->priv->truncated = FALSE;
+
 	word = get_word_at_iter (&iter);
 
 	activation = gtk_source_completion_context_get_activation (context);
@@ -247,7 +597,26 @@ gtk_source_completion_words_populate (GtkSourceCompletionProvider *provider,
 	words->priv->context = g_object_ref (context);
 
 	words->priv->word = word;
-	words->priv->word_len = strlen (word);
+	words->priv->prefix_len = g_utf8_next_char (word) - word;
+
+	words->priv->populate_iter =
+		gtk_source_completion_words_library_find_first (words->priv->library,
+		                                                words->priv->word,
+		                                                words->priv->prefix_len);
+
+	/* Map the new version of the indexes which have been updated. On error
+	 * the previous version is kept.
+	 */
+	for (l = words->priv->indexes; l != NULL; l = l->next)
+	{
+		gtk_source_completion_words_index_load (l->data, NULL);
+	}
+
+	words->priv->populate_indexes = g_list_copy_deep (words->priv->indexes,
+							  (GCopyFunc)g_object_ref,
+							  NULL);
+
+	set_populate_index_item (words, words->priv->populate_indexes);
 
 	/* Do first right now */
 	if (add_in_idle (words))
@@ -279,9 +648,23 @@ gtk_source_completion_words_dispose (GObject *object)
 	g_clear_object (&provider->priv->icon);
 	g_clear_object (&provider->priv->library);
 
+	g_list_free_full (provider->priv->indexes, g_object_unref);
+	provider->priv->indexes = NULL;
+
 	G_OBJECT_CLASS (gtk_source_completion_words_parent_class)->dispose (object);
 }
 
+static void
+gtk_source_completion_words_finalize (GObject *object)
+{
+	GtkSourceCompletionWords *provider = GTK_SOURCE_COMPLETION_WORDS (object);
+
+	g_array_free (provider->priv->ranked_words, TRUE);
+	g_string_free (provider->priv->candidate, TRUE);
+
+	G_OBJECT_CLASS (gtk_source_completion_words_parent_class)->finalize (object);
+}
+
 static void
 update_buffers_batch_size (GtkSourceCompletionWords *words)
 {
@@ -337,6 +720,10 @@ gtk_source_completion_words_set_property (GObject      *object,
 			self->priv->proposals_batch_size = g_value_get_uint (value);
 			break;
 
+		case PROP_MAXIMUM_PROPOSALS:
+			self->priv->maximum_proposals = g_value_get_uint (value);
+			break;
+
 		case PROP_SCAN_BATCH_SIZE:
 			self->priv->scan_batch_size = g_value_get_uint (value);
 			update_buffers_batch_size (self);
@@ -387,6 +774,10 @@ gtk_source_completion_words_get_property (GObject    *object,
 			g_value_set_uint (value, self->priv->proposals_batch_size);
 			break;
 
+		case PROP_MAXIMUM_PROPOSALS:
+			g_value_set_uint (value, self->priv->maximum_proposals);
+			break;
+
 		case PROP_SCAN_BATCH_SIZE:
 			g_value_set_uint (value, self->priv->scan_batch_size);
 			break;
@@ -419,6 +810,7 @@ gtk_source_completion_words_class_init (GtkSourceCompletionWordsClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
 	object_class->dispose = gtk_source_completion_words_dispose;
+	object_class->finalize = gtk_source_completion_words_finalize;
 
 	object_class->set_property = gtk_source_completion_words_set_property;
 	object_class->get_property = gtk_source_completion_words_get_property;
@@ -449,6 +841,25 @@ gtk_source_completion_words_class_init (GtkSourceCompletionWordsClass *klass)
 	                                                    300,
 	                                                    G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
 
+	/**
+	 * GtkSourceCompletionWords:maximum-proposals:
+	 *
+	 * The maximum number of proposals. The words are ranked by their
+	 * number of occurrences in the registered buffers, and the words
+	 * recently typed in the buffers come first.
+	 *
+	 * Since: 3.10
+	 */
+	g_object_class_install_property (object_class,
+	                                 PROP_MAXIMUM_PROPOSALS,
+	                                 g_param_spec_uint ("maximum-proposals",
+	                                                    _("Maximum Proposals"),
+	                                                    _("The maximum number of proposals"),
+	                                                    1,
+	                                                    G_MAXUINT,
+	                                                    100,
+	                                                    G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
+
 	g_object_class_install_property (object_class,
 	                                 PROP_SCAN_BATCH_SIZE,
 	                                 g_param_spec_uint ("scan-batch-size",
@@ -546,6 +957,15 @@ gtk_source_completion_words_get_activation (GtkSourceCompletionProvider *provide
 	return GTK_SOURCE_COMPLETION_WORDS (provider)->priv->activation;
 }
 
+/* When some words were dropped, the proposals can not simply be narrowed when
+ * the word is extended: a dropped word can be among the best ones.
+ */
+static gboolean
+gtk_source_completion_words_get_repopulate (GtkSourceCompletionProvider *provider)
+{
+	return GTK_SOURCE_COMPLETION_WORDS (provider)->priv->truncated;
+}
+
 static void
 gtk_source_completion_words_iface_init (GtkSourceCompletionProviderIface *iface)
 {
@@ -556,6 +976,7 @@ gtk_source_completion_words_iface_init (GtkSourceCompletionProviderIface *iface)
 	iface->get_interactive_delay = gtk_source_completion_words_get_interactive_delay;
 	iface->get_priority = gtk_source_completion_words_get_priority;
 	iface->get_activation = gtk_source_completion_words_get_activation;
+	iface->get_repopulate = gtk_source_completion_words_get_repopulate;
 }
 
 static void
@@ -564,6 +985,8 @@ gtk_source_completion_words_init (GtkSourceCompletionWords *self)
 	self->priv = gtk_source_completion_words_get_instance_private (self);
 
 	self->priv->library = gtk_source_completion_words_library_new ();
+	self->priv->ranked_words = g_array_new (FALSE, FALSE, sizeof (RankedWord));
+	self->priv->candidate = g_string_new (NULL);
 }
 
 /**
@@ -654,3 +1077,123 @@ gtk_source_completion_words_unregister (GtkSourceCompletionWords *words,
 
 	g_object_set_data (G_OBJECT (buffer), BUFFER_KEY, NULL);
 }
+
+/**
+ * gtk_source_completion_words_register_index:
+ * @words: a #GtkSourceCompletionWords
+ * @filename: a words index file.
+ * @error: return location for a #GError, or %NULL.
+ *
+ * Registers a words index, created with
+ * gtk_source_completion_words_update_index(), in the @words provider. The
+ * words of the index are proposed along with the words of the registered
+ * buffers, ranked by their number of occurrences in the buffers and in the
+ * indexes. The words shorter than #GtkSourceCompletionWords:minimum-word-size
+ * are not proposed.
+ *
+ * The index is memory-mapped read-only, so several processes can share it.
+ * When the index is updated, the new version is used by the next population.
+ *
+ * Returns: whether the index has been successfully loaded.
+ * Since: 3.10
+ */
+gboolean
+gtk_source_completion_words_register_index (GtkSourceCompletionWords  *words,
+					    const gchar               *filename,
+					    GError                   **error)
+{
+	GtkSourceCompletionWordsIndex *index;
+	GList *l;
+
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS (words), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	for (l = words->priv->indexes; l != NULL; l = l->next)
+	{
+		if (g_strcmp0 (gtk_source_completion_words_index_get_filename (l->data), filename) == 0)
+		{
+			return TRUE;
+		}
+	}
+
+	index = gtk_source_completion_words_index_new (filename);
+
+	if (!gtk_source_completion_words_index_load (index, error))
+	{
+		g_object_unref (index);
+		return FALSE;
+	}
+
+	words->priv->indexes = g_list_append (words->priv->indexes, index);
+	return TRUE;
+}
+
+/**
+ * gtk_source_completion_words_unregister_index:
+ * @words: a #GtkSourceCompletionWords
+ * @filename: a words index file.
+ *
+ * Unregisters the words index @filename from the @words provider.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_completion_words_unregister_index (GtkSourceCompletionWords *words,
+					      const gchar              *filename)
+{
+	GList *l;
+
+	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS (words));
+	g_return_if_fail (filename != NULL);
+
+	for (l = words->priv->indexes; l != NULL; l = l->next)
+	{
+		if (g_strcmp0 (gtk_source_completion_words_index_get_filename (l->data), filename) == 0)
+		{
+			/* A running population keeps its own reference. */
+			g_object_unref (l->data);
+			words->priv->indexes = g_list_delete_link (words->priv->indexes, l);
+			return;
+		}
+	}
+}
+
+/**
+ * gtk_source_completion_words_update_index:
+ * @filename: a words index file.
+ * @directory: the directory to index.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @error: return location for a #GError, or %NULL.
+ *
+ * Creates or updates the words index @filename with the words of the files in
+ * @directory and its subdirectories, for example the directory of a project.
+ * The hidden files and directories are skipped.
+ *
+ * If the index already exists, only the files added or modified since the last
+ * update are read. The index file is replaced atomically, so it can be updated
+ * while it is used by other processes.
+ *
+ * This is a blocking operation, which can take some time for a big directory.
+ * It can be run in a thread.
+ *
+ * Returns: whether the index has been successfully written.
+ * Since: 3.10
+ */
+gboolean
+gtk_source_completion_words_update_index (const gchar   *filename,
+					  const gchar   *directory,
+					  GCancellable  *cancellable,
+					  GError       **error)
+{
+	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (directory != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	return gtk_source_completion_words_index_update (filename,
+							 directory,
+							 INDEX_MINIMUM_WORD_SIZE,
+							 cancellable,
+							 error);
+}
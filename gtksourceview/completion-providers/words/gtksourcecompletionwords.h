@@ -60,6 +60,18 @@ void 		gtk_source_completion_words_register 	(GtkSourceCompletionWords *words,
 void 		gtk_source_completion_words_unregister 	(GtkSourceCompletionWords *words,
                                                          GtkTextBuffer            *buffer);
 
+gboolean	gtk_source_completion_words_register_index	(GtkSourceCompletionWords  *words,
+								 const gchar               *filename,
+								 GError                   **error);
+
+void		gtk_source_completion_words_unregister_index	(GtkSourceCompletionWords  *words,
+								 const gchar               *filename);
+
+gboolean	gtk_source_completion_words_update_index	(const gchar               *filename,
+								 const gchar               *directory,
+								 GCancellable              *cancellable,
+								 GError                   **error);
+
 G_END_DECLS
 
 #endif /* __GTK_SOURCE_COMPLETION_WORDS_H__ */
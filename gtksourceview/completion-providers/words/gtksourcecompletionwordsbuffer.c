@@ -23,6 +23,9 @@
 #include "gtksourcecompletionwordsbuffer.h"
 #include "gtksourcecompletionwordsutils.h"
 #include "gtksourceview/gtktextregion.h"
+#include "gtksourceview/gtksourcebuffer.h"
+#include "gtksourceview/gtksourcebuffer-private.h"
+#include <string.h>
 
 /* Timeout in seconds */
 #define INITIATE_SCAN_TIMEOUT 5
@@ -30,12 +33,6 @@
 /* Timeout in milliseconds */
 #define BATCH_SCAN_TIMEOUT 10
 
-typedef struct
-{
-	GtkSourceCompletionWordsProposal *proposal;
-	guint use_count;
-} ProposalCache;
-
 struct _GtkSourceCompletionWordsBufferPrivate
 {
 	GtkSourceCompletionWordsLibrary *library;
@@ -48,50 +45,105 @@ struct _GtkSourceCompletionWordsBufferPrivate
 	guint scan_batch_size;
 	guint minimum_word_size;
 
+	/* Whether the scan region contains only lines modified by the user.
+	 * The words of those lines become recent in the library. The lines
+	 * added by a batch edit or by a scan of the whole buffer don't make
+	 * their words recent.
+	 */
+	guint scan_region_recent : 1;
+
+	/* The words added by this buffer to the library, with their number of
+	 * occurrences: gchar * -> GUINT_TO_POINTER (use count).
+	 */
 	GHashTable *words;
+
+	/* The initial scan of the whole buffer is done in a thread, on a copy
+	 * of the text. While it runs, or while its result waits for the
+	 * library to be unlocked, the batch scan is not installed, and the
+	 * buffer is handled as if the words of the copy were in the library:
+	 * before a line which is not in the scan region is modified, its words
+	 * are added to initial_scan_removed_words instead of being removed
+	 * from the library. They are subtracted from the result of the thread
+	 * when it is merged, and the scan region, which contains the modified
+	 * lines, is then scanned as usual.
+	 */
+	GCancellable *initial_scan_cancellable;
+	GHashTable *initial_scan_words;
+	GHashTable *initial_scan_removed_words;
 };
 
+typedef struct
+{
+	gchar *text;
+	guint minimum_word_size;
+} InitialScanData;
+
 G_DEFINE_TYPE_WITH_PRIVATE (GtkSourceCompletionWordsBuffer, gtk_source_completion_words_buffer, G_TYPE_OBJECT)
 
-static ProposalCache *
-proposal_cache_new (GtkSourceCompletionWordsProposal *proposal)
+static void
+remove_word_occurrences (const gchar                    *word,
+			 gpointer                        use_count,
+			 GtkSourceCompletionWordsBuffer *buffer)
 {
-	ProposalCache *cache = g_slice_new (ProposalCache);
-	cache->proposal = g_object_ref (proposal);
-	cache->use_count = 1;
+	guint i;
 
-	return cache;
+	for (i = 0; i < GPOINTER_TO_UINT (use_count); ++i)
+	{
+		gtk_source_completion_words_library_remove_word (buffer->priv->library,
+		                                                 word);
+	}
 }
 
 static void
-proposal_cache_free (ProposalCache *cache)
+remove_all_words (GtkSourceCompletionWordsBuffer *buffer)
 {
-	g_object_unref (cache->proposal);
-	g_slice_free (ProposalCache, cache);
+	g_hash_table_foreach (buffer->priv->words,
+	                      (GHFunc)remove_word_occurrences,
+	                      buffer);
+
+	g_hash_table_remove_all (buffer->priv->words);
 }
 
 static void
-remove_proposal_cache (const gchar                    *key,
-                       ProposalCache                  *cache,
-                       GtkSourceCompletionWordsBuffer *buffer)
+cancel_initial_scan (GtkSourceCompletionWordsBuffer *buffer)
 {
-	guint i;
+	if (buffer->priv->initial_scan_cancellable != NULL)
+	{
+		g_cancellable_cancel (buffer->priv->initial_scan_cancellable);
+		g_clear_object (&buffer->priv->initial_scan_cancellable);
+	}
 
-	for (i = 0; i < cache->use_count; ++i)
+	if (buffer->priv->initial_scan_words != NULL)
 	{
-		gtk_source_completion_words_library_remove_word (buffer->priv->library,
-		                                                 cache->proposal);
+		g_hash_table_destroy (buffer->priv->initial_scan_words);
+		buffer->priv->initial_scan_words = NULL;
+	}
+
+	if (buffer->priv->initial_scan_removed_words != NULL)
+	{
+		g_hash_table_destroy (buffer->priv->initial_scan_removed_words);
+		buffer->priv->initial_scan_removed_words = NULL;
 	}
 }
 
+static gboolean
+initial_scan_pending (GtkSourceCompletionWordsBuffer *buffer)
+{
+	return (buffer->priv->initial_scan_cancellable != NULL ||
+		buffer->priv->initial_scan_words != NULL);
+}
+
+/* Takes ownership of @word. */
 static void
-remove_all_words (GtkSourceCompletionWordsBuffer *buffer)
+add_initial_scan_removed_word (GtkSourceCompletionWordsBuffer *buffer,
+			       gchar                          *word)
 {
-	g_hash_table_foreach (buffer->priv->words,
-	                      (GHFunc)remove_proposal_cache,
-	                      buffer);
+	guint use_count = GPOINTER_TO_UINT (g_hash_table_lookup (buffer->priv->initial_scan_removed_words,
+								 word));
 
-	g_hash_table_remove_all (buffer->priv->words);
+	g_hash_table_replace (buffer->priv->initial_scan_removed_words,
+			      word,
+			      GUINT_TO_POINTER (use_count + 1));
 }
 
 static void
@@ -100,6 +152,8 @@ gtk_source_completion_words_buffer_dispose (GObject *object)
 	GtkSourceCompletionWordsBuffer *buffer =
 		GTK_SOURCE_COMPLETION_WORDS_BUFFER (object);
 
+	cancel_initial_scan (buffer);
+
 	if (buffer->priv->words != NULL)
 	{
 		remove_all_words (buffer);
@@ -146,12 +200,15 @@ gtk_source_completion_words_buffer_init (GtkSourceCompletionWordsBuffer *self)
 	self->priv = gtk_source_completion_words_buffer_get_instance_private (self);
 
 	self->priv->scan_batch_size = 20;
-	self->priv->minimum_word_size = 3;
+	/* Same default as the provider, so the initial scan started by
+	 * _new() is not restarted when the buffer is registered.
+	 */
+	self->priv->minimum_word_size = 2;
 
 	self->priv->words = g_hash_table_new_full (g_str_hash,
 	                                           g_str_equal,
 	                                           (GDestroyNotify)g_free,
-	                                           (GDestroyNotify)proposal_cache_free);
+	                                           NULL);
 }
 
 static GSList *
@@ -186,9 +243,9 @@ static void
 remove_word (GtkSourceCompletionWordsBuffer *buffer,
              const gchar                    *word)
 {
-	ProposalCache *cache = g_hash_table_lookup (buffer->priv->words, word);
+	guint use_count = GPOINTER_TO_UINT (g_hash_table_lookup (buffer->priv->words, word));
 
-	if (cache == NULL)
+	if (use_count == 0)
 	{
 		g_warning ("Could not find word to remove in buffer (%s), this should not happen!",
 		           word);
@@ -196,14 +253,20 @@ remove_word (GtkSourceCompletionWordsBuffer *buffer,
 	}
 
 	gtk_source_completion_words_library_remove_word (buffer->priv->library,
-	                                                 cache->proposal);
+	                                                 word);
 
-	--cache->use_count;
+	--use_count;
 
-	if (cache->use_count == 0)
+	if (use_count == 0)
 	{
 		g_hash_table_remove (buffer->priv->words, word);
 	}
+	else
+	{
+		g_hash_table_insert (buffer->priv->words,
+				     g_strdup (word),
+				     GUINT_TO_POINTER (use_count));
+	}
 }
 
 static void
@@ -214,28 +277,24 @@ add_words (GtkSourceCompletionWordsBuffer *buffer,
 
 	for (item = words; item != NULL; item = g_slist_next (item))
 	{
-		GtkSourceCompletionWordsProposal *proposal;
-		ProposalCache *cache;
-
-		proposal = gtk_source_completion_words_library_add_word (buffer->priv->library,
-		                                                         item->data);
-
-		cache = g_hash_table_lookup (buffer->priv->words,
-		                             item->data);
+		guint use_count;
 
-		if (cache != NULL)
+		/* A new word is not added while the library is locked. */
+		if (!gtk_source_completion_words_library_add_word (buffer->priv->library,
+		                                                   item->data,
+		                                                   buffer->priv->scan_region_recent))
 		{
-			++cache->use_count;
 			g_free (item->data);
+			continue;
 		}
-		else
-		{
-			/* Hash table takes over ownership of the word string */
-			cache = proposal_cache_new (proposal);
-			g_hash_table_insert (buffer->priv->words,
-			                     item->data,
-			                     cache);
-		}
+
+		use_count = GPOINTER_TO_UINT (g_hash_table_lookup (buffer->priv->words,
+		                                                   item->data));
+
+		/* Hash table takes over ownership of the word string */
+		g_hash_table_replace (buffer->priv->words,
+		                      item->data,
+		                      GUINT_TO_POINTER (use_count + 1));
 	}
 
 	g_slist_free (words);
@@ -364,6 +423,7 @@ idle_scan_regions (GtkSourceCompletionWordsBuffer *buffer)
 	if (finished)
 	{
 		buffer->priv->batch_scan_id = 0;
+		buffer->priv->scan_region_recent = TRUE;
 	}
 
 	return !finished;
@@ -388,7 +448,8 @@ initiate_scan (GtkSourceCompletionWordsBuffer *buffer)
 static void
 install_initiate_scan (GtkSourceCompletionWordsBuffer *buffer)
 {
-	if (buffer->priv->batch_scan_id == 0 &&
+	if (!initial_scan_pending (buffer) &&
+	    buffer->priv->batch_scan_id == 0 &&
 	    buffer->priv->initiate_scan_id == 0)
 	{
 		buffer->priv->initiate_scan_id =
@@ -414,6 +475,12 @@ remove_words_in_subregion (GtkSourceCompletionWordsBuffer *buffer,
 
 		for (item = words; item != NULL; item = g_slist_next (item))
 		{
+			if (initial_scan_pending (buffer))
+			{
+				add_initial_scan_removed_word (buffer, item->data);
+				continue;
+			}
+
 			remove_word (buffer, item->data);
 			g_free (item->data);
 		}
@@ -509,10 +576,12 @@ invalidate_region (GtkSourceCompletionWordsBuffer *buffer,
 	gtk_text_region_destroy (remove_region, TRUE);
 }
 
+/* @recent: whether the lines are modified by the user. */
 static void
 add_to_scan_region (GtkSourceCompletionWordsBuffer *buffer,
                     GtkTextIter                    *start,
-                    GtkTextIter                    *end)
+                    GtkTextIter                    *end,
+                    gboolean                        recent)
 {
 	GtkTextIter start_iter = *start;
 	GtkTextIter end_iter = *end;
@@ -531,9 +600,59 @@ add_to_scan_region (GtkSourceCompletionWordsBuffer *buffer,
 			     &start_iter,
 			     &end_iter);
 
+	if (!recent)
+	{
+		buffer->priv->scan_region_recent = FALSE;
+	}
+
 	install_initiate_scan (buffer);
 }
 
+static gboolean
+in_batch_edit (GtkSourceCompletionWordsBuffer *buffer)
+{
+	return (GTK_SOURCE_IS_BUFFER (buffer->priv->buffer) &&
+		gtk_source_buffer_is_in_batch_edit (GTK_SOURCE_BUFFER (buffer->priv->buffer)));
+}
+
+/* During a batch edit, the lines of the region containing all the changes are
+ * added to the scan region, so the scan region stays contiguous instead of
+ * being fragmented by each change, and the next changes in those lines don't
+ * need to remove any word. The scan is installed at the end of the batch edit.
+ */
+static void
+add_batch_edit_region_to_scan_region (GtkSourceCompletionWordsBuffer *buffer)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	if (!_gtk_source_buffer_get_batch_edit_region (GTK_SOURCE_BUFFER (buffer->priv->buffer),
+						       &start,
+						       &end))
+	{
+		return;
+	}
+
+	gtk_text_iter_set_line_offset (&start, 0);
+
+	if (!gtk_text_iter_ends_line (&end))
+	{
+		gtk_text_iter_forward_to_line_end (&end);
+	}
+
+	gtk_text_region_add (buffer->priv->scan_region, &start, &end);
+	buffer->priv->scan_region_recent = FALSE;
+}
+
+static void
+on_batch_edit_finished_cb (GtkSourceBuffer                *source_buffer,
+			   GtkTextIter                    *start,
+			   GtkTextIter                    *end,
+			   GtkSourceCompletionWordsBuffer *buffer)
+{
+	add_to_scan_region (buffer, start, end, FALSE);
+}
+
 static void
 on_insert_text_before_cb (GtkTextBuffer                  *textbuffer,
 			  GtkTextIter                    *location,
@@ -552,7 +671,16 @@ on_insert_text_after_cb (GtkTextBuffer                  *textbuffer,
 			 GtkSourceCompletionWordsBuffer *buffer)
 {
 	GtkTextIter start_iter = *location;
-	gint nb_chars = g_utf8_strlen (text, -1);
+	gint nb_chars;
+	gboolean recent;
+
+	if (in_batch_edit (buffer))
+	{
+		add_batch_edit_region_to_scan_region (buffer);
+		return;
+	}
+
+	nb_chars = g_utf8_strlen (text, -1);
 
 	gtk_text_iter_backward_chars (&start_iter, nb_chars);
 
@@ -560,8 +688,14 @@ on_insert_text_after_cb (GtkTextBuffer                  *textbuffer,
 	 * line is empty, the TextRegion is empty too and it is not added to the
 	 * scan region. After the text insertion, we are sure that the
 	 * TextRegion is not empty and that the words will be scanned.
+	 *
+	 * When the text fills the whole buffer, for example when a file is
+	 * loaded, its words don't become recent.
 	 */
-	add_to_scan_region (buffer, &start_iter, location);
+	recent = !(gtk_text_iter_is_start (&start_iter) &&
+		   gtk_text_iter_is_end (location));
+
+	add_to_scan_region (buffer, &start_iter, location, recent);
 }
 
 static void
@@ -575,14 +709,18 @@ on_delete_range_before_cb (GtkTextBuffer                  *text_buffer,
 
 	gtk_text_buffer_get_bounds (text_buffer, &start_buf, &end_buf);
 
-	/* Special case removing all the text */
+	/* Special case removing all the text. The result of the initial scan
+	 * would be entirely removed.
+	 */
 	if (gtk_text_iter_equal (start, &start_buf) &&
 	    gtk_text_iter_equal (end, &end_buf))
 	{
+		cancel_initial_scan (buffer);
 		remove_all_words (buffer);
 
 		gtk_text_region_destroy (buffer->priv->scan_region, TRUE);
 		buffer->priv->scan_region = gtk_text_region_new (text_buffer);
+		buffer->priv->scan_region_recent = TRUE;
 	}
 	else
 	{
@@ -604,24 +742,240 @@ on_delete_range_after_cb (GtkTextBuffer                  *text_buffer,
 	 * the text deletion, the TextRegion is not removed from the scan
 	 * region. Hence two callbacks: before and after the text deletion.
 	 */
-	add_to_scan_region (buffer, start, end);
+	if (in_batch_edit (buffer))
+	{
+		add_batch_edit_region_to_scan_region (buffer);
+	}
+	else
+	{
+		add_to_scan_region (buffer, start, end, TRUE);
+	}
+}
+
+static void
+initial_scan_data_free (InitialScanData *data)
+{
+	g_free (data->text);
+	g_slice_free (InitialScanData, data);
 }
 
+/* Runs in a thread. Counts the words of the text, line by line, and returns a
+ * word -> count hash table, in the same format as priv->words.
+ */
+static void
+initial_scan_thread (GTask        *task,
+		     gpointer      source_object,
+		     gpointer      task_data,
+		     GCancellable *cancellable)
+{
+	InitialScanData *data = task_data;
+	GHashTable *words;
+	gchar *line = data->text;
+
+	words = g_hash_table_new_full (g_str_hash,
+				       g_str_equal,
+				       (GDestroyNotify)g_free,
+				       NULL);
+
+	while (line != NULL)
+	{
+		gchar *line_end;
+		GSList *line_words;
+		GSList *item;
+
+		if (g_task_return_error_if_cancelled (task))
+		{
+			g_hash_table_destroy (words);
+			return;
+		}
+
+		/* The text is a copy, it can be split in place. */
+		line_end = strchr (line, '\n');
+
+		if (line_end != NULL)
+		{
+			*line_end = '\0';
+		}
+
+		line_words = _gtk_source_completion_words_utils_scan_words (line,
+									    data->minimum_word_size);
+
+		for (item = line_words; item != NULL; item = g_slist_next (item))
+		{
+			guint use_count = GPOINTER_TO_UINT (g_hash_table_lookup (words, item->data));
+
+			g_hash_table_replace (words,
+					      item->data,
+					      GUINT_TO_POINTER (use_count + 1));
+		}
+
+		g_slist_free (line_words);
+
+		line = line_end != NULL ? line_end + 1 : NULL;
+	}
+
+	g_task_return_pointer (task, words, (GDestroyNotify)g_hash_table_unref);
+}
+
+/* Subtracts the words of the lines modified since the copy of the text from
+ * the result of the initial scan.
+ */
+static void
+subtract_initial_scan_removed_words (GtkSourceCompletionWordsBuffer *buffer)
+{
+	GHashTableIter iter;
+	gpointer word;
+	gpointer removed_count;
+
+	g_hash_table_iter_init (&iter, buffer->priv->initial_scan_removed_words);
+
+	while (g_hash_table_iter_next (&iter, &word, &removed_count))
+	{
+		guint use_count = GPOINTER_TO_UINT (g_hash_table_lookup (buffer->priv->initial_scan_words,
+									 word));
+
+		if (use_count <= GPOINTER_TO_UINT (removed_count))
+		{
+			g_hash_table_remove (buffer->priv->initial_scan_words, word);
+		}
+		else
+		{
+			g_hash_table_insert (buffer->priv->initial_scan_words,
+					     g_strdup (word),
+					     GUINT_TO_POINTER (use_count - GPOINTER_TO_UINT (removed_count)));
+		}
+	}
+
+	g_hash_table_destroy (buffer->priv->initial_scan_removed_words);
+	buffer->priv->initial_scan_removed_words = NULL;
+}
+
+/* Adds all the words found by the initial scan to the library in one step. The
+ * lines modified in the meantime are in the scan region, they are scanned
+ * afterwards.
+ */
+static void
+merge_initial_scan_words (GtkSourceCompletionWordsBuffer *buffer)
+{
+	GHashTableIter iter;
+	gpointer word;
+	gpointer use_count;
+
+	g_assert (g_hash_table_size (buffer->priv->words) == 0);
+
+	subtract_initial_scan_removed_words (buffer);
+
+	g_hash_table_iter_init (&iter, buffer->priv->initial_scan_words);
+
+	while (g_hash_table_iter_next (&iter, &word, &use_count))
+	{
+		gtk_source_completion_words_library_add_word_occurrences (buffer->priv->library,
+									  word,
+									  GPOINTER_TO_UINT (use_count));
+	}
+
+	g_hash_table_destroy (buffer->priv->words);
+	buffer->priv->words = buffer->priv->initial_scan_words;
+	buffer->priv->initial_scan_words = NULL;
+
+	if (!is_text_region_empty (buffer->priv->scan_region))
+	{
+		install_initiate_scan (buffer);
+	}
+}
+
+static void
+initial_scan_cb (GObject      *source_object,
+		 GAsyncResult *result,
+		 gpointer      user_data)
+{
+	GtkSourceCompletionWordsBuffer *buffer = user_data;
+	GTask *task = G_TASK (result);
+
+	/* The buffer is maybe already finalized, it cancels the scan in its
+	 * dispose.
+	 */
+	if (g_cancellable_is_cancelled (g_task_get_cancellable (task)))
+	{
+		return;
+	}
+
+	g_clear_object (&buffer->priv->initial_scan_cancellable);
+	buffer->priv->initial_scan_words = g_task_propagate_pointer (task, NULL);
+
+	/* The whole buffer is scanned by batches instead. */
+	if (buffer->priv->initial_scan_words == NULL)
+	{
+		GtkTextIter start;
+		GtkTextIter end;
+
+		g_hash_table_destroy (buffer->priv->initial_scan_removed_words);
+		buffer->priv->initial_scan_removed_words = NULL;
+
+		gtk_text_buffer_get_bounds (buffer->priv->buffer, &start, &end);
+		add_to_scan_region (buffer, &start, &end, FALSE);
+	}
+	else if (!gtk_source_completion_words_library_is_locked (buffer->priv->library))
+	{
+		merge_initial_scan_words (buffer);
+	}
+}
+
+/* The buffer must not contain any word in the library. */
 static void
 scan_all_buffer (GtkSourceCompletionWordsBuffer *buffer)
 {
 	GtkTextIter start;
 	GtkTextIter end;
+	InitialScanData *data;
+	GTask *task;
+
+	g_assert (g_hash_table_size (buffer->priv->words) == 0);
+
+	cancel_initial_scan (buffer);
+
+	if (buffer->priv->batch_scan_id != 0)
+	{
+		g_source_remove (buffer->priv->batch_scan_id);
+		buffer->priv->batch_scan_id = 0;
+	}
+
+	if (buffer->priv->initiate_scan_id != 0)
+	{
+		g_source_remove (buffer->priv->initiate_scan_id);
+		buffer->priv->initiate_scan_id = 0;
+	}
+
+	/* All the lines are scanned by the thread. */
+	gtk_text_region_destroy (buffer->priv->scan_region, TRUE);
+	buffer->priv->scan_region = gtk_text_region_new (buffer->priv->buffer);
+	buffer->priv->scan_region_recent = TRUE;
 
 	gtk_text_buffer_get_bounds (buffer->priv->buffer,
 	                            &start,
 	                            &end);
 
-	gtk_text_region_add (buffer->priv->scan_region,
-			     &start,
-			     &end);
-
-	install_initiate_scan (buffer);
+	data = g_slice_new (InitialScanData);
+	data->text = gtk_text_buffer_get_text (buffer->priv->buffer,
+					       &start,
+					       &end,
+					       FALSE);
+	data->minimum_word_size = buffer->priv->minimum_word_size;
+
+	buffer->priv->initial_scan_cancellable = g_cancellable_new ();
+	buffer->priv->initial_scan_removed_words = g_hash_table_new_full (g_str_hash,
+									  g_str_equal,
+									  (GDestroyNotify)g_free,
+									  NULL);
+
+	task = g_task_new (NULL,
+			   buffer->priv->initial_scan_cancellable,
+			   initial_scan_cb,
+			   buffer);
+
+	g_task_set_task_data (task, data, (GDestroyNotify)initial_scan_data_free);
+	g_task_run_in_thread (task, initial_scan_thread);
+	g_object_unref (task);
 }
 
 static void
@@ -651,6 +1005,15 @@ connect_buffer (GtkSourceCompletionWordsBuffer *buffer)
 				 buffer,
 				 G_CONNECT_AFTER);
 
+	if (GTK_SOURCE_IS_BUFFER (buffer->priv->buffer))
+	{
+		g_signal_connect_object (buffer->priv->buffer,
+					 "batch-edit-finished",
+					 G_CALLBACK (on_batch_edit_finished_cb),
+					 buffer,
+					 0);
+	}
+
 	scan_all_buffer (buffer);
 }
 
@@ -673,7 +1036,11 @@ on_library_lock (GtkSourceCompletionWordsBuffer *buffer)
 static void
 on_library_unlock (GtkSourceCompletionWordsBuffer *buffer)
 {
-	if (!is_text_region_empty (buffer->priv->scan_region))
+	if (buffer->priv->initial_scan_words != NULL)
+	{
+		merge_initial_scan_words (buffer);
+	}
+	else if (!is_text_region_empty (buffer->priv->scan_region))
 	{
 		install_initiate_scan (buffer);
 	}
@@ -694,6 +1061,7 @@ gtk_source_completion_words_buffer_new (GtkSourceCompletionWordsLibrary *library
 	ret->priv->buffer = g_object_ref (buffer);
 
 	ret->priv->scan_region = gtk_text_region_new (buffer);
+	ret->priv->scan_region_recent = TRUE;
 
 	g_signal_connect_object (ret->priv->library,
 				 "lock",
@@ -737,6 +1105,11 @@ gtk_source_completion_words_buffer_set_minimum_word_size (GtkSourceCompletionWor
 	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_BUFFER (buffer));
 	g_return_if_fail (size != 0);
 
+	if (buffer->priv->minimum_word_size == size)
+	{
+		return;
+	}
+
 	buffer->priv->minimum_word_size = size;
 
 	remove_all_words (buffer);
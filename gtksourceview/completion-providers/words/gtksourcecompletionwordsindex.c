@@ -0,0 +1,915 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; coding: utf-8 -*-
+ * gtksourcecompletionwordsindex.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * gtksourceview is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * gtksourceview is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "gtksourcecompletionwordsindex.h"
+#include "gtksourcecompletionwordsutils.h"
+#include "gtksourceview/gtksourceview-i18n.h"
+
+#include <string.h>
+#include <glib/gstdio.h>
+
+/* A words index is a file containing the words of the files of a directory,
+ * with their number of occurrences. It is memory-mapped read-only, so several
+ * processes using the same index share the same pages, and a lookup touches
+ * only the pages of the words found.
+ *
+ * The file begins with an IndexHeader, followed by the sections:
+ * - the words, as WordEntry, sorted in the strcmp() order, so the words with a
+ *   given prefix are contiguous and found by a binary search;
+ * - the indexed files, as FileEntry, with their modification time and size;
+ * - for each file, its words with their number of occurrences, as Occurrence.
+ *   They are needed to update the index without reading the unchanged files;
+ * - the strings: the words and the file paths, relative to the directory,
+ *   nul-terminated.
+ *
+ * The integers are in the host byte order. The offsets are in bytes from the
+ * beginning of the file, the strings are referenced by their offset in the
+ * strings section.
+ *
+ * An update writes a new file and renames it, so the processes which have
+ * mapped the previous version are not disturbed. They map the new version
+ * when gtk_source_completion_words_index_load() is called again.
+ */
+
+#define INDEX_MAGIC "GSVWORDS"
+#define INDEX_BYTE_ORDER 0x01020304
+#define INDEX_VERSION 1
+
+/* The bigger files are most probably not source code. */
+#define MAX_FILE_SIZE (4 * 1024 * 1024)
+
+typedef struct
+{
+	gchar magic[8];
+	guint32 byte_order;
+	guint32 version;
+	guint32 minimum_word_size;
+	guint32 nb_words;
+	guint32 nb_files;
+	guint32 nb_occurrences;
+	guint32 words_offset;
+	guint32 files_offset;
+	guint32 occurrences_offset;
+	guint32 strings_offset;
+	guint32 strings_size;
+	guint32 padding;
+} IndexHeader;
+
+typedef struct
+{
+	guint32 string;
+	guint32 count;
+} WordEntry;
+
+typedef struct
+{
+	guint32 path;
+	guint32 first_occurrence;
+	guint32 nb_occurrences;
+	guint32 padding;
+	gint64 mtime;
+	guint64 size;
+} FileEntry;
+
+typedef struct
+{
+	guint32 word;
+	guint32 count;
+} Occurrence;
+
+/* A mapped and validated index file. */
+typedef struct
+{
+	GMappedFile *mapped_file;
+	const IndexHeader *header;
+	const WordEntry *words;
+	const FileEntry *files;
+	const Occurrence *occurrences;
+	const gchar *strings;
+} IndexData;
+
+struct _GtkSourceCompletionWordsIndexPrivate
+{
+	gchar *filename;
+	IndexData data;
+
+	/* To know if the file has been replaced since it was mapped. */
+	GStatBuf file_info;
+};
+
+/* A file while the index is updated. */
+typedef struct
+{
+	const gchar *path;
+	gint64 mtime;
+	guint64 size;
+
+	/* Word -> GUINT_TO_POINTER (count). The strings are in the chunk. */
+	GHashTable *words;
+} FileRecord;
+
+typedef struct
+{
+	const gchar *directory;
+	guint minimum_word_size;
+	GCancellable *cancellable;
+
+	/* The words and the paths. */
+	GStringChunk *chunk;
+
+	/* FileRecord. */
+	GPtrArray *files;
+
+	/* The previous version of the index, if it can be reused.
+	 * Path -> FileEntry.
+	 */
+	IndexData *old_data;
+	GHashTable *old_files;
+} UpdateData;
+
+G_DEFINE_TYPE_WITH_PRIVATE (GtkSourceCompletionWordsIndex, gtk_source_completion_words_index, G_TYPE_OBJECT)
+
+static void
+index_data_clear (IndexData *data)
+{
+	if (data->mapped_file != NULL)
+	{
+		g_mapped_file_unref (data->mapped_file);
+	}
+
+	memset (data, 0, sizeof (IndexData));
+}
+
+static gboolean
+check_section (gsize   length,
+	       guint32 offset,
+	       guint32 nb_items,
+	       gsize   item_size)
+{
+	return (offset % 8 == 0 &&
+		(guint64) offset + (guint64) nb_items * item_size <= length);
+}
+
+/* Checks everything that could make a lookup read outside of the file, since
+ * the file can come from anywhere.
+ */
+static gboolean
+check_index_data (IndexData *data,
+		  gsize      length)
+{
+	const IndexHeader *header = data->header;
+	const gchar *contents = (const gchar *) header;
+	guint i;
+
+	if (length < sizeof (IndexHeader) ||
+	    memcmp (header->magic, INDEX_MAGIC, sizeof (header->magic)) != 0 ||
+	    header->byte_order != INDEX_BYTE_ORDER ||
+	    header->version != INDEX_VERSION)
+	{
+		return FALSE;
+	}
+
+	if (!check_section (length, header->words_offset, header->nb_words, sizeof (WordEntry)) ||
+	    !check_section (length, header->files_offset, header->nb_files, sizeof (FileEntry)) ||
+	    !check_section (length, header->occurrences_offset, header->nb_occurrences, sizeof (Occurrence)) ||
+	    !check_section (length, header->strings_offset, header->strings_size, 1) ||
+	    header->strings_size == 0 ||
+	    contents[header->strings_offset + header->strings_size - 1] != '\0')
+	{
+		return FALSE;
+	}
+
+	data->words = (const WordEntry *) (contents + header->words_offset);
+	data->files = (const FileEntry *) (contents + header->files_offset);
+	data->occurrences = (const Occurrence *) (contents + header->occurrences_offset);
+	data->strings = contents + header->strings_offset;
+
+	for (i = 0; i < header->nb_words; i++)
+	{
+		if (data->words[i].string >= header->strings_size)
+		{
+			return FALSE;
+		}
+	}
+
+	for (i = 0; i < header->nb_files; i++)
+	{
+		const FileEntry *file = &data->files[i];
+
+		if (file->path >= header->strings_size ||
+		    (guint64) file->first_occurrence + file->nb_occurrences > header->nb_occurrences)
+		{
+			return FALSE;
+		}
+	}
+
+	for (i = 0; i < header->nb_occurrences; i++)
+	{
+		if (data->occurrences[i].word >= header->nb_words)
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean
+index_data_load (IndexData    *data,
+		 const gchar  *filename,
+		 GError      **error)
+{
+	GMappedFile *mapped_file;
+
+	mapped_file = g_mapped_file_new (filename, FALSE, error);
+
+	if (mapped_file == NULL)
+	{
+		return FALSE;
+	}
+
+	data->mapped_file = mapped_file;
+	data->header = (const IndexHeader *) g_mapped_file_get_contents (mapped_file);
+
+	if (data->header == NULL ||
+	    !check_index_data (data, g_mapped_file_get_length (mapped_file)))
+	{
+		index_data_clear (data);
+
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     _("Invalid words index: %s"),
+			     filename);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static const gchar *
+index_data_get_word (IndexData *data,
+		     guint      pos)
+{
+	return data->strings + data->words[pos].string;
+}
+
+static void
+gtk_source_completion_words_index_finalize (GObject *object)
+{
+	GtkSourceCompletionWordsIndex *index = GTK_SOURCE_COMPLETION_WORDS_INDEX (object);
+
+	index_data_clear (&index->priv->data);
+	g_free (index->priv->filename);
+
+	G_OBJECT_CLASS (gtk_source_completion_words_index_parent_class)->finalize (object);
+}
+
+static void
+gtk_source_completion_words_index_class_init (GtkSourceCompletionWordsIndexClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = gtk_source_completion_words_index_finalize;
+}
+
+static void
+gtk_source_completion_words_index_init (GtkSourceCompletionWordsIndex *self)
+{
+	self->priv = gtk_source_completion_words_index_get_instance_private (self);
+}
+
+/* The file is mapped by gtk_source_completion_words_index_load(). */
+GtkSourceCompletionWordsIndex *
+gtk_source_completion_words_index_new (const gchar *filename)
+{
+	GtkSourceCompletionWordsIndex *index;
+
+	g_return_val_if_fail (filename != NULL, NULL);
+
+	index = g_object_new (GTK_SOURCE_TYPE_COMPLETION_WORDS_INDEX, NULL);
+	index->priv->filename = g_strdup (filename);
+
+	return index;
+}
+
+const gchar *
+gtk_source_completion_words_index_get_filename (GtkSourceCompletionWordsIndex *index)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_INDEX (index), NULL);
+
+	return index->priv->filename;
+}
+
+/* Maps the file, if it has been replaced since the last call. On error, the
+ * previous version stays mapped.
+ */
+gboolean
+gtk_source_completion_words_index_load (GtkSourceCompletionWordsIndex  *index,
+					GError                        **error)
+{
+	IndexData data = { NULL };
+	GStatBuf file_info;
+
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_INDEX (index), FALSE);
+
+	if (g_stat (index->priv->filename, &file_info) != 0)
+	{
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_FOUND,
+			     _("Can not read the words index: %s"),
+			     index->priv->filename);
+
+		return FALSE;
+	}
+
+	if (index->priv->data.mapped_file != NULL &&
+	    file_info.st_ino == index->priv->file_info.st_ino &&
+	    file_info.st_mtime == index->priv->file_info.st_mtime &&
+	    file_info.st_size == index->priv->file_info.st_size)
+	{
+		return TRUE;
+	}
+
+	if (!index_data_load (&data, index->priv->filename, error))
+	{
+		return FALSE;
+	}
+
+	index_data_clear (&index->priv->data);
+	index->priv->data = data;
+	index->priv->file_info = file_info;
+
+	return TRUE;
+}
+
+guint
+gtk_source_completion_words_index_get_n_words (GtkSourceCompletionWordsIndex *index)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_INDEX (index), 0);
+
+	if (index->priv->data.header == NULL)
+	{
+		return 0;
+	}
+
+	return index->priv->data.header->nb_words;
+}
+
+/* Finds the words beginning with the first @len bytes of @word (all of @word if
+ * @len is -1). Returns the position of the first one, and @end is set to the
+ * position after the last one. No memory is allocated.
+ */
+guint
+gtk_source_completion_words_index_find_prefix (GtkSourceCompletionWordsIndex *index,
+					       const gchar                   *word,
+					       gint                           len,
+					       guint                         *end)
+{
+	IndexData *data;
+	guint low = 0;
+	guint high;
+	guint first;
+
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_INDEX (index), 0);
+	g_return_val_if_fail (word != NULL, 0);
+	g_return_val_if_fail (end != NULL, 0);
+
+	data = &index->priv->data;
+	high = gtk_source_completion_words_index_get_n_words (index);
+
+	if (len == -1)
+	{
+		len = strlen (word);
+	}
+
+	/* The first word not before the prefix. */
+	while (low < high)
+	{
+		guint middle = low + (high - low) / 2;
+
+		if (strncmp (index_data_get_word (data, middle), word, len) < 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	first = low;
+	high = gtk_source_completion_words_index_get_n_words (index);
+
+	/* The first word after the prefix. */
+	while (low < high)
+	{
+		guint middle = low + (high - low) / 2;
+
+		if (strncmp (index_data_get_word (data, middle), word, len) <= 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	*end = low;
+	return first;
+}
+
+const gchar *
+gtk_source_completion_words_index_get_word (GtkSourceCompletionWordsIndex *index,
+					    guint                          pos)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_INDEX (index), NULL);
+	g_return_val_if_fail (pos < gtk_source_completion_words_index_get_n_words (index), NULL);
+
+	return index_data_get_word (&index->priv->data, pos);
+}
+
+/* Returns the number of occurrences of the word at @pos in all the files. */
+guint
+gtk_source_completion_words_index_get_count (GtkSourceCompletionWordsIndex *index,
+					     guint                          pos)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_INDEX (index), 0);
+	g_return_val_if_fail (pos < gtk_source_completion_words_index_get_n_words (index), 0);
+
+	return index->priv->data.words[pos].count;
+}
+
+static void
+file_record_free (FileRecord *record)
+{
+	g_hash_table_unref (record->words);
+	g_slice_free (FileRecord, record);
+}
+
+static void
+add_occurrences (UpdateData  *data,
+		 FileRecord  *record,
+		 const gchar *word,
+		 guint        count)
+{
+	gchar *chunk_word = g_string_chunk_insert_const (data->chunk, word);
+	guint prev_count = GPOINTER_TO_UINT (g_hash_table_lookup (record->words, chunk_word));
+
+	g_hash_table_insert (record->words,
+			     chunk_word,
+			     GUINT_TO_POINTER (prev_count + count));
+}
+
+/* The words of an unchanged file are taken from the previous index. */
+static void
+reuse_file (UpdateData      *data,
+	    FileRecord      *record,
+	    const FileEntry *old_file)
+{
+	guint i;
+
+	for (i = 0; i < old_file->nb_occurrences; i++)
+	{
+		const Occurrence *occurrence = &data->old_data->occurrences[old_file->first_occurrence + i];
+
+		add_occurrences (data,
+				 record,
+				 index_data_get_word (data->old_data, occurrence->word),
+				 occurrence->count);
+	}
+}
+
+static void
+scan_file (UpdateData  *data,
+	   FileRecord  *record,
+	   const gchar *filename)
+{
+	gchar *contents;
+	gchar *line;
+
+	if (record->size > MAX_FILE_SIZE ||
+	    !g_file_get_contents (filename, &contents, NULL, NULL))
+	{
+		return;
+	}
+
+	/* Probably a binary file. It is kept in the index without words, so it
+	 * is not read again by the next updates.
+	 */
+	if (!g_utf8_validate (contents, -1, NULL))
+	{
+		g_free (contents);
+		return;
+	}
+
+	line = contents;
+
+	while (line != NULL)
+	{
+		gchar *line_end = strchr (line, '\n');
+		GSList *words;
+		GSList *item;
+
+		if (line_end != NULL)
+		{
+			*line_end = '\0';
+		}
+
+		words = _gtk_source_completion_words_utils_scan_words (line, data->minimum_word_size);
+
+		for (item = words; item != NULL; item = g_slist_next (item))
+		{
+			add_occurrences (data, record, item->data, 1);
+		}
+
+		g_slist_free_full (words, g_free);
+
+		line = line_end != NULL ? line_end + 1 : NULL;
+	}
+
+	g_free (contents);
+}
+
+static void
+add_file (UpdateData  *data,
+	  const gchar *relative_path,
+	  GStatBuf    *file_info)
+{
+	gchar *filename = g_build_filename (data->directory, relative_path, NULL);
+	FileRecord *record;
+	const FileEntry *old_file = NULL;
+
+	record = g_slice_new0 (FileRecord);
+	record->path = g_string_chunk_insert (data->chunk, relative_path);
+	record->mtime = file_info->st_mtime;
+	record->size = file_info->st_size;
+	record->words = g_hash_table_new (g_str_hash, g_str_equal);
+
+	if (data->old_files != NULL)
+	{
+		old_file = g_hash_table_lookup (data->old_files, relative_path);
+	}
+
+	if (old_file != NULL &&
+	    old_file->mtime == record->mtime &&
+	    old_file->size == record->size)
+	{
+		reuse_file (data, record, old_file);
+	}
+	else
+	{
+		scan_file (data, record, filename);
+	}
+
+	g_ptr_array_add (data->files, record);
+	g_free (filename);
+}
+
+/* The hidden files and directories, and the symbolic links, are skipped. */
+static gboolean
+scan_directory (UpdateData   *data,
+		const gchar  *relative_dir,
+		GError      **error)
+{
+	gchar *dirname = g_build_filename (data->directory, relative_dir, NULL);
+	GDir *dir;
+	const gchar *name;
+	gboolean ret = TRUE;
+
+	dir = g_dir_open (dirname, 0, error);
+	g_free (dirname);
+
+	if (dir == NULL)
+	{
+		return FALSE;
+	}
+
+	while (ret && (name = g_dir_read_name (dir)) != NULL)
+	{
+		gchar *relative_path;
+		gchar *filename;
+		GStatBuf file_info;
+
+		if (name[0] == '.')
+		{
+			continue;
+		}
+
+		if (g_cancellable_set_error_if_cancelled (data->cancellable, error))
+		{
+			ret = FALSE;
+			break;
+		}
+
+		relative_path = g_build_filename (relative_dir, name, NULL);
+		filename = g_build_filename (data->directory, relative_path, NULL);
+
+		if (g_lstat (filename, &file_info) == 0)
+		{
+			if (S_ISDIR (file_info.st_mode))
+			{
+				GError *dir_error = NULL;
+
+				/* An unreadable subdirectory is not fatal. */
+				ret = scan_directory (data, relative_path, &dir_error);
+
+				if (!ret &&
+				    !g_error_matches (dir_error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+				{
+					g_clear_error (&dir_error);
+					ret = TRUE;
+				}
+				else if (dir_error != NULL)
+				{
+					g_propagate_error (error, dir_error);
+				}
+			}
+			else if (S_ISREG (file_info.st_mode))
+			{
+				add_file (data, relative_path, &file_info);
+			}
+		}
+
+		g_free (relative_path);
+		g_free (filename);
+	}
+
+	g_dir_close (dir);
+	return ret;
+}
+
+static gint
+compare_words (gconstpointer a,
+	       gconstpointer b)
+{
+	return strcmp (*(const gchar * const *) a, *(const gchar * const *) b);
+}
+
+static gint
+compare_file_records (gconstpointer a,
+		      gconstpointer b)
+{
+	const FileRecord *record_a = *(const FileRecord * const *) a;
+	const FileRecord *record_b = *(const FileRecord * const *) b;
+
+	return strcmp (record_a->path, record_b->path);
+}
+
+static guint32
+add_string (GString     *strings,
+	    const gchar *str)
+{
+	guint32 offset = strings->len;
+
+	g_string_append_len (strings, str, strlen (str) + 1);
+	return offset;
+}
+
+/* Serializes the files and their words in the index format. */
+static GByteArray *
+build_index_contents (UpdateData  *data,
+		      GError     **error)
+{
+	GHashTable *totals;
+	GHashTable *word_positions;
+	GPtrArray *sorted_words;
+	GArray *words;
+	GArray *files;
+	GArray *occurrences;
+	GString *strings;
+	GByteArray *contents = NULL;
+	IndexHeader header;
+	GHashTableIter iter;
+	gpointer word;
+	gpointer count;
+	guint64 total_size;
+	guint i;
+
+	/* The total number of occurrences of each word. */
+	totals = g_hash_table_new (g_str_hash, g_str_equal);
+
+	for (i = 0; i < data->files->len; i++)
+	{
+		FileRecord *record = g_ptr_array_index (data->files, i);
+
+		g_hash_table_iter_init (&iter, record->words);
+
+		while (g_hash_table_iter_next (&iter, &word, &count))
+		{
+			guint total = GPOINTER_TO_UINT (g_hash_table_lookup (totals, word));
+
+			g_hash_table_insert (totals, word, GUINT_TO_POINTER (total + GPOINTER_TO_UINT (count)));
+		}
+	}
+
+	sorted_words = g_ptr_array_sized_new (g_hash_table_size (totals));
+	g_hash_table_iter_init (&iter, totals);
+
+	while (g_hash_table_iter_next (&iter, &word, NULL))
+	{
+		g_ptr_array_add (sorted_words, word);
+	}
+
+	g_ptr_array_sort (sorted_words, compare_words);
+	g_ptr_array_sort (data->files, compare_file_records);
+
+	strings = g_string_new (NULL);
+	words = g_array_sized_new (FALSE, FALSE, sizeof (WordEntry), sorted_words->len);
+	files = g_array_sized_new (FALSE, FALSE, sizeof (FileEntry), data->files->len);
+	occurrences = g_array_new (FALSE, FALSE, sizeof (Occurrence));
+	word_positions = g_hash_table_new (g_str_hash, g_str_equal);
+
+	for (i = 0; i < sorted_words->len; i++)
+	{
+		WordEntry entry;
+
+		word = g_ptr_array_index (sorted_words, i);
+
+		entry.string = add_string (strings, word);
+		entry.count = GPOINTER_TO_UINT (g_hash_table_lookup (totals, word));
+		g_array_append_val (words, entry);
+
+		g_hash_table_insert (word_positions, word, GUINT_TO_POINTER (i));
+	}
+
+	for (i = 0; i < data->files->len; i++)
+	{
+		FileRecord *record = g_ptr_array_index (data->files, i);
+		FileEntry entry = { 0 };
+
+		entry.path = add_string (strings, record->path);
+		entry.first_occurrence = occurrences->len;
+		entry.nb_occurrences = g_hash_table_size (record->words);
+		entry.mtime = record->mtime;
+		entry.size = record->size;
+		g_array_append_val (files, entry);
+
+		g_hash_table_iter_init (&iter, record->words);
+
+		while (g_hash_table_iter_next (&iter, &word, &count))
+		{
+			Occurrence occurrence;
+
+			occurrence.word = GPOINTER_TO_UINT (g_hash_table_lookup (word_positions, word));
+			occurrence.count = GPOINTER_TO_UINT (count);
+			g_array_append_val (occurrences, occurrence);
+		}
+	}
+
+	/* The strings section can not be empty. */
+	if (strings->len == 0)
+	{
+		g_string_append_c (strings, '\0');
+	}
+
+	total_size = (guint64) sizeof (IndexHeader) +
+		     (guint64) words->len * sizeof (WordEntry) +
+		     (guint64) files->len * sizeof (FileEntry) +
+		     (guint64) occurrences->len * sizeof (Occurrence) +
+		     strings->len;
+
+	if (total_size > G_MAXUINT32)
+	{
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NO_SPACE,
+				     _("The words index is too big"));
+		goto out;
+	}
+
+	memset (&header, 0, sizeof (IndexHeader));
+	memcpy (header.magic, INDEX_MAGIC, sizeof (header.magic));
+	header.byte_order = INDEX_BYTE_ORDER;
+	header.version = INDEX_VERSION;
+	header.minimum_word_size = data->minimum_word_size;
+	header.nb_words = words->len;
+	header.nb_files = files->len;
+	header.nb_occurrences = occurrences->len;
+	header.words_offset = sizeof (IndexHeader);
+	header.files_offset = header.words_offset + words->len * sizeof (WordEntry);
+	header.occurrences_offset = header.files_offset + files->len * sizeof (FileEntry);
+	header.strings_offset = header.occurrences_offset + occurrences->len * sizeof (Occurrence);
+	header.strings_size = strings->len;
+
+	contents = g_byte_array_sized_new (total_size);
+	g_byte_array_append (contents, (const guint8 *) &header, sizeof (IndexHeader));
+	g_byte_array_append (contents, (const guint8 *) words->data, words->len * sizeof (WordEntry));
+	g_byte_array_append (contents, (const guint8 *) files->data, files->len * sizeof (FileEntry));
+	g_byte_array_append (contents, (const guint8 *) occurrences->data, occurrences->len * sizeof (Occurrence));
+	g_byte_array_append (contents, (const guint8 *) strings->str, strings->len);
+
+out:
+	g_hash_table_unref (totals);
+	g_hash_table_unref (word_positions);
+	g_ptr_array_unref (sorted_words);
+	g_array_unref (words);
+	g_array_unref (files);
+	g_array_unref (occurrences);
+	g_string_free (strings, TRUE);
+
+	return contents;
+}
+
+/* Creates or updates the index @filename with the words of the files in
+ * @directory and its subdirectories. If the index already exists, only the
+ * files added or modified since the last update are read. The file is replaced
+ * atomically.
+ *
+ * This is a blocking operation, it can be run in a thread.
+ */
+gboolean
+gtk_source_completion_words_index_update (const gchar   *filename,
+					  const gchar   *directory,
+					  guint          minimum_word_size,
+					  GCancellable  *cancellable,
+					  GError       **error)
+{
+	UpdateData data = { NULL };
+	IndexData old_data = { NULL };
+	GByteArray *contents;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (directory != NULL, FALSE);
+	g_return_val_if_fail (minimum_word_size != 0, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	data.directory = directory;
+	data.minimum_word_size = minimum_word_size;
+	data.cancellable = cancellable;
+	data.chunk = g_string_chunk_new (4096);
+	data.files = g_ptr_array_new_with_free_func ((GDestroyNotify)file_record_free);
+
+	/* An invalid or incompatible previous version is ignored. */
+	if (index_data_load (&old_data, filename, NULL) &&
+	    old_data.header->minimum_word_size == minimum_word_size)
+	{
+		guint i;
+
+		data.old_data = &old_data;
+		data.old_files = g_hash_table_new (g_str_hash, g_str_equal);
+
+		for (i = 0; i < old_data.header->nb_files; i++)
+		{
+			const FileEntry *file = &old_data.files[i];
+
+			g_hash_table_insert (data.old_files,
+					     (gpointer) (old_data.strings + file->path),
+					     (gpointer) file);
+		}
+	}
+
+	if (!scan_directory (&data, "", error))
+	{
+		goto out;
+	}
+
+	contents = build_index_contents (&data, error);
+
+	if (contents == NULL)
+	{
+		goto out;
+	}
+
+	ret = g_file_set_contents (filename,
+				   (const gchar *) contents->data,
+				   contents->len,
+				   error);
+
+	g_byte_array_unref (contents);
+
+out:
+	if (data.old_files != NULL)
+	{
+		g_hash_table_unref (data.old_files);
+	}
+
+	index_data_clear (&old_data);
+	g_ptr_array_unref (data.files);
+	g_string_chunk_free (data.chunk);
+
+	return ret;
+}
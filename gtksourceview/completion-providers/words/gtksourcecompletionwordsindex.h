@@ -0,0 +1,93 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; coding: utf-8 -*-
+ * gtksourcecompletionwordsindex.h
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * gtksourceview is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * gtksourceview is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GTK_SOURCE_COMPLETION_WORDS_INDEX_H__
+#define __GTK_SOURCE_COMPLETION_WORDS_INDEX_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define GTK_SOURCE_TYPE_COMPLETION_WORDS_INDEX			(gtk_source_completion_words_index_get_type ())
+#define GTK_SOURCE_COMPLETION_WORDS_INDEX(obj)			(G_TYPE_CHECK_INSTANCE_CAST ((obj), GTK_SOURCE_TYPE_COMPLETION_WORDS_INDEX, GtkSourceCompletionWordsIndex))
+#define GTK_SOURCE_COMPLETION_WORDS_INDEX_CLASS(klass)		(G_TYPE_CHECK_CLASS_CAST ((klass), GTK_SOURCE_TYPE_COMPLETION_WORDS_INDEX, GtkSourceCompletionWordsIndexClass))
+#define GTK_SOURCE_IS_COMPLETION_WORDS_INDEX(obj)		(G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTK_SOURCE_TYPE_COMPLETION_WORDS_INDEX))
+#define GTK_SOURCE_IS_COMPLETION_WORDS_INDEX_CLASS(klass)	(G_TYPE_CHECK_CLASS_TYPE ((klass), GTK_SOURCE_TYPE_COMPLETION_WORDS_INDEX))
+#define GTK_SOURCE_COMPLETION_WORDS_INDEX_GET_CLASS(obj)	(G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_SOURCE_TYPE_COMPLETION_WORDS_INDEX, GtkSourceCompletionWordsIndexClass))
+
+typedef struct _GtkSourceCompletionWordsIndex		GtkSourceCompletionWordsIndex;
+typedef struct _GtkSourceCompletionWordsIndexClass	GtkSourceCompletionWordsIndexClass;
+typedef struct _GtkSourceCompletionWordsIndexPrivate	GtkSourceCompletionWordsIndexPrivate;
+
+struct _GtkSourceCompletionWordsIndex {
+	GObject parent;
+
+	GtkSourceCompletionWordsIndexPrivate *priv;
+};
+
+struct _GtkSourceCompletionWordsIndexClass {
+	GObjectClass parent_class;
+};
+
+G_GNUC_INTERNAL
+GType		 gtk_source_completion_words_index_get_type		(void) G_GNUC_CONST;
+
+G_GNUC_INTERNAL
+GtkSourceCompletionWordsIndex *
+		 gtk_source_completion_words_index_new			(const gchar                   *filename);
+
+G_GNUC_INTERNAL
+const gchar	*gtk_source_completion_words_index_get_filename		(GtkSourceCompletionWordsIndex *index);
+
+G_GNUC_INTERNAL
+gboolean	 gtk_source_completion_words_index_load			(GtkSourceCompletionWordsIndex *index,
+									 GError                       **error);
+
+/* Finding */
+G_GNUC_INTERNAL
+guint		 gtk_source_completion_words_index_find_prefix		(GtkSourceCompletionWordsIndex *index,
+									 const gchar                   *word,
+									 gint                           len,
+									 guint                         *end);
+
+G_GNUC_INTERNAL
+guint		 gtk_source_completion_words_index_get_n_words		(GtkSourceCompletionWordsIndex *index);
+
+/* Getting */
+G_GNUC_INTERNAL
+const gchar	*gtk_source_completion_words_index_get_word		(GtkSourceCompletionWordsIndex *index,
+									 guint                          pos);
+
+G_GNUC_INTERNAL
+guint		 gtk_source_completion_words_index_get_count		(GtkSourceCompletionWordsIndex *index,
+									 guint                          pos);
+
+/* Building */
+G_GNUC_INTERNAL
+gboolean	 gtk_source_completion_words_index_update		(const gchar                   *filename,
+									 const gchar                   *directory,
+									 guint                          minimum_word_size,
+									 GCancellable                  *cancellable,
+									 GError                       **error);
+
+G_END_DECLS
+
+#endif /* __GTK_SOURCE_COMPLETION_WORDS_INDEX_H__ */
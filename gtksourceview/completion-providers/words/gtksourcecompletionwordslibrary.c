@@ -24,6 +24,30 @@
 
 #include <string.h>
 
+/* The words are stored in a radix tree: each node has a label, and the word
+ * ending at a node is the concatenation of the labels from the root. The
+ * children of a node begin with different bytes and are sorted, so a pre-order
+ * traversal gives the words in the strcmp() order. A node is allocated in one
+ * block with its label, and a proposal object is created only when a node is
+ * returned by gtk_source_completion_words_library_get_proposal().
+ *
+ * A node without a word has at least two children: when a word is removed, its
+ * node is freed if it is a leaf, and a node left with one child is merged with
+ * it, so the tree stays compressed.
+ *
+ * While the library is locked, the nodes are never freed, so the iters (which
+ * are nodes) stay valid. The nodes of the words removed meanwhile are recorded,
+ * and only them are pruned when the library is unlocked.
+ *
+ * Each word also has a score, to rank the proposals: its number of occurrences,
+ * plus a bonus if it has been added recently. The words are added one by one
+ * by the buffers when they scan the lines modified by the user, so the recent
+ * words are the ones around the places being edited.
+ */
+
+/* Number of word additions during which a word keeps a recency bonus. */
+#define RECENT_WORDS 1000
+
 enum
 {
 	LOCK,
@@ -31,22 +55,405 @@ enum
 	NUM_SIGNALS
 };
 
+struct _GtkSourceCompletionWordsLibraryIter
+{
+	GtkSourceCompletionWordsLibraryIter *parent;
+
+	/* The children are sorted by the first byte of their label. */
+	GtkSourceCompletionWordsLibraryIter *first_child;
+	GtkSourceCompletionWordsLibraryIter *next_sibling;
+
+	/* Weak pointer. The proposal exists only while it is used, for example
+	 * by the completion model.
+	 */
+	GtkSourceCompletionWordsProposal *proposal;
+
+	/* Number of occurrences of the word ending at this node, 0 for an
+	 * inner node.
+	 */
+	guint use_count;
+
+	/* Value of the library stamp when the word was last added as a recent
+	 * word, 0 if it never was.
+	 */
+	guint last_use;
+
+	/* Length in bytes of the word ending at this node. */
+	guint depth;
+
+	guint label_len;
+
+	/* Unlinked from the tree, freed at the end of the pruning. */
+	guint dead : 1;
+
+	/* Nul-terminated. Allocated with the node. */
+	gchar label[1];
+};
+
+typedef GtkSourceCompletionWordsLibraryIter WordNode;
+
 struct _GtkSourceCompletionWordsLibraryPrivate
 {
-	GSequence *store;
+	WordNode *root;
 	gboolean locked;
+
+	/* Incremented each time a word is added. */
+	guint stamp;
+
+	/* The nodes whose use count reached 0 while the library was locked,
+	 * they are pruned when it is unlocked.
+	 */
+	GPtrArray *removed_nodes;
+
+	/* The nodes unlinked while the removed nodes are pruned, NULL outside
+	 * of the pruning.
+	 */
+	GPtrArray *dead_nodes;
 };
 
 static guint signals[NUM_SIGNALS] = {0,};
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtkSourceCompletionWordsLibrary, gtk_source_completion_words_library, G_TYPE_OBJECT)
 
+static WordNode *
+word_node_new (WordNode    *parent,
+	       const gchar *label,
+	       guint        label_len)
+{
+	WordNode *node = g_malloc0 (sizeof (WordNode) + label_len);
+
+	node->parent = parent;
+	node->depth = (parent != NULL ? parent->depth : 0) + label_len;
+	node->label_len = label_len;
+	memcpy (node->label, label, label_len);
+	node->label[label_len] = '\0';
+
+	return node;
+}
+
+static void
+word_node_free (WordNode *node)
+{
+	if (node->proposal != NULL)
+	{
+		g_object_remove_weak_pointer (G_OBJECT (node->proposal),
+					      (gpointer *) &node->proposal);
+	}
+
+	g_free (node);
+}
+
+static void
+word_node_free_recursive (WordNode *node)
+{
+	WordNode *child = node->first_child;
+
+	while (child != NULL)
+	{
+		WordNode *next = child->next_sibling;
+		word_node_free_recursive (child);
+		child = next;
+	}
+
+	word_node_free (node);
+}
+
+/* Returns the child beginning with @byte, or NULL. @prev is set to the last
+ * child before the position of @byte, or NULL if it would be the first child.
+ */
+static WordNode *
+find_child (WordNode  *node,
+	    gchar      byte,
+	    WordNode **prev)
+{
+	WordNode *child;
+
+	*prev = NULL;
+
+	for (child = node->first_child; child != NULL; child = child->next_sibling)
+	{
+		guchar first = child->label[0];
+
+		if (first == (guchar) byte)
+		{
+			return child;
+		}
+
+		if (first > (guchar) byte)
+		{
+			break;
+		}
+
+		*prev = child;
+	}
+
+	return NULL;
+}
+
+static void
+replace_child (WordNode *parent,
+	       WordNode *prev,
+	       WordNode *old_child,
+	       WordNode *new_child)
+{
+	new_child->next_sibling = old_child->next_sibling;
+
+	if (prev != NULL)
+	{
+		prev->next_sibling = new_child;
+	}
+	else
+	{
+		parent->first_child = new_child;
+	}
+}
+
+static void
+unlink_child (WordNode *child)
+{
+	WordNode *parent = child->parent;
+	WordNode **link;
+
+	for (link = &parent->first_child; *link != child; link = &(*link)->next_sibling)
+	{
+		g_assert (*link != NULL);
+	}
+
+	*link = child->next_sibling;
+}
+
+/* Splits @node after the first @len bytes of its label. @node keeps its
+ * identity, so an iter or a proposal pointing to it stays valid.
+ * Returns the new parent of @node.
+ */
+static WordNode *
+split_node (WordNode *node,
+	    WordNode *prev,
+	    guint     len)
+{
+	WordNode *parent = node->parent;
+	WordNode *middle;
+
+	g_assert (0 < len && len < node->label_len);
+
+	middle = word_node_new (parent, node->label, len);
+	replace_child (parent, prev, node, middle);
+
+	middle->first_child = node;
+	node->parent = middle;
+	node->next_sibling = NULL;
+
+	memmove (node->label, node->label + len, node->label_len - len);
+	node->label_len -= len;
+	node->label[node->label_len] = '\0';
+
+	return middle;
+}
+
+/* Returns the node of @word, or NULL. If @create is TRUE, the missing nodes are
+ * created.
+ */
+static WordNode *
+lookup_node (GtkSourceCompletionWordsLibrary *library,
+	     const gchar                     *word,
+	     gboolean                         create)
+{
+	WordNode *node = library->priv->root;
+	guint len = strlen (word);
+	guint pos = 0;
+
+	while (pos < len)
+	{
+		WordNode *prev;
+		WordNode *child;
+		guint common = 0;
+
+		child = find_child (node, word[pos], &prev);
+
+		if (child == NULL)
+		{
+			if (!create)
+			{
+				return NULL;
+			}
+
+			child = word_node_new (node, word + pos, len - pos);
+
+			if (prev != NULL)
+			{
+				child->next_sibling = prev->next_sibling;
+				prev->next_sibling = child;
+			}
+			else
+			{
+				child->next_sibling = node->first_child;
+				node->first_child = child;
+			}
+
+			return child;
+		}
+
+		while (common < child->label_len &&
+		       pos + common < len &&
+		       child->label[common] == word[pos + common])
+		{
+			common++;
+		}
+
+		if (common < child->label_len)
+		{
+			if (!create)
+			{
+				return NULL;
+			}
+
+			child = split_node (child, prev, common);
+		}
+
+		node = child;
+		pos += common;
+	}
+
+	return node;
+}
+
+/* Frees @node, which is unlinked from the tree. While the removed nodes are
+ * pruned, the freeing is deferred: a removed node which is not pruned yet can
+ * be unlinked meanwhile.
+ */
+static void
+release_node (GtkSourceCompletionWordsLibrary *library,
+	      WordNode                        *node)
+{
+	if (library->priv->dead_nodes != NULL)
+	{
+		node->dead = TRUE;
+		g_ptr_array_add (library->priv->dead_nodes, node);
+	}
+	else
+	{
+		word_node_free (node);
+	}
+}
+
+/* Merges @node, which has no word and only one child, with its child. The
+ * label is allocated with the node, so both are replaced by a new node.
+ * Returns the new node.
+ */
+static WordNode *
+merge_node (GtkSourceCompletionWordsLibrary *library,
+	    WordNode                        *node)
+{
+	WordNode *child = node->first_child;
+	WordNode *parent = node->parent;
+	WordNode *merged;
+	WordNode *prev;
+	WordNode *grandchild;
+
+	g_assert (child != NULL && child->next_sibling == NULL);
+
+	merged = g_malloc0 (sizeof (WordNode) + node->label_len + child->label_len);
+	merged->parent = parent;
+	merged->depth = child->depth;
+	merged->label_len = node->label_len + child->label_len;
+	memcpy (merged->label, node->label, node->label_len);
+	memcpy (merged->label + node->label_len, child->label, child->label_len);
+	merged->label[merged->label_len] = '\0';
+
+	merged->use_count = child->use_count;
+	merged->last_use = child->last_use;
+	merged->first_child = child->first_child;
+
+	for (grandchild = merged->first_child; grandchild != NULL; grandchild = grandchild->next_sibling)
+	{
+		grandchild->parent = merged;
+	}
+
+	if (child->proposal != NULL)
+	{
+		merged->proposal = child->proposal;
+		g_object_remove_weak_pointer (G_OBJECT (child->proposal),
+					      (gpointer *) &child->proposal);
+		g_object_add_weak_pointer (G_OBJECT (merged->proposal),
+					   (gpointer *) &merged->proposal);
+		child->proposal = NULL;
+	}
+
+	find_child (parent, node->label[0], &prev);
+	replace_child (parent, prev, node, merged);
+
+	child->first_child = NULL;
+	node->first_child = NULL;
+	release_node (library, child);
+	release_node (library, node);
+
+	return merged;
+}
+
+/* Restores the invariants after the use count of @node reached 0: frees @node
+ * and its ancestors as long as they are unused leaves, and merges the first
+ * unused ancestor left with one child.
+ */
+static void
+prune_node (GtkSourceCompletionWordsLibrary *library,
+	    WordNode                        *node)
+{
+	while (node != library->priv->root &&
+	       node->use_count == 0)
+	{
+		if (node->first_child == NULL)
+		{
+			WordNode *parent = node->parent;
+
+			unlink_child (node);
+			release_node (library, node);
+
+			node = parent;
+		}
+		else if (node->first_child->next_sibling == NULL)
+		{
+			node = merge_node (library, node);
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+/* The next node in pre-order, staying in the subtree of the words beginning
+ * with a prefix of @len bytes. The root of this subtree is the node whose
+ * parent is shorter than the prefix.
+ */
+static WordNode *
+next_node (WordNode *node,
+	   guint     len)
+{
+	if (node->first_child != NULL)
+	{
+		return node->first_child;
+	}
+
+	while (node->parent != NULL && node->parent->depth >= len)
+	{
+		if (node->next_sibling != NULL)
+		{
+			return node->next_sibling;
+		}
+
+		node = node->parent;
+	}
+
+	return NULL;
+}
+
 static void
 gtk_source_completion_words_library_finalize (GObject *object)
 {
 	GtkSourceCompletionWordsLibrary *library = GTK_SOURCE_COMPLETION_WORDS_LIBRARY (object);
 
-	g_sequence_free (library->priv->store);
+	word_node_free_recursive (library->priv->root);
+	g_ptr_array_free (library->priv->removed_nodes, TRUE);
 
 	G_OBJECT_CLASS (gtk_source_completion_words_library_parent_class)->finalize (object);
 }
@@ -86,7 +493,8 @@ gtk_source_completion_words_library_init (GtkSourceCompletionWordsLibrary *self)
 {
 	self->priv = gtk_source_completion_words_library_get_instance_private (self);
 
-	self->priv->store = g_sequence_new ((GDestroyNotify)g_object_unref);
+	self->priv->root = word_node_new (NULL, "", 0);
+	self->priv->removed_nodes = g_ptr_array_new ();
 }
 
 GtkSourceCompletionWordsLibrary *
@@ -95,66 +503,110 @@ gtk_source_completion_words_library_new (void)
 	return g_object_new (GTK_SOURCE_TYPE_COMPLETION_WORDS_LIBRARY, NULL);
 }
 
-static gint
-compare_full (GtkSourceCompletionWordsProposal *a,
-	      GtkSourceCompletionWordsProposal *b)
+/* Copies the word of @node in @dest, which has room for node->depth bytes. The
+ * labels are concatenated from the end of the word.
+ */
+static void
+copy_node_word (WordNode *node,
+		gchar    *dest)
 {
-	if (a == b)
+	gchar *end = dest + node->depth;
+
+	for (; node->parent != NULL; node = node->parent)
 	{
-		return 0;
+		end -= node->label_len;
+		memcpy (end, node->label, node->label_len);
 	}
-
-	return strcmp (gtk_source_completion_words_proposal_get_word (a),
-	               gtk_source_completion_words_proposal_get_word (b));
 }
 
-static gint
-compare_prefix (GtkSourceCompletionWordsProposal *a,
-		GtkSourceCompletionWordsProposal *b,
-		gpointer                          len)
+/* Returns a new reference to the proposal of the word at @iter. The proposal
+ * is created if needed.
+ */
+GtkSourceCompletionWordsProposal *
+gtk_source_completion_words_library_get_proposal (GtkSourceCompletionWordsLibraryIter *iter)
 {
-	gint prefix_length = GPOINTER_TO_INT (len);
+	WordNode *node = iter;
+	gchar *word;
 
-	return strncmp (gtk_source_completion_words_proposal_get_word (a),
-			gtk_source_completion_words_proposal_get_word (b),
-			prefix_length);
+	if (node == NULL)
+	{
+		return NULL;
+	}
+
+	if (node->proposal != NULL)
+	{
+		return g_object_ref (node->proposal);
+	}
+
+	word = g_malloc (node->depth + 1);
+	copy_node_word (node, word);
+	word[node->depth] = '\0';
+
+	node->proposal = gtk_source_completion_words_proposal_new (word);
+	g_object_add_weak_pointer (G_OBJECT (node->proposal),
+				   (gpointer *) &node->proposal);
+
+	g_free (word);
+	return node->proposal;
 }
 
-static gboolean
-iter_match_prefix (GSequenceIter *iter,
-                   const gchar   *word,
-                   gint           len)
+/* Returns the length in bytes of the word at @iter. */
+guint
+gtk_source_completion_words_library_get_word_length (GtkSourceCompletionWordsLibraryIter *iter)
 {
-	GtkSourceCompletionWordsProposal *item;
+	g_return_val_if_fail (iter != NULL, 0);
 
-	item = gtk_source_completion_words_library_get_proposal (iter);
+	return iter->depth;
+}
+
+/* Sets @word to the word at @iter, without creating its proposal. */
+void
+gtk_source_completion_words_library_get_word (GtkSourceCompletionWordsLibraryIter *iter,
+                                              GString                             *word)
+{
+	g_return_if_fail (iter != NULL);
+	g_return_if_fail (word != NULL);
 
-	return strncmp (gtk_source_completion_words_proposal_get_word (item),
-	                word,
-	                len != -1 ? len : strlen (word)) == 0;
+	g_string_set_size (word, iter->depth);
+	copy_node_word (iter, word->str);
 }
 
-GtkSourceCompletionWordsProposal *
-gtk_source_completion_words_library_get_proposal (GSequenceIter *iter)
+/* Returns the score of the word at @iter, to rank the proposals. */
+guint
+gtk_source_completion_words_library_get_score (GtkSourceCompletionWordsLibrary     *library,
+                                               GtkSourceCompletionWordsLibraryIter *iter)
 {
-	if (iter == NULL)
+	guint age;
+
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_LIBRARY (library), 0);
+	g_return_val_if_fail (iter != NULL, 0);
+
+	if (iter->last_use == 0)
 	{
-		return NULL;
+		return iter->use_count;
 	}
 
-	return GTK_SOURCE_COMPLETION_WORDS_PROPOSAL (g_sequence_get (iter));
+	/* Unsigned arithmetic, correct even if the stamp wrapped around. */
+	age = library->priv->stamp - iter->last_use;
+
+	if (age >= RECENT_WORDS)
+	{
+		return iter->use_count;
+	}
+
+	return iter->use_count + RECENT_WORDS - age;
 }
 
 /* Find the first item in the library with the prefix equal to @word.
- * If no such items exist, returns %NULL.
+ * If no such items exist, returns %NULL. No memory is allocated.
  */
-GSequenceIter *
+GtkSourceCompletionWordsLibraryIter *
 gtk_source_completion_words_library_find_first (GtkSourceCompletionWordsLibrary *library,
                                                 const gchar                     *word,
                                                 gint                             len)
 {
-	GtkSourceCompletionWordsProposal *proposal;
-	GSequenceIter *iter;
+	WordNode *node;
+	guint pos = 0;
 
 	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_LIBRARY (library), NULL);
 	g_return_val_if_fail (word != NULL, NULL);
@@ -164,135 +616,192 @@ gtk_source_completion_words_library_find_first (GtkSourceCompletionWordsLibrary
 		len = strlen (word);
 	}
 
-	proposal = gtk_source_completion_words_proposal_new (word);
+	node = library->priv->root;
 
-	iter = g_sequence_lookup (library->priv->store,
-				  proposal,
-				  (GCompareDataFunc)compare_prefix,
-				  GINT_TO_POINTER (len));
+	/* Find the root of the subtree: the prefix ends in its label. */
+	while (pos < (guint) len)
+	{
+		WordNode *prev;
+		WordNode *child;
+		guint n;
 
-	g_clear_object (&proposal);
+		child = find_child (node, word[pos], &prev);
 
-	if (iter == NULL)
-	{
-		return NULL;
-	}
+		if (child == NULL)
+		{
+			return NULL;
+		}
 
-	while (!g_sequence_iter_is_begin (iter))
-	{
-		GSequenceIter *prev = g_sequence_iter_prev (iter);
+		n = MIN (child->label_len, len - pos);
 
-		if (!iter_match_prefix (prev, word, len))
+		if (memcmp (child->label, word + pos, n) != 0)
 		{
-			break;
+			return NULL;
 		}
 
-		iter = prev;
+		node = child;
+		pos += n;
+	}
+
+	while (node != NULL && node->use_count == 0)
+	{
+		node = next_node (node, len);
 	}
 
-	return iter;
+	return node;
 }
 
-GSequenceIter *
-gtk_source_completion_words_library_find_next (GSequenceIter *iter,
-                                               const gchar   *word,
-                                               gint           len)
+GtkSourceCompletionWordsLibraryIter *
+gtk_source_completion_words_library_find_next (GtkSourceCompletionWordsLibraryIter *iter,
+                                               const gchar                         *word,
+                                               gint                                 len)
 {
+	WordNode *node = iter;
+
 	g_return_val_if_fail (iter != NULL, NULL);
 	g_return_val_if_fail (word != NULL, NULL);
 
-	iter = g_sequence_iter_next (iter);
+	if (len == -1)
+	{
+		len = strlen (word);
+	}
 
-	if (!g_sequence_iter_is_end (iter) &&
-	    iter_match_prefix (iter, word, len))
+	do
 	{
-		return iter;
+		node = next_node (node, len);
 	}
+	while (node != NULL && node->use_count == 0);
 
-	return NULL;
+	return node;
 }
 
-GSequenceIter *
-gtk_source_completion_words_library_find (GtkSourceCompletionWordsLibrary  *library,
-					  GtkSourceCompletionWordsProposal *proposal)
+/* Returns the iter of @word, or %NULL if @word is not in the library. */
+GtkSourceCompletionWordsLibraryIter *
+gtk_source_completion_words_library_find (GtkSourceCompletionWordsLibrary *library,
+					  const gchar                     *word)
 {
-	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_LIBRARY (library), NULL);
-	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_PROPOSAL (proposal), NULL);
+	WordNode *node;
 
-	return g_sequence_lookup (library->priv->store,
-				  proposal,
-				  (GCompareDataFunc)compare_full,
-				  NULL);
-}
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_LIBRARY (library), NULL);
+	g_return_val_if_fail (word != NULL, NULL);
 
-static void
-on_proposal_unused (GtkSourceCompletionWordsProposal *proposal,
-                    GtkSourceCompletionWordsLibrary  *library)
-{
-	GSequenceIter *iter = gtk_source_completion_words_library_find (library,
-	                                                                proposal);
+	node = lookup_node (library, word, FALSE);
 
-	if (iter != NULL)
+	if (node == NULL || node->use_count == 0)
 	{
-		g_sequence_remove (iter);
+		return NULL;
 	}
+
+	return node;
 }
 
-GtkSourceCompletionWordsProposal *
+/* Adds an occurrence of @word. If @recent is %TRUE, the word becomes the most
+ * recently used one, which increases its score. Returns %FALSE if @word is a
+ * new word and the library is locked, in which case it is not added.
+ */
+gboolean
 gtk_source_completion_words_library_add_word (GtkSourceCompletionWordsLibrary *library,
-                                              const gchar                     *word)
+                                              const gchar                     *word,
+                                              gboolean                         recent)
 {
-	GtkSourceCompletionWordsProposal *proposal;
-	GSequenceIter *iter;
-
-	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_LIBRARY (library), NULL);
-	g_return_val_if_fail (word != NULL, NULL);
+	WordNode *node;
 
-	/* Check if word already exists */
-	proposal = gtk_source_completion_words_proposal_new (word);
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_LIBRARY (library), FALSE);
+	g_return_val_if_fail (word != NULL, FALSE);
+	g_return_val_if_fail (word[0] != '\0', FALSE);
 
-	iter = gtk_source_completion_words_library_find (library, proposal);
+	node = lookup_node (library, word, FALSE);
 
-	if (iter != NULL)
+	if (node != NULL && node->use_count > 0)
 	{
-		GtkSourceCompletionWordsProposal *iter_proposal;
-
-		iter_proposal = gtk_source_completion_words_library_get_proposal (iter);
-
 		/* Already exists, increase the use count */
-		gtk_source_completion_words_proposal_use (iter_proposal);
+		node->use_count++;
+	}
+	else if (library->priv->locked)
+	{
+		return FALSE;
+	}
+	else
+	{
+		if (node == NULL)
+		{
+			node = lookup_node (library, word, TRUE);
+		}
 
-		g_object_unref (proposal);
-		return iter_proposal;
+		node->use_count = 1;
 	}
 
-	if (library->priv->locked)
+	if (!recent)
 	{
-		g_object_unref (proposal);
-		return NULL;
+		return TRUE;
 	}
 
-	g_signal_connect (proposal,
-	                  "unused",
-	                  G_CALLBACK (on_proposal_unused),
-	                  library);
+	/* 0 means never used. */
+	if (++library->priv->stamp == 0)
+	{
+		library->priv->stamp = 1;
+	}
 
-	g_sequence_insert_sorted (library->priv->store,
-	                          proposal,
-	                          (GCompareDataFunc)compare_full,
-	                          NULL);
+	node->last_use = library->priv->stamp;
+	return TRUE;
+}
+
+/* Adds @count occurrences of @word at once. The library must not be locked.
+ * Used by the initial scan of a buffer: the word doesn't become recent.
+ */
+void
+gtk_source_completion_words_library_add_word_occurrences (GtkSourceCompletionWordsLibrary *library,
+                                                          const gchar                     *word,
+                                                          guint                            count)
+{
+	WordNode *node;
+
+	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_LIBRARY (library));
+	g_return_if_fail (word != NULL);
+	g_return_if_fail (word[0] != '\0');
+	g_return_if_fail (!library->priv->locked);
+
+	if (count == 0)
+	{
+		return;
+	}
 
-	return proposal;
+	node = lookup_node (library, word, TRUE);
+	node->use_count += count;
 }
 
+/* Removes an occurrence of @word. */
 void
-gtk_source_completion_words_library_remove_word (GtkSourceCompletionWordsLibrary  *library,
-                                                 GtkSourceCompletionWordsProposal *proposal)
+gtk_source_completion_words_library_remove_word (GtkSourceCompletionWordsLibrary *library,
+                                                 const gchar                     *word)
 {
+	WordNode *node;
+
 	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_LIBRARY (library));
-	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_PROPOSAL (proposal));
+	g_return_if_fail (word != NULL);
+
+	node = lookup_node (library, word, FALSE);
+
+	g_return_if_fail (node != NULL && node->use_count > 0);
+
+	node->use_count--;
+
+	if (node->use_count > 0)
+	{
+		return;
+	}
 
-	gtk_source_completion_words_proposal_unuse (proposal);
+	/* A node doesn't become used again while the library is locked, so
+	 * it is recorded only once.
+	 */
+	if (library->priv->locked)
+	{
+		g_ptr_array_add (library->priv->removed_nodes, node);
+	}
+	else
+	{
+		prune_node (library, node);
+	}
 }
 
 void
@@ -310,6 +819,29 @@ gtk_source_completion_words_library_unlock (GtkSourceCompletionWordsLibrary *lib
 	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_LIBRARY (library));
 
 	library->priv->locked = FALSE;
+
+	if (library->priv->removed_nodes->len > 0)
+	{
+		GPtrArray *removed_nodes = library->priv->removed_nodes;
+		guint i;
+
+		library->priv->dead_nodes = g_ptr_array_new_with_free_func ((GDestroyNotify)word_node_free);
+
+		for (i = 0; i < removed_nodes->len; i++)
+		{
+			WordNode *node = g_ptr_array_index (removed_nodes, i);
+
+			if (!node->dead)
+			{
+				prune_node (library, node);
+			}
+		}
+
+		g_ptr_array_set_size (removed_nodes, 0);
+		g_ptr_array_free (library->priv->dead_nodes, TRUE);
+		library->priv->dead_nodes = NULL;
+	}
+
 	g_signal_emit (library, signals[UNLOCK], 0);
 }
 
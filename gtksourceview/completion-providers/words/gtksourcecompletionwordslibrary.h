@@ -39,6 +39,9 @@ typedef struct _GtkSourceCompletionWordsLibrary			GtkSourceCompletionWordsLibrar
 typedef struct _GtkSourceCompletionWordsLibraryClass		GtkSourceCompletionWordsLibraryClass;
 typedef struct _GtkSourceCompletionWordsLibraryPrivate		GtkSourceCompletionWordsLibraryPrivate;
 
+/* Opaque. An iter stays valid while the library is locked. */
+typedef struct _GtkSourceCompletionWordsLibraryIter		GtkSourceCompletionWordsLibraryIter;
+
 struct _GtkSourceCompletionWordsLibrary {
 	GObject parent;
 
@@ -58,33 +61,52 @@ GtkSourceCompletionWordsLibrary *
 
 /* Finding */
 G_GNUC_INTERNAL
-GSequenceIter	*gtk_source_completion_words_library_find 		(GtkSourceCompletionWordsLibrary  *library,
-									 GtkSourceCompletionWordsProposal *proposal);
+GtkSourceCompletionWordsLibraryIter *
+		 gtk_source_completion_words_library_find 		(GtkSourceCompletionWordsLibrary     *library,
+									 const gchar                         *word);
 
 G_GNUC_INTERNAL
-GSequenceIter	*gtk_source_completion_words_library_find_first		(GtkSourceCompletionWordsLibrary  *library,
-									 const gchar                      *word,
-									 gint                              len);
+GtkSourceCompletionWordsLibraryIter *
+		 gtk_source_completion_words_library_find_first		(GtkSourceCompletionWordsLibrary     *library,
+									 const gchar                         *word,
+									 gint                                 len);
 
 G_GNUC_INTERNAL
-GSequenceIter	*gtk_source_completion_words_library_find_next		(GSequenceIter                    *iter,
-									 const gchar                      *word,
-									 gint                              len);
+GtkSourceCompletionWordsLibraryIter *
+		 gtk_source_completion_words_library_find_next		(GtkSourceCompletionWordsLibraryIter *iter,
+									 const gchar                         *word,
+									 gint                                 len);
 
 /* Getting */
 G_GNUC_INTERNAL
 GtkSourceCompletionWordsProposal *
-		 gtk_source_completion_words_library_get_proposal 	(GSequenceIter                    *iter);
+		 gtk_source_completion_words_library_get_proposal 	(GtkSourceCompletionWordsLibraryIter *iter);
+
+G_GNUC_INTERNAL
+guint		 gtk_source_completion_words_library_get_word_length	(GtkSourceCompletionWordsLibraryIter *iter);
+
+G_GNUC_INTERNAL
+void		 gtk_source_completion_words_library_get_word		(GtkSourceCompletionWordsLibraryIter *iter,
+									 GString                             *word);
+
+G_GNUC_INTERNAL
+guint		 gtk_source_completion_words_library_get_score		(GtkSourceCompletionWordsLibrary     *library,
+									 GtkSourceCompletionWordsLibraryIter *iter);
 
 /* Adding/removing */
 G_GNUC_INTERNAL
-GtkSourceCompletionWordsProposal *
-		 gtk_source_completion_words_library_add_word 		(GtkSourceCompletionWordsLibrary  *library,
-                                              				 const gchar                      *word);
+gboolean	 gtk_source_completion_words_library_add_word 		(GtkSourceCompletionWordsLibrary     *library,
+									 const gchar                         *word,
+									 gboolean                             recent);
+
+G_GNUC_INTERNAL
+void		 gtk_source_completion_words_library_add_word_occurrences (GtkSourceCompletionWordsLibrary     *library,
+									 const gchar                         *word,
+									 guint                                count);
 
 G_GNUC_INTERNAL
-void		 gtk_source_completion_words_library_remove_word 	(GtkSourceCompletionWordsLibrary  *library,
-                                                 			 GtkSourceCompletionWordsProposal *proposal);
+void		 gtk_source_completion_words_library_remove_word 	(GtkSourceCompletionWordsLibrary     *library,
+									 const gchar                         *word);
 
 G_GNUC_INTERNAL
 gboolean	 gtk_source_completion_words_library_is_locked 		(GtkSourceCompletionWordsLibrary  *library);
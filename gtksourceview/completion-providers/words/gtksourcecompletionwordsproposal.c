@@ -24,17 +24,8 @@
 struct _GtkSourceCompletionWordsProposalPrivate
 {
 	gchar *word;
-	gint use_count;
 };
 
-enum
-{
-	UNUSED,
-	NUM_SIGNALS
-};
-
-static guint signals[NUM_SIGNALS] = {0,};
-
 static void gtk_source_completion_proposal_iface_init (gpointer g_iface, gpointer iface_data);
 
 G_DEFINE_TYPE_WITH_CODE (GtkSourceCompletionWordsProposal,
@@ -78,24 +69,12 @@ gtk_source_completion_words_proposal_class_init (GtkSourceCompletionWordsProposa
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
 	object_class->finalize = gtk_source_completion_words_proposal_finalize;
-
-	signals[UNUSED] =
-		g_signal_new ("unused",
-		              G_TYPE_FROM_CLASS (klass),
-		              G_SIGNAL_RUN_LAST,
-		              0,
-		              NULL,
-		              NULL,
-		              g_cclosure_marshal_VOID__VOID,
-		              G_TYPE_NONE,
-		              0);
 }
 
 static void
 gtk_source_completion_words_proposal_init (GtkSourceCompletionWordsProposal *self)
 {
 	self->priv = gtk_source_completion_words_proposal_get_instance_private (self);
-	self->priv->use_count = 1;
 }
 
 GtkSourceCompletionWordsProposal *
@@ -108,25 +87,6 @@ gtk_source_completion_words_proposal_new (const gchar *word)
 	return proposal;
 }
 
-void
-gtk_source_completion_words_proposal_use (GtkSourceCompletionWordsProposal *proposal)
-{
-	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_PROPOSAL (proposal));
-
-	g_atomic_int_inc (&proposal->priv->use_count);
-}
-
-void
-gtk_source_completion_words_proposal_unuse (GtkSourceCompletionWordsProposal *proposal)
-{
-	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_WORDS_PROPOSAL (proposal));
-
-	if (g_atomic_int_dec_and_test (&proposal->priv->use_count))
-	{
-		g_signal_emit (proposal, signals[UNUSED], 0);
-	}
-}
-
 const gchar *
 gtk_source_completion_words_proposal_get_word (GtkSourceCompletionWordsProposal *proposal)
 {
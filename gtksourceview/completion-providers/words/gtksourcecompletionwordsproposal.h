@@ -59,12 +59,6 @@ GtkSourceCompletionWordsProposal *
 G_GNUC_INTERNAL
 const gchar 	*gtk_source_completion_words_proposal_get_word 	(GtkSourceCompletionWordsProposal *proposal);
 
-G_GNUC_INTERNAL
-void		 gtk_source_completion_words_proposal_use 	(GtkSourceCompletionWordsProposal *proposal);
-
-G_GNUC_INTERNAL
-void		 gtk_source_completion_words_proposal_unuse 	(GtkSourceCompletionWordsProposal *proposal);
-
 G_END_DECLS
 
 #endif /* __GTK_SOURCE_COMPLETION_WORDS_PROPOSAL_H__ */
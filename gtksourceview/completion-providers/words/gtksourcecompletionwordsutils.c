@@ -40,6 +40,36 @@ valid_start_char (gunichar ch)
 	return !g_unichar_isdigit (ch);
 }
 
+/* Returns the number of bytes of the character at @ch if it is a word
+ * character, 0 otherwise. ASCII is by far the most common case in source code,
+ * it is classified with the GLib ASCII table, without decoding the UTF-8.
+ */
+static inline guint
+get_word_char_length (const gchar *ch)
+{
+	guchar byte = (guchar) *ch;
+
+	if (byte < 0x80)
+	{
+		return (g_ascii_isalnum (byte) || byte == '_') ? 1 : 0;
+	}
+
+	return valid_word_char (g_utf8_get_char (ch)) ? g_utf8_skip[byte] : 0;
+}
+
+static inline gboolean
+valid_word_start (const gchar *word)
+{
+	guchar byte = (guchar) *word;
+
+	if (byte < 0x80)
+	{
+		return !g_ascii_isdigit (byte);
+	}
+
+	return valid_start_char (g_utf8_get_char (word));
+}
+
 /* Find the next word in @text, beginning at the index @start_idx.
  * Use only valid_word_char() to find the word boundaries.
  * Store in @start_idx and @end_idx the word boundaries. The character at
@@ -53,46 +83,34 @@ find_next_word (gchar *text,
 		guint *start_idx,
 		guint *end_idx)
 {
-	gchar *cur_char;
+	gchar *cur_char = text + *start_idx;
+	guint char_length;
 
 	/* Find the start of the next word */
 
-	cur_char = text + *start_idx;
-
-	while (TRUE)
+	while ((char_length = get_word_char_length (cur_char)) == 0)
 	{
-		gunichar ch = g_utf8_get_char (cur_char);
-
-		if (ch == '\0')
+		if (*cur_char == '\0')
 		{
 			return FALSE;
 		}
 
-		if (valid_word_char (ch))
-		{
-			*start_idx = cur_char - text;
-			break;
-		}
-
 		cur_char = g_utf8_next_char (cur_char);
 	}
 
+	*start_idx = cur_char - text;
+
 	/* Find the end of the word */
 
-	while (TRUE)
+	do
 	{
-		gunichar ch;
-
-		cur_char = g_utf8_next_char (cur_char);
-		ch = g_utf8_get_char (cur_char);
-
-		if (ch == '\0' ||
-		    !valid_word_char (ch))
-		{
-			*end_idx = cur_char - text;
-			return TRUE;
-		}
+		cur_char += char_length;
+		char_length = get_word_char_length (cur_char);
 	}
+	while (char_length != 0);
+
+	*end_idx = cur_char - text;
+	return TRUE;
 }
 
 /* Get the list of words in @text.
@@ -110,12 +128,11 @@ _gtk_source_completion_words_utils_scan_words (gchar *text,
 	while (find_next_word (text, &start_idx, &end_idx))
 	{
 		gint word_size = end_idx - start_idx;
-		gunichar ch = g_utf8_get_char (text + start_idx);
 
 		g_assert (word_size >= 0);
 
 		if (word_size >= minimum_word_size &&
-		    valid_start_char (ch))
+		    valid_word_start (text + start_idx))
 		{
 			gchar *new_word = g_strndup (text + start_idx, word_size);
 			words = g_slist_prepend (words, new_word);
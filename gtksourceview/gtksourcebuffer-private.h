@@ -46,6 +46,14 @@ GtkSourceMark		*_gtk_source_buffer_source_mark_prev		(GtkSourceBuffer        *bu
 G_GNUC_INTERNAL
 GtkTextTag		*_gtk_source_buffer_get_bracket_match_tag	(GtkSourceBuffer        *buffer);
 
+G_GNUC_INTERNAL
+gboolean		 _gtk_source_buffer_get_batch_edit_region	(GtkSourceBuffer        *buffer,
+									 GtkTextIter            *start,
+									 GtkTextIter            *end);
+
+G_GNUC_INTERNAL
+gboolean		 _gtk_source_buffer_is_highlighting_deferred	(GtkSourceBuffer        *buffer);
+
 G_GNUC_INTERNAL
 void			 _gtk_source_buffer_add_search_context		(GtkSourceBuffer        *buffer,
 									 GtkSourceSearchContext *search_context);
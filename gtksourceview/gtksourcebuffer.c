@@ -143,6 +143,8 @@
 enum {
 	HIGHLIGHT_UPDATED,
 	SOURCE_MARK_UPDATED,
+	SOURCE_MARKS_UPDATED,
+	BATCH_EDIT_FINISHED,
 	UNDO,
 	REDO,
 	BRACKET_MATCHED,
@@ -157,6 +159,7 @@ enum {
 	PROP_HIGHLIGHT_SYNTAX,
 	PROP_HIGHLIGHT_MATCHING_BRACKETS,
 	PROP_MAX_UNDO_LEVELS,
+	PROP_MAX_UNDO_SIZE,
 	PROP_LANGUAGE,
 	PROP_STYLE_SCHEME,
 	PROP_UNDO_MANAGER
@@ -169,7 +172,33 @@ struct _GtkSourceBufferPrivate
 	GtkTextMark           *bracket_mark_match;
 	GtkSourceBracketMatchType bracket_match;
 
-	GArray                *source_marks;
+	/* All the source marks, and the source marks of each category
+	 * (category -> GSequence), sorted by position.
+	 */
+	GSequence             *source_marks;
+	GHashTable            *source_marks_per_category;
+
+	/* During a bulk operation on source marks, the lines range of the
+	 * modified marks, to emit ::source-marks-updated only once.
+	 */
+	guint                  source_marks_batch_depth;
+	gint                   source_marks_batch_start_line;
+	gint                   source_marks_batch_end_line;
+
+	/* During a batch edit, the region containing all the text changes,
+	 * as character offsets in the current text, and the difference
+	 * between the current and the old lengths of the region.
+	 * batch_edit_start is -1 while the text has not changed.
+	 */
+	guint                  batch_edit_depth;
+	gint                   batch_edit_start;
+	gint                   batch_edit_end;
+	gint                   batch_edit_delta;
+
+	/* The highlight engine has been created during the batch edit, so it
+	 * is notified of each change, as it doesn't know the old text.
+	 */
+	guint                  batch_edit_new_engine : 1;
 
 	GtkSourceLanguage     *language;
 
@@ -178,6 +207,7 @@ struct _GtkSourceBufferPrivate
 
 	GtkSourceUndoManager  *undo_manager;
 	gint                   max_undo_levels;
+	gint                   max_undo_size;
 
 	GList                 *search_contexts;
 
@@ -237,6 +267,8 @@ static gboolean	 gtk_source_buffer_find_bracket_match_with_limit (GtkSourceBuffe
 static void	 gtk_source_buffer_real_undo		(GtkSourceBuffer	 *buffer);
 static void	 gtk_source_buffer_real_redo		(GtkSourceBuffer	 *buffer);
 
+static GQuark	 get_source_mark_nodes_quark		(void);
+
 static void
 gtk_source_buffer_constructed (GObject *object)
 {
@@ -326,6 +358,28 @@ gtk_source_buffer_class_init (GtkSourceBufferClass *klass)
 							   1000,
 							   G_PARAM_READWRITE));
 
+	/**
+	 * GtkSourceBuffer:max-undo-size:
+	 *
+	 * Maximum number of bytes of text kept in the undo history. When the
+	 * history exceeds this size, the oldest undo levels are discarded
+	 * (but the most recent one is always kept), and the text of the old
+	 * actions is compressed. -1 means no limit. This property will only
+	 * affect the default undo manager.
+	 *
+	 * Since: 3.10
+	 */
+	g_object_class_install_property (object_class,
+					 PROP_MAX_UNDO_SIZE,
+					 g_param_spec_int ("max-undo-size",
+							   _("Maximum Undo Size"),
+							   _("Maximum number of bytes of "
+							     "text in the undo history"),
+							   -1,
+							   G_MAXINT,
+							   -1,
+							   G_PARAM_READWRITE));
+
 	g_object_class_install_property (object_class,
 					 PROP_LANGUAGE,
 					 g_param_spec_object ("language",
@@ -395,7 +449,9 @@ gtk_source_buffer_class_init (GtkSourceBufferClass *klass)
 	 * @mark: the #GtkSourceMark
 	 *
 	 * The ::source_mark_updated signal is emitted each time
-	 * a mark is added to, moved or removed from the @buffer.
+	 * a mark is added to, moved or removed from the @buffer, except
+	 * for the marks added by gtk_source_buffer_create_source_marks() (see
+	 * #GtkSourceBuffer::source-marks-updated).
 	 **/
 	buffer_signals[SOURCE_MARK_UPDATED] =
 	    g_signal_new ("source_mark_updated",
@@ -407,6 +463,53 @@ gtk_source_buffer_class_init (GtkSourceBufferClass *klass)
 			   G_TYPE_NONE,
 			   1, GTK_TYPE_TEXT_MARK);
 
+	/**
+	 * GtkSourceBuffer::source-marks-updated:
+	 * @buffer: the buffer that received the signal
+	 * @start: the start of the updated region
+	 * @end: the end of the updated region
+	 *
+	 * The ::source_marks_updated signal is emitted once after
+	 * gtk_source_buffer_create_source_marks(), instead of the
+	 * ::source-mark-updated signal for each new mark.
+	 *
+	 * Since: 3.10
+	 **/
+	buffer_signals[SOURCE_MARKS_UPDATED] =
+	    g_signal_newv ("source_marks_updated",
+			   G_OBJECT_CLASS_TYPE (object_class),
+			   G_SIGNAL_RUN_LAST,
+			   NULL,
+			   NULL, NULL,
+			   _gtksourceview_marshal_VOID__BOXED_BOXED,
+			   G_TYPE_NONE,
+			   2, param_types);
+
+	/**
+	 * GtkSourceBuffer::batch-edit-finished:
+	 * @buffer: the buffer that received the signal
+	 * @start: the start of the modified region
+	 * @end: the end of the modified region
+	 *
+	 * The ::batch-edit-finished signal is emitted when the outermost batch
+	 * edit ends, if the text has been modified. All the text changes done
+	 * during the batch edit are between @start and @end, which can be
+	 * equal if text has only been removed.
+	 *
+	 * See gtk_source_buffer_begin_batch_edit().
+	 *
+	 * Since: 3.10
+	 */
+	buffer_signals[BATCH_EDIT_FINISHED] =
+	    g_signal_newv ("batch-edit-finished",
+			   G_OBJECT_CLASS_TYPE (object_class),
+			   G_SIGNAL_RUN_LAST,
+			   NULL,
+			   NULL, NULL,
+			   _gtksourceview_marshal_VOID__BOXED_BOXED,
+			   G_TYPE_NONE,
+			   2, param_types);
+
 	buffer_signals[UNDO] =
 	    g_signal_new ("undo",
 			  G_OBJECT_CLASS_TYPE (object_class),
@@ -514,8 +617,16 @@ gtk_source_buffer_init (GtkSourceBuffer *buffer)
 	priv->bracket_mark_cursor = NULL;
 	priv->bracket_mark_match = NULL;
 	priv->bracket_match = GTK_SOURCE_BRACKET_MATCH_NONE;
-
-	priv->source_marks = g_array_new (FALSE, FALSE, sizeof (GtkSourceMark *));
+	priv->max_undo_size = -1;
+
+	priv->source_marks = g_sequence_new (NULL);
+	priv->source_marks_per_category = g_hash_table_new_full (g_str_hash,
+								 g_str_equal,
+								 g_free,
+								 (GDestroyNotify) g_sequence_free);
+	priv->source_marks_batch_start_line = -1;
+	priv->source_marks_batch_end_line = -1;
+	priv->batch_edit_start = -1;
 	priv->style_scheme = _gtk_source_style_scheme_get_default ();
 
 	if (priv->style_scheme != NULL)
@@ -535,8 +646,25 @@ gtk_source_buffer_finalize (GObject *object)
 	buffer = GTK_SOURCE_BUFFER (object);
 	g_return_if_fail (buffer->priv != NULL);
 
-	if (buffer->priv->source_marks)
-		g_array_free (buffer->priv->source_marks, TRUE);
+	if (buffer->priv->source_marks != NULL)
+	{
+		GSequenceIter *node;
+
+		for (node = g_sequence_get_begin_iter (buffer->priv->source_marks);
+		     !g_sequence_iter_is_end (node);
+		     node = g_sequence_iter_next (node))
+		{
+			GObject *mark = g_sequence_get (node);
+
+			g_object_set_qdata (mark, get_source_mark_nodes_quark (), NULL);
+			g_object_unref (mark);
+		}
+
+		g_sequence_free (buffer->priv->source_marks);
+	}
+
+	if (buffer->priv->source_marks_per_category != NULL)
+		g_hash_table_destroy (buffer->priv->source_marks_per_category);
 
 	G_OBJECT_CLASS (gtk_source_buffer_parent_class)->finalize (object);
 }
@@ -610,6 +738,11 @@ gtk_source_buffer_set_property (GObject      *object,
 							       g_value_get_int (value));
 			break;
 
+		case PROP_MAX_UNDO_SIZE:
+			gtk_source_buffer_set_max_undo_size (source_buffer,
+							     g_value_get_int (value));
+			break;
+
 		case PROP_LANGUAGE:
 			gtk_source_buffer_set_language (source_buffer,
 							g_value_get_object (value));
@@ -660,6 +793,11 @@ gtk_source_buffer_get_property (GObject    *object,
 					 source_buffer->priv->max_undo_levels);
 			break;
 
+		case PROP_MAX_UNDO_SIZE:
+			g_value_set_int (value,
+					 source_buffer->priv->max_undo_size);
+			break;
+
 		case PROP_LANGUAGE:
 			g_value_set_object (value, source_buffer->priv->language);
 			break;
@@ -963,6 +1101,61 @@ gtk_source_buffer_move_cursor (GtkTextBuffer     *buffer,
 	}
 }
 
+/* Adds a text insertion to the region of the current batch edit. */
+static void
+batch_edit_add_insertion (GtkSourceBuffer *buffer,
+			  gint             offset,
+			  gint             length)
+{
+	GtkSourceBufferPrivate *priv = buffer->priv;
+
+	if (priv->batch_edit_start == -1)
+	{
+		priv->batch_edit_start = offset;
+		priv->batch_edit_end = offset + length;
+		priv->batch_edit_delta = length;
+		return;
+	}
+
+	/* The insertion moves the end, and also the start if the text is
+	 * inserted before.
+	 */
+	priv->batch_edit_start = MIN (priv->batch_edit_start, offset);
+
+	if (offset <= priv->batch_edit_end)
+		priv->batch_edit_end += length;
+	else
+		priv->batch_edit_end = offset + length;
+
+	priv->batch_edit_delta += length;
+}
+
+/* Adds a text deletion to the region of the current batch edit. */
+static void
+batch_edit_add_deletion (GtkSourceBuffer *buffer,
+			 gint             offset,
+			 gint             length)
+{
+	GtkSourceBufferPrivate *priv = buffer->priv;
+
+	if (priv->batch_edit_start == -1)
+	{
+		priv->batch_edit_start = offset;
+		priv->batch_edit_end = offset;
+		priv->batch_edit_delta = -length;
+		return;
+	}
+
+	priv->batch_edit_start = MIN (priv->batch_edit_start, offset);
+
+	if (priv->batch_edit_end >= offset + length)
+		priv->batch_edit_end -= length;
+	else
+		priv->batch_edit_end = MAX (priv->batch_edit_end, offset);
+
+	priv->batch_edit_delta -= length;
+}
+
 static void
 gtk_source_buffer_content_inserted (GtkTextBuffer *buffer,
 				    gint           start_offset,
@@ -976,7 +1169,12 @@ gtk_source_buffer_content_inserted (GtkTextBuffer *buffer,
 	gtk_text_buffer_get_iter_at_mark (buffer, &insert_iter, mark);
 	gtk_source_buffer_move_cursor (buffer, &insert_iter, mark);
 
-	if (source_buffer->priv->highlight_engine != NULL)
+	/* During a batch edit, the engine is notified at the end. */
+	if (source_buffer->priv->batch_edit_depth > 0)
+		batch_edit_add_insertion (source_buffer, start_offset, end_offset - start_offset);
+
+	if (source_buffer->priv->highlight_engine != NULL &&
+	    !_gtk_source_buffer_is_highlighting_deferred (source_buffer))
 		_gtk_source_engine_text_inserted (source_buffer->priv->highlight_engine,
 						  start_offset,
 						  end_offset);
@@ -1092,7 +1290,11 @@ gtk_source_buffer_real_delete_range (GtkTextBuffer *buffer,
 	gtk_source_buffer_move_cursor (buffer, &iter, mark);
 
 	/* emit text deleted for engines */
-	if (source_buffer->priv->highlight_engine != NULL)
+	if (source_buffer->priv->batch_edit_depth > 0)
+		batch_edit_add_deletion (source_buffer, offset, length);
+
+	if (source_buffer->priv->highlight_engine != NULL &&
+	    !_gtk_source_buffer_is_highlighting_deferred (source_buffer))
 		_gtk_source_engine_text_deleted (source_buffer->priv->highlight_engine,
 						 offset, length);
 }
@@ -1359,6 +1561,152 @@ gtk_source_buffer_set_max_undo_levels (GtkSourceBuffer *buffer,
 	g_object_notify (G_OBJECT (buffer), "max-undo-levels");
 }
 
+/**
+ * gtk_source_buffer_get_max_undo_size:
+ * @buffer: a #GtkSourceBuffer.
+ *
+ * Returns: the maximum number of bytes of text kept in the undo history, or
+ * -1 if no limit is set.
+ *
+ * Since: 3.10
+ */
+gint
+gtk_source_buffer_get_max_undo_size (GtkSourceBuffer *buffer)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), 0);
+
+	return buffer->priv->max_undo_size;
+}
+
+/**
+ * gtk_source_buffer_set_max_undo_size:
+ * @buffer: a #GtkSourceBuffer.
+ * @max_undo_size: the desired maximum number of bytes, or -1.
+ *
+ * Sets the maximum number of bytes of text (inserted or deleted) that the
+ * default undo manager keeps in its history. This limit is enforced in
+ * addition to #GtkSourceBuffer:max-undo-levels: when the history exceeds it,
+ * the oldest undo levels are discarded, except the most recent one. So a big
+ * paste followed by its deletion doesn't keep two copies of the pasted text.
+ *
+ * With a limit, the text of the old actions is also compressed, so more undo
+ * levels fit in the same memory.
+ *
+ * If @max_undo_size is -1, no limit is set.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_buffer_set_max_undo_size (GtkSourceBuffer *buffer,
+				     gint             max_undo_size)
+{
+	g_return_if_fail (GTK_SOURCE_IS_BUFFER (buffer));
+	g_return_if_fail (max_undo_size >= -1);
+
+	if (buffer->priv->max_undo_size == max_undo_size)
+	{
+		return;
+	}
+
+	buffer->priv->max_undo_size = max_undo_size;
+
+	if (GTK_SOURCE_IS_UNDO_MANAGER_DEFAULT (buffer->priv->undo_manager))
+	{
+		gtk_source_undo_manager_default_set_max_undo_size (GTK_SOURCE_UNDO_MANAGER_DEFAULT (buffer->priv->undo_manager),
+		                                                   max_undo_size);
+	}
+
+	g_object_notify (G_OBJECT (buffer), "max-undo-size");
+}
+
+/**
+ * gtk_source_buffer_save_undo_history:
+ * @buffer: a #GtkSourceBuffer.
+ * @file: the file where to save the undo history.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @error: a #GError, or %NULL.
+ *
+ * Saves the undo history of @buffer in @file, in a compact format, with a
+ * checksum of the buffer contents. The history can be restored with
+ * gtk_source_buffer_load_undo_history() when the same contents is reopened,
+ * typically when the buffer is saved or closed.
+ *
+ * Only the default undo manager supports this function.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurred.
+ *
+ * Since: 3.10
+ */
+gboolean
+gtk_source_buffer_save_undo_history (GtkSourceBuffer  *buffer,
+				     GFile            *file,
+				     GCancellable     *cancellable,
+				     GError          **error)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), FALSE);
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!GTK_SOURCE_IS_UNDO_MANAGER_DEFAULT (buffer->priv->undo_manager))
+	{
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+				     _("Only the default undo manager can save its history."));
+		return FALSE;
+	}
+
+	return gtk_source_undo_manager_default_save_history (GTK_SOURCE_UNDO_MANAGER_DEFAULT (buffer->priv->undo_manager),
+							     file,
+							     cancellable,
+							     error);
+}
+
+/**
+ * gtk_source_buffer_load_undo_history:
+ * @buffer: a #GtkSourceBuffer.
+ * @file: a file saved with gtk_source_buffer_save_undo_history().
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @error: a #GError, or %NULL.
+ *
+ * Replaces the undo history of @buffer by the one saved in @file. Call this
+ * function after the buffer contents has been loaded.
+ *
+ * The history is loaded lazily: only the header of @file is read by this
+ * function, so it is fast even for a big history. The actions are read the
+ * first time they are needed, i.e. on the first undo, redo or modification
+ * of the buffer. At that time, if the buffer contents doesn't match the
+ * checksum saved in @file, the history is discarded.
+ *
+ * Only the default undo manager supports this function.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurred.
+ *
+ * Since: 3.10
+ */
+gboolean
+gtk_source_buffer_load_undo_history (GtkSourceBuffer  *buffer,
+				     GFile            *file,
+				     GCancellable     *cancellable,
+				     GError          **error)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), FALSE);
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!GTK_SOURCE_IS_UNDO_MANAGER_DEFAULT (buffer->priv->undo_manager))
+	{
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+				     _("Only the default undo manager can load a history."));
+		return FALSE;
+	}
+
+	return gtk_source_undo_manager_default_load_history (GTK_SOURCE_UNDO_MANAGER_DEFAULT (buffer->priv->undo_manager),
+							     file,
+							     cancellable,
+							     error);
+}
+
 /**
  * gtk_source_buffer_begin_not_undoable_action:
  * @buffer: a #GtkSourceBuffer.
@@ -1396,6 +1744,165 @@ gtk_source_buffer_end_not_undoable_action (GtkSourceBuffer *buffer)
 	gtk_source_undo_manager_end_not_undoable_action (buffer->priv->undo_manager);
 }
 
+/**
+ * gtk_source_buffer_begin_batch_edit:
+ * @buffer: a #GtkSourceBuffer.
+ *
+ * Marks the beginning of a batch edit, typically a lot of insertions and
+ * deletions done by a script or a plugin.
+ *
+ * The text is modified as usual during a batch edit, but the objects which
+ * analyze the buffer contents (the syntax highlighting engine, the
+ * #GtkSourceSearchContext<!-- -->s and the words completion provider) don't
+ * update their state after each change. When the last batch edit ends, they
+ * update once the region containing all the changes, and the
+ * #GtkSourceBuffer::batch-edit-finished signal is emitted. Other objects
+ * doing expensive work on each change can do the same, see
+ * gtk_source_buffer_is_in_batch_edit().
+ *
+ * You may nest gtk_source_buffer_begin_batch_edit() /
+ * gtk_source_buffer_end_batch_edit() blocks.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_buffer_begin_batch_edit (GtkSourceBuffer *buffer)
+{
+	g_return_if_fail (GTK_SOURCE_IS_BUFFER (buffer));
+
+	buffer->priv->batch_edit_depth++;
+}
+
+/**
+ * gtk_source_buffer_end_batch_edit:
+ * @buffer: a #GtkSourceBuffer.
+ *
+ * Marks the end of a batch edit. See gtk_source_buffer_begin_batch_edit().
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_buffer_end_batch_edit (GtkSourceBuffer *buffer)
+{
+	GtkSourceBufferPrivate *priv;
+	GtkTextIter start;
+	GtkTextIter end;
+	gint start_offset;
+	gint end_offset;
+	gint old_length;
+	gboolean new_engine;
+
+	g_return_if_fail (GTK_SOURCE_IS_BUFFER (buffer));
+
+	priv = buffer->priv;
+
+	g_return_if_fail (priv->batch_edit_depth > 0);
+
+	if (--priv->batch_edit_depth > 0)
+	{
+		return;
+	}
+
+	new_engine = priv->batch_edit_new_engine;
+	priv->batch_edit_new_engine = FALSE;
+
+	if (priv->batch_edit_start == -1)
+	{
+		return;
+	}
+
+	start_offset = priv->batch_edit_start;
+	end_offset = priv->batch_edit_end;
+	old_length = end_offset - start_offset - priv->batch_edit_delta;
+
+	priv->batch_edit_start = -1;
+
+	/* As if the old text of the region was replaced by the new one. */
+	if (priv->highlight_engine != NULL && !new_engine)
+	{
+		if (old_length > 0)
+		{
+			_gtk_source_engine_text_deleted (priv->highlight_engine,
+							 start_offset,
+							 old_length);
+		}
+
+		if (end_offset > start_offset)
+		{
+			_gtk_source_engine_text_inserted (priv->highlight_engine,
+							  start_offset,
+							  end_offset);
+		}
+	}
+
+	gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (buffer), &start, start_offset);
+	gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (buffer), &end, end_offset);
+
+	g_signal_emit (buffer, buffer_signals[BATCH_EDIT_FINISHED], 0, &start, &end);
+}
+
+/**
+ * gtk_source_buffer_is_in_batch_edit:
+ * @buffer: a #GtkSourceBuffer.
+ *
+ * Returns: whether a batch edit is in progress.
+ * Since: 3.10
+ */
+gboolean
+gtk_source_buffer_is_in_batch_edit (GtkSourceBuffer *buffer)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), FALSE);
+
+	return buffer->priv->batch_edit_depth > 0;
+}
+
+/* Gets the region containing the text changes done so far during the current
+ * batch edit. Returns FALSE if there is no batch edit, or if the text has not
+ * changed yet. @start and @end can be %NULL.
+ */
+gboolean
+_gtk_source_buffer_get_batch_edit_region (GtkSourceBuffer *buffer,
+					  GtkTextIter     *start,
+					  GtkTextIter     *end)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), FALSE);
+
+	if (buffer->priv->batch_edit_depth == 0 ||
+	    buffer->priv->batch_edit_start == -1)
+	{
+		return FALSE;
+	}
+
+	if (start != NULL)
+	{
+		gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (buffer),
+						    start,
+						    buffer->priv->batch_edit_start);
+	}
+
+	if (end != NULL)
+	{
+		gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (buffer),
+						    end,
+						    buffer->priv->batch_edit_end);
+	}
+
+	return TRUE;
+}
+
+/* Returns whether the highlight engine is notified of the text changes only at
+ * the end of the current batch edit, in which case it must not analyze the
+ * buffer in the meantime.
+ */
+gboolean
+_gtk_source_buffer_is_highlighting_deferred (GtkSourceBuffer *buffer)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), FALSE);
+
+	return (buffer->priv->batch_edit_depth > 0 &&
+		!buffer->priv->batch_edit_new_engine);
+}
+
 /**
  * gtk_source_buffer_get_highlight_matching_brackets:
  * @buffer: a #GtkSourceBuffer.
@@ -1543,6 +2050,9 @@ gtk_source_buffer_set_language (GtkSourceBuffer   *buffer,
 
 		if (buffer->priv->highlight_engine)
 		{
+			if (buffer->priv->batch_edit_depth > 0)
+				buffer->priv->batch_edit_new_engine = TRUE;
+
 			_gtk_source_engine_attach_buffer (buffer->priv->highlight_engine,
 							  GTK_TEXT_BUFFER (buffer));
 
@@ -1690,164 +2200,266 @@ gtk_source_buffer_get_style_scheme (GtkSourceBuffer *buffer)
 
 /* Source Marks functionality */
 
-/* At the moment this is pretty dumb (O(N)), if it is a performance
- * problem we should change data struct.
- * Since it's used from mark_set when the mark was moved, we cannot bsearch.
- * Returns TRUE if the mark was found and removed */
-static gboolean
-source_mark_remove (GtkSourceBuffer *buffer, GtkSourceMark *mark)
+/* The source marks are stored in GSequence's (balanced trees) sorted by
+ * position: one for all the marks, and one per category. The position of a
+ * mark is not stored, it is retrieved from the GtkTextBuffer when needed, so
+ * the trees don't need to be updated when the text is modified: the relative
+ * order of the marks doesn't change. When a mark is moved, it is removed and
+ * re-inserted at the right place. Each mark keeps its nodes in the trees
+ * (see SourceMarkNodes), so it can be found in O(1).
+ */
+
+typedef struct
 {
-	guint i;
+	GSequenceIter *node;
+	GSequenceIter *category_node;
+} SourceMarkNodes;
 
-	for (i = 0; i < buffer->priv->source_marks->len; ++i)
-	{
-		GtkSourceMark *m;
+/* Key to search a position in the source marks trees. */
+typedef struct
+{
+	GtkTextBuffer *buffer;
+	GtkTextIter iter;
 
-		m = g_array_index (buffer->priv->source_marks, GtkSourceMark *, i);
-		if (mark == m)
-		{
-			g_array_remove_index (buffer->priv->source_marks, i);
-			g_object_unref (m);
+	/* Whether the key is placed after the marks at the same position. */
+	gboolean after_equal;
+} SourceMarkKey;
 
-			return TRUE;
-		}
+static GQuark
+get_source_mark_nodes_quark (void)
+{
+	static GQuark quark = 0;
+
+	if (G_UNLIKELY (quark == 0))
+	{
+		quark = g_quark_from_static_string ("gtk-source-buffer-mark-nodes");
 	}
 
-	return FALSE;
+	return quark;
+}
+
+static SourceMarkNodes *
+get_source_mark_nodes (GtkSourceMark *mark)
+{
+	return g_object_get_qdata (G_OBJECT (mark), get_source_mark_nodes_quark ());
+}
+
+static void
+source_mark_nodes_free (SourceMarkNodes *nodes)
+{
+	g_slice_free (SourceMarkNodes, nodes);
 }
 
-/* Performs a binary search among the source marks in @buffer for the
- * position of the @iter.  Returns the index of the mark at the specified
- * position or nearest before or after depending on @before.
- *
- * Return value: an index in the source marks array or -1 if the array is
- * empty or if there is no mark before/after the specified position
- */
 static gint
-source_mark_bsearch (GtkSourceBuffer *buffer, GtkTextIter *iter, gboolean before)
+compare_source_mark_to_key (GtkSourceMark *mark,
+			    SourceMarkKey *key)
 {
-	GArray *marks = buffer->priv->source_marks;
-	GtkSourceMark *check;
-	GtkTextIter check_iter, found_iter;
-	gint cmp, i, min, max;
+	GtkTextIter mark_iter;
+	gint cmp;
 
-	if (marks->len == 0)
-		return -1;
+	gtk_text_buffer_get_iter_at_mark (key->buffer,
+					  &mark_iter,
+					  GTK_TEXT_MARK (mark));
+
+	cmp = gtk_text_iter_compare (&mark_iter, &key->iter);
 
-	i = min = 0;
-	max = marks->len - 1;
-	while (max >= min)
+	if (cmp == 0)
 	{
-		i = (min + max) >> 1;
-		check = g_array_index (marks, GtkSourceMark *, i);
-		gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
-						  &check_iter,
-						  GTK_TEXT_MARK (check));
-		cmp = gtk_text_iter_compare (iter, &check_iter);
-		if (cmp < 0)
-		{
-			max = i - 1;
-		}
-		else if (cmp > 0)
-		{
-			min = i + 1;
-		}
-		else
-			break;
+		return key->after_equal ? -1 : 1;
 	}
 
-	if (before)
-	{
-		/* if the binary search match is after the specified iter, go back */
-		while (cmp < 0 && i >= 0)
-		{
-			if (i == 0)
-				return -1;
-
-			i--;
-			check = g_array_index (marks, GtkSourceMark *, i);
-			gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
-							  &check_iter,
-							  GTK_TEXT_MARK (check));
-			cmp = gtk_text_iter_compare (iter, &check_iter);
-		}
+	return cmp;
+}
 
-		/* if there are many marks at the given iter, return the last */
-		found_iter = check_iter;
-		while (i < marks->len - 1)
-		{
-			check = g_array_index (marks, GtkSourceMark *, i + 1);
-			gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
-							  &check_iter,
-							  GTK_TEXT_MARK (check));
-			cmp = gtk_text_iter_compare (&found_iter, &check_iter);
-			if (cmp != 0)
-			{
-				break;
-			}
-			i++;
-		}
+static gint
+source_mark_key_cmp (gconstpointer a,
+		     gconstpointer b,
+		     gpointer      key)
+{
+	if (a == key)
+	{
+		return -compare_source_mark_to_key ((GtkSourceMark *) b, key);
 	}
-	else
+
+	return compare_source_mark_to_key ((GtkSourceMark *) a, key);
+}
+
+/* Returns the position in @marks where a mark at @iter would be inserted,
+ * before or after the marks already at @iter depending on @after_equal.
+ */
+static GSequenceIter *
+source_mark_search (GtkSourceBuffer   *buffer,
+		    GSequence         *marks,
+		    const GtkTextIter *iter,
+		    gboolean           after_equal)
+{
+	SourceMarkKey key;
+
+	key.buffer = GTK_TEXT_BUFFER (buffer);
+	key.iter = *iter;
+	key.after_equal = after_equal;
+
+	return g_sequence_search (marks, &key, source_mark_key_cmp, &key);
+}
+
+/* Returns the node of the first mark at or after @iter, or NULL. */
+static GSequenceIter *
+source_mark_search_first_after (GtkSourceBuffer   *buffer,
+				GSequence         *marks,
+				const GtkTextIter *iter)
+{
+	GSequenceIter *node = source_mark_search (buffer, marks, iter, FALSE);
+
+	return g_sequence_iter_is_end (node) ? NULL : node;
+}
+
+/* Returns the marks of @category, or all the marks if @category is NULL.
+ * Returns NULL if there is no mark of @category.
+ */
+static GSequence *
+get_source_marks (GtkSourceBuffer *buffer,
+		  const gchar     *category)
+{
+	if (category == NULL)
 	{
-		/* if the binary search match is before the specified iter, go forward */
-		while (cmp > 0 && i < marks->len)
-		{
-			if (i == marks->len - 1)
-				return -1;
-
-			i++;
-			check = g_array_index (marks, GtkSourceMark *, i);
-			gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
-							  &check_iter,
-							  GTK_TEXT_MARK (check));
-			cmp = gtk_text_iter_compare (iter, &check_iter);
-		}
+		return buffer->priv->source_marks;
+	}
 
-		/* if there are many marks at the given iter, return the first */
-		found_iter = check_iter;
-		while (i > 0)
-		{
-			check = g_array_index (marks, GtkSourceMark *, i - 1);
-			gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
-							  &check_iter,
-							  GTK_TEXT_MARK (check));
-			cmp = gtk_text_iter_compare (&found_iter, &check_iter);
-			if (cmp != 0)
-			{
-				break;
-			}
-			i--;
-		}
+	return g_hash_table_lookup (buffer->priv->source_marks_per_category, category);
+}
+
+static gboolean
+source_marks_is_empty (GSequence *marks)
+{
+	return (marks == NULL ||
+		g_sequence_iter_is_end (g_sequence_get_begin_iter (marks)));
+}
+
+/* Returns TRUE if the mark was found and removed. */
+static gboolean
+source_mark_remove (GtkSourceBuffer *buffer, GtkSourceMark *mark)
+{
+	SourceMarkNodes *nodes = get_source_mark_nodes (mark);
+
+	if (nodes == NULL)
+	{
+		return FALSE;
 	}
 
-	return i;
+	g_sequence_remove (nodes->node);
+	g_sequence_remove (nodes->category_node);
+
+	/* The per-category trees are kept even if empty, the number of
+	 * categories is small.
+	 */
+
+	g_object_set_qdata (G_OBJECT (mark), get_source_mark_nodes_quark (), NULL);
+	g_object_unref (mark);
+
+	return TRUE;
 }
 
 static void
 source_mark_insert (GtkSourceBuffer *buffer, GtkSourceMark *mark)
 {
+	const gchar *category = gtk_source_mark_get_category (mark);
+	GSequence *category_marks;
+	SourceMarkNodes *nodes;
 	GtkTextIter iter;
-	gint idx;
 
 	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
 					  &iter,
 					  GTK_TEXT_MARK (mark));
 
-	idx = source_mark_bsearch (buffer, &iter, TRUE);
-	if (idx >= 0)
+	category_marks = g_hash_table_lookup (buffer->priv->source_marks_per_category,
+					      category);
+
+	if (category_marks == NULL)
 	{
-		/* if the mark we found is at same iter or before
-		 * put our mark after that */
-		idx++;
+		category_marks = g_sequence_new (NULL);
+		g_hash_table_insert (buffer->priv->source_marks_per_category,
+				     g_strdup (category),
+				     category_marks);
+	}
+
+	/* If there are marks at the same position, put our mark after them. */
+	nodes = g_slice_new (SourceMarkNodes);
+	nodes->node = g_sequence_insert_before (source_mark_search (buffer,
+								    buffer->priv->source_marks,
+								    &iter,
+								    TRUE),
+						mark);
+	nodes->category_node = g_sequence_insert_before (source_mark_search (buffer,
+									     category_marks,
+									     &iter,
+									     TRUE),
+							 mark);
+
+	g_object_set_qdata_full (G_OBJECT (mark),
+				 get_source_mark_nodes_quark (),
+				 nodes,
+				 (GDestroyNotify) source_mark_nodes_free);
+
+	g_object_ref (mark);
+}
+
+static void
+source_marks_batch_begin (GtkSourceBuffer *buffer)
+{
+	buffer->priv->source_marks_batch_depth++;
+}
+
+static void
+source_marks_batch_add_lines (GtkSourceBuffer *buffer,
+			      gint             start_line,
+			      gint             end_line)
+{
+	GtkSourceBufferPrivate *priv = buffer->priv;
+
+	if (priv->source_marks_batch_start_line == -1)
+	{
+		priv->source_marks_batch_start_line = start_line;
+		priv->source_marks_batch_end_line = end_line;
 	}
 	else
 	{
-		idx = 0;
+		priv->source_marks_batch_start_line = MIN (priv->source_marks_batch_start_line, start_line);
+		priv->source_marks_batch_end_line = MAX (priv->source_marks_batch_end_line, end_line);
 	}
+}
 
-	g_object_ref (mark);
-	g_array_insert_val (buffer->priv->source_marks, idx, mark);
+static void
+source_marks_batch_end (GtkSourceBuffer *buffer)
+{
+	GtkSourceBufferPrivate *priv = buffer->priv;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	g_return_if_fail (priv->source_marks_batch_depth > 0);
+
+	if (--priv->source_marks_batch_depth > 0 ||
+	    priv->source_marks_batch_start_line == -1)
+	{
+		return;
+	}
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer),
+					  &start,
+					  priv->source_marks_batch_start_line);
+
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer),
+					  &end,
+					  priv->source_marks_batch_end_line);
+
+	if (!gtk_text_iter_ends_line (&end))
+	{
+		gtk_text_iter_forward_to_line_end (&end);
+	}
+
+	priv->source_marks_batch_start_line = -1;
+	priv->source_marks_batch_end_line = -1;
+
+	g_signal_emit (buffer, buffer_signals[SOURCE_MARKS_UPDATED], 0, &start, &end);
 }
 
 static void
@@ -1885,7 +2497,15 @@ gtk_source_buffer_real_mark_set	(GtkTextBuffer     *buffer,
 		source_mark_insert (GTK_SOURCE_BUFFER (buffer),
 				    GTK_SOURCE_MARK (mark));
 
-		g_signal_emit_by_name (buffer, "source_mark_updated", mark);
+		if (GTK_SOURCE_BUFFER (buffer)->priv->source_marks_batch_depth > 0)
+		{
+			gint line = gtk_text_iter_get_line (location);
+			source_marks_batch_add_lines (GTK_SOURCE_BUFFER (buffer), line, line);
+		}
+		else
+		{
+			g_signal_emit_by_name (buffer, "source_mark_updated", mark);
+		}
 	}
 
 	/* if the mark is the insert mark, update bracket matching */
@@ -1975,83 +2595,232 @@ gtk_source_buffer_create_source_mark (GtkSourceBuffer   *buffer,
 }
 
 static gint
-get_mark_index (GtkSourceBuffer *buffer,
-		GtkSourceMark   *mark)
+compare_lines (gconstpointer a,
+	       gconstpointer b,
+	       gpointer      user_data)
 {
-	GtkTextIter iter;
-	gint idx;
+	gint line_a = *(const gint *) a;
+	gint line_b = *(const gint *) b;
 
-	/* TODO: we could speed this up by caching the current
-	 * position in the mark and invalidating the cache when
-	 * the marks array changes. For now we always lookup. */
-	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
-					  &iter,
-					  GTK_TEXT_MARK (mark));
+	return line_a < line_b ? -1 : (line_a > line_b ? 1 : 0);
+}
+
+/**
+ * gtk_source_buffer_create_source_marks:
+ * @buffer: a #GtkSourceBuffer.
+ * @category: a string defining the marks category.
+ * @lines: (array length=n_lines): the line numbers.
+ * @n_lines: the number of elements in @lines.
+ *
+ * Creates anonymous source marks of category @category at the start of each
+ * line of @lines, in one bulk operation. It is much faster than calling
+ * gtk_source_buffer_create_source_mark() for each line when there are a lot of
+ * marks, for example for diagnostics or code coverage results: the
+ * #GtkSourceBuffer::source-marks-updated signal is emitted only once, instead
+ * of #GtkSourceBuffer::source-mark-updated for each mark.
+ *
+ * Returns: (element-type GtkSource.Mark) (transfer container): a newly
+ * allocated #GSList of the new marks, sorted by line. The marks are owned by
+ * the buffer.
+ *
+ * Since: 3.10
+ */
+GSList *
+gtk_source_buffer_create_source_marks (GtkSourceBuffer *buffer,
+				       const gchar     *category,
+				       const gint      *lines,
+				       gint             n_lines)
+{
+	GtkTextBuffer *text_buffer;
+	gint *sorted_lines;
+	GSList *marks = NULL;
+	gint i;
+
+	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), NULL);
+	g_return_val_if_fail (category != NULL, NULL);
+	g_return_val_if_fail (lines != NULL || n_lines == 0, NULL);
+
+	if (n_lines <= 0)
+	{
+		return NULL;
+	}
 
-	idx = source_mark_bsearch (buffer, &iter, FALSE);
+	text_buffer = GTK_TEXT_BUFFER (buffer);
 
-	/* the array should already contain @mark */
-	g_assert (idx >= 0);
+	/* Each mark is still inserted with its own search in the marks tree.
+	 * Sorting the lines only improves the locality: the marks are inserted
+	 * next to each other, and the lines are walked in order.
+	 */
+	sorted_lines = g_memdup (lines, n_lines * sizeof (gint));
+	g_qsort_with_data (sorted_lines, n_lines, sizeof (gint), compare_lines, NULL);
+
+	source_marks_batch_begin (buffer);
 
-	/* move up to our mark among the ones at this position */
-	while (mark != g_array_index (buffer->priv->source_marks, GtkSourceMark *, idx))
+	for (i = n_lines - 1; i >= 0; i--)
 	{
-		++idx;
+		GtkSourceMark *mark;
+		GtkTextIter iter;
+
+		gtk_text_buffer_get_iter_at_line (text_buffer, &iter, sorted_lines[i]);
+
+		mark = gtk_source_mark_new (NULL, category);
+		gtk_text_buffer_add_mark (text_buffer, GTK_TEXT_MARK (mark), &iter);
+
+		/* The buffer owns the mark. */
+		g_object_unref (mark);
+
+		marks = g_slist_prepend (marks, mark);
 	}
 
-	return idx;
+	source_marks_batch_end (buffer);
+
+	g_free (sorted_lines);
+	return marks;
 }
 
+/* Returns the next mark of @category after @mark, in the order of the marks
+ * tree.
+ */
 GtkSourceMark *
 _gtk_source_buffer_source_mark_next (GtkSourceBuffer *buffer,
 				     GtkSourceMark   *mark,
 				     const gchar     *category)
 {
-	gint idx;
+	SourceMarkNodes *nodes;
+	GSequence *marks;
+	GSequenceIter *node;
+	GtkTextIter iter;
 
 	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), NULL);
 
-	idx = get_mark_index (buffer, mark);
+	nodes = get_source_mark_nodes (mark);
+	g_return_val_if_fail (nodes != NULL, NULL);
 
-	while ((guint) ++idx < buffer->priv->source_marks->len)
+	if (category == NULL)
 	{
-		GtkSourceMark *ret;
+		node = g_sequence_iter_next (nodes->node);
+		return g_sequence_iter_is_end (node) ? NULL : g_sequence_get (node);
+	}
 
-		ret = g_array_index (buffer->priv->source_marks, GtkSourceMark *, idx);
-		if (category == NULL ||
-		    0 == strcmp (category, gtk_source_mark_get_category (ret)))
+	if (g_str_equal (category, gtk_source_mark_get_category (mark)))
+	{
+		node = g_sequence_iter_next (nodes->category_node);
+		return g_sequence_iter_is_end (node) ? NULL : g_sequence_get (node);
+	}
+
+	/* @mark is of another category. Look first at the marks at the same
+	 * position, placed after @mark.
+	 */
+	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
+					  &iter,
+					  GTK_TEXT_MARK (mark));
+
+	for (node = g_sequence_iter_next (nodes->node);
+	     !g_sequence_iter_is_end (node);
+	     node = g_sequence_iter_next (node))
+	{
+		GtkSourceMark *ret = g_sequence_get (node);
+		GtkTextIter ret_iter;
+
+		gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
+						  &ret_iter,
+						  GTK_TEXT_MARK (ret));
+
+		if (!gtk_text_iter_equal (&iter, &ret_iter))
+		{
+			break;
+		}
+
+		if (g_str_equal (category, gtk_source_mark_get_category (ret)))
 		{
 			return ret;
 		}
 	}
 
-	return NULL;
+	marks = get_source_marks (buffer, category);
+
+	if (marks == NULL)
+	{
+		return NULL;
+	}
+
+	node = source_mark_search (buffer, marks, &iter, TRUE);
+	return g_sequence_iter_is_end (node) ? NULL : g_sequence_get (node);
 }
 
+/* Returns the previous mark of @category before @mark, in the order of the
+ * marks tree.
+ */
 GtkSourceMark *
 _gtk_source_buffer_source_mark_prev (GtkSourceBuffer *buffer,
 				     GtkSourceMark   *mark,
 				     const gchar     *category)
 {
-	gint idx;
+	SourceMarkNodes *nodes;
+	GSequence *marks;
+	GSequenceIter *node;
+	GtkTextIter iter;
 
 	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), NULL);
 
-	idx = get_mark_index (buffer, mark);
+	nodes = get_source_mark_nodes (mark);
+	g_return_val_if_fail (nodes != NULL, NULL);
 
-	while (--idx >= 0)
+	if (category == NULL)
+	{
+		return g_sequence_iter_is_begin (nodes->node) ?
+		       NULL :
+		       g_sequence_get (g_sequence_iter_prev (nodes->node));
+	}
+
+	if (g_str_equal (category, gtk_source_mark_get_category (mark)))
+	{
+		return g_sequence_iter_is_begin (nodes->category_node) ?
+		       NULL :
+		       g_sequence_get (g_sequence_iter_prev (nodes->category_node));
+	}
+
+	/* @mark is of another category. Look first at the marks at the same
+	 * position, placed before @mark.
+	 */
+	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
+					  &iter,
+					  GTK_TEXT_MARK (mark));
+
+	node = nodes->node;
+
+	while (!g_sequence_iter_is_begin (node))
 	{
 		GtkSourceMark *ret;
+		GtkTextIter ret_iter;
 
-		ret = g_array_index (buffer->priv->source_marks, GtkSourceMark *, idx);
-		if (category == NULL ||
-		    0 == strcmp (category, gtk_source_mark_get_category (ret)))
+		node = g_sequence_iter_prev (node);
+		ret = g_sequence_get (node);
+
+		gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
+						  &ret_iter,
+						  GTK_TEXT_MARK (ret));
+
+		if (!gtk_text_iter_equal (&iter, &ret_iter))
+		{
+			break;
+		}
+
+		if (g_str_equal (category, gtk_source_mark_get_category (ret)))
 		{
 			return ret;
 		}
 	}
 
-	return NULL;
+	marks = get_source_marks (buffer, category);
+
+	if (marks == NULL)
+	{
+		return NULL;
+	}
+
+	node = source_mark_search (buffer, marks, &iter, FALSE);
+	return g_sequence_iter_is_begin (node) ? NULL : g_sequence_get (g_sequence_iter_prev (node));
 }
 
 /**
@@ -2073,39 +2842,28 @@ gtk_source_buffer_forward_iter_to_source_mark (GtkSourceBuffer *buffer,
 					       GtkTextIter     *iter,
 					       const gchar     *category)
 {
+	GSequence *marks;
+	GSequenceIter *node;
 	GtkTextIter i;
-	gint idx;
 
 	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), FALSE);
 	g_return_val_if_fail (iter != NULL, FALSE);
 
-	i = *iter;
+	marks = get_source_marks (buffer, category);
 
-	idx = source_mark_bsearch (buffer, &i, FALSE);
-	if (idx < 0)
+	if (marks == NULL)
 		return FALSE;
 
-	while ((guint) idx < buffer->priv->source_marks->len)
-	{
-		GtkSourceMark *mark;
-
-		mark = g_array_index (buffer->priv->source_marks, GtkSourceMark *, idx);
-		if (category == NULL ||
-		    0 == strcmp (category, gtk_source_mark_get_category (mark)))
-		{
-			/* update the iter */
-			gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer), &i, GTK_TEXT_MARK (mark));
-			if (gtk_text_iter_compare (&i, iter) > 0)
-			{
-				*iter = i;
-				return TRUE;
-			}
-		}
-
-		++idx;
-	}
+	/* The first mark strictly after @iter. */
+	node = source_mark_search (buffer, marks, iter, TRUE);
+	if (g_sequence_iter_is_end (node))
+		return FALSE;
 
-	return FALSE;
+	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
+					  &i,
+					  GTK_TEXT_MARK (g_sequence_get (node)));
+	*iter = i;
+	return TRUE;
 }
 
 /**
@@ -2127,39 +2885,29 @@ gtk_source_buffer_backward_iter_to_source_mark (GtkSourceBuffer *buffer,
 						GtkTextIter     *iter,
 						const gchar     *category)
 {
+	GSequence *marks;
+	GSequenceIter *node;
 	GtkTextIter i;
-	gint idx;
 
 	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), FALSE);
 	g_return_val_if_fail (iter != NULL, FALSE);
 
-	i = *iter;
+	marks = get_source_marks (buffer, category);
 
-	idx = source_mark_bsearch (buffer, &i, TRUE);
-	if (idx < 0)
+	if (marks == NULL)
 		return FALSE;
 
-	while (idx >= 0)
-	{
-		GtkSourceMark *mark;
-
-		mark = g_array_index (buffer->priv->source_marks, GtkSourceMark *, idx);
-		if (category == NULL ||
-		    0 == strcmp (category, gtk_source_mark_get_category (mark)))
-		{
-			/* update the iter */
-			gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer), &i, GTK_TEXT_MARK (mark));
-			if (gtk_text_iter_compare (&i, iter) < 0)
-			{
-				*iter = i;
-				return TRUE;
-			}
-		}
-
-		--idx;
-	}
+	/* The last mark strictly before @iter. */
+	node = source_mark_search (buffer, marks, iter, FALSE);
+	if (g_sequence_iter_is_begin (node))
+		return FALSE;
 
-	return FALSE;
+	node = g_sequence_iter_prev (node);
+	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
+					  &i,
+					  GTK_TEXT_MARK (g_sequence_get (node)));
+	*iter = i;
+	return TRUE;
 }
 
 /**
@@ -2185,7 +2933,7 @@ gtk_source_buffer_get_source_marks_at_iter (GtkSourceBuffer *buffer,
 
 	g_return_val_if_fail (iter != NULL, NULL);
 
-	if (buffer->priv->source_marks->len == 0)
+	if (source_marks_is_empty (get_source_marks (buffer, category)))
 		return NULL;
 
 	res = NULL;
@@ -2230,42 +2978,38 @@ gtk_source_buffer_get_source_marks_at_line (GtkSourceBuffer *buffer,
 					    gint             line,
 					    const gchar     *category)
 {
+	GSequence *marks;
+	GSequenceIter *node;
 	GtkTextIter iter;
-	GSList *res;
+	GSList *res = NULL;
 
  	g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), NULL);
 
-	if (buffer->priv->source_marks->len == 0)
+	marks = get_source_marks (buffer, category);
+
+	if (source_marks_is_empty (marks))
 		return NULL;
 
 	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (buffer),
 					  &iter, line);
 
-	res = gtk_source_buffer_get_source_marks_at_iter (buffer,
-							  &iter,
-							  category);
-
-	while (gtk_source_buffer_forward_iter_to_source_mark (buffer,
-							      &iter,
-							      category))
+	for (node = source_mark_search_first_after (buffer, marks, &iter);
+	     node != NULL && !g_sequence_iter_is_end (node);
+	     node = g_sequence_iter_next (node))
 	{
-		if (gtk_text_iter_get_line (&iter) == line)
-		{
-			GSList *l;
+		GtkSourceMark *mark = g_sequence_get (node);
 
-			l =  gtk_source_buffer_get_source_marks_at_iter (buffer,
-									 &iter,
-									 category);
+		gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer),
+						  &iter,
+						  GTK_TEXT_MARK (mark));
 
-			res = g_slist_concat (res, l);
-		}
-		else
-		{
+		if (gtk_text_iter_get_line (&iter) != line)
 			break;
-		}
+
+		res = g_slist_prepend (res, mark);
 	}
 
-	return res;
+	return g_slist_reverse (res);
 }
 
 /**
@@ -2286,38 +3030,45 @@ gtk_source_buffer_remove_source_marks (GtkSourceBuffer   *buffer,
 				       const GtkTextIter *end,
 				       const gchar       *category)
 {
-	GtkTextIter iter;
-	GSList *list;
+	GSequence *marks;
+	GSequenceIter *node;
+	GSequenceIter *end_node;
+	GtkTextIter range_start;
+	GtkTextIter range_end;
+	GSList *list = NULL;
 	GSList *l;
 
  	g_return_if_fail (GTK_SOURCE_IS_BUFFER (buffer));
  	g_return_if_fail (start != NULL);
  	g_return_if_fail (end != NULL);
 
-	iter = *start;
+	range_start = *start;
+	range_end = *end;
+	gtk_text_iter_order (&range_start, &range_end);
 
-	list = gtk_source_buffer_get_source_marks_at_iter (buffer,
-							   &iter,
-							   category);
+	marks = get_source_marks (buffer, category);
 
-	while (gtk_source_buffer_forward_iter_to_source_mark (buffer,
-							      &iter,
-							      category))
-	{
-		if (gtk_text_iter_compare (&iter, end) <= 0)
-		{
-			l =  gtk_source_buffer_get_source_marks_at_iter (buffer,
-									 &iter,
-									 category);
+	if (source_marks_is_empty (marks))
+		return;
 
-			list = g_slist_concat (list, l);
-		}
-		else
-		{
-			break;
-		}
+	/* The marks are collected first, since deleting a mark modifies the
+	 * trees.
+	 */
+	node = source_mark_search (buffer, marks, &range_start, FALSE);
+	end_node = source_mark_search (buffer, marks, &range_end, TRUE);
+
+	while (node != end_node && !g_sequence_iter_is_end (node))
+	{
+		list = g_slist_prepend (list, g_sequence_get (node));
+		node = g_sequence_iter_next (node);
 	}
 
+	if (list == NULL)
+		return;
+
+	/* ::source-mark-updated is still emitted for each removed mark, as
+	 * before the bulk API was added.
+	 */
 	for (l = list; l != NULL; l = l->next)
 	{
 		gtk_text_buffer_delete_mark (GTK_TEXT_BUFFER (buffer),
@@ -2530,6 +3281,7 @@ gtk_source_buffer_set_undo_manager (GtkSourceBuffer      *buffer,
 		manager = g_object_new (GTK_SOURCE_TYPE_UNDO_MANAGER_DEFAULT,
 		                        "buffer", buffer,
 		                        "max-undo-levels", buffer->priv->max_undo_levels,
+		                        "max-undo-size", buffer->priv->max_undo_size,
 		                        NULL);
 	}
 	else
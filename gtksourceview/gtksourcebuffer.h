@@ -104,6 +104,21 @@ gint			 gtk_source_buffer_get_max_undo_levels			(GtkSourceBuffer        *buffer)
 void			 gtk_source_buffer_set_max_undo_levels			(GtkSourceBuffer        *buffer,
 										 gint                    max_undo_levels);
 
+gint			 gtk_source_buffer_get_max_undo_size			(GtkSourceBuffer        *buffer);
+
+void			 gtk_source_buffer_set_max_undo_size			(GtkSourceBuffer        *buffer,
+										 gint                    max_undo_size);
+
+gboolean		 gtk_source_buffer_save_undo_history			(GtkSourceBuffer        *buffer,
+										 GFile                  *file,
+										 GCancellable           *cancellable,
+										 GError                **error);
+
+gboolean		 gtk_source_buffer_load_undo_history			(GtkSourceBuffer        *buffer,
+										 GFile                  *file,
+										 GCancellable           *cancellable,
+										 GError                **error);
+
 GtkSourceLanguage 	*gtk_source_buffer_get_language				(GtkSourceBuffer        *buffer);
 
 void			 gtk_source_buffer_set_language				(GtkSourceBuffer        *buffer,
@@ -132,12 +147,24 @@ void			 gtk_source_buffer_begin_not_undoable_action		(GtkSourceBuffer	*buffer);
 
 void			 gtk_source_buffer_end_not_undoable_action		(GtkSourceBuffer	*buffer);
 
+/* Batch edits */
+void			 gtk_source_buffer_begin_batch_edit			(GtkSourceBuffer        *buffer);
+
+void			 gtk_source_buffer_end_batch_edit			(GtkSourceBuffer        *buffer);
+
+gboolean		 gtk_source_buffer_is_in_batch_edit			(GtkSourceBuffer        *buffer);
+
 /* Mark methods */
 GtkSourceMark		*gtk_source_buffer_create_source_mark			(GtkSourceBuffer        *buffer,
 										 const gchar            *name,
 										 const gchar            *category,
 										 const GtkTextIter      *where);
 
+GSList			*gtk_source_buffer_create_source_marks			(GtkSourceBuffer        *buffer,
+										 const gchar            *category,
+										 const gint             *lines,
+										 gint                    n_lines);
+
 gboolean		 gtk_source_buffer_forward_iter_to_source_mark		(GtkSourceBuffer        *buffer,
 										 GtkTextIter            *iter,
 										 const gchar            *category);
@@ -79,12 +79,14 @@
  * GtkSourceCompletionInfo for the main completion window.
  */
 
+#include <string.h>
 #include "gtksourcecompletion.h"
 #include "gtksourcecompletion-private.h"
 #include "gtksourcecompletionmodel.h"
 #include "gtksourcecompletioncontext.h"
 #include "gtksourcecompletioninfo.h"
 #include "gtksourcecompletionproposal.h"
+#include "gtksourcecompletionmatcher.h"
 #include "gtksourcecompletionprovider.h"
 #include "gtksourcecompletioncontainer.h"
 #include "gtksourcebuffer.h"
@@ -92,6 +94,13 @@
 #include "gtksourceview-marshal.h"
 #include "gtksourceview-i18n.h"
 
+/* The tree view of the proposals is in fixed-height mode, so only the visible
+ * rows are measured and rendered, and the proposals are queried lazily by the
+ * model. The width of the columns is computed from the first rows only; the
+ * longer proposals further down the list are ellipsized.
+ */
+#define N_MEASURED_ROWS 50
+
 /* Signals */
 enum
 {
@@ -150,6 +159,8 @@ struct _GtkSourceCompletionPrivate
 
 	/* List of proposals */
 	GtkTreeView *tree_view_proposals;
+	GtkTreeViewColumn *tree_view_column_proposal;
+	GtkTreeViewColumn *tree_view_column_accelerator;
 
 	/* Completion management */
 
@@ -161,6 +172,19 @@ struct _GtkSourceCompletionPrivate
 	GList *active_providers;
 	GList *running_providers;
 
+	/* The word at the context iter when the providers were populated, and
+	 * the offset of its start. When the user extends the word, the
+	 * proposals are narrowed in place instead of populating the providers
+	 * again.
+	 */
+	gchar *filter_word;
+	gint filter_word_offset;
+
+	/* For the providers that implement populate_async(). Cancelled when
+	 * the completion is reset, so the stale results are ignored.
+	 */
+	GCancellable *populate_cancellable;
+
 	guint show_timed_out_id;
 
 	gulong signals_ids[LAST_EXTERNAL_SIGNAL];
@@ -186,6 +210,9 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtkSourceCompletion, gtk_source_completion, G_TYPE_OBJECT)
 
+static void populating_done (GtkSourceCompletion        *completion,
+			     GtkSourceCompletionContext *context);
+
 static void
 scroll_to_iter (GtkSourceCompletion *completion,
                 GtkTreeIter         *iter)
@@ -364,6 +391,15 @@ reset_completion (GtkSourceCompletion *completion)
 	g_list_free (completion->priv->active_providers);
 	completion->priv->running_providers = NULL;
 	completion->priv->active_providers = NULL;
+
+	g_free (completion->priv->filter_word);
+	completion->priv->filter_word = NULL;
+
+	if (completion->priv->populate_cancellable != NULL)
+	{
+		g_cancellable_cancel (completion->priv->populate_cancellable);
+		g_clear_object (&completion->priv->populate_cancellable);
+	}
 }
 
 /* A separator is a character like (, a space etc. An _ is not a separator. */
@@ -379,6 +415,22 @@ is_separator (const gunichar ch)
 	return TRUE;
 }
 
+/* Moves @iter to the start of the word that ends at @iter. */
+static void
+backward_word_start (GtkTextIter *iter)
+{
+	while (gtk_text_iter_backward_char (iter))
+	{
+		gunichar ch = gtk_text_iter_get_char (iter);
+
+		if (is_separator (ch))
+		{
+			gtk_text_iter_forward_char (iter);
+			return;
+		}
+	}
+}
+
 /* Assigns @start_word to the start position of the word, and @end_word to the
  * end position.
  */
@@ -392,17 +444,26 @@ get_word_iter (GtkTextBuffer *buffer,
 	                                  gtk_text_buffer_get_insert (buffer));
 
 	*start_word = *end_word;
+	backward_word_start (start_word);
+}
 
-	while (gtk_text_iter_backward_char (start_word))
-	{
-		gunichar ch = gtk_text_iter_get_char (start_word);
+/* Returns the word that ends at the iter of the current context, and the
+ * offset of its start in @word_offset.
+ */
+static gchar *
+get_context_word (GtkSourceCompletion *completion,
+		  gint                *word_offset)
+{
+	GtkTextIter word_start;
+	GtkTextIter word_end;
 
-		if (is_separator (ch))
-		{
-			gtk_text_iter_forward_char (start_word);
-			return;
-		}
-	}
+	gtk_source_completion_context_get_iter (completion->priv->context, &word_end);
+
+	word_start = word_end;
+	backward_word_start (&word_start);
+
+	*word_offset = gtk_text_iter_get_offset (&word_start);
+	return gtk_text_iter_get_slice (&word_start, &word_end);
 }
 
 static void
@@ -982,6 +1043,97 @@ get_previous_provider (GtkSourceCompletion *completion,
 	return ret;
 }
 
+static gint
+get_column_natural_width (GtkSourceCompletion *completion,
+			  GtkTreeViewColumn   *column,
+			  GtkTreeModel        *model,
+			  GtkTreeIter         *iter)
+{
+	GList *cells;
+	GList *l;
+	gint width = 0;
+
+	gtk_tree_view_column_cell_set_cell_data (column, model, iter, FALSE, FALSE);
+
+	cells = gtk_cell_layout_get_cells (GTK_CELL_LAYOUT (column));
+
+	for (l = cells; l != NULL; l = l->next)
+	{
+		GtkCellRenderer *cell = l->data;
+		gint natural_width;
+
+		if (!gtk_cell_renderer_get_visible (cell))
+		{
+			continue;
+		}
+
+		gtk_cell_renderer_get_preferred_width (cell,
+						       GTK_WIDGET (completion->priv->tree_view_proposals),
+						       NULL,
+						       &natural_width);
+
+		width += natural_width;
+	}
+
+	g_list_free (cells);
+	return width;
+}
+
+/* Sets the fixed width of the columns, from the first N_MEASURED_ROWS rows. It
+ * replaces gtk_tree_view_columns_autosize(), which measures all the rows.
+ */
+static void
+update_columns_width (GtkSourceCompletion *completion)
+{
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	gint proposal_width = 1;
+	gint accelerator_width = 1;
+	gint horizontal_separator = 0;
+	gint row;
+
+	model = gtk_tree_view_get_model (completion->priv->tree_view_proposals);
+
+	if (model != NULL && gtk_tree_model_get_iter_first (model, &iter))
+	{
+		row = 0;
+
+		do
+		{
+			proposal_width = MAX (proposal_width,
+					      get_column_natural_width (completion,
+									completion->priv->tree_view_column_proposal,
+									model,
+									&iter));
+
+			if (completion->priv->num_accelerators > 0)
+			{
+				accelerator_width = MAX (accelerator_width,
+							 get_column_natural_width (completion,
+										   completion->priv->tree_view_column_accelerator,
+										   model,
+										   &iter));
+			}
+
+			row++;
+		}
+		while (row < N_MEASURED_ROWS && gtk_tree_model_iter_next (model, &iter));
+	}
+
+	/* The tree view removes the separator from the cell area of each
+	 * column.
+	 */
+	gtk_widget_style_get (GTK_WIDGET (completion->priv->tree_view_proposals),
+			      "horizontal-separator", &horizontal_separator,
+			      NULL);
+
+	gtk_tree_view_column_set_fixed_width (completion->priv->tree_view_column_proposal,
+					      proposal_width + horizontal_separator);
+
+	gtk_tree_view_column_set_fixed_width (completion->priv->tree_view_column_accelerator,
+					      accelerator_width + horizontal_separator);
+}
+
 static void
 gtk_source_completion_move_page (GtkSourceCompletion *completion,
                                  GtkScrollStep        step,
@@ -1018,7 +1170,6 @@ gtk_source_completion_move_page (GtkSourceCompletion *completion,
 	}
 
 	gtk_tree_view_set_model (completion->priv->tree_view_proposals, NULL);
-	gtk_tree_view_columns_autosize (completion->priv->tree_view_proposals);
 
 	gtk_source_completion_model_set_visible_providers (completion->priv->model_proposals,
 							   visible_providers);
@@ -1026,6 +1177,8 @@ gtk_source_completion_move_page (GtkSourceCompletion *completion,
 	gtk_tree_view_set_model (completion->priv->tree_view_proposals,
 				 GTK_TREE_MODEL (completion->priv->model_proposals));
 
+	update_columns_width (completion);
+
 	update_selection_label (completion);
 	check_first_selected (completion);
 
@@ -1237,6 +1390,93 @@ update_transient_for_info (GObject             *window,
 				      gtk_window_get_transient_for (GTK_WINDOW (completion->priv->main_window)));
 }
 
+typedef struct
+{
+	GtkSourceCompletion *completion;
+	GtkSourceCompletionContext *context;
+	GCancellable *cancellable;
+} PopulateData;
+
+static void
+populate_data_free (PopulateData *data)
+{
+	g_object_unref (data->completion);
+	g_object_unref (data->context);
+	g_object_unref (data->cancellable);
+	g_slice_free (PopulateData, data);
+}
+
+/* Called in the main thread. The proposals are added to the model as soon as
+ * a provider has finished, independently of the other providers.
+ */
+static void
+populate_async_cb (GtkSourceCompletionProvider *provider,
+		   GAsyncResult                *result,
+		   PopulateData                *data)
+{
+	GtkSourceCompletion *completion = data->completion;
+	GList *proposals;
+	GError *error = NULL;
+
+	proposals = gtk_source_completion_provider_populate_finish (provider, result, &error);
+
+	/* If the completion has been reset in the meantime, the results are
+	 * stale.
+	 */
+	if (g_cancellable_is_cancelled (data->cancellable) ||
+	    completion->priv->populate_cancellable != data->cancellable)
+	{
+		goto out;
+	}
+
+	if (error != NULL)
+	{
+		g_warning ("Completion provider population failed: %s", error->message);
+	}
+
+	_gtk_source_completion_add_proposals (completion,
+					      data->context,
+					      provider,
+					      proposals,
+					      TRUE);
+
+out:
+	g_clear_error (&error);
+	g_list_free_full (proposals, g_object_unref);
+	populate_data_free (data);
+}
+
+/* The provider must be in the list of running providers. */
+static void
+populate_provider (GtkSourceCompletion         *completion,
+		   GtkSourceCompletionProvider *provider,
+		   GtkSourceCompletionContext  *context)
+{
+	PopulateData *data;
+
+	if (GTK_SOURCE_COMPLETION_PROVIDER_GET_INTERFACE (provider)->populate_async == NULL)
+	{
+		gtk_source_completion_provider_populate (provider, context);
+		return;
+	}
+
+	if (completion->priv->populate_cancellable == NULL)
+	{
+		completion->priv->populate_cancellable = g_cancellable_new ();
+	}
+
+	data = g_slice_new (PopulateData);
+	data->completion = g_object_ref (completion);
+	data->context = g_object_ref (context);
+	data->cancellable = g_object_ref (completion->priv->populate_cancellable);
+
+	gtk_source_completion_provider_populate_async (provider,
+						       context,
+						       data->cancellable,
+						       (GAsyncReadyCallback) populate_async_cb,
+						       data);
+}
+
 static void
 replace_model (GtkSourceCompletion *completion)
 {
@@ -1272,14 +1512,16 @@ update_completion (GtkSourceCompletion        *completion,
 
 	/* Create a new CompletionModel */
 	gtk_tree_view_set_model (completion->priv->tree_view_proposals, NULL);
-	gtk_tree_view_columns_autosize (completion->priv->tree_view_proposals);
 
 	replace_model (completion);
 
+	completion->priv->filter_word = get_context_word (completion,
+							  &completion->priv->filter_word_offset);
+
 	for (item = providers_copy; item != NULL; item = g_list_next (item))
 	{
 		GtkSourceCompletionProvider *provider = item->data;
-		gtk_source_completion_provider_populate (provider, context_copy);
+		populate_provider (completion, provider, context_copy);
 	}
 
 	g_list_free (providers_copy);
@@ -1360,6 +1602,154 @@ start_interactive_completion (GtkSourceCompletion *completion,
 		                    (GDestroyNotify)auto_completion_destroy);
 }
 
+static gboolean
+proposal_matches_word (GtkSourceCompletionProposal *proposal,
+		       const gchar                 *word)
+{
+	gchar *text;
+	gboolean keep;
+
+	text = gtk_source_completion_proposal_get_text (proposal);
+
+	if (text == NULL)
+	{
+		text = gtk_source_completion_proposal_get_label (proposal);
+	}
+
+	/* Like the words provider, an exact match is not kept: activating it
+	 * would not change the text.
+	 */
+	keep = (text != NULL &&
+		strcmp (text, word) != 0 &&
+		gtk_source_completion_matcher_fuzzy_match (word, text, NULL));
+
+	g_free (text);
+	return keep;
+}
+
+static gboolean
+same_providers (GList *providers1,
+		GList *providers2)
+{
+	GList *l;
+
+	if (g_list_length (providers1) != g_list_length (providers2))
+	{
+		return FALSE;
+	}
+
+	for (l = providers1; l != NULL; l = l->next)
+	{
+		if (g_list_find (providers2, l->data) == NULL)
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* When the word at the context iter extends the word for which the providers
+ * were populated, the proposals already in the model of the providers which opt
+ * out of gtk_source_completion_provider_get_repopulate() are narrowed in place,
+ * by fuzzy matching them against the new word. The other providers, and the
+ * ones that had no proposals, are populated again. The model is not replaced, so the tree view
+ * keeps its rows that are still present.
+ *
+ * Returns: %FALSE if the completion must be updated from scratch.
+ */
+static gboolean
+refilter_completion (GtkSourceCompletion *completion,
+		     GList               *providers)
+{
+	GtkSourceCompletionModel *model = completion->priv->model_proposals;
+	GtkSourceCompletionContext *context = completion->priv->context;
+	GList *model_providers;
+	GList *repopulate_providers = NULL;
+	GList *l;
+	gchar *word;
+	gint word_offset;
+
+	/* The proposals of a running provider are incomplete. */
+	if (completion->priv->filter_word == NULL ||
+	    completion->priv->running_providers != NULL ||
+	    !same_providers (providers, completion->priv->active_providers))
+	{
+		return FALSE;
+	}
+
+	word = get_context_word (completion, &word_offset);
+
+	if (word_offset != completion->priv->filter_word_offset ||
+	    strlen (word) <= strlen (completion->priv->filter_word) ||
+	    !g_str_has_prefix (word, completion->priv->filter_word))
+	{
+		g_free (word);
+		return FALSE;
+	}
+
+	g_free (completion->priv->filter_word);
+	completion->priv->filter_word = word;
+
+	model_providers = gtk_source_completion_model_get_providers (model);
+
+	for (l = providers; l != NULL; l = l->next)
+	{
+		GtkSourceCompletionProvider *provider = l->data;
+
+		if (gtk_source_completion_provider_get_repopulate (provider) ||
+		    g_list_find (model_providers, provider) == NULL)
+		{
+			repopulate_providers = g_list_prepend (repopulate_providers, provider);
+		}
+	}
+
+	g_list_free (model_providers);
+	repopulate_providers = g_list_reverse (repopulate_providers);
+
+	/* The model doesn't emit "row-inserted" when proposals are added, so
+	 * it is detached from the tree view until populating_done().
+	 */
+	if (repopulate_providers != NULL)
+	{
+		gtk_tree_view_set_model (completion->priv->tree_view_proposals, NULL);
+	}
+
+	for (l = providers; l != NULL; l = l->next)
+	{
+		GtkSourceCompletionProvider *provider = l->data;
+
+		if (g_list_find (repopulate_providers, provider) != NULL)
+		{
+			gtk_source_completion_model_filter_proposals (model, provider, NULL, NULL);
+		}
+		else
+		{
+			gtk_source_completion_model_filter_proposals (model,
+								      provider,
+								      (GtkSourceCompletionModelFilterFunc) proposal_matches_word,
+								      word);
+		}
+	}
+
+	if (repopulate_providers == NULL)
+	{
+		populating_done (completion, context);
+		return TRUE;
+	}
+
+	completion->priv->running_providers = g_list_copy (repopulate_providers);
+
+	for (l = repopulate_providers; l != NULL; l = l->next)
+	{
+		GtkSourceCompletionProvider *provider = l->data;
+		populate_provider (completion, provider, context);
+	}
+
+	g_list_free (repopulate_providers);
+	return TRUE;
+}
+
 static void
 update_active_completion (GtkSourceCompletion *completion,
 			  GtkTextIter         *new_iter)
@@ -1377,9 +1767,12 @@ update_active_completion (GtkSourceCompletion *completion,
 
 	if (selected_providers != NULL)
 	{
-		update_completion (completion,
-				   selected_providers,
-				   completion->priv->context);
+		if (!refilter_completion (completion, selected_providers))
+		{
+			update_completion (completion,
+					   selected_providers,
+					   completion->priv->context);
+		}
 
 		g_list_free (selected_providers);
 	}
@@ -1457,6 +1850,8 @@ populating_done (GtkSourceCompletion        *completion,
 	gtk_tree_view_set_model (completion->priv->tree_view_proposals,
 				 GTK_TREE_MODEL (completion->priv->model_proposals));
 
+	update_columns_width (completion);
+
 	update_selection_label (completion);
 	update_bottom_bar_visibility (completion);
 
@@ -2132,6 +2527,7 @@ accelerators_notify_cb (GtkSourceCompletion *completion,
 			GtkTreeViewColumn   *column)
 {
 	gtk_tree_view_column_set_visible (column, completion->priv->num_accelerators > 0);
+	update_columns_width (completion);
 }
 
 static void
@@ -2144,8 +2540,11 @@ init_tree_view (GtkSourceCompletion *completion,
 	GtkStyleContext *style_context;
 	GdkRGBA background_color;
 	GdkRGBA foreground_color;
+	gint icon_height;
 
 	completion->priv->tree_view_proposals = GTK_TREE_VIEW (gtk_builder_get_object (builder, "tree_view_proposals"));
+	completion->priv->tree_view_column_proposal = GTK_TREE_VIEW_COLUMN (gtk_builder_get_object (builder, "tree_view_column_proposal"));
+	completion->priv->tree_view_column_accelerator = GTK_TREE_VIEW_COLUMN (gtk_builder_get_object (builder, "tree_view_column_accelerator"));
 
 	g_signal_connect_swapped (completion->priv->tree_view_proposals,
 				  "row-activated",
@@ -2170,7 +2569,13 @@ init_tree_view (GtkSourceCompletion *completion,
 
 	cell_renderer = GTK_CELL_RENDERER (gtk_builder_get_object (builder, "cell_renderer_icon"));
 
-	column = GTK_TREE_VIEW_COLUMN (gtk_builder_get_object (builder, "tree_view_column_proposal"));
+	column = completion->priv->tree_view_column_proposal;
+
+	/* In fixed-height mode, the height of all the rows is the height of
+	 * the first one, which is a header without icon most of the time.
+	 */
+	gtk_icon_size_lookup (GTK_ICON_SIZE_MENU, NULL, &icon_height);
+	gtk_cell_renderer_set_fixed_size (cell_renderer, -1, icon_height);
 
 	gtk_tree_view_column_set_attributes (column, cell_renderer,
 					     "pixbuf", GTK_SOURCE_COMPLETION_MODEL_COLUMN_ICON,
@@ -2211,7 +2616,7 @@ init_tree_view (GtkSourceCompletion *completion,
 
 	/* Accelerators cell renderer */
 
-	column = GTK_TREE_VIEW_COLUMN (gtk_builder_get_object (builder, "tree_view_column_accelerator"));
+	column = completion->priv->tree_view_column_accelerator;
 
 	cell_renderer = GTK_CELL_RENDERER (gtk_builder_get_object (builder, "cell_renderer_accelerator"));
 
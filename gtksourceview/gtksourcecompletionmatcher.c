@@ -0,0 +1,486 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; coding: utf-8 -*- */
+/* gtksourcecompletionmatcher.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "gtksourcecompletionmatcher.h"
+#include "gtksourcecompletionproposal.h"
+
+/**
+ * SECTION:completionmatcher
+ * @Short_description: Fuzzy matching of completion proposals
+ * @Title: GtkSourceCompletionMatcher
+ * @See_also: #GtkSourceCompletionProvider, #GtkSourceCompletionProposal
+ *
+ * A #GtkSourceCompletionMatcher filters and sorts a set of
+ * #GtkSourceCompletionProposal<!-- -->s by fuzzy matching their labels against
+ * a query, typically the word being typed. A provider can give all its
+ * proposals to the matcher once, with
+ * gtk_source_completion_matcher_set_proposals(), and then call
+ * gtk_source_completion_matcher_filter() for each new query.
+ *
+ * A proposal matches if the characters of the query appear in its label in
+ * the same order, not necessarily contiguous, ignoring the case. For example
+ * "gsv" matches "gtk_source_view" and "GtkSourceView". The matching proposals
+ * are ranked: the matches at the start of the label, at the start of a word
+ * (after an underscore, a dash, a space or a dot, or at a camelCase hump) and
+ * the consecutive matches are preferred, and the gaps are penalized.
+ *
+ * When the new query extends the previous one, as it is the case when the user
+ * types, only the proposals that matched the previous query are tested again.
+ *
+ * The completion window uses the same matching to narrow the proposals of the
+ * providers that allow it when the word is extended, see
+ * gtk_source_completion_provider_get_repopulate().
+ */
+
+/* Score of a matched character. */
+#define SCORE_MATCH 16
+
+/* Bonus when the first character of the label is matched. */
+#define BONUS_START 24
+
+/* Bonus when the matched character is at the start of a word. */
+#define BONUS_BOUNDARY 20
+
+/* Bonus when the previous character has been matched too. */
+#define BONUS_CONSECUTIVE 12
+
+/* Penalty per character skipped before a match, up to MAX_GAP_PENALTY. */
+#define PENALTY_GAP 2
+#define MAX_GAP_PENALTY 16
+
+/* Penalty per character after the last match, up to MAX_TRAILING_PENALTY, to
+ * prefer the shortest labels.
+ */
+#define MAX_TRAILING_PENALTY 16
+
+typedef struct
+{
+	GtkSourceCompletionProposal *proposal;
+	gchar *label;
+} Entry;
+
+typedef struct
+{
+	/* Index in the entries array. */
+	guint entry_index;
+	gint score;
+} Match;
+
+struct _GtkSourceCompletionMatcherPrivate
+{
+	/* Array of Entry. The labels are retrieved once, when the proposals
+	 * are set.
+	 */
+	GArray *entries;
+
+	/* The result of the last filtering, array of Match sorted by score. */
+	GArray *matches;
+	gchar *last_query;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (GtkSourceCompletionMatcher, gtk_source_completion_matcher, G_TYPE_OBJECT)
+
+static void
+clear_entry (Entry *entry)
+{
+	g_object_unref (entry->proposal);
+	g_free (entry->label);
+}
+
+static void
+clear_last_result (GtkSourceCompletionMatcher *matcher)
+{
+	g_array_set_size (matcher->priv->matches, 0);
+
+	g_free (matcher->priv->last_query);
+	matcher->priv->last_query = NULL;
+}
+
+static void
+gtk_source_completion_matcher_finalize (GObject *object)
+{
+	GtkSourceCompletionMatcher *matcher = GTK_SOURCE_COMPLETION_MATCHER (object);
+
+	g_array_free (matcher->priv->entries, TRUE);
+	g_array_free (matcher->priv->matches, TRUE);
+	g_free (matcher->priv->last_query);
+
+	G_OBJECT_CLASS (gtk_source_completion_matcher_parent_class)->finalize (object);
+}
+
+static void
+gtk_source_completion_matcher_class_init (GtkSourceCompletionMatcherClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = gtk_source_completion_matcher_finalize;
+}
+
+static void
+gtk_source_completion_matcher_init (GtkSourceCompletionMatcher *matcher)
+{
+	matcher->priv = gtk_source_completion_matcher_get_instance_private (matcher);
+
+	matcher->priv->entries = g_array_new (FALSE, FALSE, sizeof (Entry));
+	g_array_set_clear_func (matcher->priv->entries, (GDestroyNotify)clear_entry);
+
+	matcher->priv->matches = g_array_new (FALSE, FALSE, sizeof (Match));
+}
+
+static gboolean
+is_separator (gunichar ch)
+{
+	return (ch == '_' ||
+		ch == '-' ||
+		ch == ' ' ||
+		ch == '.' ||
+		ch == '/' ||
+		ch == ':');
+}
+
+/* Whether @ch is at the start of a word, @prev being the previous character. */
+static gboolean
+is_word_start (gunichar prev,
+	       gunichar ch)
+{
+	if (is_separator (prev))
+	{
+		return !is_separator (ch);
+	}
+
+	/* camelCase */
+	return g_unichar_islower (prev) && g_unichar_isupper (ch);
+}
+
+/* Returns the lower case characters of @query, and its length in @length. */
+static gunichar *
+get_query_chars (const gchar *query,
+		 glong       *length)
+{
+	gunichar *chars = g_utf8_to_ucs4_fast (query, -1, length);
+	glong i;
+
+	for (i = 0; i < *length; i++)
+	{
+		chars[i] = g_unichar_tolower (chars[i]);
+	}
+
+	return chars;
+}
+
+/* The matching is greedy: each query character is matched with its first
+ * occurrence after the previous match. It is not always the best match, but it
+ * is linear in the label length, and it finds whether the label matches.
+ */
+static gboolean
+match_label (const gunichar *query,
+	     glong           query_length,
+	     const gchar    *label,
+	     gint           *score)
+{
+	const gchar *p = label;
+	gunichar prev = 0;
+	glong n_matched = 0;
+	gint cur_score = 0;
+	gint gap = 0;
+	gint trailing;
+	gboolean position_start = TRUE;
+	gboolean prev_matched = FALSE;
+
+	if (query_length == 0)
+	{
+		*score = 0;
+		return TRUE;
+	}
+
+	while (*p != '\0' && n_matched < query_length)
+	{
+		gunichar ch;
+		gunichar lower;
+
+		/* ASCII fast path, most labels are identifiers. */
+		if ((guchar)*p < 0x80)
+		{
+			ch = (guchar)*p;
+			lower = g_ascii_tolower (ch);
+			p++;
+		}
+		else
+		{
+			ch = g_utf8_get_char (p);
+			lower = g_unichar_tolower (ch);
+			p = g_utf8_next_char (p);
+		}
+
+		if (lower == query[n_matched])
+		{
+			cur_score += SCORE_MATCH;
+
+			if (position_start)
+			{
+				cur_score += BONUS_START;
+			}
+			else if (is_word_start (prev, ch))
+			{
+				cur_score += BONUS_BOUNDARY;
+			}
+
+			if (prev_matched)
+			{
+				cur_score += BONUS_CONSECUTIVE;
+			}
+			else
+			{
+				cur_score -= MIN (gap * PENALTY_GAP, MAX_GAP_PENALTY);
+			}
+
+			n_matched++;
+			gap = 0;
+			prev_matched = TRUE;
+		}
+		else
+		{
+			gap++;
+			prev_matched = FALSE;
+		}
+
+		prev = ch;
+		position_start = FALSE;
+	}
+
+	if (n_matched < query_length)
+	{
+		return FALSE;
+	}
+
+	trailing = 0;
+	while (*p != '\0' && trailing < MAX_TRAILING_PENALTY)
+	{
+		p = g_utf8_next_char (p);
+		trailing++;
+	}
+
+	*score = cur_score - trailing;
+	return TRUE;
+}
+
+static gint
+compare_matches (gconstpointer a,
+		 gconstpointer b)
+{
+	const Match *match_a = a;
+	const Match *match_b = b;
+
+	if (match_a->score != match_b->score)
+	{
+		return match_a->score > match_b->score ? -1 : 1;
+	}
+
+	/* Keep the order of the proposals given by the provider. */
+	if (match_a->entry_index != match_b->entry_index)
+	{
+		return match_a->entry_index < match_b->entry_index ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/**
+ * gtk_source_completion_matcher_new:
+ *
+ * Returns: a new #GtkSourceCompletionMatcher.
+ * Since: 3.10
+ */
+GtkSourceCompletionMatcher *
+gtk_source_completion_matcher_new (void)
+{
+	return g_object_new (GTK_SOURCE_TYPE_COMPLETION_MATCHER, NULL);
+}
+
+/**
+ * gtk_source_completion_matcher_set_proposals:
+ * @matcher: a #GtkSourceCompletionMatcher.
+ * @proposals: (element-type GtkSourceCompletionProposal) (allow-none): the
+ *   proposals to filter.
+ *
+ * Sets the proposals to filter. The proposals are matched against their label,
+ * or their text if they have no label. The previous proposals are removed.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_completion_matcher_set_proposals (GtkSourceCompletionMatcher *matcher,
+					     GList                      *proposals)
+{
+	GList *l;
+
+	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_MATCHER (matcher));
+
+	clear_last_result (matcher);
+	g_array_set_size (matcher->priv->entries, 0);
+
+	for (l = proposals; l != NULL; l = l->next)
+	{
+		Entry entry;
+
+		entry.proposal = g_object_ref (l->data);
+		entry.label = gtk_source_completion_proposal_get_label (entry.proposal);
+
+		if (entry.label == NULL)
+		{
+			entry.label = gtk_source_completion_proposal_get_text (entry.proposal);
+		}
+
+		if (entry.label == NULL)
+		{
+			entry.label = g_strdup ("");
+		}
+
+		g_array_append_val (matcher->priv->entries, entry);
+	}
+}
+
+/**
+ * gtk_source_completion_matcher_filter:
+ * @matcher: a #GtkSourceCompletionMatcher.
+ * @query: the text to match, for example the word being completed.
+ *
+ * Filters the proposals set with gtk_source_completion_matcher_set_proposals()
+ * by fuzzy matching their label against @query. See
+ * gtk_source_completion_matcher_fuzzy_match().
+ *
+ * If @query starts with the query of the previous call, only the proposals
+ * that matched the previous query are tested.
+ *
+ * Returns: (transfer container) (element-type GtkSourceCompletionProposal):
+ * the matching proposals, the best matches first. With an empty @query, all
+ * the proposals in their original order. Free with g_list_free().
+ * Since: 3.10
+ */
+GList *
+gtk_source_completion_matcher_filter (GtkSourceCompletionMatcher *matcher,
+				      const gchar                *query)
+{
+	GtkSourceCompletionMatcherPrivate *priv;
+	gunichar *query_chars;
+	glong query_length;
+	GArray *new_matches;
+	gboolean narrow;
+	GList *ret = NULL;
+	guint n_candidates;
+	guint i;
+
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_MATCHER (matcher), NULL);
+	g_return_val_if_fail (query != NULL, NULL);
+
+	priv = matcher->priv;
+
+	/* A label that matches the new query also matches the previous one,
+	 * so the candidates are the previous matches.
+	 */
+	narrow = priv->last_query != NULL && g_str_has_prefix (query, priv->last_query);
+
+	n_candidates = narrow ? priv->matches->len : priv->entries->len;
+	new_matches = g_array_sized_new (FALSE, FALSE, sizeof (Match), n_candidates);
+
+	query_chars = get_query_chars (query, &query_length);
+
+	for (i = 0; i < n_candidates; i++)
+	{
+		Match match;
+		Entry *entry;
+
+		if (narrow)
+		{
+			match.entry_index = g_array_index (priv->matches, Match, i).entry_index;
+		}
+		else
+		{
+			match.entry_index = i;
+		}
+
+		entry = &g_array_index (priv->entries, Entry, match.entry_index);
+
+		if (match_label (query_chars, query_length, entry->label, &match.score))
+		{
+			g_array_append_val (new_matches, match);
+		}
+	}
+
+	g_free (query_chars);
+
+	g_array_sort (new_matches, compare_matches);
+
+	g_array_free (priv->matches, TRUE);
+	priv->matches = new_matches;
+
+	g_free (priv->last_query);
+	priv->last_query = g_strdup (query);
+
+	for (i = new_matches->len; i > 0; i--)
+	{
+		Match *match = &g_array_index (new_matches, Match, i - 1);
+		Entry *entry = &g_array_index (priv->entries, Entry, match->entry_index);
+
+		ret = g_list_prepend (ret, entry->proposal);
+	}
+
+	return ret;
+}
+
+/**
+ * gtk_source_completion_matcher_fuzzy_match:
+ * @query: the text to match.
+ * @label: the text to match against, for example a proposal label.
+ * @score: (out) (allow-none): return location for the score of the match.
+ *
+ * Checks whether the characters of @query appear in @label in the same order,
+ * ignoring the case. If it is the case, @score is set to a number that is
+ * higher for better matches: the matches at the start of @label or at the
+ * start of a word, and the consecutive matches, give a higher score.
+ *
+ * Returns: whether @label matches @query.
+ * Since: 3.10
+ */
+gboolean
+gtk_source_completion_matcher_fuzzy_match (const gchar *query,
+					   const gchar *label,
+					   gint        *score)
+{
+	gunichar *query_chars;
+	glong query_length;
+	gint cur_score;
+	gboolean match;
+
+	g_return_val_if_fail (query != NULL, FALSE);
+	g_return_val_if_fail (label != NULL, FALSE);
+
+	query_chars = get_query_chars (query, &query_length);
+	match = match_label (query_chars, query_length, label, &cur_score);
+	g_free (query_chars);
+
+	if (match && score != NULL)
+	{
+		*score = cur_score;
+	}
+
+	return match;
+}
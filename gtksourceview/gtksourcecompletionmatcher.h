@@ -0,0 +1,71 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; coding: utf-8 -*- */
+/* gtksourcecompletionmatcher.h
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GTK_SOURCE_COMPLETION_MATCHER_H__
+#define __GTK_SOURCE_COMPLETION_MATCHER_H__
+
+#include <glib-object.h>
+#include <gtksourceview/gtksourcetypes.h>
+
+G_BEGIN_DECLS
+
+#define GTK_SOURCE_TYPE_COMPLETION_MATCHER             (gtk_source_completion_matcher_get_type ())
+#define GTK_SOURCE_COMPLETION_MATCHER(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTK_SOURCE_TYPE_COMPLETION_MATCHER, GtkSourceCompletionMatcher))
+#define GTK_SOURCE_COMPLETION_MATCHER_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GTK_SOURCE_TYPE_COMPLETION_MATCHER, GtkSourceCompletionMatcherClass))
+#define GTK_SOURCE_IS_COMPLETION_MATCHER(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTK_SOURCE_TYPE_COMPLETION_MATCHER))
+#define GTK_SOURCE_IS_COMPLETION_MATCHER_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GTK_SOURCE_TYPE_COMPLETION_MATCHER))
+#define GTK_SOURCE_COMPLETION_MATCHER_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_SOURCE_TYPE_COMPLETION_MATCHER, GtkSourceCompletionMatcherClass))
+
+typedef struct _GtkSourceCompletionMatcherClass    GtkSourceCompletionMatcherClass;
+typedef struct _GtkSourceCompletionMatcherPrivate  GtkSourceCompletionMatcherPrivate;
+
+struct _GtkSourceCompletionMatcher
+{
+	GObject parent;
+
+	GtkSourceCompletionMatcherPrivate *priv;
+};
+
+struct _GtkSourceCompletionMatcherClass
+{
+	GObjectClass parent_class;
+
+	gpointer padding[10];
+};
+
+GType			 gtk_source_completion_matcher_get_type		(void) G_GNUC_CONST;
+
+GtkSourceCompletionMatcher *
+			 gtk_source_completion_matcher_new		(void);
+
+void			 gtk_source_completion_matcher_set_proposals	(GtkSourceCompletionMatcher *matcher,
+									 GList                      *proposals);
+
+GList			*gtk_source_completion_matcher_filter		(GtkSourceCompletionMatcher *matcher,
+									 const gchar                *query);
+
+gboolean		 gtk_source_completion_matcher_fuzzy_match	(const gchar                *query,
+									 const gchar                *label,
+									 gint                       *score);
+
+G_END_DECLS
+
+#endif /* __GTK_SOURCE_COMPLETION_MATCHER_H__ */
@@ -25,20 +25,6 @@
 #include "gtksourcecompletionproposal.h"
 #include "gtksourceview-i18n.h"
 
-typedef struct
-{
-	GtkSourceCompletionModel *model;
-	GtkSourceCompletionProvider *completion_provider;
-
-	/* List of ProposalInfo. If the header is visible, it is included. */
-	GQueue *proposals;
-
-	/* By default, all providers are visible. But with Ctrl+{left, right},
-	 * the user can switch between providers. In this case, only one
-	 * provider is visible, and the others are hidden. */
-	guint visible : 1;
-} ProviderInfo;
-
 typedef struct
 {
 	/* Node from model->priv->providers */
@@ -47,11 +33,40 @@ typedef struct
 	/* For the header, the completion proposal is NULL. */
 	GtkSourceCompletionProposal *completion_proposal;
 
+	/* Index in the proposals array of the provider, -1 for the header. */
+	gint index;
+
 	/* For the "changed" signal emitted by the proposal.
 	 * When the node is freed, the signal is disconnected. */
 	gulong changed_id;
 } ProposalInfo;
 
+typedef struct
+{
+	GtkSourceCompletionModel *model;
+	GtkSourceCompletionProvider *completion_provider;
+
+	/* Array of ProposalInfo, without the header. Proposals are appended,
+	 * or removed by gtk_source_completion_model_filter_proposals(), which
+	 * updates the indexes of the remaining proposals.
+	 */
+	GPtrArray *proposals;
+
+	/* The header row, or NULL if the headers are hidden. */
+	ProposalInfo *header;
+
+	/* Index of the first row, i.e. the number of rows of the visible
+	 * providers before this one. Valid only if the rows index of the model
+	 * is up-to-date, see ensure_rows_index().
+	 */
+	gint start_index;
+
+	/* By default, all providers are visible. But with Ctrl+{left, right},
+	 * the user can switch between providers. In this case, only one
+	 * provider is visible, and the others are hidden. */
+	guint visible : 1;
+} ProviderInfo;
+
 struct _GtkSourceCompletionModelPrivate
 {
 	GType column_types[GTK_SOURCE_COMPLETION_MODEL_N_COLUMNS];
@@ -63,6 +78,16 @@ struct _GtkSourceCompletionModelPrivate
 	 * visible. */
 	GList *visible_providers;
 
+	/* The rows index: array of the visible ProviderInfo, sorted by
+	 * start_index, to find the row at a given index with a binary search.
+	 * NULL when it must be recomputed, i.e. after a change in the
+	 * providers, the proposals, the headers or the visibility.
+	 */
+	GPtrArray *visible_infos;
+
+	/* Total number of rows. Valid only if visible_infos is not NULL. */
+	gint n_rows;
+
 	guint show_headers : 1;
 };
 
@@ -97,100 +122,167 @@ is_provider_visible (GtkSourceCompletionModel    *model,
 	return g_list_find (model->priv->visible_providers, provider) != NULL;
 }
 
-static gboolean
-get_iter_from_index (GtkSourceCompletionModel *model,
-                     GtkTreeIter              *iter,
-                     gint                      idx)
+static gint
+get_provider_n_rows (ProviderInfo *info)
+{
+	return info->proposals->len + (info->header != NULL ? 1 : 0);
+}
+
+/* A provider is created only with some proposals, so it has at least one row. */
+static ProposalInfo *
+get_provider_first_row (ProviderInfo *info)
+{
+	if (info->header != NULL)
+	{
+		return info->header;
+	}
+
+	return g_ptr_array_index (info->proposals, 0);
+}
+
+static ProposalInfo *
+get_provider_last_row (ProviderInfo *info)
 {
-	gint provider_index = 0;
+	return g_ptr_array_index (info->proposals, info->proposals->len - 1);
+}
+
+static void
+invalidate_rows_index (GtkSourceCompletionModel *model)
+{
+	if (model->priv->visible_infos != NULL)
+	{
+		g_ptr_array_free (model->priv->visible_infos, TRUE);
+		model->priv->visible_infos = NULL;
+	}
+}
+
+/* Computes the start index of each provider, i.e. the prefix sums of the
+ * number of rows of the visible providers. It is done lazily, so adding a lot
+ * of proposals in several batches doesn't recompute it each time.
+ */
+static void
+ensure_rows_index (GtkSourceCompletionModel *model)
+{
+	gint start_index = 0;
 	GList *l;
-	ProviderInfo *info;
 
-	if (idx < 0)
+	if (model->priv->visible_infos != NULL)
 	{
-		return FALSE;
+		return;
 	}
 
-	/* Find the provider */
+	model->priv->visible_infos = g_ptr_array_new ();
+
 	for (l = model->priv->providers; l != NULL; l = l->next)
 	{
-		gint new_index;
-		info = l->data;
-
-		if (!info->visible)
-		{
-			continue;
-		}
+		ProviderInfo *info = l->data;
 
-		new_index = provider_index + info->proposals->length;
+		/* A hidden provider also has a start index, for
+		 * get_proposal_path().
+		 */
+		info->start_index = start_index;
 
-		if (idx < new_index)
+		if (info->visible)
 		{
-			break;
+			g_ptr_array_add (model->priv->visible_infos, info);
+			start_index += get_provider_n_rows (info);
 		}
-
-		provider_index = new_index;
 	}
 
-	if (l == NULL)
+	model->priv->n_rows = start_index;
+}
+
+static gboolean
+get_iter_from_index (GtkSourceCompletionModel *model,
+                     GtkTreeIter              *iter,
+                     gint                      idx)
+{
+	GPtrArray *visible_infos;
+	ProviderInfo *info;
+	gint low;
+	gint high;
+	gint row;
+
+	if (idx < 0)
 	{
 		return FALSE;
 	}
 
-	/* Find the node inside the provider */
-	iter->user_data = g_queue_peek_nth_link (info->proposals, idx - provider_index);
+	ensure_rows_index (model);
 
-	return iter->user_data != NULL;
-}
-
-static gint
-get_provider_start_index (GtkSourceCompletionModel *model,
-			  ProviderInfo		   *info)
-{
-	gint start_index = 0;
-	GList *l;
+	if (idx >= model->priv->n_rows)
+	{
+		return FALSE;
+	}
 
-	g_assert (info != NULL);
+	/* Find the provider: the last one with start_index <= idx. */
+	visible_infos = model->priv->visible_infos;
+	low = 0;
+	high = visible_infos->len - 1;
 
-	for (l = model->priv->providers; l != NULL; l = l->next)
+	while (low < high)
 	{
-		ProviderInfo *cur_info = l->data;
+		gint middle = low + (high - low + 1) / 2;
+		ProviderInfo *middle_info = g_ptr_array_index (visible_infos, middle);
 
-		if (cur_info == info)
+		if (middle_info->start_index <= idx)
 		{
-			break;
+			low = middle;
 		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+
+	info = g_ptr_array_index (visible_infos, low);
+
+	/* Find the row inside the provider */
+	row = idx - info->start_index;
 
-		if (cur_info->visible)
+	if (info->header != NULL)
+	{
+		if (row == 0)
 		{
-			start_index += cur_info->proposals->length;
+			iter->user_data = info->header;
+			return TRUE;
 		}
+
+		row--;
 	}
 
-	/* The provider must be in the list. */
-	g_assert (l != NULL);
+	iter->user_data = g_ptr_array_index (info->proposals, row);
 
-	return start_index;
+	return TRUE;
 }
 
 static GtkTreePath *
 get_proposal_path (GtkSourceCompletionModel *model,
-		   GList                    *proposal_node)
+		   ProposalInfo             *proposal_info)
 {
-	ProposalInfo *proposal_info;
 	ProviderInfo *provider_info;
 	gint idx;
 
-	if (proposal_node == NULL)
+	if (proposal_info == NULL)
 	{
 		return NULL;
 	}
 
-	proposal_info = proposal_node->data;
 	provider_info = proposal_info->provider_node->data;
 
-	idx = get_provider_start_index (model, provider_info);
-	idx += g_queue_link_index (provider_info->proposals, proposal_node);
+	ensure_rows_index (model);
+
+	idx = provider_info->start_index;
+
+	if (!is_header (proposal_info))
+	{
+		idx += proposal_info->index;
+
+		if (provider_info->header != NULL)
+		{
+			idx++;
+		}
+	}
 
 	return gtk_tree_path_new_from_indices (idx, -1);
 }
@@ -273,8 +365,7 @@ get_last_iter (GtkSourceCompletionModel *model,
 
 	provider_info = last_provider->data;
 
-	iter->user_data = provider_info->proposals->tail;
-	g_assert (iter->user_data != NULL);
+	iter->user_data = get_provider_last_row (provider_info);
 
 	if (!provider_info->visible)
 	{
@@ -319,7 +410,8 @@ provider_info_free (gpointer data)
 	}
 
 	g_object_unref (info->completion_provider);
-	g_queue_free_full (info->proposals, (GDestroyNotify)proposal_info_free);
+	g_ptr_array_free (info->proposals, TRUE);
+	proposal_info_free (info->header);
 	g_slice_free (ProviderInfo, data);
 }
 
@@ -330,8 +422,12 @@ add_header (GList *provider_node)
 	ProposalInfo *header = g_slice_new0 (ProposalInfo);
 
 	header->provider_node = provider_node;
+	header->index = -1;
 
-	g_queue_push_head (provider_info->proposals, header);
+	g_assert (provider_info->header == NULL);
+	provider_info->header = header;
+
+	invalidate_rows_index (provider_info->model);
 }
 
 /* Add the header, and emit the "row-inserted" signal. */
@@ -345,10 +441,10 @@ show_header (GtkSourceCompletionModel *model,
 
 	if (provider_info->visible)
 	{
-		GtkTreePath *path = get_proposal_path (model, provider_info->proposals->head);
+		GtkTreePath *path = get_proposal_path (model, provider_info->header);
 		GtkTreeIter iter;
 
-		iter.user_data = provider_info->proposals->head;
+		iter.user_data = provider_info->header;
 		gtk_tree_model_row_inserted (GTK_TREE_MODEL (model), path, &iter);
 
 		gtk_tree_path_free (path);
@@ -361,16 +457,23 @@ hide_header (GtkSourceCompletionModel *model,
 	     GList                    *provider_node)
 {
 	ProviderInfo *provider_info = provider_node->data;
-	ProposalInfo *proposal_info = g_queue_pop_head (provider_info->proposals);
-
-	g_assert (provider_info->proposals->length > 0);
-	g_assert (is_header (proposal_info));
+	GtkTreePath *path = NULL;
 
-	proposal_info_free (proposal_info);
+	g_assert (provider_info->header != NULL);
+	g_assert (provider_info->proposals->len > 0);
 
 	if (provider_info->visible)
 	{
-		GtkTreePath *path = get_proposal_path (model, provider_info->proposals->head);
+		path = get_proposal_path (model, provider_info->header);
+	}
+
+	proposal_info_free (provider_info->header);
+	provider_info->header = NULL;
+
+	invalidate_rows_index (model);
+
+	if (path != NULL)
+	{
 		gtk_tree_model_row_deleted (GTK_TREE_MODEL (model), path);
 		gtk_tree_path_free (path);
 	}
@@ -443,7 +546,6 @@ tree_model_get_value (GtkTreeModel *tree_model,
 		      gint          column,
 		      GValue       *value)
 {
-	GList *proposal_node;
 	ProposalInfo *proposal_info;
 	ProviderInfo *provider_info;
 	GtkSourceCompletionProposal *completion_proposal;
@@ -454,8 +556,7 @@ tree_model_get_value (GtkTreeModel *tree_model,
 	g_return_if_fail (iter->user_data != NULL);
 	g_return_if_fail (0 <= column && column < GTK_SOURCE_COMPLETION_MODEL_N_COLUMNS);
 
-	proposal_node = iter->user_data;
-	proposal_info = proposal_node->data;
+	proposal_info = iter->user_data;
 	provider_info = proposal_info->provider_node->data;
 	completion_proposal = proposal_info->completion_proposal;
 	completion_provider = provider_info->completion_provider;
@@ -534,21 +635,25 @@ tree_model_iter_next (GtkTreeModel *tree_model,
 		      GtkTreeIter  *iter)
 {
 	ProposalInfo *proposal_info;
-	GList *proposal_node;
+	ProviderInfo *provider_info;
 	GList *cur_provider;
+	gint next_index;
 
 	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_MODEL (tree_model), FALSE);
 	g_return_val_if_fail (iter != NULL, FALSE);
 	g_return_val_if_fail (iter->user_data != NULL, FALSE);
 
-	proposal_node = iter->user_data;
-	proposal_info = proposal_node->data;
+	proposal_info = iter->user_data;
+	provider_info = proposal_info->provider_node->data;
+
+	/* The header has the index -1. */
+	next_index = proposal_info->index + 1;
 
 	/* Find the right provider, which must be visible */
 
 	cur_provider = proposal_info->provider_node;
 
-	if (proposal_node->next == NULL)
+	if (next_index >= (gint) provider_info->proposals->len)
 	{
 		cur_provider = g_list_next (cur_provider);
 	}
@@ -564,12 +669,11 @@ tree_model_iter_next (GtkTreeModel *tree_model,
 
 	if (cur_provider == proposal_info->provider_node)
 	{
-		iter->user_data = g_list_next (proposal_node);
+		iter->user_data = g_ptr_array_index (provider_info->proposals, next_index);
 	}
 	else
 	{
-		ProviderInfo *info = cur_provider->data;
-		iter->user_data = info->proposals->head;
+		iter->user_data = get_provider_first_row (cur_provider->data);
 	}
 
 	g_assert (iter->user_data != NULL);
@@ -612,8 +716,6 @@ tree_model_iter_n_children (GtkTreeModel *tree_model,
 			    GtkTreeIter  *iter)
 {
 	GtkSourceCompletionModel *model;
-	GList *l;
-	gint num_nodes = 0;
 
 	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_MODEL (tree_model), 0);
 	g_return_val_if_fail (iter == NULL || iter->user_data != NULL, 0);
@@ -625,17 +727,9 @@ tree_model_iter_n_children (GtkTreeModel *tree_model,
 
 	model = GTK_SOURCE_COMPLETION_MODEL (tree_model);
 
-	for (l = model->priv->providers; l != NULL; l = l->next)
-	{
-		ProviderInfo *info = l->data;
-
-		if (info->visible)
-		{
-			num_nodes += info->proposals->length;
-		}
-	}
+	ensure_rows_index (model);
 
-	return num_nodes;
+	return model->priv->n_rows;
 }
 
 static gboolean
@@ -706,6 +800,8 @@ gtk_source_completion_model_dispose (GObject *object)
 	g_list_free_full (model->priv->visible_providers, g_object_unref);
 	model->priv->visible_providers = NULL;
 
+	invalidate_rows_index (model);
+
 	G_OBJECT_CLASS (gtk_source_completion_model_parent_class)->dispose (object);
 }
 
@@ -750,7 +846,7 @@ create_provider_info (GtkSourceCompletionModel    *model,
 	info = g_slice_new0 (ProviderInfo);
 	info->model = model;
 	info->completion_provider = g_object_ref (provider);
-	info->proposals = g_queue_new ();
+	info->proposals = g_ptr_array_new_with_free_func (proposal_info_free);
 	info->visible = is_provider_visible (model, provider);
 
 	/* Insert the ProviderInfo in the list */
@@ -772,6 +868,8 @@ create_provider_info (GtkSourceCompletionModel    *model,
 
 	provider_node = g_list_find (model->priv->providers, info);
 
+	invalidate_rows_index (model);
+
 	/* Insert the header if needed */
 
 	if (model->priv->show_headers)
@@ -784,9 +882,8 @@ create_provider_info (GtkSourceCompletionModel    *model,
 
 static void
 on_proposal_changed (GtkSourceCompletionProposal *proposal,
-		     GList                       *proposal_node)
+		     ProposalInfo                *proposal_info)
 {
-	ProposalInfo *proposal_info = proposal_node->data;
 	ProviderInfo *provider_info = proposal_info->provider_node->data;
 
 	if (provider_info->visible)
@@ -794,8 +891,8 @@ on_proposal_changed (GtkSourceCompletionProposal *proposal,
 		GtkTreeIter iter;
 		GtkTreePath *path;
 
-		iter.user_data = proposal_node;
-		path = get_proposal_path (provider_info->model, proposal_node);
+		iter.user_data = proposal_info;
+		path = get_proposal_path (provider_info->model, proposal_info);
 
 		gtk_tree_model_row_changed (GTK_TREE_MODEL (provider_info->model),
 					    path,
@@ -814,13 +911,14 @@ add_proposal (GtkSourceCompletionProposal *proposal,
 
 	proposal_info->provider_node = provider_node;
 	proposal_info->completion_proposal = g_object_ref (proposal);
+	proposal_info->index = provider_info->proposals->len;
 
-	g_queue_push_tail (provider_info->proposals, proposal_info);
+	g_ptr_array_add (provider_info->proposals, proposal_info);
 
 	proposal_info->changed_id = g_signal_connect (proposal,
 						      "changed",
 						      G_CALLBACK (on_proposal_changed),
-						      provider_info->proposals->tail);
+						      proposal_info);
 }
 
 void
@@ -846,6 +944,121 @@ gtk_source_completion_model_add_proposals (GtkSourceCompletionModel    *model,
 	}
 
 	g_list_foreach (proposals, (GFunc)add_proposal, provider_node);
+
+	invalidate_rows_index (model);
+}
+
+/* Filtering: remove proposals */
+
+/* Keeps only the proposals of @provider for which @filter_func returns TRUE, in
+ * the same order. If @filter_func is NULL, all the proposals are removed. Since
+ * a provider can not be empty, a provider without proposals is removed, with
+ * its header.
+ *
+ * The proposals are removed from the last to the first, and the "row-deleted"
+ * signal is emitted right after each removal, so the model is always
+ * consistent with the signals received by the views. Walking backwards, only
+ * the kept proposals after a removed one are moved.
+ */
+void
+gtk_source_completion_model_filter_proposals (GtkSourceCompletionModel           *model,
+					      GtkSourceCompletionProvider        *provider,
+					      GtkSourceCompletionModelFilterFunc  filter_func,
+					      gpointer                            user_data)
+{
+	GList *provider_node;
+	ProviderInfo *provider_info;
+	GPtrArray *proposals;
+	gboolean *keep;
+	guint n_kept = 0;
+	gint first_row;
+	guint i;
+
+	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_MODEL (model));
+	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_PROVIDER (provider));
+
+	provider_node = get_provider_node (model, provider);
+
+	if (provider_node == NULL)
+	{
+		return;
+	}
+
+	provider_info = provider_node->data;
+	proposals = provider_info->proposals;
+
+	keep = g_new (gboolean, proposals->len);
+
+	for (i = 0; i < proposals->len; i++)
+	{
+		ProposalInfo *proposal_info = g_ptr_array_index (proposals, i);
+
+		keep[i] = (filter_func != NULL &&
+			   filter_func (proposal_info->completion_proposal, user_data));
+
+		if (keep[i])
+		{
+			n_kept++;
+		}
+	}
+
+	/* The header of a provider that loses all its proposals is removed
+	 * first, so the provider has a row until the last one is removed.
+	 */
+	if (n_kept == 0 && provider_info->header != NULL)
+	{
+		hide_header (model, provider_node);
+	}
+
+	ensure_rows_index (model);
+
+	first_row = provider_info->start_index;
+
+	if (provider_info->header != NULL)
+	{
+		first_row++;
+	}
+
+	for (i = proposals->len; i > 0; i--)
+	{
+		guint pos = i - 1;
+		guint j;
+
+		if (keep[pos])
+		{
+			continue;
+		}
+
+		g_ptr_array_remove_index (proposals, pos);
+
+		for (j = pos; j < proposals->len; j++)
+		{
+			ProposalInfo *proposal_info = g_ptr_array_index (proposals, j);
+			proposal_info->index = j;
+		}
+
+		if (proposals->len == 0)
+		{
+			model->priv->providers = g_list_delete_link (model->priv->providers,
+								     provider_node);
+		}
+
+		invalidate_rows_index (model);
+
+		if (provider_info->visible)
+		{
+			GtkTreePath *path = gtk_tree_path_new_from_indices (first_row + pos, -1);
+			gtk_tree_model_row_deleted (GTK_TREE_MODEL (model), path);
+			gtk_tree_path_free (path);
+		}
+	}
+
+	if (proposals->len == 0)
+	{
+		provider_info_free (provider_info);
+	}
+
+	g_free (keep);
 }
 
 /* Other public functions */
@@ -874,6 +1087,8 @@ gtk_source_completion_model_set_visible_providers (GtkSourceCompletionModel *mod
 		ProviderInfo *provider_info = l->data;
 		provider_info->visible = is_provider_visible (model, provider_info->completion_provider);
 	}
+
+	invalidate_rows_index (model);
 }
 
 GList *
@@ -941,17 +1156,11 @@ gboolean
 gtk_source_completion_model_iter_is_header (GtkSourceCompletionModel *model,
                                             GtkTreeIter              *iter)
 {
-	GList *proposal_node;
-	ProposalInfo *proposal_info;
-
 	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_MODEL (model), FALSE);
 	g_return_val_if_fail (iter != NULL, FALSE);
 	g_return_val_if_fail (iter->user_data != NULL, FALSE);
 
-	proposal_node = iter->user_data;
-	proposal_info = proposal_node->data;
-
-	return is_header (proposal_info);
+	return is_header (iter->user_data);
 }
 
 gboolean
@@ -961,21 +1170,24 @@ gtk_source_completion_model_iter_previous (GtkSourceCompletionModel *model,
 	/* This function is the symmetry of tree_model_iter_next(). */
 
 	ProposalInfo *proposal_info;
-	GList *proposal_node;
+	ProviderInfo *provider_info;
 	GList *cur_provider;
+	gboolean is_first_row;
 
 	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_MODEL (model), FALSE);
 	g_return_val_if_fail (iter != NULL, FALSE);
 	g_return_val_if_fail (iter->user_data != NULL, FALSE);
 
-	proposal_node = iter->user_data;
-	proposal_info = proposal_node->data;
+	proposal_info = iter->user_data;
+	provider_info = proposal_info->provider_node->data;
+
+	is_first_row = proposal_info == get_provider_first_row (provider_info);
 
 	/* Find the right provider, which must be visible */
 
 	cur_provider = proposal_info->provider_node;
 
-	if (proposal_node->prev == NULL)
+	if (is_first_row)
 	{
 		cur_provider = g_list_previous (cur_provider);
 	}
@@ -989,14 +1201,18 @@ gtk_source_completion_model_iter_previous (GtkSourceCompletionModel *model,
 
 	/* Find the proposal inside the provider */
 
-	if (cur_provider == proposal_info->provider_node)
+	if (cur_provider != proposal_info->provider_node)
+	{
+		iter->user_data = get_provider_last_row (cur_provider->data);
+	}
+	else if (proposal_info->index == 0)
 	{
-		iter->user_data = g_list_previous (proposal_node);
+		iter->user_data = provider_info->header;
 	}
 	else
 	{
-		ProviderInfo *info = cur_provider->data;
-		iter->user_data = info->proposals->tail;
+		iter->user_data = g_ptr_array_index (provider_info->proposals,
+						     proposal_info->index - 1);
 	}
 
 	g_assert (iter->user_data != NULL);
@@ -1144,16 +1360,11 @@ proposal_has_info (GtkSourceCompletionProvider *provider,
 static gboolean
 provider_has_info (ProviderInfo *provider_info)
 {
-	GList *l;
+	guint i;
 
-	for (l = provider_info->proposals->head; l != NULL; l = l->next)
+	for (i = 0; i < provider_info->proposals->len; i++)
 	{
-		ProposalInfo *proposal_info = l->data;
-
-		if (proposal_info->completion_proposal == NULL)
-		{
-			continue;
-		}
+		ProposalInfo *proposal_info = g_ptr_array_index (provider_info->proposals, i);
 
 		if (proposal_has_info (provider_info->completion_provider,
 				       proposal_info->completion_proposal))
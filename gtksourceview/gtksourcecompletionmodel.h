@@ -61,6 +61,10 @@ enum
 	GTK_SOURCE_COMPLETION_MODEL_N_COLUMNS
 };
 
+/* Returns %TRUE to keep @proposal. */
+typedef gboolean (*GtkSourceCompletionModelFilterFunc) (GtkSourceCompletionProposal *proposal,
+							gpointer                     user_data);
+
 G_GNUC_INTERNAL
 GType    gtk_source_completion_model_get_type			(void) G_GNUC_CONST;
 
@@ -73,6 +77,12 @@ void     gtk_source_completion_model_add_proposals              (GtkSourceComple
 								 GtkSourceCompletionProvider *provider,
 								 GList                       *proposals);
 
+G_GNUC_INTERNAL
+void     gtk_source_completion_model_filter_proposals		(GtkSourceCompletionModel           *model,
+								 GtkSourceCompletionProvider        *provider,
+								 GtkSourceCompletionModelFilterFunc  filter_func,
+								 gpointer                            user_data);
+
 G_GNUC_INTERNAL
 gboolean gtk_source_completion_model_is_empty			(GtkSourceCompletionModel    *model,
 								 gboolean                     only_visible);
@@ -32,6 +32,7 @@
 #include "gtksourcecompletionprovider.h"
 #include "gtksourcecompletionproposal.h"
 #include "gtksourcecompletioninfo.h"
+#include "gtksourceview-i18n.h"
 
 typedef GtkSourceCompletionProviderIface GtkSourceCompletionProviderInterface;
 
@@ -115,6 +116,12 @@ gtk_source_completion_provider_get_priority_default (GtkSourceCompletionProvider
 	return 0;
 }
 
+static gboolean
+gtk_source_completion_provider_get_repopulate_default (GtkSourceCompletionProvider *provider)
+{
+	return TRUE;
+}
+
 static void
 gtk_source_completion_provider_default_init (GtkSourceCompletionProviderIface *iface)
 {
@@ -134,6 +141,7 @@ gtk_source_completion_provider_default_init (GtkSourceCompletionProviderIface *i
 
 	iface->get_interactive_delay = gtk_source_completion_provider_get_interactive_delay_default;
 	iface->get_priority = gtk_source_completion_provider_get_priority_default;
+	iface->get_repopulate = gtk_source_completion_provider_get_repopulate_default;
 }
 
 /**
@@ -388,3 +396,124 @@ gtk_source_completion_provider_get_priority (GtkSourceCompletionProvider *provid
 
 	return GTK_SOURCE_COMPLETION_PROVIDER_GET_INTERFACE (provider)->get_priority (provider);
 }
+
+/**
+ * gtk_source_completion_provider_get_repopulate:
+ * @provider: a #GtkSourceCompletionProvider.
+ *
+ * Get whether gtk_source_completion_provider_populate() must be called again
+ * each time the word under the cursor is extended.
+ *
+ * By default, %TRUE is returned: when the user types more characters at the end
+ * of the word, @provider is populated again, as with the previous versions.
+ *
+ * A provider can return %FALSE to have its proposals narrowed in place instead,
+ * which is faster: the proposals of @provider that don't match the new word are
+ * removed from the completion window, and @provider is not populated again. The
+ * text of the proposals (or their label if they have no text) is fuzzy matched
+ * against the word, see gtk_source_completion_matcher_fuzzy_match(), and a
+ * proposal equal to the word is removed too.
+ * gtk_source_completion_provider_match() is not called. So a provider should
+ * return %FALSE only if its own population filters the proposals the same way.
+ *
+ * Returns: %TRUE if @provider must be populated again when the word is
+ * extended, %FALSE if its proposals can be narrowed in place.
+ *
+ * Since: 3.10
+ */
+gboolean
+gtk_source_completion_provider_get_repopulate (GtkSourceCompletionProvider *provider)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_PROVIDER (provider), FALSE);
+
+	return GTK_SOURCE_COMPLETION_PROVIDER_GET_INTERFACE (provider)->get_repopulate (provider);
+}
+
+/**
+ * gtk_source_completion_provider_populate_async:
+ * @provider: a #GtkSourceCompletionProvider.
+ * @context: a #GtkSourceCompletionContext.
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the request is
+ *   satisfied.
+ * @user_data: (closure): the data to pass to the @callback function.
+ *
+ * Asynchronously computes the proposals for @context. It is an alternative to
+ * gtk_source_completion_provider_populate(), for the providers that do an
+ * expensive work, like querying an index of symbols. If a provider implements
+ * this virtual function, #GtkSourceCompletion uses it instead of
+ * gtk_source_completion_provider_populate().
+ *
+ * The implementation should retrieve what it needs from @context (e.g. the
+ * word at the context iter) right away, in the main thread, and then do the
+ * work in a worker thread, for example with g_task_run_in_thread(). This way,
+ * the typing is never blocked by the provider. The completion cancels
+ * @cancellable when the proposals are not needed anymore, typically when the
+ * user continues typing; the results are then ignored.
+ *
+ * If the provider doesn't implement this virtual function, the operation fails
+ * with a %G_IO_ERROR_NOT_SUPPORTED error.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_completion_provider_populate_async (GtkSourceCompletionProvider *provider,
+					       GtkSourceCompletionContext  *context,
+					       GCancellable                *cancellable,
+					       GAsyncReadyCallback          callback,
+					       gpointer                     user_data)
+{
+	GtkSourceCompletionProviderIface *iface;
+
+	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_PROVIDER (provider));
+	g_return_if_fail (GTK_SOURCE_IS_COMPLETION_CONTEXT (context));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	iface = GTK_SOURCE_COMPLETION_PROVIDER_GET_INTERFACE (provider);
+
+	if (iface->populate_async == NULL)
+	{
+		g_task_report_new_error (provider,
+					 callback,
+					 user_data,
+					 gtk_source_completion_provider_populate_async,
+					 G_IO_ERROR,
+					 G_IO_ERROR_NOT_SUPPORTED,
+					 _("The provider doesn't support asynchronous population."));
+		return;
+	}
+
+	iface->populate_async (provider, context, cancellable, callback, user_data);
+}
+
+/**
+ * gtk_source_completion_provider_populate_finish:
+ * @provider: a #GtkSourceCompletionProvider.
+ * @result: a #GAsyncResult.
+ * @error: a #GError, or %NULL.
+ *
+ * Finishes an asynchronous population started with
+ * gtk_source_completion_provider_populate_async().
+ *
+ * Returns: (transfer full) (element-type GtkSource.CompletionProposal): the
+ * list of proposals, or %NULL if there are no proposals or if an error occurred.
+ * Free with g_list_free_full() and g_object_unref().
+ *
+ * Since: 3.10
+ */
+GList *
+gtk_source_completion_provider_populate_finish (GtkSourceCompletionProvider  *provider,
+						GAsyncResult                 *result,
+						GError                      **error)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_COMPLETION_PROVIDER (provider), NULL);
+	g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+
+	if (g_async_result_is_tagged (result, gtk_source_completion_provider_populate_async))
+	{
+		return g_task_propagate_pointer (G_TASK (result), error);
+	}
+
+	return GTK_SOURCE_COMPLETION_PROVIDER_GET_INTERFACE (provider)->populate_finish (provider, result, error);
+}
+
@@ -61,6 +61,12 @@ typedef struct _GtkSourceCompletionProviderIface GtkSourceCompletionProviderIfac
  * By default, -1 is returned.
  * @get_priority: The virtual function pointer for gtk_source_completion_provider_get_priority().
  * By default, 0 is returned.
+ * @get_repopulate: The virtual function pointer for gtk_source_completion_provider_get_repopulate().
+ * By default, %TRUE is returned.
+ * @populate_async: The virtual function pointer for gtk_source_completion_provider_populate_async().
+ * Not implemented by default, in which case @populate is used.
+ * @populate_finish: The virtual function pointer for gtk_source_completion_provider_populate_finish().
+ * Must be implemented if @populate_async is implemented.
  *
  * The virtual function table for #GtkSourceCompletionProvider.
  */
@@ -95,6 +101,16 @@ struct _GtkSourceCompletionProviderIface
 
 	gint		 (*get_interactive_delay) (GtkSourceCompletionProvider *provider);
 	gint		 (*get_priority)	(GtkSourceCompletionProvider *provider);
+	gboolean	 (*get_repopulate)	(GtkSourceCompletionProvider *provider);
+
+	void		 (*populate_async)	(GtkSourceCompletionProvider *provider,
+						 GtkSourceCompletionContext  *context,
+						 GCancellable                *cancellable,
+						 GAsyncReadyCallback          callback,
+						 gpointer                     user_data);
+	GList		*(*populate_finish)	(GtkSourceCompletionProvider *provider,
+						 GAsyncResult                *result,
+						 GError                     **error);
 };
 
 GType		 gtk_source_completion_provider_get_type	(void);
@@ -132,6 +148,18 @@ gboolean	 gtk_source_completion_provider_activate_proposal (GtkSourceCompletionP
 gint		 gtk_source_completion_provider_get_interactive_delay (GtkSourceCompletionProvider *provider);
 gint		 gtk_source_completion_provider_get_priority	(GtkSourceCompletionProvider *provider);
 
+gboolean	 gtk_source_completion_provider_get_repopulate	(GtkSourceCompletionProvider *provider);
+
+void		 gtk_source_completion_provider_populate_async	(GtkSourceCompletionProvider *provider,
+								 GtkSourceCompletionContext  *context,
+								 GCancellable                *cancellable,
+								 GAsyncReadyCallback          callback,
+								 gpointer                     user_data);
+
+GList		*gtk_source_completion_provider_populate_finish	(GtkSourceCompletionProvider *provider,
+								 GAsyncResult                *result,
+								 GError                     **error);
+
 G_END_DECLS
 
 #endif /* __GTK_SOURCE_COMPLETION_PROVIDER_H__ */
@@ -28,6 +28,7 @@
 #include "gtksourcelanguage.h"
 #include "gtksourcelanguage-private.h"
 #include "gtksourcebuffer.h"
+#include "gtksourcebuffer-private.h"
 #include "gtksourceregex.h"
 #include "gtksourcestyle-private.h"
 #include "gtksourceview-utils.h"
@@ -2222,6 +2223,12 @@ gtk_source_context_engine_update_highlight (GtkSourceEngine   *engine,
 	if (!ce->priv->highlight || ce->priv->disabled)
 		return;
 
+	/* The text changes are notified at the end of the batch edit, the
+	 * tree doesn't match the buffer contents until then.
+	 */
+	if (batch_edit_pending (ce))
+		return;
+
 	invalid_line = get_invalid_line (ce);
 	end_line = gtk_text_iter_get_line (end);
 
@@ -2310,6 +2317,23 @@ all_analyzed (GtkSourceContextEngine *ce)
 	return ce->priv->invalid == NULL && ce->priv->invalid_region.empty;
 }
 
+/**
+ * batch_edit_pending:
+ * @ce: a #GtkSourceContextEngine.
+ *
+ * Returns: whether the buffer has been modified during a batch edit that is
+ * not yet finished. The engine is notified of those changes only at the end,
+ * so it must not analyze the buffer in the meantime.
+ */
+static gboolean
+batch_edit_pending (GtkSourceContextEngine *ce)
+{
+	GtkSourceBuffer *buffer = GTK_SOURCE_BUFFER (ce->priv->buffer);
+
+	return (_gtk_source_buffer_is_highlighting_deferred (buffer) &&
+		_gtk_source_buffer_get_batch_edit_region (buffer, NULL, NULL));
+}
+
 /**
  * idle_worker:
  * @ce: #GtkSourceContextEngine.
@@ -2324,6 +2348,13 @@ idle_worker (GtkSourceContextEngine *ce)
 
 	g_return_val_if_fail (ce->priv->buffer != NULL, G_SOURCE_REMOVE);
 
+	/* Reinstalled when the batch edit finishes. */
+	if (batch_edit_pending (ce))
+	{
+		ce->priv->incremental_update = 0;
+		return G_SOURCE_REMOVE;
+	}
+
 	/* analyze batch of text */
 	update_syntax (ce, NULL, INCREMENTAL_UPDATE_TIME_SLICE);
 	CHECK_TREE (ce);
@@ -2349,6 +2380,13 @@ first_update_callback (GtkSourceContextEngine *ce)
 {
 	g_return_val_if_fail (ce->priv->buffer != NULL, G_SOURCE_REMOVE);
 
+	/* Reinstalled when the batch edit finishes. */
+	if (batch_edit_pending (ce))
+	{
+		ce->priv->first_update = 0;
+		return G_SOURCE_REMOVE;
+	}
+
 	/* analyze batch of text */
 	update_syntax (ce, NULL, FIRST_UPDATE_TIME_SLICE);
 	CHECK_TREE (ce);
@@ -0,0 +1,962 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; coding: utf-8 -*- */
+/* gtksourcemultisearch.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "gtksourcemultisearch.h"
+#include "gtksourcesearchsettings.h"
+#include "gtksourcebuffer.h"
+#include "gtksourceview-i18n.h"
+#include "gtksourceview-marshal.h"
+
+#include <string.h>
+
+/**
+ * SECTION:multisearch
+ * @Short_description: Search in several buffers at once
+ * @Title: GtkSourceMultiSearch
+ * @See_also: #GtkSourceSearchContext, #GtkSourceSearchSettings
+ *
+ * A #GtkSourceMultiSearch searches the same #GtkSourceSearchSettings in a set
+ * of #GtkSourceBuffer<!-- -->s, for example for a "find in project" feature.
+ *
+ * Unlike #GtkSourceSearchContext, a #GtkSourceMultiSearch doesn't highlight
+ * anything and doesn't follow the buffer modifications. When
+ * gtk_source_multi_search_run_async() is called, a snapshot of each buffer's
+ * contents is taken, and the snapshots are scanned concurrently in worker
+ * threads. The matches are streamed back in the main thread through the
+ * #GtkSourceMultiSearch::match-found signal, while the scan is still running.
+ *
+ * If a buffer is modified while it is scanned, its remaining matches are
+ * discarded, because the offsets would refer to an outdated content.
+ *
+ * The search is always done with a #GRegex, even when the regex search is
+ * disabled in the settings (the search text is then escaped). So the
+ * #GtkSourceSearchSettings:at-word-boundaries setting uses \b, which is not
+ * exactly the same as gtk_text_iter_starts_word() and
+ * gtk_text_iter_ends_word(). The #GtkSourceSearchSettings:wrap-around setting
+ * is meaningless here and is ignored.
+ */
+
+/* Implementation overview:
+ *
+ * For each run, a RunData is allocated. It is shared between the main thread
+ * and the worker threads, hence the atomic reference count. For each buffer,
+ * a Job is pushed to a thread pool. A Job contains the text snapshot, taken in
+ * the main thread with gtk_text_buffer_get_slice() (with the hidden text and
+ * the 0xFFFC character for pixbufs and child anchors, so that the character
+ * offsets are the same as in the buffer).
+ *
+ * The worker threads push Batches of matches to an asynchronous queue, and a
+ * last Batch with the done flag set when the Job is finished. The main thread
+ * drains the queue in an idle callback, emits the signals, and when all the
+ * Jobs are done, returns the GTask.
+ *
+ * Since there is only one queue per run, the order of the Batches of a given
+ * Job is preserved, so the done Batch is always the last one.
+ */
+
+/* Maximum number of matches in one batch sent to the main thread. */
+#define BATCH_SIZE 64
+
+/* Maximum number of characters of a preview. */
+#define PREVIEW_MAX_CHARS 128
+
+enum
+{
+	PROP_0,
+	PROP_SETTINGS
+};
+
+enum
+{
+	MATCH_FOUND,
+	N_SIGNALS
+};
+
+typedef struct _RunData RunData;
+
+struct _GtkSourceMultiSearchPrivate
+{
+	GtkSourceSearchSettings *settings;
+
+	/* List of GtkSourceBuffer's, with a reference. */
+	GList *buffers;
+
+	RunData *run;
+};
+
+struct _RunData
+{
+	volatile gint ref_count;
+
+	/* Main thread only. NULL when the run is cleared. */
+	GtkSourceMultiSearch *search;
+	GTask *task;
+	guint nb_pending_jobs;
+	gint nb_matches;
+
+	/* Read-only in the worker threads. */
+	GRegex *regex;
+	GCancellable *cancellable;
+
+	GMainContext *main_context;
+	GAsyncQueue *queue;
+	volatile gint drain_scheduled;
+	volatile gint cancelled;
+};
+
+typedef struct
+{
+	RunData *run;
+
+	/* Main thread only. */
+	GtkSourceBuffer *buffer;
+	gulong changed_handler_id;
+
+	/* Freed by the worker thread. */
+	gchar *text;
+
+	/* Set in the main thread when the buffer is modified. */
+	volatile gint stale;
+} Job;
+
+typedef struct
+{
+	gint offset;
+	gint length;
+	gint line;
+	gchar *preview;
+} Match;
+
+typedef struct
+{
+	Job *job;
+
+	/* Array of Match's. */
+	GArray *matches;
+
+	guint done : 1;
+} Batch;
+
+static guint signals[N_SIGNALS];
+
+G_DEFINE_TYPE_WITH_PRIVATE (GtkSourceMultiSearch, gtk_source_multi_search, G_TYPE_OBJECT)
+
+static RunData *
+run_data_ref (RunData *run)
+{
+	g_atomic_int_inc (&run->ref_count);
+	return run;
+}
+
+static void
+run_data_unref (RunData *run)
+{
+	if (g_atomic_int_dec_and_test (&run->ref_count))
+	{
+		g_assert (run->task == NULL);
+
+		if (run->regex != NULL)
+		{
+			g_regex_unref (run->regex);
+		}
+
+		g_clear_object (&run->cancellable);
+		g_main_context_unref (run->main_context);
+		g_async_queue_unref (run->queue);
+
+		g_slice_free (RunData, run);
+	}
+}
+
+static gboolean
+run_data_is_cancelled (RunData *run)
+{
+	return (g_atomic_int_get (&run->cancelled) ||
+		g_cancellable_is_cancelled (run->cancellable));
+}
+
+static void
+match_clear (Match *match)
+{
+	g_free (match->preview);
+}
+
+static Batch *
+batch_new (Job *job)
+{
+	Batch *batch = g_slice_new0 (Batch);
+
+	batch->job = job;
+	batch->matches = g_array_sized_new (FALSE, FALSE, sizeof (Match), BATCH_SIZE);
+	g_array_set_clear_func (batch->matches, (GDestroyNotify)match_clear);
+
+	return batch;
+}
+
+static void
+batch_free (Batch *batch)
+{
+	g_array_unref (batch->matches);
+	g_slice_free (Batch, batch);
+}
+
+/* Main thread only. */
+static void
+job_free (Job *job)
+{
+	if (job->changed_handler_id != 0)
+	{
+		g_signal_handler_disconnect (job->buffer, job->changed_handler_id);
+	}
+
+	g_object_unref (job->buffer);
+	g_free (job->text);
+	run_data_unref (job->run);
+
+	g_slice_free (Job, job);
+}
+
+static void
+buffer_changed_cb (GtkTextBuffer *buffer,
+		   Job           *job)
+{
+	g_atomic_int_set (&job->stale, 1);
+}
+
+static void
+complete_run (RunData *run)
+{
+	GTask *task = run->task;
+	gint nb_matches = run->nb_matches;
+
+	run->task = NULL;
+
+	if (run->search != NULL && run->search->priv->run == run)
+	{
+		run->search->priv->run = NULL;
+		run->search = NULL;
+
+		/* May free the run data. */
+		run_data_unref (run);
+	}
+
+	if (task != NULL)
+	{
+		if (!g_task_return_error_if_cancelled (task))
+		{
+			g_task_return_int (task, nb_matches);
+		}
+
+		g_object_unref (task);
+	}
+}
+
+static gboolean
+drain_queue_cb (RunData *run)
+{
+	Batch *batch;
+
+	/* Reset the flag before popping, so a batch pushed during the drain
+	 * schedules a new drain, and is never forgotten.
+	 */
+	g_atomic_int_set (&run->drain_scheduled, 0);
+
+	while ((batch = g_async_queue_try_pop (run->queue)) != NULL)
+	{
+		Job *job = batch->job;
+
+		if (run->search != NULL &&
+		    !run_data_is_cancelled (run) &&
+		    !g_atomic_int_get (&job->stale))
+		{
+			guint i;
+
+			for (i = 0; i < batch->matches->len; i++)
+			{
+				Match *match = &g_array_index (batch->matches, Match, i);
+
+				run->nb_matches++;
+
+				g_signal_emit (run->search,
+					       signals[MATCH_FOUND],
+					       0,
+					       job->buffer,
+					       match->offset,
+					       match->length,
+					       match->line,
+					       match->preview);
+
+				/* A signal handler can clear the run. */
+				if (run->search == NULL)
+				{
+					break;
+				}
+			}
+		}
+
+		if (batch->done)
+		{
+			job_free (job);
+
+			g_assert (run->nb_pending_jobs > 0);
+			run->nb_pending_jobs--;
+
+			if (run->nb_pending_jobs == 0)
+			{
+				complete_run (run);
+			}
+		}
+
+		batch_free (batch);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Called in a worker thread. */
+static void
+push_batch (RunData *run,
+	    Batch   *batch)
+{
+	g_async_queue_push (run->queue, batch);
+
+	/* Not g_main_context_invoke(): if the main context is not owned, it
+	 * would run the callback right now, in this thread.
+	 */
+	if (g_atomic_int_compare_and_exchange (&run->drain_scheduled, 0, 1))
+	{
+		GSource *source = g_idle_source_new ();
+
+		g_source_set_priority (source, G_PRIORITY_DEFAULT_IDLE);
+		g_source_set_callback (source,
+				       (GSourceFunc)drain_queue_cb,
+				       run_data_ref (run),
+				       (GDestroyNotify)run_data_unref);
+
+		g_source_attach (source, run->main_context);
+		g_source_unref (source);
+	}
+}
+
+/* Returns the byte length of the line delimiter at @p, or 0. */
+static gint
+line_delimiter_length (const gchar *p)
+{
+	if (p[0] == '\n')
+	{
+		return 1;
+	}
+
+	if (p[0] == '\r')
+	{
+		return p[1] == '\n' ? 2 : 1;
+	}
+
+	/* U+2029 PARAGRAPH SEPARATOR */
+	if ((guchar)p[0] == 0xE2 && (guchar)p[1] == 0x80 && (guchar)p[2] == 0xA9)
+	{
+		return 3;
+	}
+
+	return 0;
+}
+
+static gchar *
+get_preview (const gchar *line_start)
+{
+	const gchar *p = line_start;
+	gint nb_chars = 0;
+
+	while (*p != '\0' &&
+	       line_delimiter_length (p) == 0 &&
+	       nb_chars < PREVIEW_MAX_CHARS)
+	{
+		p = g_utf8_next_char (p);
+		nb_chars++;
+	}
+
+	return g_strndup (line_start, p - line_start);
+}
+
+/* Called in a worker thread. */
+static void
+scan_job (Job *job)
+{
+	RunData *run = job->run;
+	const gchar *text = job->text;
+	gssize text_length = strlen (text);
+	Batch *batch = batch_new (job);
+	GMatchInfo *match_info = NULL;
+
+	/* Position reached so far, for incremental offset and line counting. */
+	const gchar *pos = text;
+	const gchar *line_start = text;
+	gint offset = 0;
+	gint line = 0;
+
+	g_regex_match_full (run->regex,
+			    text,
+			    text_length,
+			    0,
+			    0,
+			    &match_info,
+			    NULL);
+
+	while (g_match_info_matches (match_info))
+	{
+		gint start_byte_pos;
+		gint end_byte_pos;
+		const gchar *match_start;
+		Match match;
+
+		if (run_data_is_cancelled (run) ||
+		    g_atomic_int_get (&job->stale))
+		{
+			break;
+		}
+
+		if (!g_match_info_fetch_pos (match_info, 0, &start_byte_pos, &end_byte_pos))
+		{
+			break;
+		}
+
+		match_start = text + start_byte_pos;
+
+		while (pos < match_start)
+		{
+			gint delimiter_length = line_delimiter_length (pos);
+
+			if (delimiter_length > 0 &&
+			    pos + delimiter_length <= match_start)
+			{
+				pos += delimiter_length;
+				line++;
+				line_start = pos;
+
+				/* "\r\n" is two characters but one line
+				 * delimiter. U+2029 is one character.
+				 */
+				offset += delimiter_length == 3 ? 1 : delimiter_length;
+			}
+			else
+			{
+				pos = g_utf8_next_char (pos);
+				offset++;
+			}
+		}
+
+		match.offset = offset;
+		match.length = g_utf8_strlen (match_start, end_byte_pos - start_byte_pos);
+		match.line = line;
+		match.preview = get_preview (line_start);
+
+		g_array_append_val (batch->matches, match);
+
+		if (batch->matches->len >= BATCH_SIZE)
+		{
+			push_batch (run, batch);
+			batch = batch_new (job);
+		}
+
+		g_match_info_next (match_info, NULL);
+	}
+
+	g_match_info_free (match_info);
+
+	g_free (job->text);
+	job->text = NULL;
+
+	batch->done = TRUE;
+	push_batch (run, batch);
+}
+
+static void
+worker_func (Job      *job,
+	     gpointer  user_data)
+{
+	scan_job (job);
+}
+
+static GThreadPool *
+get_thread_pool (void)
+{
+	static GThreadPool *pool = NULL;
+
+	if (g_once_init_enter (&pool))
+	{
+		GThreadPool *new_pool;
+
+		new_pool = g_thread_pool_new ((GFunc)worker_func,
+					      NULL,
+					      MAX (1, g_get_num_processors ()),
+					      FALSE,
+					      NULL);
+
+		g_once_init_leave (&pool, new_pool);
+	}
+
+	return pool;
+}
+
+static GRegex *
+create_regex (GtkSourceSearchSettings  *settings,
+	      GError                  **error)
+{
+	const gchar *search_text = gtk_source_search_settings_get_search_text (settings);
+	GRegexCompileFlags compile_flags = G_REGEX_OPTIMIZE | G_REGEX_MULTILINE;
+	gchar *pattern;
+	GRegex *regex;
+
+	if (search_text == NULL)
+	{
+		return NULL;
+	}
+
+	if (!gtk_source_search_settings_get_case_sensitive (settings))
+	{
+		compile_flags |= G_REGEX_CASELESS;
+	}
+
+	if (gtk_source_search_settings_get_regex_enabled (settings))
+	{
+		pattern = g_strdup (search_text);
+	}
+	else
+	{
+		pattern = g_regex_escape_string (search_text, -1);
+	}
+
+	if (gtk_source_search_settings_get_at_word_boundaries (settings))
+	{
+		gchar *tmp = pattern;
+		pattern = g_strdup_printf ("\\b%s\\b", tmp);
+		g_free (tmp);
+	}
+
+	regex = g_regex_new (pattern,
+			     compile_flags,
+			     G_REGEX_MATCH_NOTEMPTY,
+			     error);
+
+	g_free (pattern);
+	return regex;
+}
+
+static void
+clear_run (GtkSourceMultiSearch *search)
+{
+	RunData *run = search->priv->run;
+
+	if (run == NULL)
+	{
+		return;
+	}
+
+	search->priv->run = NULL;
+
+	/* The pending jobs keep a reference to the run data, and the queue is
+	 * still drained to free them.
+	 */
+	g_atomic_int_set (&run->cancelled, 1);
+	run->search = NULL;
+
+	if (run->task != NULL)
+	{
+		GTask *task = run->task;
+
+		run->task = NULL;
+
+		g_task_return_new_error (task,
+					 G_IO_ERROR,
+					 G_IO_ERROR_CANCELLED,
+					 "%s",
+					 _("The search has been restarted or stopped"));
+
+		g_object_unref (task);
+	}
+
+	run_data_unref (run);
+}
+
+static void
+gtk_source_multi_search_dispose (GObject *object)
+{
+	GtkSourceMultiSearch *search = GTK_SOURCE_MULTI_SEARCH (object);
+
+	clear_run (search);
+
+	g_list_free_full (search->priv->buffers, g_object_unref);
+	search->priv->buffers = NULL;
+
+	g_clear_object (&search->priv->settings);
+
+	G_OBJECT_CLASS (gtk_source_multi_search_parent_class)->dispose (object);
+}
+
+static void
+gtk_source_multi_search_get_property (GObject    *object,
+				      guint       prop_id,
+				      GValue     *value,
+				      GParamSpec *pspec)
+{
+	GtkSourceMultiSearch *search;
+
+	g_return_if_fail (GTK_SOURCE_IS_MULTI_SEARCH (object));
+
+	search = GTK_SOURCE_MULTI_SEARCH (object);
+
+	switch (prop_id)
+	{
+		case PROP_SETTINGS:
+			g_value_set_object (value, search->priv->settings);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gtk_source_multi_search_set_property (GObject      *object,
+				      guint         prop_id,
+				      const GValue *value,
+				      GParamSpec   *pspec)
+{
+	GtkSourceMultiSearch *search;
+
+	g_return_if_fail (GTK_SOURCE_IS_MULTI_SEARCH (object));
+
+	search = GTK_SOURCE_MULTI_SEARCH (object);
+
+	switch (prop_id)
+	{
+		case PROP_SETTINGS:
+			gtk_source_multi_search_set_settings (search, g_value_get_object (value));
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gtk_source_multi_search_class_init (GtkSourceMultiSearchClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gtk_source_multi_search_dispose;
+	object_class->get_property = gtk_source_multi_search_get_property;
+	object_class->set_property = gtk_source_multi_search_set_property;
+
+	/**
+	 * GtkSourceMultiSearch:settings:
+	 *
+	 * The #GtkSourceSearchSettings associated to the multi search.
+	 *
+	 * Since: 3.10
+	 */
+	g_object_class_install_property (object_class,
+					 PROP_SETTINGS,
+					 g_param_spec_object ("settings",
+							      _("Settings"),
+							      _("The associated GtkSourceSearchSettings"),
+							      GTK_SOURCE_TYPE_SEARCH_SETTINGS,
+							      G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
+
+	/**
+	 * GtkSourceMultiSearch::match-found:
+	 * @search: the #GtkSourceMultiSearch.
+	 * @buffer: the #GtkSourceBuffer containing the match.
+	 * @offset: the character offset of the match start.
+	 * @length: the length of the match, in characters.
+	 * @line: the line number of the match start.
+	 * @preview: the beginning of the line containing the match start.
+	 *
+	 * Emitted in the main thread for each match found by
+	 * gtk_source_multi_search_run_async(). The positions refer to the
+	 * buffer contents at the time the search was started. Matches of a
+	 * buffer modified in the meantime are not emitted.
+	 *
+	 * Since: 3.10
+	 */
+	signals[MATCH_FOUND] =
+		g_signal_new ("match-found",
+			      G_OBJECT_CLASS_TYPE (object_class),
+			      G_SIGNAL_RUN_LAST,
+			      G_STRUCT_OFFSET (GtkSourceMultiSearchClass, match_found),
+			      NULL, NULL,
+			      _gtksourceview_marshal_VOID__OBJECT_INT_INT_INT_STRING,
+			      G_TYPE_NONE, 5,
+			      GTK_SOURCE_TYPE_BUFFER,
+			      G_TYPE_INT,
+			      G_TYPE_INT,
+			      G_TYPE_INT,
+			      G_TYPE_STRING);
+}
+
+static void
+gtk_source_multi_search_init (GtkSourceMultiSearch *search)
+{
+	search->priv = gtk_source_multi_search_get_instance_private (search);
+}
+
+/**
+ * gtk_source_multi_search_new:
+ * @settings: (allow-none): a #GtkSourceSearchSettings, or %NULL.
+ *
+ * Creates a new multi search, without buffers. If @settings is %NULL, a new
+ * #GtkSourceSearchSettings object will be created, that you can retrieve with
+ * gtk_source_multi_search_get_settings().
+ *
+ * Returns: a new #GtkSourceMultiSearch.
+ * Since: 3.10
+ */
+GtkSourceMultiSearch *
+gtk_source_multi_search_new (GtkSourceSearchSettings *settings)
+{
+	g_return_val_if_fail (settings == NULL || GTK_SOURCE_IS_SEARCH_SETTINGS (settings), NULL);
+
+	return g_object_new (GTK_SOURCE_TYPE_MULTI_SEARCH,
+			     "settings", settings,
+			     NULL);
+}
+
+/**
+ * gtk_source_multi_search_get_settings:
+ * @search: a #GtkSourceMultiSearch.
+ *
+ * Returns: (transfer none): the search settings.
+ * Since: 3.10
+ */
+GtkSourceSearchSettings *
+gtk_source_multi_search_get_settings (GtkSourceMultiSearch *search)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_MULTI_SEARCH (search), NULL);
+
+	return search->priv->settings;
+}
+
+/**
+ * gtk_source_multi_search_set_settings:
+ * @search: a #GtkSourceMultiSearch.
+ * @settings: (allow-none): the new #GtkSourceSearchSettings, or %NULL.
+ *
+ * Associate a #GtkSourceSearchSettings with the multi search. If @settings is
+ * %NULL, a new one will be created. A running search is not affected, the
+ * settings are read when gtk_source_multi_search_run_async() is called.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_multi_search_set_settings (GtkSourceMultiSearch    *search,
+				      GtkSourceSearchSettings *settings)
+{
+	g_return_if_fail (GTK_SOURCE_IS_MULTI_SEARCH (search));
+	g_return_if_fail (settings == NULL || GTK_SOURCE_IS_SEARCH_SETTINGS (settings));
+
+	g_clear_object (&search->priv->settings);
+
+	if (settings != NULL)
+	{
+		search->priv->settings = g_object_ref (settings);
+	}
+	else
+	{
+		search->priv->settings = gtk_source_search_settings_new ();
+	}
+
+	g_object_notify (G_OBJECT (search), "settings");
+}
+
+/**
+ * gtk_source_multi_search_add_buffer:
+ * @search: a #GtkSourceMultiSearch.
+ * @buffer: a #GtkSourceBuffer.
+ *
+ * Adds @buffer to the set of buffers to search. Adding a buffer twice has no
+ * effect.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_multi_search_add_buffer (GtkSourceMultiSearch *search,
+				    GtkSourceBuffer      *buffer)
+{
+	g_return_if_fail (GTK_SOURCE_IS_MULTI_SEARCH (search));
+	g_return_if_fail (GTK_SOURCE_IS_BUFFER (buffer));
+
+	if (g_list_find (search->priv->buffers, buffer) == NULL)
+	{
+		search->priv->buffers = g_list_append (search->priv->buffers,
+						       g_object_ref (buffer));
+	}
+}
+
+/**
+ * gtk_source_multi_search_remove_buffer:
+ * @search: a #GtkSourceMultiSearch.
+ * @buffer: a #GtkSourceBuffer.
+ *
+ * Removes @buffer from the set of buffers to search. A running search is not
+ * affected.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_multi_search_remove_buffer (GtkSourceMultiSearch *search,
+				       GtkSourceBuffer      *buffer)
+{
+	GList *node;
+
+	g_return_if_fail (GTK_SOURCE_IS_MULTI_SEARCH (search));
+	g_return_if_fail (GTK_SOURCE_IS_BUFFER (buffer));
+
+	node = g_list_find (search->priv->buffers, buffer);
+
+	if (node != NULL)
+	{
+		search->priv->buffers = g_list_delete_link (search->priv->buffers, node);
+		g_object_unref (buffer);
+	}
+}
+
+/**
+ * gtk_source_multi_search_get_buffers:
+ * @search: a #GtkSourceMultiSearch.
+ *
+ * Returns: (element-type GtkSource.Buffer) (transfer container): the list of
+ * buffers to search. Free it with g_list_free().
+ * Since: 3.10
+ */
+GList *
+gtk_source_multi_search_get_buffers (GtkSourceMultiSearch *search)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_MULTI_SEARCH (search), NULL);
+
+	return g_list_copy (search->priv->buffers);
+}
+
+/**
+ * gtk_source_multi_search_run_async:
+ * @search: a #GtkSourceMultiSearch.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @callback: a #GAsyncReadyCallback to call when the search is finished.
+ * @user_data: the data to pass to the @callback function.
+ *
+ * Searches all the buffers concurrently, in worker threads. The
+ * #GtkSourceMultiSearch::match-found signal is emitted for each match, then
+ * @callback is called when all the buffers have been scanned.
+ *
+ * Only one search can run at a time. If a search is already running, it is
+ * stopped, and its @callback receives a %G_IO_ERROR_CANCELLED error.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_multi_search_run_async (GtkSourceMultiSearch *search,
+				   GCancellable         *cancellable,
+				   GAsyncReadyCallback   callback,
+				   gpointer              user_data)
+{
+	RunData *run;
+	GRegex *regex;
+	GError *error = NULL;
+	GList *l;
+
+	g_return_if_fail (GTK_SOURCE_IS_MULTI_SEARCH (search));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	clear_run (search);
+
+	regex = create_regex (search->priv->settings, &error);
+
+	if (error != NULL)
+	{
+		g_task_report_error (search, callback, user_data,
+				     gtk_source_multi_search_run_async,
+				     error);
+		return;
+	}
+
+	run = g_slice_new0 (RunData);
+	run->ref_count = 1;
+	run->search = search;
+	run->task = g_task_new (search, cancellable, callback, user_data);
+	run->regex = regex;
+	run->cancellable = cancellable != NULL ? g_object_ref (cancellable) : NULL;
+	run->main_context = g_main_context_ref_thread_default ();
+	run->queue = g_async_queue_new ();
+
+	search->priv->run = run;
+
+	if (regex == NULL || search->priv->buffers == NULL)
+	{
+		complete_run (run);
+		return;
+	}
+
+	for (l = search->priv->buffers; l != NULL; l = l->next)
+	{
+		GtkTextBuffer *buffer = l->data;
+		GtkTextIter start;
+		GtkTextIter end;
+		Job *job;
+
+		job = g_slice_new0 (Job);
+		job->run = run_data_ref (run);
+		job->buffer = g_object_ref (buffer);
+
+		gtk_text_buffer_get_bounds (buffer, &start, &end);
+		job->text = gtk_text_buffer_get_slice (buffer, &start, &end, TRUE);
+
+		job->changed_handler_id = g_signal_connect (buffer,
+							    "changed",
+							    G_CALLBACK (buffer_changed_cb),
+							    job);
+
+		run->nb_pending_jobs++;
+		g_thread_pool_push (get_thread_pool (), job, NULL);
+	}
+}
+
+/**
+ * gtk_source_multi_search_run_finish:
+ * @search: a #GtkSourceMultiSearch.
+ * @result: a #GAsyncResult.
+ * @error: a #GError, or %NULL.
+ *
+ * Finishes a search started with gtk_source_multi_search_run_async().
+ *
+ * Returns: the number of matches emitted, or -1 on error.
+ * Since: 3.10
+ */
+gint
+gtk_source_multi_search_run_finish (GtkSourceMultiSearch  *search,
+				    GAsyncResult          *result,
+				    GError               **error)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_MULTI_SEARCH (search), -1);
+	g_return_val_if_fail (g_task_is_valid (result, search), -1);
+
+	return g_task_propagate_int (G_TASK (result), error);
+}
@@ -0,0 +1,90 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; coding: utf-8 -*- */
+/* gtksourcemultisearch.h
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GTK_SOURCE_MULTI_SEARCH_H__
+#define __GTK_SOURCE_MULTI_SEARCH_H__
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksourcetypes.h>
+
+G_BEGIN_DECLS
+
+#define GTK_SOURCE_TYPE_MULTI_SEARCH             (gtk_source_multi_search_get_type ())
+#define GTK_SOURCE_MULTI_SEARCH(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTK_SOURCE_TYPE_MULTI_SEARCH, GtkSourceMultiSearch))
+#define GTK_SOURCE_MULTI_SEARCH_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GTK_SOURCE_TYPE_MULTI_SEARCH, GtkSourceMultiSearchClass))
+#define GTK_SOURCE_IS_MULTI_SEARCH(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTK_SOURCE_TYPE_MULTI_SEARCH))
+#define GTK_SOURCE_IS_MULTI_SEARCH_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GTK_SOURCE_TYPE_MULTI_SEARCH))
+#define GTK_SOURCE_MULTI_SEARCH_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_SOURCE_TYPE_MULTI_SEARCH, GtkSourceMultiSearchClass))
+
+typedef struct _GtkSourceMultiSearchClass    GtkSourceMultiSearchClass;
+typedef struct _GtkSourceMultiSearchPrivate  GtkSourceMultiSearchPrivate;
+
+struct _GtkSourceMultiSearch
+{
+	GObject parent;
+
+	GtkSourceMultiSearchPrivate *priv;
+};
+
+struct _GtkSourceMultiSearchClass
+{
+	GObjectClass parent_class;
+
+	/* Signals */
+	void (*match_found)	(GtkSourceMultiSearch	*search,
+				 GtkSourceBuffer	*buffer,
+				 gint			 offset,
+				 gint			 length,
+				 gint			 line,
+				 const gchar		*preview);
+
+	gpointer padding[10];
+};
+
+GType			 gtk_source_multi_search_get_type		(void) G_GNUC_CONST;
+
+GtkSourceMultiSearch	*gtk_source_multi_search_new			(GtkSourceSearchSettings *settings);
+
+GtkSourceSearchSettings	*gtk_source_multi_search_get_settings		(GtkSourceMultiSearch	 *search);
+
+void			 gtk_source_multi_search_set_settings		(GtkSourceMultiSearch	 *search,
+									 GtkSourceSearchSettings *settings);
+
+void			 gtk_source_multi_search_add_buffer		(GtkSourceMultiSearch	 *search,
+									 GtkSourceBuffer	 *buffer);
+
+void			 gtk_source_multi_search_remove_buffer		(GtkSourceMultiSearch	 *search,
+									 GtkSourceBuffer	 *buffer);
+
+GList			*gtk_source_multi_search_get_buffers		(GtkSourceMultiSearch	 *search);
+
+void			 gtk_source_multi_search_run_async		(GtkSourceMultiSearch	 *search,
+									 GCancellable		 *cancellable,
+									 GAsyncReadyCallback	  callback,
+									 gpointer		  user_data);
+
+gint			 gtk_source_multi_search_run_finish		(GtkSourceMultiSearch	 *search,
+									 GAsyncResult		 *result,
+									 GError			**error);
+
+G_END_DECLS
+
+#endif /* __GTK_SOURCE_MULTI_SEARCH_H__ */
@@ -52,6 +52,8 @@
  * The buffer is scanned asynchronously, so it doesn't block the user interface.
  * For each search, the buffer is scanned at most once. After that, navigating
  * through the occurrences doesn't require to re-scan the buffer entirely.
+ * When a search has a huge number of occurrences, scanning only the visible
+ * region can be enabled with #GtkSourceSearchContext:scan-visible-only.
  *
  * To search forward, use gtk_source_search_context_forward() or
  * gtk_source_search_context_forward_async() for the asynchronous version.
@@ -85,6 +87,28 @@
  * region, we first remove the found_tag's in this region and then we highlight
  * the newly found matches by applying the found_tag to them.
  *
+ * Incremental search
+ * ------------------
+ *
+ * While the user types the search text, each new character usually extends
+ * the previous search text. For a non-regex search without the word
+ * boundaries option, a match of the new search text begins with a match of the
+ * previous search text (with the overlapping matches taken into account). When
+ * the buffer has been fully scanned with the previous search text, every such
+ * position is located inside a found_tag region: either it is the start of an
+ * occurrence, or it is covered by an occurrence (that's how the non-overlapping
+ * matches are found). So instead of re-scanning all the buffer, only the
+ * found_tag regions are put in the scan_region. The lines around them are
+ * re-scanned anyway by adjust_subregion().
+ *
+ * For the other direction (when the user removes characters), the previous
+ * results are kept in a small history: a GtkTextRegion of the found_tag's and
+ * the number of occurrences, for each fully scanned search text. If the
+ * search text comes back to a value present in the history, the found_tag's are
+ * restored from the history without scanning the buffer. The history is
+ * cleared each time the buffer is modified, or when another search setting
+ * changes.
+ *
  * If we only want to highlight the matches, without counting the number of
  * occurrences, a good solution would be to highlight only the visible region of
  * the buffer on the screen. So it would be useless to always scan all the
@@ -266,6 +290,18 @@
  */
 #define SCAN_BATCH_SIZE 100
 
+/* Maximum number of lines to count in one batch, when only the visible region
+ * is scanned. Counting without applying tags is cheaper.
+ */
+#define COUNT_BATCH_SIZE 1000
+
+/* Maximum number of entries in the search history, and maximum number of
+ * occurrences for a search result to be kept in the history. A GtkTextRegion
+ * subregion uses two GtkTextMark's, so the history must stay small.
+ */
+#define HISTORY_MAX_ENTRIES 8
+#define HISTORY_MAX_OCCURRENCES 5000
+
 enum
 {
 	PROP_0,
@@ -274,7 +310,9 @@ enum
 	PROP_HIGHLIGHT,
 	PROP_OCCURRENCES_COUNT,
 	PROP_REGEX_ERROR,
-	PROP_REGEX_STATE
+	PROP_REGEX_STATE,
+	PROP_SCAN_VISIBLE_ONLY,
+	PROP_OCCURRENCES_COUNT_LIMIT
 };
 
 struct _GtkSourceSearchContextPrivate
@@ -295,11 +333,12 @@ struct _GtkSourceSearchContextPrivate
 	 */
 	GtkTextRegion *high_priority_region;
 
-	/* An asynchronous running task. task_region has a higher priority than
-	 * scan_region, but a lower priority than high_priority_region.
+	/* The running asynchronous forward and backward searches, sorted by
+	 * priority (see g_task_get_priority()). The region of a task (see
+	 * TaskData) has a higher priority than scan_region, but a lower
+	 * priority than high_priority_region.
 	 */
-	GTask *task;
-	GtkTextRegion *task_region;
+	GList *tasks;
 
 	/* If the regex search is disabled, text_nb_lines is the number of lines
 	 * of the search text. It is useful to adjust the region to scan.
@@ -313,13 +352,47 @@ struct _GtkSourceSearchContextPrivate
 	gint occurrences_count;
 	gulong idle_scan_id;
 
+	/* The search text of the current found_tag's, if the incremental
+	 * search is possible. NULL otherwise.
+	 */
+	gchar *scanned_search_text;
+
+	/* The history of fully scanned search results, most recent first.
+	 * Contains HistoryEntry's.
+	 */
+	GQueue *history;
+
+	/* When only the visible region is scanned (see is_scan_visible_only()),
+	 * the occurrences are counted by a separate pass, without applying the
+	 * found_tag. count_mark is where the counting pass is, or where it
+	 * stopped if the count is capped. The count is updated incrementally
+	 * when the buffer is edited.
+	 */
+	GtkTextMark *count_mark;
+	gint count;
+	gint occurrences_count_limit;
+
 	guint highlight : 1;
+	guint scan_visible_only : 1;
+	guint count_finished : 1;
+	guint count_capped : 1;
+
+	/* Between the "before" and "after" handlers of an edit, whether the
+	 * occurrences of the edited lines must be counted again.
+	 */
+	guint count_edit_pending : 1;
 };
 
-/* Data for the asynchronous forward and backward search tasks. */
 typedef struct
 {
-	GtkTextMark *start_at;
+	gchar *search_text;
+	GtkTextRegion *occurrences;
+	gint occurrences_count;
+} HistoryEntry;
+
+/* Result of the asynchronous forward and backward search tasks. */
+typedef struct
+{
 	GtkTextIter match_start;
 	GtkTextIter match_end;
 	guint found : 1;
@@ -329,6 +402,28 @@ typedef struct
 	guint is_forward : 1;
 } ForwardBackwardData;
 
+/* Data attached to a running forward or backward search task. */
+typedef struct
+{
+	/* Where to resume the search. */
+	GtkTextMark *start_at;
+
+	/* The region to scan before resuming the search, or NULL. */
+	GtkTextRegion *region;
+
+	GtkSourceSearchProgressCallback progress_callback;
+	gpointer progress_callback_data;
+	GDestroyNotify progress_callback_data_free;
+
+	/* Where the search began, to report the progress. */
+	gint initial_offset;
+
+	guint wrapped_around : 1;
+
+	/* forward or backward */
+	guint is_forward : 1;
+} TaskData;
+
 G_DEFINE_TYPE_WITH_PRIVATE (GtkSourceSearchContext, gtk_source_search_context, G_TYPE_OBJECT);
 
 static void		install_idle_scan		(GtkSourceSearchContext *search);
@@ -494,25 +589,164 @@ get_last_subregion (GtkTextRegion *region,
 }
 
 static void
-clear_task (GtkSourceSearchContext *search)
+task_data_free (TaskData *task_data)
+{
+	if (task_data->start_at != NULL)
+	{
+		GtkTextBuffer *buffer = gtk_text_mark_get_buffer (task_data->start_at);
+
+		if (buffer != NULL)
+		{
+			gtk_text_buffer_delete_mark (buffer, task_data->start_at);
+		}
+
+		g_object_unref (task_data->start_at);
+	}
+
+	if (task_data->region != NULL)
+	{
+		gtk_text_region_destroy (task_data->region, TRUE);
+	}
+
+	if (task_data->progress_callback_data_free != NULL)
+	{
+		task_data->progress_callback_data_free (task_data->progress_callback_data);
+	}
+
+	g_slice_free (TaskData, task_data);
+}
+
+/* The tasks with the same priority are kept in the order of creation. */
+static void
+add_task (GtkSourceSearchContext *search,
+	  GTask                  *task)
+{
+	gint priority = g_task_get_priority (task);
+	GList *l;
+
+	for (l = search->priv->tasks; l != NULL; l = l->next)
+	{
+		if (priority < g_task_get_priority (l->data))
+		{
+			break;
+		}
+	}
+
+	search->priv->tasks = g_list_insert_before (search->priv->tasks, l, task);
+}
+
+/* The search has changed, so the results of the running tasks would be
+ * wrong. All the tasks return G_IO_ERROR_CANCELLED. Their cancellables belong
+ * to the callers, so they are not cancelled.
+ */
+static void
+clear_tasks (GtkSourceSearchContext *search)
 {
-	if (search->priv->task_region != NULL)
+	GList *tasks = search->priv->tasks;
+	GList *l;
+
+	/* A callback can start a new task, or clear the tasks again. */
+	search->priv->tasks = NULL;
+
+	for (l = tasks; l != NULL; l = l->next)
 	{
-		gtk_text_region_destroy (search->priv->task_region, TRUE);
-		search->priv->task_region = NULL;
+		GTask *task = l->data;
+
+		g_task_return_new_error (task,
+					 G_IO_ERROR,
+					 G_IO_ERROR_CANCELLED,
+					 "%s",
+					 _("The search has been modified."));
+
+		g_object_unref (task);
 	}
 
-	if (search->priv->task != NULL)
+	g_list_free (tasks);
+}
+
+/* Cancelling a task is checked between two batches of the scan. */
+static void
+remove_cancelled_tasks (GtkSourceSearchContext *search)
+{
+	GList *l = search->priv->tasks;
+
+	while (l != NULL)
 	{
-		GCancellable *cancellable = g_task_get_cancellable (search->priv->task);
+		GTask *task = l->data;
+		GCancellable *cancellable = g_task_get_cancellable (task);
 
-		if (cancellable != NULL)
+		if (cancellable == NULL || !g_cancellable_is_cancelled (cancellable))
 		{
-			g_cancellable_cancel (cancellable);
-			g_task_return_error_if_cancelled (search->priv->task);
+			l = l->next;
+			continue;
 		}
 
-		g_clear_object (&search->priv->task);
+		/* The task is removed from the list before returning, because
+		 * the callback can be called synchronously and can modify the
+		 * list.
+		 */
+		search->priv->tasks = g_list_delete_link (search->priv->tasks, l);
+
+		g_task_return_error_if_cancelled (task);
+		g_object_unref (task);
+
+		l = search->priv->tasks;
+	}
+}
+
+static GTask *
+create_task (GtkSourceSearchContext          *search,
+	     const GtkTextIter               *iter,
+	     gboolean                         is_forward,
+	     gint                             io_priority,
+	     GCancellable                    *cancellable,
+	     GtkSourceSearchProgressCallback  progress_callback,
+	     gpointer                         progress_callback_data,
+	     GDestroyNotify                   progress_callback_data_free,
+	     GAsyncReadyCallback              callback,
+	     gpointer                         user_data)
+{
+	GTask *task;
+	TaskData *task_data;
+
+	task = g_task_new (search, cancellable, callback, user_data);
+	g_task_set_priority (task, io_priority);
+
+	task_data = g_slice_new0 (TaskData);
+	task_data->is_forward = is_forward != FALSE;
+	task_data->initial_offset = gtk_text_iter_get_offset (iter);
+	task_data->progress_callback = progress_callback;
+	task_data->progress_callback_data = progress_callback_data;
+	task_data->progress_callback_data_free = progress_callback_data_free;
+	task_data->start_at = gtk_text_buffer_create_mark (search->priv->buffer,
+							   NULL,
+							   iter,
+							   TRUE);
+	g_object_ref (task_data->start_at);
+
+	g_task_set_task_data (task, task_data, (GDestroyNotify)task_data_free);
+
+	/* The list owns the reference. */
+	add_task (search, task);
+
+	return task;
+}
+
+static void
+subtract_from_task_regions (GtkSourceSearchContext *search,
+			    const GtkTextIter      *start,
+			    const GtkTextIter      *end)
+{
+	GList *l;
+
+	for (l = search->priv->tasks; l != NULL; l = l->next)
+	{
+		TaskData *task_data = g_task_get_task_data (l->data);
+
+		if (task_data->region != NULL)
+		{
+			gtk_text_region_subtract (task_data->region, start, end);
+		}
 	}
 }
 
@@ -528,6 +762,11 @@ clear_search (GtkSourceSearchContext *search)
 		search->priv->scan_region = NULL;
 	}
 
+	search->priv->count = 0;
+	search->priv->count_finished = FALSE;
+	search->priv->count_capped = FALSE;
+	search->priv->count_edit_pending = FALSE;
+
 	if (search->priv->high_priority_region != NULL)
 	{
 		gtk_text_region_destroy (search->priv->high_priority_region, TRUE);
@@ -566,7 +805,7 @@ clear_search (GtkSourceSearchContext *search)
 		g_object_notify (G_OBJECT (search), "regex-state");
 	}
 
-	clear_task (search);
+	clear_tasks (search);
 
 	search->priv->occurrences_count = 0;
 }
@@ -951,49 +1190,150 @@ basic_backward_search (GtkSourceSearchContext *search,
 static void
 forward_backward_data_free (ForwardBackwardData *data)
 {
-	if (data->start_at != NULL)
+	g_slice_free (ForwardBackwardData, data);
+}
+
+/* Reports the progress of the task, with @position the current search
+ * position, or %NULL if the search is finished.
+ */
+static void
+report_progress (GtkSourceSearchContext *search,
+		 GTask                  *task,
+		 const GtkTextIter      *position)
+{
+	TaskData *task_data = g_task_get_task_data (task);
+	gint nb_chars;
+	gint offset;
+	gint nb_scanned_chars;
+	gint nb_total_chars;
+	gboolean wrap_around;
+
+	if (task_data->progress_callback == NULL)
 	{
-		GtkTextBuffer *buffer = gtk_text_mark_get_buffer (data->start_at);
-		gtk_text_buffer_delete_mark (buffer, data->start_at);
+		return;
 	}
 
-	g_slice_free (ForwardBackwardData, data);
+	nb_chars = gtk_text_buffer_get_char_count (search->priv->buffer);
+	wrap_around = gtk_source_search_settings_get_wrap_around (search->priv->settings);
+
+	if (task_data->is_forward)
+	{
+		nb_total_chars = wrap_around ? nb_chars : nb_chars - task_data->initial_offset;
+	}
+	else
+	{
+		nb_total_chars = wrap_around ? nb_chars : task_data->initial_offset;
+	}
+
+	if (position == NULL)
+	{
+		nb_scanned_chars = nb_total_chars;
+	}
+	else
+	{
+		offset = gtk_text_iter_get_offset (position);
+
+		if (task_data->is_forward)
+		{
+			nb_scanned_chars = task_data->wrapped_around ?
+					   nb_chars - task_data->initial_offset + offset :
+					   offset - task_data->initial_offset;
+		}
+		else
+		{
+			nb_scanned_chars = task_data->wrapped_around ?
+					   task_data->initial_offset + nb_chars - offset :
+					   task_data->initial_offset - offset;
+		}
+	}
+
+	nb_scanned_chars = CLAMP (nb_scanned_chars, 0, nb_total_chars);
+
+	task_data->progress_callback (nb_scanned_chars,
+				      nb_total_chars,
+				      task_data->progress_callback_data);
+}
+
+/* Returns the result of the task, and removes it from the list. */
+static void
+task_return (GtkSourceSearchContext *search,
+	     GTask                  *task,
+	     const GtkTextIter      *match_start,
+	     const GtkTextIter      *match_end)
+{
+	TaskData *task_data = g_task_get_task_data (task);
+	ForwardBackwardData *data;
+
+	data = g_slice_new0 (ForwardBackwardData);
+	data->is_forward = task_data->is_forward;
+	data->wrapped_around = task_data->wrapped_around;
+
+	if (match_start != NULL && match_end != NULL)
+	{
+		data->found = TRUE;
+		data->match_start = *match_start;
+		data->match_end = *match_end;
+	}
+
+	report_progress (search, task, NULL);
+
+	search->priv->tasks = g_list_remove (search->priv->tasks, task);
+
+	g_task_return_pointer (task,
+			       data,
+			       (GDestroyNotify)forward_backward_data_free);
+
+	g_object_unref (task);
+}
+
+/* The task waits for @region to be scanned by the idle callback. */
+static void
+task_wait_for_scan (GtkSourceSearchContext *search,
+		    GTask                  *task,
+		    const GtkTextIter      *start_at,
+		    GtkTextRegion          *region)
+{
+	TaskData *task_data = g_task_get_task_data (task);
+
+	gtk_text_buffer_move_mark (search->priv->buffer,
+				   task_data->start_at,
+				   start_at);
+
+	if (task_data->region != NULL)
+	{
+		gtk_text_region_destroy (task_data->region, TRUE);
+	}
+
+	task_data->region = region;
+
+	report_progress (search, task, start_at);
 }
 
 /* Returns TRUE if finished. */
 static gboolean
 smart_forward_search_async_step (GtkSourceSearchContext *search,
-				 GtkTextIter            *start_at,
-				 gboolean               *wrapped_around)
+				 GTask                  *task,
+				 GtkTextIter            *start_at)
 {
+	TaskData *task_data = g_task_get_task_data (task);
 	GtkTextIter iter = *start_at;
 	GtkTextIter limit;
 	GtkTextIter region_start = *start_at;
 	GtkTextRegion *region = NULL;
-	ForwardBackwardData *task_data;
 	const gchar *search_text = gtk_source_search_settings_get_search_text (search->priv->settings);
 
 	if (gtk_text_iter_is_end (start_at))
 	{
 		if (search_text != NULL &&
-		    !*wrapped_around &&
+		    !task_data->wrapped_around &&
 		    gtk_source_search_settings_get_wrap_around (search->priv->settings))
 		{
 			gtk_text_buffer_get_start_iter (search->priv->buffer, start_at);
-			*wrapped_around = TRUE;
+			task_data->wrapped_around = TRUE;
 			return FALSE;
 		}
 
-		task_data = g_slice_new0 (ForwardBackwardData);
-		task_data->found = FALSE;
-		task_data->is_forward = TRUE;
-		task_data->wrapped_around = *wrapped_around;
-
-		g_task_return_pointer (search->priv->task,
-				       task_data,
-				       (GDestroyNotify)forward_backward_data_free);
-
-		g_clear_object (&search->priv->task);
+		task_return (search, task, NULL, NULL);
 		return TRUE;
 	}
 
@@ -1033,18 +1373,7 @@ smart_forward_search_async_step (GtkSourceSearchContext *search,
 				continue;
 			}
 
-			task_data = g_slice_new0 (ForwardBackwardData);
-			task_data->found = TRUE;
-			task_data->match_start = match_start;
-			task_data->match_end = match_end;
-			task_data->is_forward = TRUE;
-			task_data->wrapped_around = *wrapped_around;
-
-			g_task_return_pointer (search->priv->task,
-					       task_data,
-					       (GDestroyNotify)forward_backward_data_free);
-
-			g_clear_object (&search->priv->task);
+			task_return (search, task, &match_start, &match_end);
 			return TRUE;
 		}
 
@@ -1052,24 +1381,7 @@ smart_forward_search_async_step (GtkSourceSearchContext *search,
 		return FALSE;
 	}
 
-	task_data = g_slice_new0 (ForwardBackwardData);
-	task_data->is_forward = TRUE;
-	task_data->wrapped_around = *wrapped_around;
-	task_data->start_at = gtk_text_buffer_create_mark (search->priv->buffer,
-							   NULL,
-							   start_at,
-							   TRUE);
-
-	g_task_set_task_data (search->priv->task,
-			      task_data,
-			      (GDestroyNotify)forward_backward_data_free);
-
-	if (search->priv->task_region != NULL)
-	{
-		gtk_text_region_destroy (search->priv->task_region, TRUE);
-	}
-
-	search->priv->task_region = region;
+	task_wait_for_scan (search, task, start_at, region);
 
 	install_idle_scan (search);
 
@@ -1082,52 +1394,43 @@ smart_forward_search_async_step (GtkSourceSearchContext *search,
 
 static void
 smart_forward_search_async (GtkSourceSearchContext *search,
-			    const GtkTextIter      *start_at,
-			    gboolean                wrapped_around)
+			    GTask                  *task,
+			    const GtkTextIter      *start_at)
 {
 	GtkTextIter iter = *start_at;
 
 	/* A recursive function would have been more natural, but a loop is
 	 * better to avoid stack overflows.
 	 */
-	while (!smart_forward_search_async_step (search, &iter, &wrapped_around));
+	while (!smart_forward_search_async_step (search, task, &iter));
 }
 
 
 /* Returns TRUE if finished. */
 static gboolean
 smart_backward_search_async_step (GtkSourceSearchContext *search,
-				  GtkTextIter            *start_at,
-				  gboolean               *wrapped_around)
+				  GTask                  *task,
+				  GtkTextIter            *start_at)
 {
+	TaskData *task_data = g_task_get_task_data (task);
 	GtkTextIter iter = *start_at;
 	GtkTextIter limit;
 	GtkTextIter region_end = *start_at;
 	GtkTextRegion *region = NULL;
-	ForwardBackwardData *task_data;
 	const gchar *search_text = gtk_source_search_settings_get_search_text (search->priv->settings);
 
 	if (gtk_text_iter_is_start (start_at))
 	{
 		if (search_text != NULL &&
-		    !*wrapped_around &&
+		    !task_data->wrapped_around &&
 		    gtk_source_search_settings_get_wrap_around (search->priv->settings))
 		{
 			gtk_text_buffer_get_end_iter (search->priv->buffer, start_at);
-			*wrapped_around = TRUE;
+			task_data->wrapped_around = TRUE;
 			return FALSE;
 		}
 
-		task_data = g_slice_new0 (ForwardBackwardData);
-		task_data->found = FALSE;
-		task_data->is_forward = FALSE;
-		task_data->wrapped_around = *wrapped_around;
-
-		g_task_return_pointer (search->priv->task,
-				       task_data,
-				       (GDestroyNotify)forward_backward_data_free);
-
-		g_clear_object (&search->priv->task);
+		task_return (search, task, NULL, NULL);
 		return TRUE;
 	}
 
@@ -1169,18 +1472,7 @@ smart_backward_search_async_step (GtkSourceSearchContext *search,
 				continue;
 			}
 
-			task_data = g_slice_new0 (ForwardBackwardData);
-			task_data->found = TRUE;
-			task_data->match_start = match_start;
-			task_data->match_end = match_end;
-			task_data->is_forward = FALSE;
-			task_data->wrapped_around = *wrapped_around;
-
-			g_task_return_pointer (search->priv->task,
-					       task_data,
-					       (GDestroyNotify)forward_backward_data_free);
-
-			g_clear_object (&search->priv->task);
+			task_return (search, task, &match_start, &match_end);
 			return TRUE;
 		}
 
@@ -1188,24 +1480,7 @@ smart_backward_search_async_step (GtkSourceSearchContext *search,
 		return FALSE;
 	}
 
-	task_data = g_slice_new0 (ForwardBackwardData);
-	task_data->is_forward = FALSE;
-	task_data->wrapped_around = *wrapped_around;
-	task_data->start_at = gtk_text_buffer_create_mark (search->priv->buffer,
-							   NULL,
-							   start_at,
-							   TRUE);
-
-	g_task_set_task_data (search->priv->task,
-			      task_data,
-			      (GDestroyNotify)forward_backward_data_free);
-
-	if (search->priv->task_region != NULL)
-	{
-		gtk_text_region_destroy (search->priv->task_region, TRUE);
-	}
-
-	search->priv->task_region = region;
+	task_wait_for_scan (search, task, start_at, region);
 
 	install_idle_scan (search);
 
@@ -1218,15 +1493,15 @@ smart_backward_search_async_step (GtkSourceSearchContext *search,
 
 static void
 smart_backward_search_async (GtkSourceSearchContext *search,
-			     const GtkTextIter      *start_at,
-			     gboolean                wrapped_around)
+			     GTask                  *task,
+			     const GtkTextIter      *start_at)
 {
 	GtkTextIter iter = *start_at;
 
 	/* A recursive function would have been more natural, but a loop is
 	 * better to avoid stack overflows.
 	 */
-	while (!smart_backward_search_async_step (search, &iter, &wrapped_around));
+	while (!smart_backward_search_async_step (search, task, &iter));
 }
 
 /* Adjust the subregion so we are sure that all matches that are visible or
@@ -1526,10 +1801,7 @@ scan_subregion (GtkSourceSearchContext *search,
 		});
 	}
 
-	if (search->priv->task_region != NULL)
-	{
-		gtk_text_region_subtract (search->priv->task_region, start, end);
-	}
+	subtract_from_task_regions (search, start, end);
 
 	if (search_text == NULL)
 	{
@@ -1670,15 +1942,16 @@ scan_region_backward (GtkSourceSearchContext *search,
 }
 
 static void
-resume_task (GtkSourceSearchContext *search)
+resume_task (GtkSourceSearchContext *search,
+	     GTask                  *task)
 {
-	ForwardBackwardData *task_data = g_task_get_task_data (search->priv->task);
+	TaskData *task_data = g_task_get_task_data (task);
 	GtkTextIter start_at;
 
-	if (search->priv->task_region != NULL)
+	if (task_data->region != NULL)
 	{
-		gtk_text_region_destroy (search->priv->task_region, TRUE);
-		search->priv->task_region = NULL;
+		gtk_text_region_destroy (task_data->region, TRUE);
+		task_data->region = NULL;
 	}
 
 	gtk_text_buffer_get_iter_at_mark (search->priv->buffer,
@@ -1687,115 +1960,396 @@ resume_task (GtkSourceSearchContext *search)
 
 	if (task_data->is_forward)
 	{
-		smart_forward_search_async (search,
-					    &start_at,
-					    task_data->wrapped_around);
+		smart_forward_search_async (search, task, &start_at);
 	}
 	else
 	{
-		smart_backward_search_async (search,
-					     &start_at,
-					     task_data->wrapped_around);
+		smart_backward_search_async (search, task, &start_at);
 	}
 }
 
 static void
-scan_task_region (GtkSourceSearchContext *search)
+scan_task_region (GtkSourceSearchContext *search,
+		  GTask                  *task)
 {
-	ForwardBackwardData *task_data = g_task_get_task_data (search->priv->task);
+	TaskData *task_data = g_task_get_task_data (task);
 
 	if (task_data->is_forward)
 	{
-		scan_region_forward (search, search->priv->task_region);
+		scan_region_forward (search, task_data->region);
 	}
 	else
 	{
-		scan_region_backward (search, search->priv->task_region);
+		scan_region_backward (search, task_data->region);
 	}
 
-	resume_task (search);
+	resume_task (search, task);
 }
 
+/* The regex search needs to scan the buffer from the start, so the
+ * scan-visible-only mode is not supported.
+ */
 static gboolean
-idle_scan_normal_search (GtkSourceSearchContext *search)
+is_scan_visible_only (GtkSourceSearchContext *search)
 {
-	if (search->priv->high_priority_region != NULL)
-	{
-		/* Normally the high priority region is not really big, since it
-		 * is the visible area on the screen. So we can highlight it in
-		 * one batch.
-		 */
-		scan_all_region (search, search->priv->high_priority_region);
+	return (search->priv->scan_visible_only &&
+		!gtk_source_search_settings_get_regex_enabled (search->priv->settings));
+}
 
-		gtk_text_region_destroy (search->priv->high_priority_region, TRUE);
-		search->priv->high_priority_region = NULL;
+static void
+restart_count (GtkSourceSearchContext *search)
+{
+	GtkTextIter start;
 
-		return G_SOURCE_CONTINUE;
-	}
+	search->priv->count = 0;
+	search->priv->count_finished = FALSE;
+	search->priv->count_capped = FALSE;
+	search->priv->count_edit_pending = FALSE;
 
-	if (search->priv->task_region != NULL)
+	if (!is_scan_visible_only (search) ||
+	    search->priv->occurrences_count_limit == 0)
 	{
-		scan_task_region (search);
-		return G_SOURCE_CONTINUE;
+		return;
 	}
 
-	scan_region_forward (search, search->priv->scan_region);
+	gtk_text_buffer_get_start_iter (search->priv->buffer, &start);
 
-	if (is_text_region_empty (search->priv->scan_region))
+	if (search->priv->count_mark == NULL)
 	{
-		search->priv->idle_scan_id = 0;
-
-		g_object_notify (G_OBJECT (search), "occurrences-count");
-
-		if (search->priv->scan_region != NULL)
-		{
-			gtk_text_region_destroy (search->priv->scan_region, TRUE);
-			search->priv->scan_region = NULL;
-		}
-
-		return G_SOURCE_REMOVE;
+		search->priv->count_mark = gtk_text_buffer_create_mark (search->priv->buffer,
+									NULL,
+									&start,
+									TRUE);
+	}
+	else
+	{
+		gtk_text_buffer_move_mark (search->priv->buffer,
+					   search->priv->count_mark,
+					   &start);
 	}
 
-	return G_SOURCE_CONTINUE;
+	install_idle_scan (search);
 }
 
-/* Just remove the found_tag's located in the high-priority region. For big
- * documents, if the pattern is modified, it can take some time to re-scan all
- * the buffer, so it's better to clear the highlighting as soon as possible. If
- * the highlighting is not cleared, the user can wrongly think that the new
- * pattern matches the old occurrences.
- * The drawback of clearing the highlighting is that for small documents, there
- * is some flickering.
+/* Counts the occurrences in the next batch of lines, without applying the
+ * found_tag. It is much cheaper than scan_subregion() when there are a lot of
+ * occurrences, for example when searching a single letter.
  */
 static void
-regex_search_handle_high_priority_region (GtkSourceSearchContext *search)
+count_next_batch (GtkSourceSearchContext *search)
 {
-	GtkTextIter start;
-	GtkTextIter end;
-	GtkTextRegion *region;
-	GtkTextRegionIterator region_iter;
-	gint nb_subregions = gtk_text_region_subregions (search->priv->high_priority_region);
+	GtkTextIter iter;
+	GtkTextIter limit;
+	GtkTextIter next_start;
+	GtkTextIter match_start;
+	GtkTextIter match_end;
+	gint limit_count = search->priv->occurrences_count_limit;
 
-	if (nb_subregions == 0)
+	gtk_text_buffer_get_iter_at_mark (search->priv->buffer,
+					  &iter,
+					  search->priv->count_mark);
+
+	/* The count can already be at the limit after an edit. */
+	if (limit_count > 0 && search->priv->count >= limit_count)
 	{
+		search->priv->count_capped = TRUE;
+		search->priv->count_finished = TRUE;
+
+		g_object_notify (G_OBJECT (search), "occurrences-count");
 		return;
 	}
 
-	gtk_text_region_nth_subregion (search->priv->high_priority_region,
-				       0,
-				       &start,
-				       NULL);
+	limit = iter;
+	gtk_text_iter_forward_lines (&limit, MAX (COUNT_BATCH_SIZE, 2 * search->priv->text_nb_lines));
 
-	gtk_text_region_nth_subregion (search->priv->high_priority_region,
-				       nb_subregions - 1,
-				       NULL,
-				       &end);
+	while (basic_forward_search (search, &iter, &match_start, &match_end, &limit))
+	{
+		search->priv->count++;
+		iter = match_end;
 
-	region = gtk_text_region_intersect (search->priv->scan_region,
-					    &start,
-					    &end);
+		if (limit_count > 0 && search->priv->count >= limit_count)
+		{
+			search->priv->count_capped = TRUE;
+			search->priv->count_finished = TRUE;
 
-	gtk_text_region_get_iterator (region, &region_iter, 0);
+			/* Where to continue if an edit lowers the count. */
+			gtk_text_buffer_move_mark (search->priv->buffer,
+						   search->priv->count_mark,
+						   &iter);
+
+			g_object_notify (G_OBJECT (search), "occurrences-count");
+			return;
+		}
+	}
+
+	if (gtk_text_iter_is_end (&limit))
+	{
+		search->priv->count_finished = TRUE;
+
+		g_object_notify (G_OBJECT (search), "occurrences-count");
+		return;
+	}
+
+	/* An occurrence of a multi-line search text can cross the limit. */
+	next_start = limit;
+	gtk_text_iter_backward_lines (&next_start, MAX (search->priv->text_nb_lines - 1, 0));
+
+	if (gtk_text_iter_compare (&next_start, &iter) < 0)
+	{
+		next_start = iter;
+	}
+
+	gtk_text_buffer_move_mark (search->priv->buffer,
+				   search->priv->count_mark,
+				   &next_start);
+}
+
+static gboolean
+is_count_updated_on_edits (GtkSourceSearchContext *search)
+{
+	return (is_scan_visible_only (search) &&
+		search->priv->occurrences_count_limit != 0 &&
+		search->priv->count_mark != NULL &&
+		gtk_source_search_settings_get_search_text (search->priv->settings) != NULL);
+}
+
+/* Extends [@start, @end] to the lines whose occurrences can be affected by an
+ * edit between @start and @end. The same extension is used before and after
+ * the edit, so the two ranges cover the same text, apart from the edit.
+ */
+static void
+get_count_edit_range (GtkSourceSearchContext *search,
+		      GtkTextIter            *start,
+		      GtkTextIter            *end)
+{
+	gtk_text_iter_set_line_offset (start, 0);
+	gtk_text_iter_backward_lines (start, search->priv->text_nb_lines);
+
+	gtk_text_iter_forward_lines (end, search->priv->text_nb_lines);
+
+	if (!gtk_text_iter_ends_line (end))
+	{
+		gtk_text_iter_forward_to_line_end (end);
+	}
+}
+
+static gint
+count_occurrences_in_range (GtkSourceSearchContext *search,
+			    const GtkTextIter      *start,
+			    const GtkTextIter      *end)
+{
+	GtkTextIter iter = *start;
+	GtkTextIter match_start;
+	GtkTextIter match_end;
+	gint count = 0;
+
+	while (basic_forward_search (search, &iter, &match_start, &match_end, end))
+	{
+		count++;
+		iter = match_end;
+	}
+
+	return count;
+}
+
+/* Called before an edit between @edit_start and @edit_end (equal for an
+ * insertion). The occurrences of the edited lines are removed from the count,
+ * and counted again by count_after_edit(). If the counting pass is in the
+ * middle of the edited lines, it is moved back to their start instead. The
+ * edits located after the counting pass don't change the count.
+ */
+static void
+count_before_edit (GtkSourceSearchContext *search,
+		   const GtkTextIter      *edit_start,
+		   const GtkTextIter      *edit_end)
+{
+	GtkTextIter start = *edit_start;
+	GtkTextIter end = *edit_end;
+	gboolean stopped;
+
+	search->priv->count_edit_pending = FALSE;
+
+	if (!is_count_updated_on_edits (search))
+	{
+		return;
+	}
+
+	get_count_edit_range (search, &start, &end);
+
+	stopped = !search->priv->count_finished || search->priv->count_capped;
+
+	if (stopped)
+	{
+		GtkTextIter count_iter;
+
+		gtk_text_buffer_get_iter_at_mark (search->priv->buffer,
+						  &count_iter,
+						  search->priv->count_mark);
+
+		if (gtk_text_iter_compare (&count_iter, &start) <= 0)
+		{
+			return;
+		}
+
+		if (gtk_text_iter_compare (&count_iter, &end) <= 0)
+		{
+			search->priv->count -= count_occurrences_in_range (search, &start, &count_iter);
+
+			gtk_text_buffer_move_mark (search->priv->buffer,
+						   search->priv->count_mark,
+						   &start);
+
+			search->priv->count_finished = FALSE;
+			search->priv->count_capped = FALSE;
+
+			install_idle_scan (search);
+			return;
+		}
+	}
+
+	search->priv->count -= count_occurrences_in_range (search, &start, &end);
+	search->priv->count_edit_pending = TRUE;
+}
+
+static void
+count_after_edit (GtkSourceSearchContext *search,
+		  const GtkTextIter      *edit_start,
+		  const GtkTextIter      *edit_end)
+{
+	GtkTextIter start = *edit_start;
+	GtkTextIter end = *edit_end;
+
+	if (!search->priv->count_edit_pending)
+	{
+		return;
+	}
+
+	search->priv->count_edit_pending = FALSE;
+
+	get_count_edit_range (search, &start, &end);
+	search->priv->count += count_occurrences_in_range (search, &start, &end);
+
+	if (search->priv->count_capped)
+	{
+		/* The counting pass continues after the edit, and is capped
+		 * again if the count is still at the limit.
+		 */
+		search->priv->count_finished = FALSE;
+		search->priv->count_capped = FALSE;
+
+		install_idle_scan (search);
+	}
+	else if (search->priv->count_finished)
+	{
+		g_object_notify (G_OBJECT (search), "occurrences-count");
+	}
+}
+
+static gboolean
+idle_scan_normal_search (GtkSourceSearchContext *search)
+{
+	if (search->priv->high_priority_region != NULL)
+	{
+		/* Normally the high priority region is not really big, since it
+		 * is the visible area on the screen. So we can highlight it in
+		 * one batch.
+		 */
+		scan_all_region (search, search->priv->high_priority_region);
+
+		gtk_text_region_destroy (search->priv->high_priority_region, TRUE);
+		search->priv->high_priority_region = NULL;
+
+		return G_SOURCE_CONTINUE;
+	}
+
+	if (search->priv->tasks != NULL)
+	{
+		/* Only the task with the highest priority is scanned, the
+		 * others wait for their turn.
+		 */
+		GTask *task = g_object_ref (search->priv->tasks->data);
+
+		scan_task_region (search, task);
+		g_object_unref (task);
+
+		return G_SOURCE_CONTINUE;
+	}
+
+	if (is_scan_visible_only (search) &&
+	    !is_text_region_empty (search->priv->scan_region))
+	{
+		/* The rest of the buffer is scanned only when it becomes
+		 * visible, or for a forward or backward search.
+		 */
+		if (search->priv->count_mark != NULL &&
+		    search->priv->occurrences_count_limit != 0 &&
+		    !search->priv->count_finished)
+		{
+			count_next_batch (search);
+			return G_SOURCE_CONTINUE;
+		}
+
+		search->priv->idle_scan_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	scan_region_forward (search, search->priv->scan_region);
+
+	if (is_text_region_empty (search->priv->scan_region))
+	{
+		search->priv->idle_scan_id = 0;
+
+		g_object_notify (G_OBJECT (search), "occurrences-count");
+
+		if (search->priv->scan_region != NULL)
+		{
+			gtk_text_region_destroy (search->priv->scan_region, TRUE);
+			search->priv->scan_region = NULL;
+		}
+
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/* Just remove the found_tag's located in the high-priority region. For big
+ * documents, if the pattern is modified, it can take some time to re-scan all
+ * the buffer, so it's better to clear the highlighting as soon as possible. If
+ * the highlighting is not cleared, the user can wrongly think that the new
+ * pattern matches the old occurrences.
+ * The drawback of clearing the highlighting is that for small documents, there
+ * is some flickering.
+ */
+static void
+regex_search_handle_high_priority_region (GtkSourceSearchContext *search)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+	GtkTextRegion *region;
+	GtkTextRegionIterator region_iter;
+	gint nb_subregions = gtk_text_region_subregions (search->priv->high_priority_region);
+
+	if (nb_subregions == 0)
+	{
+		return;
+	}
+
+	gtk_text_region_nth_subregion (search->priv->high_priority_region,
+				       0,
+				       &start,
+				       NULL);
+
+	gtk_text_region_nth_subregion (search->priv->high_priority_region,
+				       nb_subregions - 1,
+				       NULL,
+				       &end);
+
+	region = gtk_text_region_intersect (search->priv->scan_region,
+					    &start,
+					    &end);
+
+	gtk_text_region_get_iterator (region, &region_iter, 0);
 
 	while (!gtk_text_region_iterator_is_end (&region_iter))
 	{
@@ -2003,10 +2557,7 @@ regex_search_scan_chunk (GtkSourceSearchContext *search,
 
 	gtk_text_region_subtract (search->priv->scan_region, chunk_start, &segment_start);
 
-	if (search->priv->task_region != NULL)
-	{
-		gtk_text_region_subtract (search->priv->task_region, chunk_start, &segment_start);
-	}
+	subtract_from_task_regions (search, chunk_start, &segment_start);
 }
 
 static void
@@ -2043,17 +2594,31 @@ idle_scan_regex_search (GtkSourceSearchContext *search)
 
 	regex_search_scan_next_chunk (search);
 
-	if (search->priv->task != NULL)
+	if (search->priv->tasks != NULL)
 	{
-		/* Always resume the task, even if the task region has not been
-		 * fully scanned. The task region can be huge (the whole
+		GList *tasks;
+		GList *l;
+
+		/* Always resume the tasks, even if the task regions have not
+		 * been fully scanned. A task region can be huge (the whole
 		 * buffer), and an occurrence can be found earlier. Obviously it
-		 * would be better to resume the task only if an occurrence has
-		 * been found in the task region. But it would be a little more
+		 * would be better to resume a task only if an occurrence has
+		 * been found in its region. But it would be a little more
 		 * complicated to implement, for not a big performance
 		 * improvement.
 		 */
-		resume_task (search);
+		tasks = g_list_copy_deep (search->priv->tasks, (GCopyFunc)g_object_ref, NULL);
+
+		for (l = tasks; l != NULL; l = l->next)
+		{
+			/* A previous task can have cleared the list. */
+			if (g_list_find (search->priv->tasks, l->data) != NULL)
+			{
+				resume_task (search, l->data);
+			}
+		}
+
+		g_list_free_full (tasks, g_object_unref);
 		return G_SOURCE_CONTINUE;
 	}
 
@@ -2078,6 +2643,8 @@ idle_scan_regex_search (GtkSourceSearchContext *search)
 static gboolean
 idle_scan_cb (GtkSourceSearchContext *search)
 {
+	remove_cancelled_tasks (search);
+
 	return gtk_source_search_settings_get_regex_enabled (search->priv->settings) ?
 	       idle_scan_regex_search (search) :
 	       idle_scan_normal_search (search);
@@ -2362,53 +2929,418 @@ update_regex (GtkSourceSearchContext *search)
 			pattern = g_strdup_printf ("\\b%s\\b", search_text);
 		}
 
-		search->priv->regex = g_regex_new (pattern,
-						   compile_flags,
-						   G_REGEX_MATCH_NOTEMPTY,
-						   &search->priv->regex_error);
+		search->priv->regex = g_regex_new (pattern,
+						   compile_flags,
+						   G_REGEX_MATCH_NOTEMPTY,
+						   &search->priv->regex_error);
+
+		if (search->priv->regex_error != NULL)
+		{
+			new_regex_state = GTK_SOURCE_REGEX_SEARCH_COMPILATION_ERROR;
+			regex_error_changed = TRUE;
+		}
+
+		if (gtk_source_search_settings_get_at_word_boundaries (search->priv->settings))
+		{
+			g_free (pattern);
+		}
+	}
+
+	if (search->priv->regex_state != new_regex_state)
+	{
+		search->priv->regex_state = new_regex_state;
+		g_object_notify (G_OBJECT (search), "regex-state");
+	}
+
+	if (regex_error_changed)
+	{
+		g_object_notify (G_OBJECT (search), "regex-error");
+	}
+}
+
+static gboolean
+is_incremental_search_possible (GtkSourceSearchContext *search)
+{
+	return (!gtk_source_search_settings_get_regex_enabled (search->priv->settings) &&
+		!gtk_source_search_settings_get_at_word_boundaries (search->priv->settings));
+}
+
+static void
+update_scanned_search_text (GtkSourceSearchContext *search)
+{
+	g_free (search->priv->scanned_search_text);
+	search->priv->scanned_search_text = NULL;
+
+	if (is_incremental_search_possible (search))
+	{
+		const gchar *search_text = gtk_source_search_settings_get_search_text (search->priv->settings);
+		search->priv->scanned_search_text = g_strdup (search_text);
+	}
+}
+
+static void
+update (GtkSourceSearchContext *search)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	if (dispose_has_run (search))
+	{
+		return;
+	}
+
+	clear_search (search);
+	update_regex (search);
+	update_scanned_search_text (search);
+
+	search->priv->scan_region = gtk_text_region_new (search->priv->buffer);
+
+	gtk_text_buffer_get_bounds (search->priv->buffer, &start, &end);
+	add_subregion_to_scan (search, &start, &end);
+	restart_count (search);
+}
+
+static void
+history_entry_free (HistoryEntry *entry)
+{
+	g_free (entry->search_text);
+	gtk_text_region_destroy (entry->occurrences, TRUE);
+	g_slice_free (HistoryEntry, entry);
+}
+
+static void
+clear_history (GtkSourceSearchContext *search)
+{
+	if (search->priv->history != NULL)
+	{
+		g_queue_free_full (search->priv->history, (GDestroyNotify)history_entry_free);
+		search->priv->history = NULL;
+	}
+}
+
+static GList *
+find_history_entry (GtkSourceSearchContext *search,
+		    const gchar            *search_text)
+{
+	GList *l;
+
+	if (search->priv->history == NULL)
+	{
+		return NULL;
+	}
+
+	for (l = search->priv->history->head; l != NULL; l = l->next)
+	{
+		HistoryEntry *entry = l->data;
+
+		if (g_str_equal (entry->search_text, search_text))
+		{
+			return l;
+		}
+	}
+
+	return NULL;
+}
+
+/* Returns the found_tag regions. */
+static GtkTextRegion *
+get_occurrences_region (GtkSourceSearchContext *search)
+{
+	GtkTextRegion *region = gtk_text_region_new (search->priv->buffer);
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_start_iter (search->priv->buffer, &iter);
+
+	if (!gtk_text_iter_begins_tag (&iter, search->priv->found_tag))
+	{
+		gtk_text_iter_forward_to_tag_toggle (&iter, search->priv->found_tag);
+	}
+
+	while (gtk_text_iter_begins_tag (&iter, search->priv->found_tag))
+	{
+		GtkTextIter end = iter;
+
+		gtk_text_iter_forward_to_tag_toggle (&end, search->priv->found_tag);
+		gtk_text_region_add (region, &iter, &end);
+
+		iter = end;
+		gtk_text_iter_forward_to_tag_toggle (&iter, search->priv->found_tag);
+	}
+
+	return region;
+}
+
+/* Adds the current results to the history, if the buffer is fully scanned.
+ * Returns the found_tag regions, or NULL. The returned region is owned by the
+ * history if @owned_by_history is set to TRUE.
+ */
+static GtkTextRegion *
+add_current_results_to_history (GtkSourceSearchContext *search,
+				gboolean               *owned_by_history)
+{
+	HistoryEntry *entry;
+	GList *node;
+
+	*owned_by_history = FALSE;
+
+	if (search->priv->scanned_search_text == NULL ||
+	    !is_text_region_empty (search->priv->scan_region))
+	{
+		return NULL;
+	}
+
+	node = find_history_entry (search, search->priv->scanned_search_text);
+
+	if (node != NULL)
+	{
+		history_entry_free (node->data);
+		g_queue_delete_link (search->priv->history, node);
+	}
+
+	if (search->priv->occurrences_count > HISTORY_MAX_OCCURRENCES)
+	{
+		return get_occurrences_region (search);
+	}
+
+	if (search->priv->history == NULL)
+	{
+		search->priv->history = g_queue_new ();
+	}
+
+	entry = g_slice_new (HistoryEntry);
+	entry->search_text = g_strdup (search->priv->scanned_search_text);
+	entry->occurrences = get_occurrences_region (search);
+	entry->occurrences_count = search->priv->occurrences_count;
+
+	g_queue_push_head (search->priv->history, entry);
+
+	while (g_queue_get_length (search->priv->history) > HISTORY_MAX_ENTRIES)
+	{
+		history_entry_free (g_queue_pop_tail (search->priv->history));
+	}
+
+	*owned_by_history = TRUE;
+	return entry->occurrences;
+}
+
+/* Returns whether @search_text begins with @previous_text, with at least one
+ * more character. To be on the safe side with the Unicode normalization done
+ * by gtk_text_iter_forward_search(), the first additional character must not
+ * be a combining mark.
+ */
+static gboolean
+search_text_extends (GtkSourceSearchContext *search,
+		     const gchar            *previous_text,
+		     const gchar            *search_text)
+{
+	gchar *previous_folded;
+	gchar *folded;
+	gsize previous_length;
+	gboolean extends = FALSE;
+
+	if (gtk_source_search_settings_get_case_sensitive (search->priv->settings))
+	{
+		previous_folded = g_strdup (previous_text);
+		folded = g_strdup (search_text);
+	}
+	else
+	{
+		previous_folded = g_utf8_casefold (previous_text, -1);
+		folded = g_utf8_casefold (search_text, -1);
+	}
+
+	previous_length = strlen (previous_folded);
+
+	if (strlen (folded) > previous_length &&
+	    strncmp (folded, previous_folded, previous_length) == 0 &&
+	    !g_unichar_ismark (g_utf8_get_char (folded + previous_length)))
+	{
+		extends = TRUE;
+	}
+
+	g_free (previous_folded);
+	g_free (folded);
+
+	return extends;
+}
+
+static void
+restore_from_history (GtkSourceSearchContext *search,
+		      HistoryEntry           *entry)
+{
+	GtkTextRegionIterator region_iter;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	clear_search (search);
+	update_regex (search);
+	update_scanned_search_text (search);
+
+	text_tag_set_highest_priority (search->priv->found_tag,
+				       search->priv->buffer);
+
+	gtk_text_buffer_get_bounds (search->priv->buffer, &start, &end);
+	gtk_text_buffer_remove_tag (search->priv->buffer,
+				    search->priv->found_tag,
+				    &start,
+				    &end);
+
+	gtk_text_region_get_iterator (entry->occurrences, &region_iter, 0);
+
+	while (!gtk_text_region_iterator_is_end (&region_iter))
+	{
+		GtkTextIter subregion_start;
+		GtkTextIter subregion_end;
+
+		gtk_text_region_iterator_get_subregion (&region_iter,
+							&subregion_start,
+							&subregion_end);
+
+		gtk_text_buffer_apply_tag (search->priv->buffer,
+					   search->priv->found_tag,
+					   &subregion_start,
+					   &subregion_end);
+
+		gtk_text_region_iterator_next (&region_iter);
+	}
+
+	search->priv->occurrences_count = entry->occurrences_count;
+
+	g_signal_emit_by_name (search->priv->buffer, "highlight-updated", &start, &end);
+	g_object_notify (G_OBJECT (search), "occurrences-count");
+}
+
+/* The new occurrences are located in the @previous_occurrences regions (see
+ * the implementation overview), so only these regions need to be scanned.
+ */
+static void
+narrow_search (GtkSourceSearchContext *search,
+	       GtkTextRegion          *previous_occurrences)
+{
+	GtkTextRegionIterator region_iter;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	clear_search (search);
+	update_regex (search);
+	update_scanned_search_text (search);
+
+	search->priv->scan_region = gtk_text_region_new (search->priv->buffer);
+
+	gtk_text_region_get_iterator (previous_occurrences, &region_iter, 0);
+
+	while (!gtk_text_region_iterator_is_end (&region_iter))
+	{
+		GtkTextIter subregion_start;
+		GtkTextIter subregion_end;
+
+		gtk_text_region_iterator_get_subregion (&region_iter,
+							&subregion_start,
+							&subregion_end);
+
+		gtk_text_region_add (search->priv->scan_region,
+				     &subregion_start,
+				     &subregion_end);
+
+		gtk_text_region_iterator_next (&region_iter);
+	}
+
+	if (is_text_region_empty (search->priv->scan_region))
+	{
+		gtk_text_region_destroy (search->priv->scan_region, TRUE);
+		search->priv->scan_region = NULL;
+
+		g_object_notify (G_OBJECT (search), "occurrences-count");
+		return;
+	}
+
+	install_idle_scan (search);
+	restart_count (search);
 
-		if (search->priv->regex_error != NULL)
-		{
-			new_regex_state = GTK_SOURCE_REGEX_SEARCH_COMPILATION_ERROR;
-			regex_error_changed = TRUE;
-		}
+	gtk_text_buffer_get_bounds (search->priv->buffer, &start, &end);
+	g_signal_emit_by_name (search->priv->buffer, "highlight-updated", &start, &end);
+}
 
-		if (gtk_source_search_settings_get_at_word_boundaries (search->priv->settings))
-		{
-			g_free (pattern);
-		}
+/* Called when the search text has changed. Returns TRUE if the search has been
+ * updated without re-scanning all the buffer.
+ */
+static gboolean
+incremental_update (GtkSourceSearchContext *search)
+{
+	const gchar *search_text = gtk_source_search_settings_get_search_text (search->priv->settings);
+	const gchar *previous_text = search->priv->scanned_search_text;
+	GtkTextRegion *previous_occurrences;
+	gboolean owned_by_history;
+	gboolean updated = FALSE;
+	GList *node;
+
+	if (dispose_has_run (search) ||
+	    !is_incremental_search_possible (search))
+	{
+		return FALSE;
 	}
 
-	if (search->priv->regex_state != new_regex_state)
+	previous_occurrences = add_current_results_to_history (search, &owned_by_history);
+
+	if (search_text == NULL)
 	{
-		search->priv->regex_state = new_regex_state;
-		g_object_notify (G_OBJECT (search), "regex-state");
+		updated = FALSE;
+	}
+	else if ((node = find_history_entry (search, search_text)) != NULL)
+	{
+		restore_from_history (search, node->data);
+		updated = TRUE;
+	}
+	else if (previous_occurrences != NULL &&
+		 search_text_extends (search, previous_text, search_text))
+	{
+		narrow_search (search, previous_occurrences);
+		updated = TRUE;
 	}
 
-	if (regex_error_changed)
+	if (previous_occurrences != NULL && !owned_by_history)
 	{
-		g_object_notify (G_OBJECT (search), "regex-error");
+		gtk_text_region_destroy (previous_occurrences, TRUE);
 	}
+
+	return updated;
+}
+
+static gboolean
+in_batch_edit (GtkSourceSearchContext *search)
+{
+	return gtk_source_buffer_is_in_batch_edit (GTK_SOURCE_BUFFER (search->priv->buffer));
 }
 
+/* During a batch edit, the region containing all the changes is added to the
+ * scan region after each change, so the new occurrences are not taken into
+ * account by occurrences_count. Since the region is contiguous, the scan region
+ * doesn't get fragmented. The idle scan and the highlight-updated signal are
+ * done only once, at the end of the batch edit.
+ */
 static void
-update (GtkSourceSearchContext *search)
+add_batch_edit_region_to_scan (GtkSourceSearchContext *search)
 {
 	GtkTextIter start;
 	GtkTextIter end;
 
-	if (dispose_has_run (search))
+	if (!_gtk_source_buffer_get_batch_edit_region (GTK_SOURCE_BUFFER (search->priv->buffer),
+						       &start,
+						       &end))
 	{
 		return;
 	}
 
-	clear_search (search);
-	update_regex (search);
+	/* The region can be empty after a deletion. */
+	gtk_text_iter_backward_lines (&start, search->priv->text_nb_lines);
+	gtk_text_iter_forward_lines (&end, search->priv->text_nb_lines);
 
-	search->priv->scan_region = gtk_text_region_new (search->priv->buffer);
+	if (search->priv->scan_region == NULL)
+	{
+		search->priv->scan_region = gtk_text_region_new (search->priv->buffer);
+	}
 
-	gtk_text_buffer_get_bounds (search->priv->buffer, &start, &end);
-	add_subregion_to_scan (search, &start, &end);
+	gtk_text_region_add (search->priv->scan_region, &start, &end);
 }
 
 static void
@@ -2419,7 +3351,13 @@ insert_text_before_cb (GtkSourceSearchContext *search,
 {
 	const gchar *search_text = gtk_source_search_settings_get_search_text (search->priv->settings);
 
-	clear_task (search);
+	clear_tasks (search);
+	clear_history (search);
+
+	if (!in_batch_edit (search))
+	{
+		count_before_edit (search, location, location);
+	}
 
 	if (search_text != NULL &&
 	    !gtk_source_search_settings_get_regex_enabled (search->priv->settings))
@@ -2428,7 +3366,11 @@ insert_text_before_cb (GtkSourceSearchContext *search,
 		GtkTextIter end = *location;
 
 		remove_occurrences_in_range (search, &start, &end);
-		add_subregion_to_scan (search, &start, &end);
+
+		if (!in_batch_edit (search))
+		{
+			add_subregion_to_scan (search, &start, &end);
+		}
 	}
 }
 
@@ -2438,7 +3380,15 @@ insert_text_after_cb (GtkSourceSearchContext *search,
 		      gchar                  *text,
 		      gint                    length)
 {
-	if (gtk_source_search_settings_get_regex_enabled (search->priv->settings))
+	if (in_batch_edit (search))
+	{
+		/* With a regex, the update is done at the end. */
+		if (!gtk_source_search_settings_get_regex_enabled (search->priv->settings))
+		{
+			add_batch_edit_region_to_scan (search);
+		}
+	}
+	else if (gtk_source_search_settings_get_regex_enabled (search->priv->settings))
 	{
 		update (search);
 	}
@@ -2453,6 +3403,7 @@ insert_text_after_cb (GtkSourceSearchContext *search,
 					      g_utf8_strlen (text, length));
 
 		add_subregion_to_scan (search, &start, &end);
+		count_after_edit (search, &start, &end);
 	}
 }
 
@@ -2465,13 +3416,19 @@ delete_range_before_cb (GtkSourceSearchContext *search,
 	GtkTextIter end_buffer;
 	const gchar *search_text = gtk_source_search_settings_get_search_text (search->priv->settings);
 
-	clear_task (search);
+	clear_tasks (search);
+	clear_history (search);
 
 	if (gtk_source_search_settings_get_regex_enabled (search->priv->settings))
 	{
 		return;
 	}
 
+	if (!in_batch_edit (search))
+	{
+		count_before_edit (search, delete_start, delete_end);
+	}
+
 	gtk_text_buffer_get_bounds (search->priv->buffer, &start_buffer, &end_buffer);
 
 	if (gtk_text_iter_equal (delete_start, &start_buffer) &&
@@ -2482,7 +3439,17 @@ delete_range_before_cb (GtkSourceSearchContext *search,
 		return;
 	}
 
-	if (search_text != NULL)
+	if (search_text != NULL && in_batch_edit (search))
+	{
+		/* Only the occurrences that disappear with the text. The
+		 * neighbourhood is scanned at the end of the batch edit.
+		 */
+		GtkTextIter start = *delete_start;
+		GtkTextIter end = *delete_end;
+
+		remove_occurrences_in_range (search, &start, &end);
+	}
+	else if (search_text != NULL)
 	{
 		GtkTextIter start = *delete_start;
 		GtkTextIter end = *delete_end;
@@ -2500,14 +3467,48 @@ delete_range_after_cb (GtkSourceSearchContext *search,
 		       GtkTextIter            *start,
 		       GtkTextIter            *end)
 {
-	if (gtk_source_search_settings_get_regex_enabled (search->priv->settings))
+	if (in_batch_edit (search))
+	{
+		if (!gtk_source_search_settings_get_regex_enabled (search->priv->settings))
+		{
+			add_batch_edit_region_to_scan (search);
+		}
+	}
+	else if (gtk_source_search_settings_get_regex_enabled (search->priv->settings))
 	{
 		update (search);
 	}
 	else
 	{
 		add_subregion_to_scan (search, start, end);
+		count_after_edit (search, start, end);
+	}
+}
+
+static void
+batch_edit_finished_cb (GtkSourceSearchContext *search,
+			GtkTextIter            *start,
+			GtkTextIter            *end)
+{
+	GtkTextIter scan_start = *start;
+	GtkTextIter scan_end = *end;
+
+	clear_tasks (search);
+	clear_history (search);
+
+	if (gtk_source_search_settings_get_regex_enabled (search->priv->settings))
+	{
+		update (search);
+		return;
 	}
+
+	gtk_text_iter_backward_lines (&scan_start, search->priv->text_nb_lines);
+	gtk_text_iter_forward_lines (&scan_end, search->priv->text_nb_lines);
+
+	add_subregion_to_scan (search, &scan_start, &scan_end);
+
+	/* The changes of a batch edit are not known one by one. */
+	restart_count (search);
 }
 
 static void
@@ -2543,6 +3544,12 @@ set_buffer (GtkSourceSearchContext *search,
 				 search,
 				 G_CONNECT_AFTER | G_CONNECT_SWAPPED);
 
+	g_signal_connect_object (buffer,
+				 "batch-edit-finished",
+				 G_CALLBACK (batch_edit_finished_cb),
+				 search,
+				 G_CONNECT_SWAPPED);
+
 	search->priv->found_tag = gtk_text_buffer_create_tag (search->priv->buffer, NULL, NULL);
 	g_object_ref (search->priv->found_tag);
 
@@ -2617,6 +3624,15 @@ settings_notify_cb (GtkSourceSearchContext  *search,
 	if (g_str_equal (property, "search-text"))
 	{
 		search_text_updated (search);
+
+		if (incremental_update (search))
+		{
+			return;
+		}
+	}
+	else
+	{
+		clear_history (search);
 	}
 
 	update (search);
@@ -2628,6 +3644,7 @@ gtk_source_search_context_dispose (GObject *object)
 	GtkSourceSearchContext *search = GTK_SOURCE_SEARCH_CONTEXT (object);
 
 	clear_search (search);
+	clear_history (search);
 
 	if (search->priv->found_tag != NULL)
 	{
@@ -2638,6 +3655,12 @@ gtk_source_search_context_dispose (GObject *object)
 		g_clear_object (&search->priv->found_tag);
 	}
 
+	if (search->priv->count_mark != NULL)
+	{
+		gtk_text_buffer_delete_mark (search->priv->buffer, search->priv->count_mark);
+		search->priv->count_mark = NULL;
+	}
+
 	g_clear_object (&search->priv->buffer);
 	g_clear_object (&search->priv->settings);
 
@@ -2659,6 +3682,8 @@ gtk_source_search_context_finalize (GObject *object)
 		g_error_free (search->priv->regex_error);
 	}
 
+	g_free (search->priv->scanned_search_text);
+
 	G_OBJECT_CLASS (gtk_source_search_context_parent_class)->finalize (object);
 }
 
@@ -2700,6 +3725,14 @@ gtk_source_search_context_get_property (GObject    *object,
 			g_value_set_enum (value, gtk_source_search_context_get_regex_state (search));
 			break;
 
+		case PROP_SCAN_VISIBLE_ONLY:
+			g_value_set_boolean (value, search->priv->scan_visible_only);
+			break;
+
+		case PROP_OCCURRENCES_COUNT_LIMIT:
+			g_value_set_int (value, search->priv->occurrences_count_limit);
+			break;
+
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -2732,6 +3765,14 @@ gtk_source_search_context_set_property (GObject      *object,
 			gtk_source_search_context_set_highlight (search, g_value_get_boolean (value));
 			break;
 
+		case PROP_SCAN_VISIBLE_ONLY:
+			gtk_source_search_context_set_scan_visible_only (search, g_value_get_boolean (value));
+			break;
+
+		case PROP_OCCURRENCES_COUNT_LIMIT:
+			gtk_source_search_context_set_occurrences_count_limit (search, g_value_get_int (value));
+			break;
+
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -2844,6 +3885,53 @@ gtk_source_search_context_class_init (GtkSourceSearchContextClass *klass)
 							    GTK_SOURCE_TYPE_REGEX_SEARCH_STATE,
 							    GTK_SOURCE_REGEX_SEARCH_NO_ERROR,
 							    G_PARAM_READABLE));
+
+	/**
+	 * GtkSourceSearchContext:scan-visible-only:
+	 *
+	 * Whether to scan and highlight only the regions of the buffer that
+	 * become visible on the screen, instead of the whole buffer. The other
+	 * regions are scanned only when needed by a forward or backward
+	 * search. The #GtkSourceSearchContext:occurrences-count is computed by
+	 * a separate and cheaper counting pass, see
+	 * #GtkSourceSearchContext:occurrences-count-limit.
+	 *
+	 * This is useful for searches with a lot of occurrences, for example a
+	 * single letter in a big buffer. The regex search always scans the whole
+	 * buffer.
+	 *
+	 * Since: 3.10
+	 */
+	g_object_class_install_property (object_class,
+					 PROP_SCAN_VISIBLE_ONLY,
+					 g_param_spec_boolean ("scan-visible-only",
+							       _("Scan visible only"),
+							       _("Scan only the visible regions of the buffer"),
+							       FALSE,
+							       G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
+
+	/**
+	 * GtkSourceSearchContext:occurrences-count-limit:
+	 *
+	 * When #GtkSourceSearchContext:scan-visible-only is set, the maximum
+	 * number of occurrences to count. When the limit is reached, the
+	 * counting stops, and the #GtkSourceSearchContext:occurrences-count
+	 * is equal to the limit (see
+	 * gtk_source_search_context_get_occurrences_count_capped()). The value
+	 * -1 means no limit, and 0 disables the counting: the occurrences
+	 * count is then unknown.
+	 *
+	 * Since: 3.10
+	 */
+	g_object_class_install_property (object_class,
+					 PROP_OCCURRENCES_COUNT_LIMIT,
+					 g_param_spec_int ("occurrences-count-limit",
+							   _("Occurrences count limit"),
+							   _("Maximum number of occurrences to count"),
+							   -1,
+							   G_MAXINT,
+							   -1,
+							   G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
 }
 
 static void
@@ -2953,6 +4041,7 @@ gtk_source_search_context_set_settings (GtkSourceSearchContext  *search,
 				 search,
 				 G_CONNECT_SWAPPED);
 
+	clear_history (search);
 	search_text_updated (search);
 	update (search);
 
@@ -3000,6 +4089,100 @@ gtk_source_search_context_set_highlight (GtkSourceSearchContext *search,
 	}
 }
 
+/**
+ * gtk_source_search_context_get_scan_visible_only:
+ * @search: a #GtkSourceSearchContext.
+ *
+ * Returns: whether only the visible regions of the buffer are scanned.
+ * Since: 3.10
+ */
+gboolean
+gtk_source_search_context_get_scan_visible_only (GtkSourceSearchContext *search)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search), FALSE);
+
+	return search->priv->scan_visible_only;
+}
+
+/**
+ * gtk_source_search_context_set_scan_visible_only:
+ * @search: a #GtkSourceSearchContext.
+ * @scan_visible_only: the setting.
+ *
+ * Sets the #GtkSourceSearchContext:scan-visible-only property.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_search_context_set_scan_visible_only (GtkSourceSearchContext *search,
+						 gboolean                scan_visible_only)
+{
+	g_return_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search));
+
+	scan_visible_only = scan_visible_only != FALSE;
+
+	if (search->priv->scan_visible_only != scan_visible_only)
+	{
+		search->priv->scan_visible_only = scan_visible_only;
+
+		if (search->priv->buffer != NULL &&
+		    search->priv->settings != NULL)
+		{
+			update (search);
+		}
+
+		g_object_notify (G_OBJECT (search), "scan-visible-only");
+	}
+}
+
+/**
+ * gtk_source_search_context_get_occurrences_count_limit:
+ * @search: a #GtkSourceSearchContext.
+ *
+ * Returns: the maximum number of occurrences to count, -1 for no limit.
+ * Since: 3.10
+ */
+gint
+gtk_source_search_context_get_occurrences_count_limit (GtkSourceSearchContext *search)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search), -1);
+
+	return search->priv->occurrences_count_limit;
+}
+
+/**
+ * gtk_source_search_context_set_occurrences_count_limit:
+ * @search: a #GtkSourceSearchContext.
+ * @limit: the maximum number of occurrences to count, -1 for no limit, or 0 to
+ *   disable the counting.
+ *
+ * Sets the #GtkSourceSearchContext:occurrences-count-limit property.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_search_context_set_occurrences_count_limit (GtkSourceSearchContext *search,
+						       gint                    limit)
+{
+	g_return_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search));
+	g_return_if_fail (limit >= -1);
+
+	if (search->priv->occurrences_count_limit != limit)
+	{
+		search->priv->occurrences_count_limit = limit;
+
+		if (search->priv->buffer != NULL &&
+		    search->priv->settings != NULL &&
+		    !is_text_region_empty (search->priv->scan_region))
+		{
+			restart_count (search);
+			g_object_notify (G_OBJECT (search), "occurrences-count");
+		}
+
+		g_object_notify (G_OBJECT (search), "occurrences-count-limit");
+	}
+}
+
 /**
  * gtk_source_search_context_get_regex_error:
  * @search: a #GtkSourceSearchContext.
@@ -3057,7 +4240,45 @@ gtk_source_search_context_get_occurrences_count (GtkSourceSearchContext *search)
 {
 	g_return_val_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search), -1);
 
-	return is_text_region_empty (search->priv->scan_region) ? search->priv->occurrences_count : -1;
+	if (is_text_region_empty (search->priv->scan_region))
+	{
+		return search->priv->occurrences_count;
+	}
+
+	if (is_scan_visible_only (search) && search->priv->count_finished)
+	{
+		/* After an edit, the count can exceed the limit until the
+		 * counting pass is capped again.
+		 */
+		return search->priv->count_capped ?
+		       MIN (search->priv->count, search->priv->occurrences_count_limit) :
+		       search->priv->count;
+	}
+
+	return -1;
+}
+
+/**
+ * gtk_source_search_context_get_occurrences_count_capped:
+ * @search: a #GtkSourceSearchContext.
+ *
+ * When #GtkSourceSearchContext:scan-visible-only is set, the counting of the
+ * occurrences stops when #GtkSourceSearchContext:occurrences-count-limit is
+ * reached. In that case the real number of occurrences can be greater than the
+ * value returned by gtk_source_search_context_get_occurrences_count(), and the
+ * user interface can show something like "1000+ occurrences".
+ *
+ * Returns: whether the counting of the occurrences has stopped at the limit.
+ * Since: 3.10
+ */
+gboolean
+gtk_source_search_context_get_occurrences_count_capped (GtkSourceSearchContext *search)
+{
+	g_return_val_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search), FALSE);
+
+	return (!is_text_region_empty (search->priv->scan_region) &&
+		is_scan_visible_only (search) &&
+		search->priv->count_capped);
 }
 
 /**
@@ -3213,9 +4434,16 @@ gtk_source_search_context_forward (GtkSourceSearchContext *search,
  * Asynchronous forward search. See the #GAsyncResult documentation to know
  * how to use this function.
  *
- * If the operation is cancelled, the @callback will only be called if
- * @cancellable was not %NULL. gtk_source_search_context_forward_async() takes
- * ownership of @cancellable, so you can unref it after calling this function.
+ * The @callback is always called. If @cancellable is cancelled, or if the
+ * buffer or the search settings are modified before the end of the search, the
+ * result is a %G_IO_ERROR_CANCELLED error.
+ * gtk_source_search_context_forward_async() takes a reference on @cancellable, so
+ * you can unref it after calling this function.
+ *
+ * Several searches can run at the same time, see
+ * gtk_source_search_context_forward_async_full(). Unlike in the previous
+ * versions, a new call doesn't cancel the running searches: to run only one
+ * search at a time, cancel the previous one with its @cancellable.
  *
  * Since: 3.10
  */
@@ -3226,6 +4454,60 @@ gtk_source_search_context_forward_async (GtkSourceSearchContext *search,
 					 GAsyncReadyCallback     callback,
 					 gpointer                user_data)
 {
+	gtk_source_search_context_forward_async_full (search,
+						      iter,
+						      G_PRIORITY_DEFAULT,
+						      cancellable,
+						      NULL, NULL, NULL,
+						      callback,
+						      user_data);
+}
+
+/**
+ * gtk_source_search_context_forward_async_full:
+ * @search: a #GtkSourceSearchContext.
+ * @iter: start of search.
+ * @io_priority: the I/O priority of the request.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @progress_callback: (allow-none) (scope notified): function to call with
+ *   progress information, or %NULL.
+ * @progress_callback_data: (closure progress_callback): data to pass to the
+ *   @progress_callback function.
+ * @progress_callback_data_free: (allow-none): function to call on
+ *   @progress_callback_data when the @progress_callback is no longer needed,
+ *   or %NULL.
+ * @callback: a #GAsyncReadyCallback to call when the operation is finished.
+ * @user_data: the data to pass to the @callback function.
+ *
+ * Like gtk_source_search_context_forward_async(), with a priority and a
+ * progress callback.
+ *
+ * Several forward and backward searches can be outstanding at the same time.
+ * When the buffer needs to be scanned, the search with the lowest
+ * @io_priority value is served first. A search is finished when an occurrence
+ * is found, when the end of the search is reached, or when @cancellable is
+ * cancelled. Modifying the buffer or the search settings cancels all the
+ * running searches.
+ *
+ * The @progress_callback is called in the main thread, each time the search
+ * needs to wait for the buffer to be scanned, and a last time when the search
+ * is finished. The progress is expressed in number of characters.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_search_context_forward_async_full (GtkSourceSearchContext          *search,
+					      const GtkTextIter               *iter,
+					      gint                             io_priority,
+					      GCancellable                    *cancellable,
+					      GtkSourceSearchProgressCallback  progress_callback,
+					      gpointer                         progress_callback_data,
+					      GDestroyNotify                   progress_callback_data_free,
+					      GAsyncReadyCallback              callback,
+					      gpointer                         user_data)
+{
+	GTask *task;
+
 	g_return_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search));
 	g_return_if_fail (iter != NULL);
 
@@ -3234,10 +4516,18 @@ gtk_source_search_context_forward_async (GtkSourceSearchContext *search,
 		return;
 	}
 
-	clear_task (search);
-	search->priv->task = g_task_new (search, cancellable, callback, user_data);
+	task = create_task (search,
+			    iter,
+			    TRUE,
+			    io_priority,
+			    cancellable,
+			    progress_callback,
+			    progress_callback_data,
+			    progress_callback_data_free,
+			    callback,
+			    user_data);
 
-	smart_forward_search_async (search, iter, FALSE);
+	smart_forward_search_async (search, task, iter);
 }
 
 /**
@@ -3366,9 +4656,16 @@ gtk_source_search_context_backward (GtkSourceSearchContext *search,
  * Asynchronous backward search. See the #GAsyncResult documentation to know
  * how to use this function.
  *
- * If the operation is cancelled, the @callback will only be called if
- * @cancellable was not %NULL. gtk_source_search_context_backward_async() takes
- * ownership of @cancellable, so you can unref it after calling this function.
+ * The @callback is always called. If @cancellable is cancelled, or if the
+ * buffer or the search settings are modified before the end of the search, the
+ * result is a %G_IO_ERROR_CANCELLED error.
+ * gtk_source_search_context_backward_async() takes a reference on @cancellable, so
+ * you can unref it after calling this function.
+ *
+ * Several searches can run at the same time, see
+ * gtk_source_search_context_backward_async_full(). Unlike in the previous
+ * versions, a new call doesn't cancel the running searches: to run only one
+ * search at a time, cancel the previous one with its @cancellable.
  *
  * Since: 3.10
  */
@@ -3379,6 +4676,50 @@ gtk_source_search_context_backward_async (GtkSourceSearchContext *search,
 					  GAsyncReadyCallback     callback,
 					  gpointer                user_data)
 {
+	gtk_source_search_context_backward_async_full (search,
+						       iter,
+						       G_PRIORITY_DEFAULT,
+						       cancellable,
+						       NULL, NULL, NULL,
+						       callback,
+						       user_data);
+}
+
+/**
+ * gtk_source_search_context_backward_async_full:
+ * @search: a #GtkSourceSearchContext.
+ * @iter: start of search.
+ * @io_priority: the I/O priority of the request.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @progress_callback: (allow-none) (scope notified): function to call with
+ *   progress information, or %NULL.
+ * @progress_callback_data: (closure progress_callback): data to pass to the
+ *   @progress_callback function.
+ * @progress_callback_data_free: (allow-none): function to call on
+ *   @progress_callback_data when the @progress_callback is no longer needed,
+ *   or %NULL.
+ * @callback: a #GAsyncReadyCallback to call when the operation is finished.
+ * @user_data: the data to pass to the @callback function.
+ *
+ * Like gtk_source_search_context_backward_async(), with a priority and a
+ * progress callback. See gtk_source_search_context_forward_async_full() for
+ * more details.
+ *
+ * Since: 3.10
+ */
+void
+gtk_source_search_context_backward_async_full (GtkSourceSearchContext          *search,
+					       const GtkTextIter               *iter,
+					       gint                             io_priority,
+					       GCancellable                    *cancellable,
+					       GtkSourceSearchProgressCallback  progress_callback,
+					       gpointer                         progress_callback_data,
+					       GDestroyNotify                   progress_callback_data_free,
+					       GAsyncReadyCallback              callback,
+					       gpointer                         user_data)
+{
+	GTask *task;
+
 	g_return_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search));
 	g_return_if_fail (iter != NULL);
 
@@ -3387,10 +4728,18 @@ gtk_source_search_context_backward_async (GtkSourceSearchContext *search,
 		return;
 	}
 
-	clear_task (search);
-	search->priv->task = g_task_new (search, cancellable, callback, user_data);
+	task = create_task (search,
+			    iter,
+			    FALSE,
+			    io_priority,
+			    cancellable,
+			    progress_callback,
+			    progress_callback_data,
+			    progress_callback_data_free,
+			    callback,
+			    user_data);
 
-	smart_backward_search_async (search, iter, FALSE);
+	smart_backward_search_async (search, task, iter);
 }
 
 /**
@@ -3568,6 +4917,9 @@ gtk_source_search_context_replace (GtkSourceSearchContext *search,
  * calling g_regex_check_replacement(). The @replace text can contain
  * backreferences; read the g_regex_replace() documentation for more details.
  *
+ * The replacements are done in a batch edit, see
+ * gtk_source_buffer_begin_batch_edit().
+ *
  * Returns: the number of replaced matches.
  * Since: 3.10
  */
@@ -3620,6 +4972,7 @@ gtk_source_search_context_replace_all (GtkSourceSearchContext *search,
 	g_signal_handlers_block_by_func (search->priv->buffer, insert_text_after_cb, search);
 	g_signal_handlers_block_by_func (search->priv->buffer, delete_range_before_cb, search);
 	g_signal_handlers_block_by_func (search->priv->buffer, delete_range_after_cb, search);
+	g_signal_handlers_block_by_func (search->priv->buffer, batch_edit_finished_cb, search);
 
 	highlight_matching_brackets =
 		gtk_source_buffer_get_highlight_matching_brackets (GTK_SOURCE_BUFFER (search->priv->buffer));
@@ -3629,7 +4982,11 @@ gtk_source_search_context_replace_all (GtkSourceSearchContext *search,
 
 	gtk_text_buffer_get_start_iter (search->priv->buffer, &iter);
 
+	/* The other objects listening to the buffer, like the highlighting
+	 * engine and the other search contexts, update once at the end.
+	 */
 	gtk_text_buffer_begin_user_action (search->priv->buffer);
+	gtk_source_buffer_begin_batch_edit (GTK_SOURCE_BUFFER (search->priv->buffer));
 
 	while (smart_forward_search (search, &iter, &match_start, &match_end))
 	{
@@ -3655,6 +5012,7 @@ gtk_source_search_context_replace_all (GtkSourceSearchContext *search,
 		iter = match_end;
 	}
 
+	gtk_source_buffer_end_batch_edit (GTK_SOURCE_BUFFER (search->priv->buffer));
 	gtk_text_buffer_end_user_action (search->priv->buffer);
 
 	gtk_source_buffer_set_highlight_matching_brackets (GTK_SOURCE_BUFFER (search->priv->buffer),
@@ -3664,7 +5022,9 @@ gtk_source_search_context_replace_all (GtkSourceSearchContext *search,
 	g_signal_handlers_unblock_by_func (search->priv->buffer, insert_text_after_cb, search);
 	g_signal_handlers_unblock_by_func (search->priv->buffer, delete_range_before_cb, search);
 	g_signal_handlers_unblock_by_func (search->priv->buffer, delete_range_after_cb, search);
+	g_signal_handlers_unblock_by_func (search->priv->buffer, batch_edit_finished_cb, search);
 
+	clear_history (search);
 	update (search);
 
 	return nb_matches_replaced;
@@ -71,6 +71,21 @@ typedef enum
 	GTK_SOURCE_REGEX_SEARCH_REPLACE_ERROR
 } GtkSourceRegexSearchState;
 
+/**
+ * GtkSourceSearchProgressCallback:
+ * @nb_scanned_chars: the number of characters already scanned.
+ * @nb_total_chars: the total number of characters to scan.
+ * @user_data: user data passed to the callback.
+ *
+ * The type of the function used to report the progress of an asynchronous
+ * forward or backward search.
+ *
+ * Since: 3.10
+ */
+typedef void (*GtkSourceSearchProgressCallback) (gint     nb_scanned_chars,
+						 gint     nb_total_chars,
+						 gpointer user_data);
+
 GType			 gtk_source_search_context_get_type			(void) G_GNUC_CONST;
 
 GtkSourceSearchContext	*gtk_source_search_context_new				(GtkSourceBuffer	 *buffer,
@@ -92,8 +107,20 @@ GError			*gtk_source_search_context_get_regex_error		(GtkSourceSearchContext	 *s
 
 GtkSourceRegexSearchState gtk_source_search_context_get_regex_state		(GtkSourceSearchContext	 *search);
 
+gboolean		 gtk_source_search_context_get_scan_visible_only	(GtkSourceSearchContext  *search);
+
+void			 gtk_source_search_context_set_scan_visible_only	(GtkSourceSearchContext  *search,
+										 gboolean                 scan_visible_only);
+
+gint			 gtk_source_search_context_get_occurrences_count_limit	(GtkSourceSearchContext  *search);
+
+void			 gtk_source_search_context_set_occurrences_count_limit	(GtkSourceSearchContext  *search,
+										 gint                     limit);
+
 gint			 gtk_source_search_context_get_occurrences_count	(GtkSourceSearchContext	 *search);
 
+gboolean		 gtk_source_search_context_get_occurrences_count_capped	(GtkSourceSearchContext	 *search);
+
 gint			 gtk_source_search_context_get_occurrence_position	(GtkSourceSearchContext	 *search,
 										 const GtkTextIter	 *match_start,
 										 const GtkTextIter	 *match_end);
@@ -109,6 +136,16 @@ void			 gtk_source_search_context_forward_async		(GtkSourceSearchContext	 *searc
 										 GAsyncReadyCallback	  callback,
 										 gpointer		  user_data);
 
+void			 gtk_source_search_context_forward_async_full		(GtkSourceSearchContext		 *search,
+										 const GtkTextIter		 *iter,
+										 gint				  io_priority,
+										 GCancellable			 *cancellable,
+										 GtkSourceSearchProgressCallback  progress_callback,
+										 gpointer			  progress_callback_data,
+										 GDestroyNotify			  progress_callback_data_free,
+										 GAsyncReadyCallback		  callback,
+										 gpointer			  user_data);
+
 gboolean		 gtk_source_search_context_forward_finish		(GtkSourceSearchContext	 *search,
 										 GAsyncResult		 *result,
 										 GtkTextIter		 *match_start,
@@ -126,6 +163,16 @@ void			 gtk_source_search_context_backward_async		(GtkSourceSearchContext	 *sear
 										 GAsyncReadyCallback	  callback,
 										 gpointer		  user_data);
 
+void			 gtk_source_search_context_backward_async_full		(GtkSourceSearchContext		 *search,
+										 const GtkTextIter		 *iter,
+										 gint				  io_priority,
+										 GCancellable			 *cancellable,
+										 GtkSourceSearchProgressCallback  progress_callback,
+										 gpointer			  progress_callback_data,
+										 GDestroyNotify			  progress_callback_data_free,
+										 GAsyncReadyCallback		  callback,
+										 gpointer			  user_data);
+
 gboolean		 gtk_source_search_context_backward_finish		(GtkSourceSearchContext	 *search,
 										 GAsyncResult		 *result,
 										 GtkTextIter		 *match_start,
@@ -31,6 +31,7 @@ typedef struct _GtkSourceCompletionContext	GtkSourceCompletionContext;
 typedef struct _GtkSourceCompletion		GtkSourceCompletion;
 typedef struct _GtkSourceCompletionInfo		GtkSourceCompletionInfo;
 typedef struct _GtkSourceCompletionItem		GtkSourceCompletionItem;
+typedef struct _GtkSourceCompletionMatcher	GtkSourceCompletionMatcher;
 typedef struct _GtkSourceCompletionProposal	GtkSourceCompletionProposal;
 typedef struct _GtkSourceCompletionProvider	GtkSourceCompletionProvider;
 typedef struct _GtkSourceGutter			GtkSourceGutter;
@@ -41,6 +42,7 @@ typedef struct _GtkSourceLanguage		GtkSourceLanguage;
 typedef struct _GtkSourceLanguageManager	GtkSourceLanguageManager;
 typedef struct _GtkSourceMarkAttributes		GtkSourceMarkAttributes;
 typedef struct _GtkSourceMark			GtkSourceMark;
+typedef struct _GtkSourceMultiSearch		GtkSourceMultiSearch;
 typedef struct _GtkSourcePrintCompositor	GtkSourcePrintCompositor;
 typedef struct _GtkSourceSearchContext		GtkSourceSearchContext;
 typedef struct _GtkSourceSearchSettings		GtkSourceSearchSettings;
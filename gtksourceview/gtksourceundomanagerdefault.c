@@ -27,14 +27,62 @@
 #endif
 
 #include <glib.h>
+#include <gio/gio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "gtksourceundomanagerdefault.h"
 #include "gtksourceundomanager.h"
+#include "gtksourcebuffer.h"
 #include "gtksourceview-i18n.h"
 
 #define DEFAULT_MAX_UNDO_LEVELS		-1
+#define DEFAULT_MAX_UNDO_SIZE		-1
+
+/* The text arena is compacted when it contains more than this number of
+ * unused bytes, and more unused bytes than used ones.
+ */
+#define TEXT_ARENA_MIN_GARBAGE		4096
+
+/* Above this size, the text arena is freed when the history is cleared. */
+#define TEXT_ARENA_MAX_KEPT_SIZE	(64 * 1024)
+
+/* The text of the deletions of more than this number of characters is copied
+ * into the text arena by chunks, to avoid a temporary copy of the whole range.
+ */
+#define DELETED_TEXT_CHUNK_CHARS	(64 * 1024)
+
+/* Persistent history file format: the header, then the payload compressed
+ * in the zlib format, whose Adler-32 checksum is verified when the payload is
+ * decompressed. All the integers are little-endian.
+ *
+ * Header:
+ * - HISTORY_FILE_MAGIC;
+ * - the SHA-256 checksum of the buffer contents, as a hexadecimal string;
+ * - can_undo and can_redo, one byte each;
+ * - the size of the uncompressed payload, 32 bits.
+ *
+ * Payload:
+ * - the number of actions, and next_redo, 32 bits each;
+ * - for each action, from the oldest: the type, the flags (mergeable and
+ *   modified) and order_in_group, the offsets of the action, then the length
+ *   of the text and the text.
+ */
+#define HISTORY_FILE_MAGIC		"GSVUNDO\2"
+#define HISTORY_FILE_MAGIC_LENGTH	8
+#define HISTORY_CHECKSUM_LENGTH		64
+#define HISTORY_HEADER_LENGTH		(HISTORY_FILE_MAGIC_LENGTH + HISTORY_CHECKSUM_LENGTH + 2 + 4)
+
+/* The buffer checksum is computed by chunks of this number of lines, so the
+ * whole contents is not copied at once.
+ */
+#define CHECKSUM_CHUNK_LINES		1000
+
+/* With a maximum size, the text of the old actions is compressed in blocks of
+ * about this size, and the text of the recent actions, about two blocks, is
+ * kept uncompressed.
+ */
+#define COMPRESSED_BLOCK_SIZE		(256 * 1024)
 
 /*
  * The old code which used a GSList and g_slist_nth_element
@@ -50,6 +98,7 @@
 typedef struct _GtkSourceUndoAction  			GtkSourceUndoAction;
 typedef struct _GtkSourceUndoInsertAction		GtkSourceUndoInsertAction;
 typedef struct _GtkSourceUndoDeleteAction		GtkSourceUndoDeleteAction;
+typedef struct _CompressedBlock				CompressedBlock;
 
 typedef enum
 {
@@ -60,13 +109,37 @@ typedef enum
 /*
  * We use offsets instead of GtkTextIters because the last ones
  * require to much memory in this context without giving us any advantage.
+ *
+ * The text of all the actions is stored in a single append-only buffer, the
+ * text arena, and each action references a slice of it. When typing, the text
+ * of the last action is at the end of the arena, so merging a new character is
+ * an append, without allocating a new string. When the slice of the action to
+ * merge is not at the end of the arena, the slice is first copied at the end
+ * and the old slice becomes unused. When the text is prepended, with the
+ * backspace key, the slice is copied with free space before it, as big as the
+ * slice, so the next characters are prepended in place. The unused bytes,
+ * including the free space and the text of the freed actions, are reclaimed by
+ * compacting the arena when they outweigh the used ones.
+ *
+ * When the history has a maximum size, the text of the oldest actions is
+ * moved out of the arena and compressed by blocks. The compressed actions are
+ * always the first ones of the list: undoing goes from the most recent action
+ * to the oldest, and when a compressed action is reached, its whole block is
+ * decompressed back into the arena.
  */
 
+struct _CompressedBlock
+{
+	GBytes *data;
+	gsize   uncompressed_size;
+
+	/* Number of actions referencing the block. */
+	guint   n_actions;
+};
+
 struct _GtkSourceUndoInsertAction
 {
 	gint   pos;
-	gchar *text;
-	gint   length;
 	gint   chars;
 
 	gint   selection_start;
@@ -77,7 +150,6 @@ struct _GtkSourceUndoDeleteAction
 {
 	gint      start;
 	gint      end;
-	gchar    *text;
 	gboolean  forward;
 
 	gint      selection_start;
@@ -94,6 +166,14 @@ struct _GtkSourceUndoAction
 		GtkSourceUndoDeleteAction  delete;
 	} action;
 
+	/* The inserted or deleted text, as a slice of the text arena, or of
+	 * the uncompressed block if the text is compressed. The slice is not
+	 * nul-terminated.
+	 */
+	CompressedBlock *block;
+	gsize text_offset;
+	gsize text_length;
+
 	gint order_in_group;
 
 	/* It is TRUE whether the action can be merged with the following action. */
@@ -124,11 +204,36 @@ struct _GtkSourceUndoManagerDefaultPrivate
 	GPtrArray *actions;
 	gint next_redo;
 
+	/* The text of the actions, see GtkSourceUndoAction. */
+	GString *text_arena;
+
+	/* Number of bytes of text_arena referenced by the actions. */
+	gsize text_arena_used;
+
+	/* Free space of text_arena reserved for prepend_action_text(), just
+	 * before the slice starting at text_arena_gap_end.
+	 */
+	gsize text_arena_gap_end;
+	gsize text_arena_gap_size;
+
+	/* The first n_compressed_actions actions have their text compressed. */
+	guint n_compressed_actions;
+	gsize compressed_size;
+
 	gint actions_in_current_group;
 	gint running_not_undoable_actions;
 	gint num_of_groups;
 	gint max_undo_levels;
 
+	/* Maximum number of bytes of stored text, or -1. */
+	gint max_undo_size;
+
+	/* A history file whose header has been read, but not the actions yet,
+	 * see gtk_source_undo_manager_default_load_history().
+	 */
+	GFile *pending_history_file;
+	gchar *pending_history_checksum;
+
 	guint can_undo : 1;
 	guint can_redo : 1;
 
@@ -149,7 +254,8 @@ enum
 {
 	PROP_0,
 	PROP_BUFFER,
-	PROP_MAX_UNDO_LEVELS
+	PROP_MAX_UNDO_LEVELS,
+	PROP_MAX_UNDO_SIZE
 };
 
 static void insert_text_handler       (GtkTextBuffer             *buffer,
@@ -172,13 +278,19 @@ static void modified_changed_handler  (GtkTextBuffer             *buffer,
 static void free_action_list          (GtkSourceUndoManagerDefault      *um);
 
 static void add_action                (GtkSourceUndoManagerDefault      *um,
-                                       const GtkSourceUndoAction *undo_action);
+                                       const GtkSourceUndoAction *undo_action,
+                                       const gchar               *text);
 static void free_first_n_actions      (GtkSourceUndoManagerDefault      *um,
                                        gint                       n);
 static void check_list_size           (GtkSourceUndoManagerDefault      *um);
+static gboolean history_exceeds_limits (GtkSourceUndoManagerDefault     *um);
+static void compact_text_arena        (GtkSourceUndoManagerDefault      *um);
+static void compress_cold_actions     (GtkSourceUndoManagerDefault      *um);
+static gboolean load_pending_history  (GtkSourceUndoManagerDefault      *um);
 
 static gboolean merge_action          (GtkSourceUndoManagerDefault      *um,
-                                       const GtkSourceUndoAction *undo_action);
+                                       const GtkSourceUndoAction *undo_action,
+                                       const gchar               *text);
 
 static void gtk_source_undo_manager_iface_init (GtkSourceUndoManagerIface *iface);
 
@@ -196,6 +308,10 @@ gtk_source_undo_manager_default_finalize (GObject *object)
 
 	free_action_list (manager);
 	g_ptr_array_free (manager->priv->actions, TRUE);
+	g_string_free (manager->priv->text_arena, TRUE);
+
+	g_clear_object (&manager->priv->pending_history_file);
+	g_free (manager->priv->pending_history_checksum);
 
 	G_OBJECT_CLASS (gtk_source_undo_manager_default_parent_class)->finalize (object);
 }
@@ -205,6 +321,10 @@ clear_undo (GtkSourceUndoManagerDefault *manager)
 {
 	free_action_list (manager);
 
+	g_clear_object (&manager->priv->pending_history_file);
+	g_free (manager->priv->pending_history_checksum);
+	manager->priv->pending_history_checksum = NULL;
+
 	manager->priv->next_redo = -1;
 
 	if (manager->priv->can_undo)
@@ -287,6 +407,39 @@ set_buffer (GtkSourceUndoManagerDefault *manager,
 	}
 }
 
+/* Removes the redo actions, then the oldest undo actions, until the history
+ * fits in the limits.
+ */
+static void
+apply_limits (GtkSourceUndoManagerDefault *manager)
+{
+	/* strip redo actions first */
+	while (manager->priv->next_redo >= 0 &&
+	       history_exceeds_limits (manager))
+	{
+		free_first_n_actions (manager, 1);
+		manager->priv->next_redo--;
+	}
+
+	/* now remove undo actions if necessary */
+	check_list_size (manager);
+	compact_text_arena (manager);
+
+	/* emit "can_undo" and/or "can_redo" if appropiate */
+	if (manager->priv->next_redo < 0 && manager->priv->can_redo)
+	{
+		manager->priv->can_redo = FALSE;
+		gtk_source_undo_manager_can_redo_changed (GTK_SOURCE_UNDO_MANAGER (manager));
+	}
+
+	if (manager->priv->can_undo &&
+	    manager->priv->next_redo >= (gint)manager->priv->actions->len - 1)
+	{
+		manager->priv->can_undo = FALSE;
+		gtk_source_undo_manager_can_undo_changed (GTK_SOURCE_UNDO_MANAGER (manager));
+	}
+}
+
 static void
 set_max_undo_levels (GtkSourceUndoManagerDefault *manager,
                      gint                         max_undo_levels)
@@ -301,33 +454,28 @@ set_max_undo_levels (GtkSourceUndoManagerDefault *manager,
 
 	if (old_levels > max_undo_levels)
 	{
-		/* strip redo actions first */
-		while (manager->priv->next_redo >= 0 &&
-		       (manager->priv->num_of_groups > max_undo_levels))
-		{
-			free_first_n_actions (manager, 1);
-			manager->priv->next_redo--;
-		}
+		apply_limits (manager);
+	}
+}
 
-		/* now remove undo actions if necessary */
-		check_list_size (manager);
+static void
+set_max_undo_size (GtkSourceUndoManagerDefault *manager,
+                   gint                         max_undo_size)
+{
+	gint old_size;
 
-		/* emit "can_undo" and/or "can_redo" if appropiate */
-		if (manager->priv->next_redo < 0 && manager->priv->can_redo)
-		{
-			manager->priv->can_redo = FALSE;
-			gtk_source_undo_manager_can_redo_changed (GTK_SOURCE_UNDO_MANAGER (manager));
-		}
+	old_size = manager->priv->max_undo_size;
+	manager->priv->max_undo_size = max_undo_size;
 
-		if (manager->priv->can_undo &&
-		    manager->priv->next_redo >= (gint)manager->priv->actions->len - 1)
-		{
-			manager->priv->can_undo = FALSE;
-			gtk_source_undo_manager_can_undo_changed (GTK_SOURCE_UNDO_MANAGER (manager));
-		}
+	if (max_undo_size < 0)
+		return;
+
+	if (old_size < 0 || old_size > max_undo_size)
+	{
+		apply_limits (manager);
+		compress_cold_actions (manager);
 	}
 }
-
 static void
 gtk_source_undo_manager_default_dispose (GObject *object)
 {
@@ -361,6 +509,10 @@ gtk_source_undo_manager_default_set_property (GObject      *object,
 			gtk_source_undo_manager_default_set_max_undo_levels (self,
 			                                                     g_value_get_int (value));
 		break;
+		case PROP_MAX_UNDO_SIZE:
+			gtk_source_undo_manager_default_set_max_undo_size (self,
+			                                                   g_value_get_int (value));
+		break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -383,6 +535,9 @@ gtk_source_undo_manager_default_get_property (GObject    *object,
 		case PROP_MAX_UNDO_LEVELS:
 			g_value_set_int (value, self->priv->max_undo_levels);
 		break;
+		case PROP_MAX_UNDO_SIZE:
+			g_value_set_int (value, self->priv->max_undo_size);
+		break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -418,6 +573,17 @@ gtk_source_undo_manager_default_class_init (GtkSourceUndoManagerDefaultClass *kl
 	                                                   G_MAXINT,
 	                                                   DEFAULT_MAX_UNDO_LEVELS,
 	                                                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_MAX_UNDO_SIZE,
+	                                 g_param_spec_int ("max-undo-size",
+	                                                   _("Maximum Undo Size"),
+	                                                   _("Maximum number of bytes of "
+							     "text in the undo history"),
+	                                                   -1,
+	                                                   G_MAXINT,
+	                                                   DEFAULT_MAX_UNDO_SIZE,
+	                                                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
 }
 
 static void
@@ -425,6 +591,9 @@ gtk_source_undo_manager_default_init (GtkSourceUndoManagerDefault *um)
 {
 	um->priv = gtk_source_undo_manager_default_get_instance_private (um);
 	um->priv->actions = g_ptr_array_new ();
+	um->priv->text_arena = g_string_new (NULL);
+	um->priv->max_undo_levels = DEFAULT_MAX_UNDO_LEVELS;
+	um->priv->max_undo_size = DEFAULT_MAX_UNDO_SIZE;
 }
 
 static void
@@ -501,6 +670,8 @@ insert_text (GtkTextBuffer *buffer,
 {
 	GtkTextIter iter;
 
+	g_return_if_fail (text != NULL);
+
 	gtk_text_buffer_get_iter_at_offset (buffer, &iter, pos);
 
 	gtk_text_buffer_begin_user_action (buffer);
@@ -546,707 +717,2043 @@ get_chars (GtkTextBuffer *buffer,
 	return gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, TRUE);
 }
 
-static GtkSourceUndoAction *
-action_list_nth_data (GPtrArray *array,
-                      gint       n)
+/* Appends the text between @start and @end to the text arena, by chunks of
+ * DELETED_TEXT_CHUNK_CHARS characters, and returns the number of bytes
+ * appended. The text is not referenced by an action yet.
+ */
+static gsize
+append_range_to_arena (GtkSourceUndoManagerDefault *um,
+                       const GtkTextIter           *start,
+                       const GtkTextIter           *end)
 {
-	if (n < 0 || n >= (gint)array->len)
-		return NULL;
-	else
-		return array->pdata[array->len - 1 - n];
+	GString *arena = um->priv->text_arena;
+	gsize old_len = arena->len;
+	GtkTextIter chunk_start = *start;
+
+	while (gtk_text_iter_compare (&chunk_start, end) < 0)
+	{
+		GtkTextIter chunk_end = chunk_start;
+		gchar *chunk;
+
+		gtk_text_iter_forward_chars (&chunk_end, DELETED_TEXT_CHUNK_CHARS);
+
+		if (gtk_text_iter_compare (&chunk_end, end) > 0)
+			chunk_end = *end;
+
+		chunk = gtk_text_buffer_get_slice (um->priv->buffer,
+		                                   &chunk_start,
+		                                   &chunk_end,
+		                                   TRUE);
+		g_string_append (arena, chunk);
+		g_free (chunk);
+
+		chunk_start = chunk_end;
+	}
+
+	return arena->len - old_len;
+}
+
+static gboolean thaw_last_compressed_block (GtkSourceUndoManagerDefault *um);
+
+/* The returned text is valid until the text arena is modified. */
+static const gchar *
+get_action_text (GtkSourceUndoManagerDefault *um,
+                 const GtkSourceUndoAction   *action)
+{
+	/* The compressed actions are the first ones, so this terminates. */
+	while (action->block != NULL)
+	{
+		if (!thaw_last_compressed_block (um))
+			return NULL;
+	}
+
+	return um->priv->text_arena->str + action->text_offset;
+}
+
+/* Returns the last character of a non-empty text of @length bytes. */
+static gunichar
+get_last_char (const gchar *text,
+               gsize        length)
+{
+	return g_utf8_get_char (g_utf8_prev_char (text + length));
 }
 
+/* Copies the text of @action at the end of the text arena. */
 static void
-action_list_prepend (GPtrArray           *array,
-                     GtkSourceUndoAction *action)
+move_action_text_to_arena_end (GtkSourceUndoManagerDefault *um,
+                               GtkSourceUndoAction         *action)
 {
-	g_ptr_array_add (array, action);
+	GString *arena = um->priv->text_arena;
+	gsize new_offset = arena->len;
+
+	if (action->text_offset + action->text_length == arena->len)
+		return;
+
+	/* Resize first, the arena can be reallocated. */
+	g_string_set_size (arena, arena->len + action->text_length);
+	memcpy (arena->str + new_offset,
+	        arena->str + action->text_offset,
+	        action->text_length);
+
+	action->text_offset = new_offset;
 }
 
-static GtkSourceUndoAction *
-action_list_last_data (GPtrArray *array)
+static void
+set_action_text (GtkSourceUndoManagerDefault *um,
+                 GtkSourceUndoAction         *action,
+                 const gchar                 *text,
+                 gsize                        length)
 {
-	if (array->len != 0)
-		return array->pdata[0];
-	else
-		return NULL;
+	action->text_offset = um->priv->text_arena->len;
+	action->text_length = length;
+
+	g_string_append_len (um->priv->text_arena, text, length);
+	um->priv->text_arena_used += length;
 }
 
 static void
-action_list_delete_last (GPtrArray *array)
+append_action_text (GtkSourceUndoManagerDefault *um,
+                    GtkSourceUndoAction         *action,
+                    const gchar                 *text,
+                    gsize                        length)
 {
-	if (array->len != 0)
+	move_action_text_to_arena_end (um, action);
+
+	g_string_append_len (um->priv->text_arena, text, length);
+	action->text_length += length;
+	um->priv->text_arena_used += length;
+}
+
+static void
+prepend_action_text (GtkSourceUndoManagerDefault *um,
+                     GtkSourceUndoAction         *action,
+                     const gchar                 *text,
+                     gsize                        length)
+{
+	GString *arena = um->priv->text_arena;
+
+	if (action->block != NULL ||
+	    action->text_offset != um->priv->text_arena_gap_end ||
+	    um->priv->text_arena_gap_size < length)
 	{
-		memmove (&array->pdata[0], &array->pdata[1], (array->len - 1)*sizeof (gpointer));
-		g_ptr_array_set_size (array, array->len - 1);
+		/* The free space doubles the size of the slice, so the cost
+		 * of the copies is amortized over a backspace run.
+		 */
+		gsize gap_size = MAX (length, action->text_length);
+		gsize new_offset = arena->len + gap_size;
+
+		/* Resize first, the arena can be reallocated. */
+		g_string_set_size (arena, new_offset + action->text_length);
+		memcpy (arena->str + new_offset,
+		        arena->str + action->text_offset,
+		        action->text_length);
+
+		action->text_offset = new_offset;
+		um->priv->text_arena_gap_size = gap_size;
 	}
+
+	action->text_offset -= length;
+	memcpy (arena->str + action->text_offset, text, length);
+	action->text_length += length;
+	um->priv->text_arena_used += length;
+
+	um->priv->text_arena_gap_end = action->text_offset;
+	um->priv->text_arena_gap_size -= length;
 }
 
+/* Reclaims the unused bytes of the text arena, if there are enough of them.
+ * The cost is amortized: the arena is compacted only when the unused bytes
+ * outweigh the used ones.
+ */
 static void
-gtk_source_undo_manager_undo_impl (GtkSourceUndoManager *manager)
+compact_text_arena (GtkSourceUndoManagerDefault *um)
 {
-	GtkSourceUndoManagerDefault *manager_default;
-	GtkSourceUndoAction *undo_action;
-	gboolean modified = FALSE;
-	gint selection_start = -1;
-	gint selection_end;
+	GString *old_arena = um->priv->text_arena;
+	GString *new_arena;
+	gsize garbage;
+	guint i;
 
-	manager_default = GTK_SOURCE_UNDO_MANAGER_DEFAULT (manager);
-
-	g_return_if_fail (manager_default->priv->can_undo);
+	garbage = old_arena->len - um->priv->text_arena_used;
 
-	manager_default->priv->modified_undoing_group = FALSE;
+	if (garbage < TEXT_ARENA_MIN_GARBAGE ||
+	    garbage < um->priv->text_arena_used)
+	{
+		return;
+	}
 
-	gtk_source_undo_manager_begin_not_undoable_action (manager);
+	new_arena = g_string_sized_new (um->priv->text_arena_used);
 
-	do
+	/* The oldest action is the first one. */
+	for (i = um->priv->n_compressed_actions; i < um->priv->actions->len; i++)
 	{
-		undo_action = action_list_nth_data (manager_default->priv->actions,
-		                                    manager_default->priv->next_redo + 1);
+		GtkSourceUndoAction *action = um->priv->actions->pdata[i];
+		gsize new_offset = new_arena->len;
 
-		g_return_if_fail (undo_action != NULL);
+		g_string_append_len (new_arena,
+		                     old_arena->str + action->text_offset,
+		                     action->text_length);
 
-		/* undo_action->modified can be TRUE only if undo_action->order_in_group <= 1 */
-		g_return_if_fail ((undo_action->order_in_group <= 1) ||
-				  ((undo_action->order_in_group > 1) && !undo_action->modified));
+		action->text_offset = new_offset;
+	}
 
-		if (undo_action->order_in_group <= 1)
-		{
-			/* Set modified to TRUE only if the buffer did not change its state from
-			 * "not modified" to "modified" undoing an action (with order_in_group > 1)
-			 * in current group. */
-			modified = (undo_action->modified &&
-			            !manager_default->priv->modified_undoing_group);
-		}
+	g_string_free (old_arena, TRUE);
+	um->priv->text_arena = new_arena;
+	um->priv->text_arena_gap_size = 0;
+}
 
-		switch (undo_action->action_type)
-		{
-			case GTK_SOURCE_UNDO_ACTION_DELETE:
-				insert_text (manager_default->priv->buffer,
-				             undo_action->action.delete.start,
-				             undo_action->action.delete.text,
-				             strlen (undo_action->action.delete.text));
+/* Runs @converter on the whole @data. */
+static GBytes *
+convert_data (GConverter  *converter,
+              const gchar *data,
+              gsize        size,
+              gsize        size_hint)
+{
+	GByteArray *output;
+	gsize input_pos = 0;
+	gsize output_pos = 0;
+	GConverterResult result;
 
-				selection_start = undo_action->action.delete.selection_start;
-				selection_end = undo_action->action.delete.selection_end;
-				break;
+	output = g_byte_array_sized_new (MAX (size_hint, 1024));
+	g_byte_array_set_size (output, MAX (size_hint, 1024));
 
-			case GTK_SOURCE_UNDO_ACTION_INSERT:
-				delete_text (manager_default->priv->buffer,
-				             undo_action->action.insert.pos,
-				             undo_action->action.insert.pos +
-				             undo_action->action.insert.chars);
+	do
+	{
+		gsize bytes_read;
+		gsize bytes_written;
+		GError *error = NULL;
+
+		result = g_converter_convert (converter,
+		                              data + input_pos,
+		                              size - input_pos,
+		                              output->data + output_pos,
+		                              output->len - output_pos,
+		                              G_CONVERTER_INPUT_AT_END,
+		                              &bytes_read,
+		                              &bytes_written,
+		                              &error);
+
+		if (result == G_CONVERTER_ERROR)
+		{
+			if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE))
+			{
+				g_warning ("Undo history compression error: %s", error->message);
+				g_error_free (error);
+				g_byte_array_free (output, TRUE);
+				return NULL;
+			}
 
-				selection_start = undo_action->action.insert.selection_start;
-				selection_end = undo_action->action.insert.selection_end;
-				break;
+			g_error_free (error);
+			g_byte_array_set_size (output, output->len * 2);
+			continue;
+		}
 
-			default:
-				/* Unknown action type. */
-				g_return_if_reached ();
+		input_pos += bytes_read;
+		output_pos += bytes_written;
+
+		if (output_pos == output->len)
+		{
+			g_byte_array_set_size (output, output->len * 2);
 		}
+	}
+	while (result != G_CONVERTER_FINISHED);
 
-		++manager_default->priv->next_redo;
+	g_byte_array_set_size (output, output_pos);
+	return g_byte_array_free_to_bytes (output);
+}
 
-	} while (undo_action->order_in_group > 1);
+static void
+compressed_block_unref (GtkSourceUndoManagerDefault *um,
+                        CompressedBlock             *block)
+{
+	g_return_if_fail (block->n_actions > 0);
 
-	if (selection_start >= 0)
+	if (--block->n_actions == 0)
 	{
-		set_cursor (manager_default->priv->buffer,
-		            selection_start,
-		            selection_end);
+		um->priv->compressed_size -= g_bytes_get_size (block->data);
+		g_bytes_unref (block->data);
+		g_slice_free (CompressedBlock, block);
 	}
+}
 
-	if (modified)
+/* Compresses the text of the actions in [first, last] in one block. */
+static void
+compress_actions (GtkSourceUndoManagerDefault *um,
+                  guint                        first,
+                  guint                        last)
+{
+	GString *text;
+	GConverter *compressor;
+	CompressedBlock *block;
+	GBytes *data;
+	guint i;
+
+	text = g_string_new (NULL);
+
+	for (i = first; i <= last; i++)
 	{
-		--manager_default->priv->next_redo;
-		gtk_text_buffer_set_modified (manager_default->priv->buffer, FALSE);
-		++manager_default->priv->next_redo;
-	}
+		GtkSourceUndoAction *action = um->priv->actions->pdata[i];
 
-	/* FIXME: why does this call the internal one ? */
-	end_not_undoable_action_internal (manager_default);
+		g_string_append_len (text, get_action_text (um, action), action->text_length);
+	}
 
-	manager_default->priv->modified_undoing_group = FALSE;
+	compressor = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, 1));
+	data = convert_data (compressor, text->str, text->len, text->len / 4);
+	g_object_unref (compressor);
 
-	if (!manager_default->priv->can_redo)
+	if (data == NULL)
 	{
-		manager_default->priv->can_redo = TRUE;
-		gtk_source_undo_manager_can_redo_changed (manager);
+		g_string_free (text, TRUE);
+		return;
 	}
 
-	if (manager_default->priv->next_redo >= (gint)manager_default->priv->actions->len - 1)
+	block = g_slice_new (CompressedBlock);
+	block->data = data;
+	block->uncompressed_size = text->len;
+	block->n_actions = 0;
+
+	um->priv->compressed_size += g_bytes_get_size (data);
+	g_string_free (text, TRUE);
+
+	for (i = first; i <= last; i++)
 	{
-		manager_default->priv->can_undo = FALSE;
-		gtk_source_undo_manager_can_undo_changed (manager);
+		GtkSourceUndoAction *action = um->priv->actions->pdata[i];
+		gsize offset = 0;
+
+		if (i > first)
+		{
+			GtkSourceUndoAction *prev = um->priv->actions->pdata[i - 1];
+			offset = prev->text_offset + prev->text_length;
+		}
+
+		um->priv->text_arena_used -= action->text_length;
+
+		action->block = block;
+		action->text_offset = offset;
+		block->n_actions++;
 	}
+
+	um->priv->n_compressed_actions = last + 1;
 }
 
+/* Compresses the text of the old actions, so more history fits in the maximum
+ * size. The last action is never compressed, the next action can be merged
+ * with it.
+ */
 static void
-gtk_source_undo_manager_redo_impl (GtkSourceUndoManager *manager)
+compress_cold_actions (GtkSourceUndoManagerDefault *um)
 {
-	GtkSourceUndoManagerDefault *manager_default;
-	GtkSourceUndoAction *undo_action;
-	gboolean modified = FALSE;
-	gint selection_start = -1;
-	gint selection_end;
+	if (um->priv->max_undo_size < 0)
+		return;
 
-	manager_default = GTK_SOURCE_UNDO_MANAGER_DEFAULT (manager);
+	while (um->priv->text_arena_used > 2 * COMPRESSED_BLOCK_SIZE)
+	{
+		guint first = um->priv->n_compressed_actions;
+		guint last = first;
+		gsize block_size = 0;
 
-	g_return_if_fail (manager_default->priv->can_redo);
+		if (first + 1 >= um->priv->actions->len)
+			break;
 
-	undo_action = action_list_nth_data (manager_default->priv->actions,
-	                                    manager_default->priv->next_redo);
-	g_return_if_fail (undo_action != NULL);
+		for (last = first; last + 1 < um->priv->actions->len; last++)
+		{
+			GtkSourceUndoAction *action = um->priv->actions->pdata[last];
 
-	gtk_source_undo_manager_begin_not_undoable_action (manager);
+			block_size += action->text_length;
 
-	do
-	{
-		if (undo_action->modified)
-		{
-			g_return_if_fail (undo_action->order_in_group <= 1);
-			modified = TRUE;
+			if (block_size >= COMPRESSED_BLOCK_SIZE)
+				break;
 		}
 
-		--manager_default->priv->next_redo;
+		if (last + 1 == um->priv->actions->len)
+			last--;
 
-		switch (undo_action->action_type)
-		{
-			case GTK_SOURCE_UNDO_ACTION_DELETE:
-				delete_text (manager_default->priv->buffer,
-				             undo_action->action.delete.start,
-				             undo_action->action.delete.end);
+		compress_actions (um, first, last);
 
-				selection_start = undo_action->action.delete.selection_start;
-				selection_end = undo_action->action.delete.selection_end;
+		/* On error, the actions are not compressed. */
+		if (um->priv->n_compressed_actions != last + 1)
+			break;
+	}
 
-				break;
+	compact_text_arena (um);
+}
 
-			case GTK_SOURCE_UNDO_ACTION_INSERT:
-				selection_start = undo_action->action.insert.selection_start;
-				selection_end = undo_action->action.insert.selection_end;
+/* Returns the uncompressed text of @block, or NULL on error. */
+static GBytes *
+decompress_block (CompressedBlock *block)
+{
+	GConverter *decompressor;
+	GBytes *text;
+
+	decompressor = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+	text = convert_data (decompressor,
+	                     g_bytes_get_data (block->data, NULL),
+	                     g_bytes_get_size (block->data),
+	                     block->uncompressed_size);
+	g_object_unref (decompressor);
+
+	/* Should not happen, the data has been compressed by us. */
+	if (text == NULL || g_bytes_get_size (text) != block->uncompressed_size)
+	{
+		g_warning ("Failed to decompress the undo history.");
 
-				insert_text (manager_default->priv->buffer,
-				             undo_action->action.insert.pos,
-				             undo_action->action.insert.text,
-				             undo_action->action.insert.length);
+		if (text != NULL)
+			g_bytes_unref (text);
 
-				break;
+		return NULL;
+	}
 
-			default:
-				/* Unknown action type */
-				++manager_default->priv->next_redo;
+	return text;
+}
+
+/* Decompresses the text of the last compressed block into the text arena. */
+static gboolean
+thaw_last_compressed_block (GtkSourceUndoManagerDefault *um)
+{
+	GtkSourceUndoAction *action;
+	CompressedBlock *block;
+	GBytes *text;
+	const gchar *text_data;
+	gint i;
+
+	g_return_val_if_fail (um->priv->n_compressed_actions > 0, FALSE);
+
+	action = um->priv->actions->pdata[um->priv->n_compressed_actions - 1];
+	block = action->block;
+
+	text = decompress_block (block);
+
+	if (text == NULL)
+		return FALSE;
+
+	text_data = g_bytes_get_data (text, NULL);
+
+	for (i = um->priv->n_compressed_actions - 1; i >= 0; i--)
+	{
+		action = um->priv->actions->pdata[i];
+
+		if (action->block != block)
+			break;
+
+		action->block = NULL;
+		set_action_text (um, action,
+		                 text_data + action->text_offset,
+		                 action->text_length);
+
+		um->priv->n_compressed_actions--;
+		compressed_block_unref (um, block);
+	}
+
+	g_bytes_unref (text);
+	return TRUE;
+}
+
+/* An edit to apply to the buffer when undoing or redoing a group of actions.
+ * Contiguous actions of the same type are merged into one edit, so the buffer,
+ * and all the objects listening to its signals (the highlighting engine, the
+ * search contexts, etc.) see a single insertion or deletion.
+ */
+typedef struct
+{
+	GtkSourceUndoActionType type;
+	gint start;
+	gint chars;
+
+	/* For an insertion, the actions providing the text, in order. */
+	GQueue actions;
+
+	/* The index of the first action applied, or -1 if the edit is empty. */
+	gint first_index;
+} PendingEdit;
+
+static void
+pending_edit_init (PendingEdit *edit)
+{
+	g_queue_init (&edit->actions);
+	edit->first_index = -1;
+}
+
+static void
+pending_edit_flush (GtkSourceUndoManagerDefault *um,
+                    PendingEdit                 *edit)
+{
+	gint next_redo;
+
+	if (edit->first_index < 0)
+		return;
+
+	/* If the buffer becomes modified, modified_changed_handler() must
+	 * find the same action as if the actions were applied one by one.
+	 */
+	next_redo = um->priv->next_redo;
+	um->priv->next_redo = edit->first_index - 1;
+
+	if (edit->type == GTK_SOURCE_UNDO_ACTION_DELETE)
+	{
+		delete_text (um->priv->buffer,
+		             edit->start,
+		             edit->start + edit->chars);
+	}
+	else if (edit->actions.length == 1)
+	{
+		GtkSourceUndoAction *action = g_queue_peek_head (&edit->actions);
+
+		insert_text (um->priv->buffer,
+		             edit->start,
+		             get_action_text (um, action),
+		             action->text_length);
+	}
+	else
+	{
+		GString *text = g_string_new (NULL);
+		GList *l;
+
+		for (l = edit->actions.head; l != NULL; l = l->next)
+		{
+			GtkSourceUndoAction *action = l->data;
+			const gchar *action_text = get_action_text (um, action);
+
+			if (action_text != NULL)
+				g_string_append_len (text, action_text, action->text_length);
+		}
+
+		insert_text (um->priv->buffer, edit->start, text->str, text->len);
+		g_string_free (text, TRUE);
+	}
+
+	um->priv->next_redo = next_redo;
+
+	g_queue_clear (&edit->actions);
+	edit->first_index = -1;
+}
+
+/* Adds the insertion of the text of @action at @pos, in the buffer state
+ * after the pending edit.
+ */
+static void
+pending_edit_add_insert (GtkSourceUndoManagerDefault *um,
+                         PendingEdit                 *edit,
+                         gint                         index,
+                         GtkSourceUndoAction         *action,
+                         gint                         pos,
+                         gint                         chars)
+{
+	if (edit->first_index >= 0 &&
+	    edit->type == GTK_SOURCE_UNDO_ACTION_INSERT)
+	{
+		if (pos == edit->start + edit->chars)
+		{
+			g_queue_push_tail (&edit->actions, action);
+			edit->chars += chars;
+			return;
+		}
+
+		if (pos == edit->start)
+		{
+			g_queue_push_head (&edit->actions, action);
+			edit->chars += chars;
+			return;
+		}
+	}
+
+	pending_edit_flush (um, edit);
+
+	edit->type = GTK_SOURCE_UNDO_ACTION_INSERT;
+	edit->start = pos;
+	edit->chars = chars;
+	edit->first_index = index;
+	g_queue_push_tail (&edit->actions, action);
+}
+
+/* Adds the deletion of [@start, @end), in the buffer state after the pending
+ * edit.
+ */
+static void
+pending_edit_add_delete (GtkSourceUndoManagerDefault *um,
+                         PendingEdit                 *edit,
+                         gint                         index,
+                         gint                         start,
+                         gint                         end)
+{
+	if (edit->first_index >= 0 &&
+	    edit->type == GTK_SOURCE_UNDO_ACTION_DELETE)
+	{
+		if (start == edit->start)
+		{
+			edit->chars += end - start;
+			return;
+		}
+
+		if (end == edit->start)
+		{
+			edit->start = start;
+			edit->chars += end - start;
+			return;
+		}
+	}
+
+	pending_edit_flush (um, edit);
+
+	edit->type = GTK_SOURCE_UNDO_ACTION_DELETE;
+	edit->start = start;
+	edit->chars = end - start;
+	edit->first_index = index;
+}
+
+static GtkSourceUndoAction *
+action_list_nth_data (GPtrArray *array,
+                      gint       n)
+{
+	if (n < 0 || n >= (gint)array->len)
+		return NULL;
+	else
+		return array->pdata[array->len - 1 - n];
+}
+
+static void
+action_list_prepend (GPtrArray           *array,
+                     GtkSourceUndoAction *action)
+{
+	g_ptr_array_add (array, action);
+}
+
+static GtkSourceUndoAction *
+action_list_last_data (GPtrArray *array)
+{
+	if (array->len != 0)
+		return array->pdata[0];
+	else
+		return NULL;
+}
+
+static void
+action_list_delete_last (GPtrArray *array)
+{
+	if (array->len != 0)
+	{
+		memmove (&array->pdata[0], &array->pdata[1], (array->len - 1)*sizeof (gpointer));
+		g_ptr_array_set_size (array, array->len - 1);
+	}
+}
+
+/* A group, for example a replace all, can contain a lot of actions which are
+ * not contiguous. With a GtkSourceBuffer, the group is applied in a batch edit,
+ * so the highlighting engine, the search contexts etc. update only once.
+ */
+static void
+begin_group_edit (GtkSourceUndoManagerDefault *manager)
+{
+	gtk_text_buffer_begin_user_action (manager->priv->buffer);
+
+	if (GTK_SOURCE_IS_BUFFER (manager->priv->buffer))
+	{
+		gtk_source_buffer_begin_batch_edit (GTK_SOURCE_BUFFER (manager->priv->buffer));
+	}
+}
+
+static void
+end_group_edit (GtkSourceUndoManagerDefault *manager)
+{
+	if (GTK_SOURCE_IS_BUFFER (manager->priv->buffer))
+	{
+		gtk_source_buffer_end_batch_edit (GTK_SOURCE_BUFFER (manager->priv->buffer));
+	}
+
+	gtk_text_buffer_end_user_action (manager->priv->buffer);
+}
+
+static void
+gtk_source_undo_manager_undo_impl (GtkSourceUndoManager *manager)
+{
+	GtkSourceUndoManagerDefault *manager_default;
+	GtkSourceUndoAction *undo_action;
+	PendingEdit edit;
+	gboolean first_action_modified = FALSE;
+	gboolean modified;
+	gint selection_start = -1;
+	gint selection_end;
+
+	manager_default = GTK_SOURCE_UNDO_MANAGER_DEFAULT (manager);
+
+	/* The history can be discarded if it doesn't match the buffer. */
+	if (!load_pending_history (manager_default))
+		return;
+
+	g_return_if_fail (manager_default->priv->can_undo);
+
+	manager_default->priv->modified_undoing_group = FALSE;
+
+	gtk_source_undo_manager_begin_not_undoable_action (manager);
+	begin_group_edit (manager_default);
+
+	pending_edit_init (&edit);
+
+	do
+	{
+		gint index = manager_default->priv->next_redo + 1;
+
+		undo_action = action_list_nth_data (manager_default->priv->actions, index);
+
+		g_return_if_fail (undo_action != NULL);
+
+		/* undo_action->modified can be TRUE only if undo_action->order_in_group <= 1 */
+		g_return_if_fail ((undo_action->order_in_group <= 1) ||
+				  ((undo_action->order_in_group > 1) && !undo_action->modified));
+
+		if (undo_action->order_in_group <= 1)
+		{
+			first_action_modified = undo_action->modified;
+		}
+
+		switch (undo_action->action_type)
+		{
+			case GTK_SOURCE_UNDO_ACTION_DELETE:
+				pending_edit_add_insert (manager_default,
+				                         &edit,
+				                         index,
+				                         undo_action,
+				                         undo_action->action.delete.start,
+				                         undo_action->action.delete.end -
+				                         undo_action->action.delete.start);
+
+				selection_start = undo_action->action.delete.selection_start;
+				selection_end = undo_action->action.delete.selection_end;
+				break;
+
+			case GTK_SOURCE_UNDO_ACTION_INSERT:
+				pending_edit_add_delete (manager_default,
+				                         &edit,
+				                         index,
+				                         undo_action->action.insert.pos,
+				                         undo_action->action.insert.pos +
+				                         undo_action->action.insert.chars);
+
+				selection_start = undo_action->action.insert.selection_start;
+				selection_end = undo_action->action.insert.selection_end;
+				break;
+
+			default:
+				/* Unknown action type. */
 				g_return_if_reached ();
 		}
 
-		if (manager_default->priv->next_redo < 0)
-			undo_action = NULL;
+		++manager_default->priv->next_redo;
+
+	} while (undo_action->order_in_group > 1);
+
+	pending_edit_flush (manager_default, &edit);
+	end_group_edit (manager_default);
+
+	/* Set modified to TRUE only if the buffer did not change its state from
+	 * "not modified" to "modified" undoing an action (with order_in_group > 1)
+	 * in current group. */
+	modified = (first_action_modified &&
+	            !manager_default->priv->modified_undoing_group);
+
+	if (selection_start >= 0)
+	{
+		set_cursor (manager_default->priv->buffer,
+		            selection_start,
+		            selection_end);
+	}
+
+	if (modified)
+	{
+		--manager_default->priv->next_redo;
+		gtk_text_buffer_set_modified (manager_default->priv->buffer, FALSE);
+		++manager_default->priv->next_redo;
+	}
+
+	/* FIXME: why does this call the internal one ? */
+	end_not_undoable_action_internal (manager_default);
+
+	manager_default->priv->modified_undoing_group = FALSE;
+
+	if (!manager_default->priv->can_redo)
+	{
+		manager_default->priv->can_redo = TRUE;
+		gtk_source_undo_manager_can_redo_changed (manager);
+	}
+
+	if (manager_default->priv->next_redo >= (gint)manager_default->priv->actions->len - 1)
+	{
+		manager_default->priv->can_undo = FALSE;
+		gtk_source_undo_manager_can_undo_changed (manager);
+	}
+}
+
+static void
+gtk_source_undo_manager_redo_impl (GtkSourceUndoManager *manager)
+{
+	GtkSourceUndoManagerDefault *manager_default;
+	GtkSourceUndoAction *undo_action;
+	PendingEdit edit;
+	gboolean modified = FALSE;
+	gint selection_start = -1;
+	gint selection_end;
+
+	manager_default = GTK_SOURCE_UNDO_MANAGER_DEFAULT (manager);
+
+	if (!load_pending_history (manager_default))
+		return;
+
+	g_return_if_fail (manager_default->priv->can_redo);
+
+	undo_action = action_list_nth_data (manager_default->priv->actions,
+	                                    manager_default->priv->next_redo);
+	g_return_if_fail (undo_action != NULL);
+
+	gtk_source_undo_manager_begin_not_undoable_action (manager);
+	begin_group_edit (manager_default);
+
+	pending_edit_init (&edit);
+
+	do
+	{
+		gint index = manager_default->priv->next_redo;
+
+		if (undo_action->modified)
+		{
+			g_return_if_fail (undo_action->order_in_group <= 1);
+			modified = TRUE;
+		}
+
+		--manager_default->priv->next_redo;
+
+		switch (undo_action->action_type)
+		{
+			case GTK_SOURCE_UNDO_ACTION_DELETE:
+				pending_edit_add_delete (manager_default,
+				                         &edit,
+				                         index,
+				                         undo_action->action.delete.start,
+				                         undo_action->action.delete.end);
+
+				selection_start = undo_action->action.delete.selection_start;
+				selection_end = undo_action->action.delete.selection_end;
+
+				break;
+
+			case GTK_SOURCE_UNDO_ACTION_INSERT:
+				selection_start = undo_action->action.insert.selection_start;
+				selection_end = undo_action->action.insert.selection_end;
+
+				pending_edit_add_insert (manager_default,
+				                         &edit,
+				                         index,
+				                         undo_action,
+				                         undo_action->action.insert.pos,
+				                         undo_action->action.insert.chars);
+
+				break;
+
+			default:
+				/* Unknown action type */
+				++manager_default->priv->next_redo;
+				g_return_if_reached ();
+		}
+
+		if (manager_default->priv->next_redo < 0)
+			undo_action = NULL;
+		else
+			undo_action = action_list_nth_data (manager_default->priv->actions,
+			                                    manager_default->priv->next_redo);
+
+	} while ((undo_action != NULL) && (undo_action->order_in_group > 1));
+
+	pending_edit_flush (manager_default, &edit);
+	end_group_edit (manager_default);
+
+	if (selection_start >= 0)
+	{
+		set_cursor (manager_default->priv->buffer,
+		            selection_start,
+		            selection_end);
+	}
+
+	if (modified)
+	{
+		++manager_default->priv->next_redo;
+		gtk_text_buffer_set_modified (manager_default->priv->buffer, FALSE);
+		--manager_default->priv->next_redo;
+	}
+
+	/* FIXME: why is this only internal ?*/
+	end_not_undoable_action_internal (manager_default);
+
+	if (manager_default->priv->next_redo < 0)
+	{
+		manager_default->priv->can_redo = FALSE;
+		gtk_source_undo_manager_can_redo_changed (manager);
+	}
+
+	if (!manager_default->priv->can_undo)
+	{
+		manager_default->priv->can_undo = TRUE;
+		gtk_source_undo_manager_can_undo_changed (manager);
+	}
+}
+
+/* The text arena is not compacted here, see compact_text_arena(). */
+static void
+gtk_source_undo_action_free (GtkSourceUndoManagerDefault *um,
+                             GtkSourceUndoAction         *action)
+{
+	if (action == NULL)
+	{
+		return;
+	}
+
+	if (action->block != NULL)
+	{
+		um->priv->n_compressed_actions--;
+		compressed_block_unref (um, action->block);
+	}
+	else
+	{
+		um->priv->text_arena_used -= action->text_length;
+	}
+
+	g_slice_free (GtkSourceUndoAction, action);
+}
+
+static void
+free_action_list (GtkSourceUndoManagerDefault *um)
+{
+	gint i;
+
+	for (i = (gint)um->priv->actions->len - 1; i >= 0; i--)
+	{
+		GtkSourceUndoAction *action = um->priv->actions->pdata[i];
+
+		if (action->order_in_group == 1)
+			--um->priv->num_of_groups;
+
+		if (action->modified)
+			um->priv->modified_action = NULL;
+
+		gtk_source_undo_action_free (um, action);
+	}
+
+	/* Some arbitrary limit, to avoid wasting space */
+	if (um->priv->actions->len > 2048)
+	{
+		g_ptr_array_free (um->priv->actions, TRUE);
+		um->priv->actions = g_ptr_array_new ();
+	}
+	else
+	{
+		g_ptr_array_set_size (um->priv->actions, 0);
+	}
+
+	g_warn_if_fail (um->priv->text_arena_used == 0);
+	g_warn_if_fail (um->priv->n_compressed_actions == 0);
+	g_warn_if_fail (um->priv->compressed_size == 0);
+
+	if (um->priv->text_arena->allocated_len > TEXT_ARENA_MAX_KEPT_SIZE)
+	{
+		g_string_free (um->priv->text_arena, TRUE);
+		um->priv->text_arena = g_string_new (NULL);
+	}
+	else
+	{
+		g_string_truncate (um->priv->text_arena, 0);
+	}
+
+	um->priv->text_arena_gap_size = 0;
+}
+
+static void
+insert_text_handler (GtkTextBuffer               *buffer,
+                     GtkTextIter                 *pos,
+                     const gchar                 *text,
+                     gint                         length,
+                     GtkSourceUndoManagerDefault *manager)
+{
+	GtkSourceUndoAction undo_action;
+	GtkTextIter selstart;
+	GtkTextIter selend;
+
+	if (manager->priv->running_not_undoable_actions > 0)
+		return;
+
+	gtk_text_buffer_get_selection_bounds (buffer, &selstart, &selend);
+
+	undo_action.action_type = GTK_SOURCE_UNDO_ACTION_INSERT;
+
+	undo_action.action.insert.pos    = gtk_text_iter_get_offset (pos);
+	undo_action.action.insert.chars  = g_utf8_strlen (text, length);
+	undo_action.text_length = length;
+
+	undo_action.action.insert.selection_start = gtk_text_iter_get_offset (&selstart);
+	undo_action.action.insert.selection_end = gtk_text_iter_get_offset (&selend);
+
+	if ((undo_action.action.insert.chars > 1) || (g_utf8_get_char (text) == '\n'))
+
+		undo_action.mergeable = FALSE;
+	else
+		undo_action.mergeable = TRUE;
+
+	undo_action.modified = FALSE;
+
+	add_action (manager, &undo_action, text);
+}
+
+static void
+delete_range_handler (GtkTextBuffer               *buffer,
+                      GtkTextIter                 *start,
+                      GtkTextIter                 *end,
+                      GtkSourceUndoManagerDefault *um)
+{
+	GtkSourceUndoAction undo_action;
+	GtkTextIter insert_iter;
+	GtkTextIter selstart;
+	GtkTextIter selend;
+	gchar *text = NULL;
+
+	if (um->priv->running_not_undoable_actions > 0)
+		return;
+
+	gtk_text_buffer_get_selection_bounds (buffer, &selstart, &selend);
+
+	undo_action.action_type = GTK_SOURCE_UNDO_ACTION_DELETE;
+
+	gtk_text_iter_order (start, end);
+
+	undo_action.action.delete.start  = gtk_text_iter_get_offset (start);
+	undo_action.action.delete.end    = gtk_text_iter_get_offset (end);
+
+	if (undo_action.action.delete.end - undo_action.action.delete.start > DELETED_TEXT_CHUNK_CHARS)
+	{
+		/* A big deletion, e.g. select all and delete: the text is
+		 * copied directly into the text arena. It must be done after
+		 * loading a pending history, which also fills the arena.
+		 */
+		load_pending_history (um);
+		undo_action.text_length = append_range_to_arena (um, start, end);
+	}
+	else
+	{
+		text = get_chars (buffer,
+				  undo_action.action.delete.start,
+				  undo_action.action.delete.end);
+		undo_action.text_length = strlen (text);
+	}
+
+	undo_action.action.delete.selection_start = gtk_text_iter_get_offset (&selstart);
+	undo_action.action.delete.selection_end = gtk_text_iter_get_offset (&selend);
+
+	/* figure out if the user used the Delete or the Backspace key */
+	gtk_text_buffer_get_iter_at_mark (buffer, &insert_iter,
+					  gtk_text_buffer_get_insert (buffer));
+	if (gtk_text_iter_get_offset (&insert_iter) <= undo_action.action.delete.start)
+		undo_action.action.delete.forward = TRUE;
+	else
+		undo_action.action.delete.forward = FALSE;
+
+	if (((undo_action.action.delete.end - undo_action.action.delete.start) > 1) ||
+	     (text == NULL) ||
+	     (g_utf8_get_char (text) == '\n'))
+		undo_action.mergeable = FALSE;
+	else
+		undo_action.mergeable = TRUE;
+
+	undo_action.modified = FALSE;
+
+	add_action (um, &undo_action, text);
+
+	g_free (text);
+}
+
+static void
+begin_user_action_handler (GtkTextBuffer               *buffer,
+                           GtkSourceUndoManagerDefault *um)
+{
+	if (um->priv->running_not_undoable_actions > 0)
+		return;
+
+	um->priv->actions_in_current_group = 0;
+}
+
+/* If @text is NULL, the text of @undo_action has already been appended to the
+ * text arena, see append_range_to_arena(). The action is then not mergeable.
+ */
+static void
+add_action (GtkSourceUndoManagerDefault *um,
+            const GtkSourceUndoAction   *undo_action,
+            const gchar                 *text)
+{
+	GtkSourceUndoAction* action;
+
+	/* The buffer is not modified yet, so the history can be checked. */
+	load_pending_history (um);
+
+	if (um->priv->next_redo >= 0)
+	{
+		free_first_n_actions (um, um->priv->next_redo + 1);
+	}
+
+	um->priv->next_redo = -1;
+
+	if (!merge_action (um, undo_action, text))
+	{
+		action = g_slice_new (GtkSourceUndoAction);
+		*action = *undo_action;
+		action->block = NULL;
+
+		if (text != NULL)
+		{
+			set_action_text (um, action, text, undo_action->text_length);
+		}
+		else
+		{
+			action->text_offset = um->priv->text_arena->len - undo_action->text_length;
+			um->priv->text_arena_used += undo_action->text_length;
+		}
+
+		++um->priv->actions_in_current_group;
+		action->order_in_group = um->priv->actions_in_current_group;
+
+		if (action->order_in_group == 1)
+			++um->priv->num_of_groups;
+
+		action_list_prepend (um->priv->actions, action);
+	}
+
+	check_list_size (um);
+	compact_text_arena (um);
+	compress_cold_actions (um);
+
+	if (!um->priv->can_undo)
+	{
+		um->priv->can_undo = TRUE;
+		gtk_source_undo_manager_can_undo_changed (GTK_SOURCE_UNDO_MANAGER (um));
+	}
+
+	if (um->priv->can_redo)
+	{
+		um->priv->can_redo = FALSE;
+		gtk_source_undo_manager_can_redo_changed (GTK_SOURCE_UNDO_MANAGER (um));
+	}
+}
+
+static void
+free_first_n_actions (GtkSourceUndoManagerDefault *um,
+                      gint                         n)
+{
+	gint i;
+
+	if (um->priv->actions->len == 0)
+		return;
+
+	for (i = 0; i < n; i++)
+	{
+		GtkSourceUndoAction *action = um->priv->actions->pdata[um->priv->actions->len - 1];
+
+		if (action->order_in_group == 1)
+			--um->priv->num_of_groups;
+
+		if (action->modified)
+			um->priv->modified_action = NULL;
+
+		gtk_source_undo_action_free (um, action);
+
+		g_ptr_array_set_size (um->priv->actions, um->priv->actions->len - 1);
+
+		if (um->priv->actions->len == 0)
+			return;
+	}
+}
+
+static gsize
+get_history_size (GtkSourceUndoManagerDefault *um)
+{
+	return um->priv->text_arena_used + um->priv->compressed_size;
+}
+
+/* The most recent group is never removed because of the maximum size: it
+ * can still be in progress.
+ */
+static gboolean
+history_exceeds_limits (GtkSourceUndoManagerDefault *um)
+{
+	if (um->priv->max_undo_levels >= 1 &&
+	    um->priv->num_of_groups > um->priv->max_undo_levels)
+	{
+		return TRUE;
+	}
+
+	if (um->priv->max_undo_size >= 0 &&
+	    um->priv->num_of_groups > 1 &&
+	    get_history_size (um) > (gsize) um->priv->max_undo_size)
+	{
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void
+check_list_size (GtkSourceUndoManagerDefault *um)
+{
+	if (history_exceeds_limits (um))
+	{
+		GtkSourceUndoAction *undo_action;
+
+		undo_action = action_list_last_data (um->priv->actions);
+
+		do
+		{
+			if (undo_action->order_in_group == 1)
+				--um->priv->num_of_groups;
+
+			if (undo_action->modified)
+				um->priv->modified_action = NULL;
+
+			gtk_source_undo_action_free (um, undo_action);
+
+			action_list_delete_last (um->priv->actions);
+
+			undo_action = action_list_last_data (um->priv->actions);
+			g_return_if_fail (undo_action != NULL);
+
+		} while ((undo_action->order_in_group > 1) ||
+			 history_exceeds_limits (um));
+	}
+}
+/**
+ * gtk_source_undo_manager_default_merge_action:
+ * @um: a #GtkSourceUndoManagerDefault.
+ * @undo_action: a #GtkSourceUndoAction.
+ *
+ * This function tries to merge the undo action at the top of
+ * the stack with a new undo action. So when we undo for example
+ * typing, we can undo the whole word and not each letter by itself.
+ *
+ * Return Value: %TRUE is merge was sucessful, %FALSE otherwise.
+ **/
+static gboolean
+merge_action (GtkSourceUndoManagerDefault *um,
+              const GtkSourceUndoAction   *undo_action,
+              const gchar                 *text)
+{
+	GtkSourceUndoAction *last_action;
+	const gchar *last_text;
+	gunichar new_char;
+
+	g_return_val_if_fail (GTK_SOURCE_IS_UNDO_MANAGER_DEFAULT (um), FALSE);
+	g_return_val_if_fail (um->priv != NULL, FALSE);
+
+	if (um->priv->actions->len == 0)
+		return FALSE;
+
+	last_action = action_list_nth_data (um->priv->actions, 0);
+
+	if (!last_action->mergeable)
+		return FALSE;
+
+	if ((!undo_action->mergeable) ||
+	    (undo_action->action_type != last_action->action_type))
+	{
+		last_action->mergeable = FALSE;
+		return FALSE;
+	}
+
+	/* Only valid until the text arena is modified. */
+	last_text = get_action_text (um, last_action);
+	new_char = g_utf8_get_char (text);
+
+	if (undo_action->action_type == GTK_SOURCE_UNDO_ACTION_DELETE)
+	{
+		if ((last_action->action.delete.forward != undo_action->action.delete.forward) ||
+		    ((last_action->action.delete.start != undo_action->action.delete.start) &&
+		     (last_action->action.delete.start != undo_action->action.delete.end)))
+		{
+			last_action->mergeable = FALSE;
+			return FALSE;
+		}
+
+		if (last_action->action.delete.start == undo_action->action.delete.start)
+		{
+			gunichar last_char = get_last_char (last_text, last_action->text_length);
+
+			/* Deleted with the delete key */
+			if ((new_char != ' ') &&
+			    (new_char != '\t') &&
+			    ((last_char == ' ') ||
+			     (last_char == '\t')))
+			{
+				last_action->mergeable = FALSE;
+				return FALSE;
+			}
+
+			append_action_text (um, last_action, text, undo_action->text_length);
+			last_action->action.delete.end += (undo_action->action.delete.end -
+							   undo_action->action.delete.start);
+		}
 		else
-			undo_action = action_list_nth_data (manager_default->priv->actions,
-			                                    manager_default->priv->next_redo);
+		{
+			gunichar first_char = g_utf8_get_char (last_text);
 
-	} while ((undo_action != NULL) && (undo_action->order_in_group > 1));
+			/* Deleted with the backspace key */
+			if ((new_char != ' ') &&
+			    (new_char != '\t') &&
+			    ((first_char == ' ') ||
+			     (first_char == '\t')))
+			{
+				last_action->mergeable = FALSE;
+				return FALSE;
+			}
 
-	if (selection_start >= 0)
-	{
-		set_cursor (manager_default->priv->buffer,
-		            selection_start,
-		            selection_end);
+			prepend_action_text (um, last_action, text, undo_action->text_length);
+			last_action->action.delete.start = undo_action->action.delete.start;
+		}
 	}
-
-	if (modified)
+	else if (undo_action->action_type == GTK_SOURCE_UNDO_ACTION_INSERT)
 	{
-		++manager_default->priv->next_redo;
-		gtk_text_buffer_set_modified (manager_default->priv->buffer, FALSE);
-		--manager_default->priv->next_redo;
-	}
+		gunichar last_char = get_last_char (last_text, last_action->text_length);
 
-	/* FIXME: why is this only internal ?*/
-	end_not_undoable_action_internal (manager_default);
+		if ((undo_action->action.insert.pos !=
+		     	(last_action->action.insert.pos + last_action->action.insert.chars)) ||
+		    ((new_char != ' ') &&
+		     (new_char != '\t') &&
+		     ((last_char == ' ') ||
+		      (last_char == '\t')))
+		   )
+		{
+			last_action->mergeable = FALSE;
+			return FALSE;
+		}
 
-	if (manager_default->priv->next_redo < 0)
-	{
-		manager_default->priv->can_redo = FALSE;
-		gtk_source_undo_manager_can_redo_changed (manager);
+		/* When typing, the text of the last action is at the end of
+		 * the arena, so this is an append in place.
+		 */
+		append_action_text (um, last_action, text, undo_action->text_length);
+		last_action->action.insert.chars += undo_action->action.insert.chars;
 	}
+	else
+		/* Unknown action inside undo merge encountered */
+		g_return_val_if_reached (TRUE);
 
-	if (!manager_default->priv->can_undo)
-	{
-		manager_default->priv->can_undo = TRUE;
-		gtk_source_undo_manager_can_undo_changed (manager);
-	}
+	return TRUE;
 }
 
 static void
-gtk_source_undo_action_free (GtkSourceUndoAction *action)
+modified_changed_handler (GtkTextBuffer               *buffer,
+                          GtkSourceUndoManagerDefault *manager)
 {
-	if (action == NULL)
+	GtkSourceUndoAction *action;
+	gint idx;
+
+	if (manager->priv->actions->len == 0)
+		return;
+
+	idx = manager->priv->next_redo + 1;
+	action = action_list_nth_data (manager->priv->actions, idx);
+
+	if (gtk_text_buffer_get_modified (buffer) == FALSE)
 	{
+		if (action != NULL)
+			action->mergeable = FALSE;
+
+		if (manager->priv->modified_action != NULL)
+		{
+			manager->priv->modified_action->modified = FALSE;
+			manager->priv->modified_action = NULL;
+		}
+
 		return;
 	}
 
-	if (action->action_type == GTK_SOURCE_UNDO_ACTION_INSERT)
+	if (action == NULL)
 	{
-		g_free (action->action.insert.text);
+		g_return_if_fail (manager->priv->running_not_undoable_actions > 0);
+
+		return;
 	}
-	else if (action->action_type == GTK_SOURCE_UNDO_ACTION_DELETE)
+
+	if (manager->priv->modified_action != NULL)
 	{
-		g_free (action->action.delete.text);
+		g_message ("%s: oops", G_STRLOC);
+		return;
 	}
-	else
+
+	if (action->order_in_group > 1)
+		manager->priv->modified_undoing_group  = TRUE;
+
+	while (action->order_in_group > 1)
 	{
-		g_free (action);
-		g_return_if_reached ();
+		action = action_list_nth_data (manager->priv->actions, ++idx);
+		g_return_if_fail (action != NULL);
 	}
 
-	g_free (action);
+	action->modified = TRUE;
+	manager->priv->modified_action = action;
 }
 
+/* Persistent history */
+
+typedef struct
+{
+	const guint8 *data;
+	gsize size;
+	gsize pos;
+	gboolean error;
+} HistoryReader;
+
 static void
-free_action_list (GtkSourceUndoManagerDefault *um)
+history_write_uint32 (GByteArray *array,
+                      guint32     value)
 {
-	gint i;
+	value = GUINT32_TO_LE (value);
+	g_byte_array_append (array, (const guint8 *) &value, 4);
+}
 
-	for (i = (gint)um->priv->actions->len - 1; i >= 0; i--)
+static void
+history_write_uint8 (GByteArray *array,
+                     guint8      value)
+{
+	g_byte_array_append (array, &value, 1);
+}
+
+static const guint8 *
+history_read (HistoryReader *reader,
+              gsize          size)
+{
+	const guint8 *ret;
+
+	if (reader->error || size > reader->size - reader->pos)
 	{
-		GtkSourceUndoAction *action = um->priv->actions->pdata[i];
+		reader->error = TRUE;
+		return NULL;
+	}
 
-		if (action->order_in_group == 1)
-			--um->priv->num_of_groups;
+	ret = reader->data + reader->pos;
+	reader->pos += size;
+	return ret;
+}
 
-		if (action->modified)
-			um->priv->modified_action = NULL;
+static guint32
+history_read_uint32 (HistoryReader *reader)
+{
+	const guint8 *data = history_read (reader, 4);
+	guint32 value;
 
-		gtk_source_undo_action_free (action);
-	}
+	if (data == NULL)
+		return 0;
 
-	/* Some arbitrary limit, to avoid wasting space */
-	if (um->priv->actions->len > 2048)
-	{
-		g_ptr_array_free (um->priv->actions, TRUE);
-		um->priv->actions = g_ptr_array_new ();
-	}
-	else
+	memcpy (&value, data, 4);
+	return GUINT32_FROM_LE (value);
+}
+
+static guint8
+history_read_uint8 (HistoryReader *reader)
+{
+	const guint8 *data = history_read (reader, 1);
+
+	return data != NULL ? *data : 0;
+}
+
+static gchar *
+compute_buffer_checksum (GtkTextBuffer *buffer)
+{
+	GChecksum *checksum;
+	GtkTextIter start;
+	GtkTextIter end;
+	gchar *ret;
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA256);
+	gtk_text_buffer_get_start_iter (buffer, &start);
+
+	while (!gtk_text_iter_is_end (&start))
 	{
-		g_ptr_array_set_size (um->priv->actions, 0);
+		gchar *text;
+
+		end = start;
+		gtk_text_iter_forward_lines (&end, CHECKSUM_CHUNK_LINES);
+
+		text = gtk_text_buffer_get_slice (buffer, &start, &end, TRUE);
+		g_checksum_update (checksum, (const guchar *) text, -1);
+		g_free (text);
+
+		start = end;
 	}
+
+	ret = g_strdup (g_checksum_get_string (checksum));
+	g_checksum_free (checksum);
+	return ret;
 }
 
-static void
-insert_text_handler (GtkTextBuffer               *buffer,
-                     GtkTextIter                 *pos,
-                     const gchar                 *text,
-                     gint                         length,
-                     GtkSourceUndoManagerDefault *manager)
+/* The compressed blocks are decompressed one at a time in a temporary buffer,
+ * so saving the history doesn't modify it.
+ */
+static GBytes *
+serialize_actions (GtkSourceUndoManagerDefault *um)
 {
-	GtkSourceUndoAction undo_action;
-	GtkTextIter selstart;
-	GtkTextIter selend;
+	GByteArray *payload;
+	CompressedBlock *block = NULL;
+	GBytes *block_text = NULL;
+	guint i;
 
-	if (manager->priv->running_not_undoable_actions > 0)
-		return;
+	payload = g_byte_array_new ();
 
-	gtk_text_buffer_get_selection_bounds (buffer, &selstart, &selend);
+	history_write_uint32 (payload, um->priv->actions->len);
+	history_write_uint32 (payload, (guint32) um->priv->next_redo);
 
-	undo_action.action_type = GTK_SOURCE_UNDO_ACTION_INSERT;
+	for (i = 0; i < um->priv->actions->len; i++)
+	{
+		GtkSourceUndoAction *action = um->priv->actions->pdata[i];
+		const gchar *text;
 
-	undo_action.action.insert.pos    = gtk_text_iter_get_offset (pos);
-	undo_action.action.insert.text   = (gchar*) text;
-	undo_action.action.insert.length = length;
-	undo_action.action.insert.chars  = g_utf8_strlen (text, length);
+		history_write_uint8 (payload, action->action_type);
+		history_write_uint8 (payload, (action->mergeable ? 1 : 0) |
+		                              (action->modified ? 2 : 0));
+		history_write_uint32 (payload, action->order_in_group);
 
-	undo_action.action.insert.selection_start = gtk_text_iter_get_offset (&selstart);
-	undo_action.action.insert.selection_end = gtk_text_iter_get_offset (&selend);
+		if (action->action_type == GTK_SOURCE_UNDO_ACTION_INSERT)
+		{
+			history_write_uint32 (payload, action->action.insert.pos);
+			history_write_uint32 (payload, action->action.insert.chars);
+			history_write_uint32 (payload, action->action.insert.selection_start);
+			history_write_uint32 (payload, action->action.insert.selection_end);
+		}
+		else
+		{
+			history_write_uint32 (payload, action->action.delete.start);
+			history_write_uint32 (payload, action->action.delete.end);
+			history_write_uint32 (payload, action->action.delete.forward);
+			history_write_uint32 (payload, action->action.delete.selection_start);
+			history_write_uint32 (payload, action->action.delete.selection_end);
+		}
 
-	if ((undo_action.action.insert.chars > 1) || (g_utf8_get_char (text) == '\n'))
+		if (action->block == NULL)
+		{
+			text = um->priv->text_arena->str + action->text_offset;
+		}
+		else
+		{
+			if (action->block != block)
+			{
+				if (block_text != NULL)
+					g_bytes_unref (block_text);
 
-		undo_action.mergeable = FALSE;
-	else
-		undo_action.mergeable = TRUE;
+				block = action->block;
+				block_text = decompress_block (block);
 
-	undo_action.modified = FALSE;
+				if (block_text == NULL)
+				{
+					g_byte_array_free (payload, TRUE);
+					return NULL;
+				}
+			}
+
+			text = (const gchar *) g_bytes_get_data (block_text, NULL) + action->text_offset;
+		}
+
+		history_write_uint32 (payload, action->text_length);
+		g_byte_array_append (payload, (const guint8 *) text, action->text_length);
+	}
+
+	if (block_text != NULL)
+		g_bytes_unref (block_text);
 
-	add_action (manager, &undo_action);
+	return g_byte_array_free_to_bytes (payload);
 }
 
-static void
-delete_range_handler (GtkTextBuffer               *buffer,
-                      GtkTextIter                 *start,
-                      GtkTextIter                 *end,
-                      GtkSourceUndoManagerDefault *um)
+/* Checks the offsets of @action, and that @text is valid UTF-8 with the
+ * number of characters of the action.
+ */
+static gboolean
+check_action (const GtkSourceUndoAction *action,
+              const gchar               *text,
+              gsize                      text_length)
 {
-	GtkSourceUndoAction undo_action;
-	GtkTextIter insert_iter;
-	GtkTextIter selstart;
-	GtkTextIter selend;
+	gint n_chars;
 
-	if (um->priv->running_not_undoable_actions > 0)
-		return;
+	if (action->action_type == GTK_SOURCE_UNDO_ACTION_INSERT)
+	{
+		if (action->action.insert.pos < 0 || action->action.insert.chars < 0)
+			return FALSE;
 
-	gtk_text_buffer_get_selection_bounds (buffer, &selstart, &selend);
+		n_chars = action->action.insert.chars;
+	}
+	else
+	{
+		if (action->action.delete.start < 0 ||
+		    action->action.delete.end < action->action.delete.start)
+			return FALSE;
 
-	undo_action.action_type = GTK_SOURCE_UNDO_ACTION_DELETE;
+		n_chars = action->action.delete.end - action->action.delete.start;
+	}
 
-	gtk_text_iter_order (start, end);
+	if (text_length > G_MAXINT ||
+	    !g_utf8_validate (text, text_length, NULL))
+		return FALSE;
 
-	undo_action.action.delete.start  = gtk_text_iter_get_offset (start);
-	undo_action.action.delete.end    = gtk_text_iter_get_offset (end);
+	return g_utf8_strlen (text, text_length) == n_chars;
+}
 
-	undo_action.action.delete.text   = get_chars (
-						buffer,
-						undo_action.action.delete.start,
-						undo_action.action.delete.end);
+/* Checks that the actions can be undone and redone from the current buffer
+ * contents: the offsets of each action must be inside the text at that point
+ * of the history.
+ */
+static gboolean
+check_actions_offsets (GtkSourceUndoManagerDefault *um,
+                       gint                         next_redo)
+{
+	gint n_actions = um->priv->actions->len;
+	gint64 length;
+	gint i;
 
-	undo_action.action.delete.selection_start = gtk_text_iter_get_offset (&selstart);
-	undo_action.action.delete.selection_end = gtk_text_iter_get_offset (&selend);
+	/* Undo the applied actions, from the most recent. */
+	length = gtk_text_buffer_get_char_count (um->priv->buffer);
 
-	/* figure out if the user used the Delete or the Backspace key */
-	gtk_text_buffer_get_iter_at_mark (buffer, &insert_iter,
-					  gtk_text_buffer_get_insert (buffer));
-	if (gtk_text_iter_get_offset (&insert_iter) <= undo_action.action.delete.start)
-		undo_action.action.delete.forward = TRUE;
-	else
-		undo_action.action.delete.forward = FALSE;
+	for (i = next_redo + 1; i < n_actions; i++)
+	{
+		GtkSourceUndoAction *action = action_list_nth_data (um->priv->actions, i);
 
-	if (((undo_action.action.delete.end - undo_action.action.delete.start) > 1) ||
-	     (g_utf8_get_char (undo_action.action.delete.text  ) == '\n'))
-		undo_action.mergeable = FALSE;
-	else
-		undo_action.mergeable = TRUE;
+		if (action->action_type == GTK_SOURCE_UNDO_ACTION_INSERT)
+		{
+			if ((gint64) action->action.insert.pos + action->action.insert.chars > length)
+				return FALSE;
 
-	undo_action.modified = FALSE;
+			length -= action->action.insert.chars;
+		}
+		else
+		{
+			if (action->action.delete.start > length)
+				return FALSE;
+
+			length += action->action.delete.end - action->action.delete.start;
+		}
+	}
+
+	/* Redo the undone actions, from the oldest. */
+	length = gtk_text_buffer_get_char_count (um->priv->buffer);
+
+	for (i = next_redo; i >= 0; i--)
+	{
+		GtkSourceUndoAction *action = action_list_nth_data (um->priv->actions, i);
+
+		if (action->action_type == GTK_SOURCE_UNDO_ACTION_INSERT)
+		{
+			if (action->action.insert.pos > length)
+				return FALSE;
 
-	add_action (um, &undo_action);
+			length += action->action.insert.chars;
+		}
+		else
+		{
+			if (action->action.delete.end > length)
+				return FALSE;
 
-	g_free (undo_action.action.delete.text);
+			length -= action->action.delete.end - action->action.delete.start;
+		}
+	}
 
+	return TRUE;
 }
 
-static void
-begin_user_action_handler (GtkTextBuffer               *buffer,
-                           GtkSourceUndoManagerDefault *um)
+/* Replaces the actions by the ones of @payload. Returns FALSE if the payload
+ * is invalid.
+ */
+static gboolean
+deserialize_actions (GtkSourceUndoManagerDefault *um,
+                     GBytes                      *payload)
 {
-	if (um->priv->running_not_undoable_actions > 0)
-		return;
+	HistoryReader reader = { 0 };
+	guint32 n_actions;
+	gint32 next_redo;
+	guint i;
 
-	um->priv->actions_in_current_group = 0;
-}
+	reader.data = g_bytes_get_data (payload, &reader.size);
 
-static void
-add_action (GtkSourceUndoManagerDefault *um,
-            const GtkSourceUndoAction   *undo_action)
-{
-	GtkSourceUndoAction* action;
+	free_action_list (um);
 
-	if (um->priv->next_redo >= 0)
-	{
-		free_first_n_actions (um, um->priv->next_redo + 1);
-	}
+	n_actions = history_read_uint32 (&reader);
+	next_redo = (gint32) history_read_uint32 (&reader);
 
-	um->priv->next_redo = -1;
+	if (next_redo < -1 || next_redo >= (gint64) n_actions)
+		return FALSE;
 
-	if (!merge_action (um, undo_action))
+	for (i = 0; i < n_actions && !reader.error; i++)
 	{
-		action = g_new (GtkSourceUndoAction, 1);
-		*action = *undo_action;
+		GtkSourceUndoAction *action;
+		guint8 flags;
+		guint32 text_length;
+		const guint8 *text;
+
+		action = g_slice_new0 (GtkSourceUndoAction);
+		action->action_type = history_read_uint8 (&reader);
+		flags = history_read_uint8 (&reader);
+		action->mergeable = (flags & 1) != 0;
+		action->modified = (flags & 2) != 0;
+		action->order_in_group = history_read_uint32 (&reader);
 
 		if (action->action_type == GTK_SOURCE_UNDO_ACTION_INSERT)
-			action->action.insert.text = g_strndup (undo_action->action.insert.text, undo_action->action.insert.length);
+		{
+			action->action.insert.pos = history_read_uint32 (&reader);
+			action->action.insert.chars = history_read_uint32 (&reader);
+			action->action.insert.selection_start = history_read_uint32 (&reader);
+			action->action.insert.selection_end = history_read_uint32 (&reader);
+		}
 		else if (action->action_type == GTK_SOURCE_UNDO_ACTION_DELETE)
-			action->action.delete.text = g_strdup (undo_action->action.delete.text);
+		{
+			action->action.delete.start = history_read_uint32 (&reader);
+			action->action.delete.end = history_read_uint32 (&reader);
+			action->action.delete.forward = history_read_uint32 (&reader) != 0;
+			action->action.delete.selection_start = history_read_uint32 (&reader);
+			action->action.delete.selection_end = history_read_uint32 (&reader);
+		}
 		else
 		{
-			g_free (action);
-			g_return_if_reached ();
+			reader.error = TRUE;
 		}
 
-		++um->priv->actions_in_current_group;
-		action->order_in_group = um->priv->actions_in_current_group;
+		text_length = history_read_uint32 (&reader);
+		text = history_read (&reader, text_length);
+
+		if (reader.error ||
+		    action->order_in_group < 1 ||
+		    (i == 0 && action->order_in_group != 1) ||
+		    !check_action (action, (const gchar *) text, text_length))
+		{
+			g_slice_free (GtkSourceUndoAction, action);
+			reader.error = TRUE;
+			break;
+		}
+
+		set_action_text (um, action, (const gchar *) text, text_length);
 
 		if (action->order_in_group == 1)
 			++um->priv->num_of_groups;
 
-		action_list_prepend (um->priv->actions, action);
+		if (action->modified)
+			um->priv->modified_action = action;
+
+		g_ptr_array_add (um->priv->actions, action);
 	}
 
-	check_list_size (um);
+	if (reader.error || !check_actions_offsets (um, next_redo))
+	{
+		free_action_list (um);
+		return FALSE;
+	}
 
-	if (!um->priv->can_undo)
+	um->priv->next_redo = next_redo;
+
+	/* The marker is set again when the buffer is modified. */
+	if (um->priv->modified_action != NULL &&
+	    !gtk_text_buffer_get_modified (um->priv->buffer))
 	{
-		um->priv->can_undo = TRUE;
-		gtk_source_undo_manager_can_undo_changed (GTK_SOURCE_UNDO_MANAGER (um));
+		um->priv->modified_action->modified = FALSE;
+		um->priv->modified_action = NULL;
 	}
 
-	if (um->priv->can_redo)
+	/* Don't merge the actions of two sessions. */
+	if (um->priv->actions->len > 0)
 	{
-		um->priv->can_redo = FALSE;
-		gtk_source_undo_manager_can_redo_changed (GTK_SOURCE_UNDO_MANAGER (um));
+		GtkSourceUndoAction *last = action_list_nth_data (um->priv->actions, 0);
+		last->mergeable = FALSE;
 	}
+
+	return TRUE;
 }
 
 static void
-free_first_n_actions (GtkSourceUndoManagerDefault *um,
-                      gint                         n)
+update_can_undo_redo (GtkSourceUndoManagerDefault *um)
 {
-	gint i;
-
-	if (um->priv->actions->len == 0)
-		return;
+	gboolean can_undo = um->priv->next_redo < (gint)um->priv->actions->len - 1;
+	gboolean can_redo = um->priv->next_redo >= 0;
 
-	for (i = 0; i < n; i++)
+	if (um->priv->can_undo != can_undo)
 	{
-		GtkSourceUndoAction *action = um->priv->actions->pdata[um->priv->actions->len - 1];
-
-		if (action->order_in_group == 1)
-			--um->priv->num_of_groups;
-
-		if (action->modified)
-			um->priv->modified_action = NULL;
-
-		gtk_source_undo_action_free (action);
-
-		g_ptr_array_set_size (um->priv->actions, um->priv->actions->len - 1);
+		um->priv->can_undo = can_undo;
+		gtk_source_undo_manager_can_undo_changed (GTK_SOURCE_UNDO_MANAGER (um));
+	}
 
-		if (um->priv->actions->len == 0)
-			return;
+	if (um->priv->can_redo != can_redo)
+	{
+		um->priv->can_redo = can_redo;
+		gtk_source_undo_manager_can_redo_changed (GTK_SOURCE_UNDO_MANAGER (um));
 	}
 }
 
-static void
-check_list_size (GtkSourceUndoManagerDefault *um)
+static GBytes *
+read_history_payload (GFile         *file,
+                      const gchar   *checksum,
+                      GError       **error)
 {
-	gint undo_levels;
+	gchar *contents;
+	gsize length;
+	guint32 payload_size;
+	GConverter *decompressor;
+	GBytes *payload;
 
-	undo_levels = um->priv->max_undo_levels;
-
-	if (undo_levels < 1)
-		return;
+	if (!g_file_load_contents (file, NULL, &contents, &length, NULL, error))
+		return NULL;
 
-	if (um->priv->num_of_groups > undo_levels)
+	/* The file can have been modified since its header was read. */
+	if (length < HISTORY_HEADER_LENGTH ||
+	    memcmp (contents, HISTORY_FILE_MAGIC, HISTORY_FILE_MAGIC_LENGTH) != 0 ||
+	    memcmp (contents + HISTORY_FILE_MAGIC_LENGTH, checksum, HISTORY_CHECKSUM_LENGTH) != 0)
 	{
-		GtkSourceUndoAction *undo_action;
-
-		undo_action = action_list_last_data (um->priv->actions);
-
-		do
-		{
-			if (undo_action->order_in_group == 1)
-				--um->priv->num_of_groups;
-
-			if (undo_action->modified)
-				um->priv->modified_action = NULL;
+		g_free (contents);
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+		                     _("The undo history file has changed."));
+		return NULL;
+	}
 
-			gtk_source_undo_action_free (undo_action);
+	memcpy (&payload_size, contents + HISTORY_HEADER_LENGTH - 4, 4);
+	payload_size = GUINT32_FROM_LE (payload_size);
 
-			action_list_delete_last (um->priv->actions);
+	decompressor = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_ZLIB));
+	payload = convert_data (decompressor,
+	                        contents + HISTORY_HEADER_LENGTH,
+	                        length - HISTORY_HEADER_LENGTH,
+	                        payload_size);
+	g_object_unref (decompressor);
+	g_free (contents);
 
-			undo_action = action_list_last_data (um->priv->actions);
-			g_return_if_fail (undo_action != NULL);
+	if (payload == NULL || g_bytes_get_size (payload) != payload_size)
+	{
+		if (payload != NULL)
+			g_bytes_unref (payload);
 
-		} while ((undo_action->order_in_group > 1) ||
-			 (um->priv->num_of_groups > undo_levels));
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+		                     _("The undo history file is corrupted."));
+		return NULL;
 	}
+
+	return payload;
 }
 
-/**
- * gtk_source_undo_manager_default_merge_action:
- * @um: a #GtkSourceUndoManagerDefault.
- * @undo_action: a #GtkSourceUndoAction.
- *
- * This function tries to merge the undo action at the top of
- * the stack with a new undo action. So when we undo for example
- * typing, we can undo the whole word and not each letter by itself.
- *
- * Return Value: %TRUE is merge was sucessful, %FALSE otherwise.
- **/
+/* Reads the actions of the pending history file, if any. The history is kept
+ * only if it matches the current buffer contents. Returns FALSE if the pending
+ * history has been discarded.
+ */
 static gboolean
-merge_action (GtkSourceUndoManagerDefault *um,
-              const GtkSourceUndoAction   *undo_action)
+load_pending_history (GtkSourceUndoManagerDefault *um)
 {
-	GtkSourceUndoAction *last_action;
-
-	g_return_val_if_fail (GTK_SOURCE_IS_UNDO_MANAGER_DEFAULT (um), FALSE);
-	g_return_val_if_fail (um->priv != NULL, FALSE);
+	GFile *file;
+	gchar *expected_checksum;
+	gchar *checksum;
+	GBytes *payload = NULL;
+	GError *error = NULL;
+	gboolean ok = FALSE;
 
-	if (um->priv->actions->len == 0)
-		return FALSE;
-
-	last_action = action_list_nth_data (um->priv->actions, 0);
+	if (um->priv->pending_history_file == NULL)
+		return TRUE;
 
-	if (!last_action->mergeable)
-		return FALSE;
+	file = um->priv->pending_history_file;
+	expected_checksum = um->priv->pending_history_checksum;
+	um->priv->pending_history_file = NULL;
+	um->priv->pending_history_checksum = NULL;
 
-	if ((!undo_action->mergeable) ||
-	    (undo_action->action_type != last_action->action_type))
-	{
-		last_action->mergeable = FALSE;
-		return FALSE;
-	}
+	checksum = compute_buffer_checksum (um->priv->buffer);
 
-	if (undo_action->action_type == GTK_SOURCE_UNDO_ACTION_DELETE)
+	if (g_str_equal (checksum, expected_checksum))
 	{
-		if ((last_action->action.delete.forward != undo_action->action.delete.forward) ||
-		    ((last_action->action.delete.start != undo_action->action.delete.start) &&
-		     (last_action->action.delete.start != undo_action->action.delete.end)))
-		{
-			last_action->mergeable = FALSE;
-			return FALSE;
-		}
+		payload = read_history_payload (file, expected_checksum, &error);
 
-		if (last_action->action.delete.start == undo_action->action.delete.start)
+		if (payload != NULL)
 		{
-			gchar *str;
-
-#define L  (last_action->action.delete.end - last_action->action.delete.start - 1)
-#define g_utf8_get_char_at(p,i) g_utf8_get_char(g_utf8_offset_to_pointer((p),(i)))
+			ok = deserialize_actions (um, payload);
 
-			/* Deleted with the delete key */
-			if ((g_utf8_get_char (undo_action->action.delete.text) != ' ') &&
-			    (g_utf8_get_char (undo_action->action.delete.text) != '\t') &&
-                            ((g_utf8_get_char_at (last_action->action.delete.text, L) == ' ') ||
-			     (g_utf8_get_char_at (last_action->action.delete.text, L)  == '\t')))
+			if (!ok)
 			{
-				last_action->mergeable = FALSE;
-				return FALSE;
+				g_warning ("Invalid undo history file.");
 			}
 
-			str = g_strdup_printf ("%s%s", last_action->action.delete.text,
-				undo_action->action.delete.text);
-
-			g_free (last_action->action.delete.text);
-			last_action->action.delete.end += (undo_action->action.delete.end -
-							   undo_action->action.delete.start);
-			last_action->action.delete.text = str;
+			g_bytes_unref (payload);
 		}
 		else
 		{
-			gchar *str;
-
-			/* Deleted with the backspace key */
-			if ((g_utf8_get_char (undo_action->action.delete.text) != ' ') &&
-			    (g_utf8_get_char (undo_action->action.delete.text) != '\t') &&
-                            ((g_utf8_get_char (last_action->action.delete.text) == ' ') ||
-			     (g_utf8_get_char (last_action->action.delete.text) == '\t')))
-			{
-				last_action->mergeable = FALSE;
-				return FALSE;
-			}
-
-			str = g_strdup_printf ("%s%s", undo_action->action.delete.text,
-				last_action->action.delete.text);
-
-			g_free (last_action->action.delete.text);
-			last_action->action.delete.start = undo_action->action.delete.start;
-			last_action->action.delete.text = str;
+			g_warning ("Error when loading the undo history: %s", error->message);
+			g_error_free (error);
 		}
 	}
-	else if (undo_action->action_type == GTK_SOURCE_UNDO_ACTION_INSERT)
-	{
-		gchar* str;
 
-#define I (last_action->action.insert.chars - 1)
+	if (ok)
+	{
+		apply_limits (um);
+		compress_cold_actions (um);
+	}
+	else
+	{
+		free_action_list (um);
+		um->priv->next_redo = -1;
+	}
 
-		if ((undo_action->action.insert.pos !=
-		     	(last_action->action.insert.pos + last_action->action.insert.chars)) ||
-		    ((g_utf8_get_char (undo_action->action.insert.text) != ' ') &&
-		      (g_utf8_get_char (undo_action->action.insert.text) != '\t') &&
-		     ((g_utf8_get_char_at (last_action->action.insert.text, I) == ' ') ||
-		      (g_utf8_get_char_at (last_action->action.insert.text, I) == '\t')))
-		   )
-		{
-			last_action->mergeable = FALSE;
-			return FALSE;
-		}
+	update_can_undo_redo (um);
 
-		str = g_strdup_printf ("%s%s", last_action->action.insert.text,
-				undo_action->action.insert.text);
+	g_object_unref (file);
+	g_free (expected_checksum);
+	g_free (checksum);
+	return ok;
+}
 
-		g_free (last_action->action.insert.text);
-		last_action->action.insert.length += undo_action->action.insert.length;
-		last_action->action.insert.text = str;
-		last_action->action.insert.chars += undo_action->action.insert.chars;
+static void
+gtk_source_undo_manager_iface_init (GtkSourceUndoManagerIface *iface)
+{
+	iface->can_undo = gtk_source_undo_manager_can_undo_impl;
+	iface->can_redo = gtk_source_undo_manager_can_redo_impl;
 
-	}
-	else
-		/* Unknown action inside undo merge encountered */
-		g_return_val_if_reached (TRUE);
+	iface->undo = gtk_source_undo_manager_undo_impl;
+	iface->redo = gtk_source_undo_manager_redo_impl;
 
-	return TRUE;
+	iface->begin_not_undoable_action = gtk_source_undo_manager_begin_not_undoable_action_impl;
+	iface->end_not_undoable_action = gtk_source_undo_manager_end_not_undoable_action_impl;
 }
 
-static void
-modified_changed_handler (GtkTextBuffer               *buffer,
-                          GtkSourceUndoManagerDefault *manager)
+void
+gtk_source_undo_manager_default_set_max_undo_levels (GtkSourceUndoManagerDefault *manager,
+                                                     gint                         max_undo_levels)
 {
-	GtkSourceUndoAction *action;
-	gint idx;
+	g_return_if_fail (GTK_SOURCE_IS_UNDO_MANAGER_DEFAULT (manager));
 
-	if (manager->priv->actions->len == 0)
-		return;
+	set_max_undo_levels (manager, max_undo_levels);
+	g_object_notify (G_OBJECT (manager), "max-undo-levels");
+}
 
-	idx = manager->priv->next_redo + 1;
-	action = action_list_nth_data (manager->priv->actions, idx);
+void
+gtk_source_undo_manager_default_set_max_undo_size (GtkSourceUndoManagerDefault *manager,
+                                                   gint                         max_undo_size)
+{
+	g_return_if_fail (GTK_SOURCE_IS_UNDO_MANAGER_DEFAULT (manager));
 
-	if (gtk_text_buffer_get_modified (buffer) == FALSE)
-	{
-		if (action != NULL)
-			action->mergeable = FALSE;
+	set_max_undo_size (manager, max_undo_size);
+	g_object_notify (G_OBJECT (manager), "max-undo-size");
+}
 
-		if (manager->priv->modified_action != NULL)
-		{
-			manager->priv->modified_action->modified = FALSE;
-			manager->priv->modified_action = NULL;
-		}
+/* Saves the history in @file, with the checksum of the buffer contents. */
+gboolean
+gtk_source_undo_manager_default_save_history (GtkSourceUndoManagerDefault  *manager,
+                                              GFile                        *file,
+                                              GCancellable                 *cancellable,
+                                              GError                      **error)
+{
+	GByteArray *contents;
+	GBytes *payload;
+	GBytes *compressed_payload;
+	GConverter *compressor;
+	gchar *checksum;
+	gboolean ret;
 
-		return;
-	}
+	g_return_val_if_fail (GTK_SOURCE_IS_UNDO_MANAGER_DEFAULT (manager), FALSE);
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
+	g_return_val_if_fail (manager->priv->buffer != NULL, FALSE);
 
-	if (action == NULL)
-	{
-		g_return_if_fail (manager->priv->running_not_undoable_actions > 0);
+	load_pending_history (manager);
 
-		return;
-	}
+	payload = serialize_actions (manager);
 
-	if (manager->priv->modified_action != NULL)
+	if (payload == NULL)
 	{
-		g_message ("%s: oops", G_STRLOC);
-		return;
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		                     _("Failed to decompress the undo history."));
+		return FALSE;
 	}
 
-	if (action->order_in_group > 1)
-		manager->priv->modified_undoing_group  = TRUE;
+	compressor = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_ZLIB, -1));
+	compressed_payload = convert_data (compressor,
+	                                   g_bytes_get_data (payload, NULL),
+	                                   g_bytes_get_size (payload),
+	                                   g_bytes_get_size (payload) / 4);
+	g_object_unref (compressor);
 
-	while (action->order_in_group > 1)
+	if (compressed_payload == NULL)
 	{
-		action = action_list_nth_data (manager->priv->actions, ++idx);
-		g_return_if_fail (action != NULL);
+		g_bytes_unref (payload);
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		                     _("Failed to compress the undo history."));
+		return FALSE;
 	}
 
-	action->modified = TRUE;
-	manager->priv->modified_action = action;
+	checksum = compute_buffer_checksum (manager->priv->buffer);
+
+	contents = g_byte_array_sized_new (HISTORY_HEADER_LENGTH + g_bytes_get_size (compressed_payload));
+	g_byte_array_append (contents, (const guint8 *) HISTORY_FILE_MAGIC, HISTORY_FILE_MAGIC_LENGTH);
+	g_byte_array_append (contents, (const guint8 *) checksum, HISTORY_CHECKSUM_LENGTH);
+	history_write_uint8 (contents, manager->priv->can_undo);
+	history_write_uint8 (contents, manager->priv->can_redo);
+	history_write_uint32 (contents, g_bytes_get_size (payload));
+	g_byte_array_append (contents,
+	                     g_bytes_get_data (compressed_payload, NULL),
+	                     g_bytes_get_size (compressed_payload));
+
+	ret = g_file_replace_contents (file,
+	                               (const gchar *) contents->data,
+	                               contents->len,
+	                               NULL,
+	                               FALSE,
+	                               G_FILE_CREATE_NONE,
+	                               NULL,
+	                               cancellable,
+	                               error);
+
+	g_byte_array_free (contents, TRUE);
+	g_bytes_unref (compressed_payload);
+	g_bytes_unref (payload);
+	g_free (checksum);
+	return ret;
 }
 
-static void
-gtk_source_undo_manager_iface_init (GtkSourceUndoManagerIface *iface)
+/* Reads only the header of @file. The actions are read, and the checksum of
+ * the buffer is checked, the first time the history is needed: on undo, redo
+ * or when the buffer is modified.
+ */
+gboolean
+gtk_source_undo_manager_default_load_history (GtkSourceUndoManagerDefault  *manager,
+                                              GFile                        *file,
+                                              GCancellable                 *cancellable,
+                                              GError                      **error)
 {
-	iface->can_undo = gtk_source_undo_manager_can_undo_impl;
-	iface->can_redo = gtk_source_undo_manager_can_redo_impl;
+	GFileInputStream *stream;
+	guint8 header[HISTORY_HEADER_LENGTH];
+	gsize bytes_read;
+	gboolean ok;
 
-	iface->undo = gtk_source_undo_manager_undo_impl;
-	iface->redo = gtk_source_undo_manager_redo_impl;
+	g_return_val_if_fail (GTK_SOURCE_IS_UNDO_MANAGER_DEFAULT (manager), FALSE);
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
 
-	iface->begin_not_undoable_action = gtk_source_undo_manager_begin_not_undoable_action_impl;
-	iface->end_not_undoable_action = gtk_source_undo_manager_end_not_undoable_action_impl;
-}
+	stream = g_file_read (file, cancellable, error);
 
-void
-gtk_source_undo_manager_default_set_max_undo_levels (GtkSourceUndoManagerDefault *manager,
-                                                     gint                         max_undo_levels)
-{
-	g_return_if_fail (GTK_SOURCE_IS_UNDO_MANAGER_DEFAULT (manager));
+	if (stream == NULL)
+		return FALSE;
 
-	set_max_undo_levels (manager, max_undo_levels);
-	g_object_notify (G_OBJECT (manager), "max-undo-levels");
+	ok = g_input_stream_read_all (G_INPUT_STREAM (stream),
+	                              header,
+	                              HISTORY_HEADER_LENGTH,
+	                              &bytes_read,
+	                              cancellable,
+	                              error);
+	g_object_unref (stream);
+
+	if (!ok)
+		return FALSE;
+
+	if (bytes_read != HISTORY_HEADER_LENGTH ||
+	    memcmp (header, HISTORY_FILE_MAGIC, HISTORY_FILE_MAGIC_LENGTH) != 0)
+	{
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+		                     _("Not an undo history file."));
+		return FALSE;
+	}
+
+	clear_undo (manager);
+
+	manager->priv->pending_history_file = g_object_ref (file);
+	manager->priv->pending_history_checksum = g_strndup ((const gchar *) header + HISTORY_FILE_MAGIC_LENGTH,
+	                                                     HISTORY_CHECKSUM_LENGTH);
+
+	manager->priv->can_undo = header[HISTORY_FILE_MAGIC_LENGTH + HISTORY_CHECKSUM_LENGTH] != 0;
+	manager->priv->can_redo = header[HISTORY_FILE_MAGIC_LENGTH + HISTORY_CHECKSUM_LENGTH + 1] != 0;
+
+	if (manager->priv->can_undo)
+		gtk_source_undo_manager_can_undo_changed (GTK_SOURCE_UNDO_MANAGER (manager));
+
+	if (manager->priv->can_redo)
+		gtk_source_undo_manager_can_redo_changed (GTK_SOURCE_UNDO_MANAGER (manager));
+
+	return TRUE;
 }
@@ -25,7 +25,7 @@
 #ifndef __GTK_SOURCE_UNDO_MANAGER_DEFAULT_H__
 #define __GTK_SOURCE_UNDO_MANAGER_DEFAULT_H__
 
-#include <glib-object.h>
+#include <gio/gio.h>
 #include "gtksourcetypes-private.h"
 
 G_BEGIN_DECLS
@@ -59,6 +59,22 @@ G_GNUC_INTERNAL
 void gtk_source_undo_manager_default_set_max_undo_levels (GtkSourceUndoManagerDefault *manager,
                                                           gint                         max_undo_levels);
 
+G_GNUC_INTERNAL
+void gtk_source_undo_manager_default_set_max_undo_size (GtkSourceUndoManagerDefault *manager,
+                                                        gint                         max_undo_size);
+
+G_GNUC_INTERNAL
+gboolean gtk_source_undo_manager_default_save_history (GtkSourceUndoManagerDefault  *manager,
+                                                       GFile                        *file,
+                                                       GCancellable                 *cancellable,
+                                                       GError                      **error);
+
+G_GNUC_INTERNAL
+gboolean gtk_source_undo_manager_default_load_history (GtkSourceUndoManagerDefault  *manager,
+                                                       GFile                        *file,
+                                                       GCancellable                 *cancellable,
+                                                       GError                      **error);
+
 G_END_DECLS
 
 #endif /* __GTK_SOURCE_UNDO_MANAGER_DEFAULT_H__ */
@@ -1103,6 +1103,15 @@ source_mark_updated_cb (GtkSourceBuffer *buffer,
 	gtk_widget_queue_draw (GTK_WIDGET (text_view));
 }
 
+static void
+source_marks_updated_cb (GtkSourceBuffer *buffer,
+			 GtkTextIter     *start,
+			 GtkTextIter     *end,
+			 GtkTextView     *text_view)
+{
+	gtk_widget_queue_draw (GTK_WIDGET (text_view));
+}
+
 static void
 buffer_style_scheme_changed_cb (GtkSourceBuffer *buffer,
 				GParamSpec	*pspec,
@@ -1130,6 +1139,10 @@ set_source_buffer (GtkSourceView *view,
 						      source_mark_updated_cb,
 						      view);
 
+		g_signal_handlers_disconnect_by_func (view->priv->source_buffer,
+						      source_marks_updated_cb,
+						      view);
+
 		g_signal_handlers_disconnect_by_func (view->priv->source_buffer,
 						      buffer_style_scheme_changed_cb,
 						      view);
@@ -1153,6 +1166,12 @@ set_source_buffer (GtkSourceView *view,
 					 view,
 					 0);
 
+		g_signal_connect_object (buffer,
+					 "source_marks_updated",
+					 G_CALLBACK (source_marks_updated_cb),
+					 view,
+					 0);
+
 		g_signal_connect_object (buffer,
 					 "notify::style-scheme",
 					 G_CALLBACK (buffer_style_scheme_changed_cb),
@@ -0,0 +1,49 @@
+/*
+ * benchmark-utils.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "benchmark-utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Returns the resident set size in kilobytes, or -1 if unknown. */
+glong
+benchmark_get_resident_memory (void)
+{
+	gchar *contents;
+	gchar *line;
+	glong rss = -1;
+
+	if (!g_file_get_contents ("/proc/self/status", &contents, NULL, NULL))
+	{
+		return -1;
+	}
+
+	line = strstr (contents, "VmRSS:");
+
+	if (line != NULL)
+	{
+		rss = strtol (line + strlen ("VmRSS:"), NULL, 10);
+	}
+
+	g_free (contents);
+	return rss;
+}
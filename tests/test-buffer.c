@@ -27,12 +27,138 @@ test_get_buffer (void)
 	g_object_unref (view);
 }
 
+static void
+batch_edit_finished_cb (GtkSourceBuffer *buffer,
+			GtkTextIter     *start,
+			GtkTextIter     *end,
+			gint            *region)
+{
+	region[0]++;
+	region[1] = gtk_text_iter_get_offset (start);
+	region[2] = gtk_text_iter_get_offset (end);
+}
+
+static void
+test_batch_edit (void)
+{
+	GtkSourceBuffer *buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	GtkTextIter start;
+	GtkTextIter end;
+	gint region[3] = { 0, -1, -1 };
+
+	gtk_text_buffer_set_text (text_buffer, "aaa bbb ccc ddd", -1);
+
+	g_signal_connect (buffer,
+			  "batch-edit-finished",
+			  G_CALLBACK (batch_edit_finished_cb),
+			  region);
+
+	/* No text change, no signal. */
+	gtk_source_buffer_begin_batch_edit (buffer);
+	g_assert (gtk_source_buffer_is_in_batch_edit (buffer));
+	gtk_source_buffer_end_batch_edit (buffer);
+	g_assert (!gtk_source_buffer_is_in_batch_edit (buffer));
+	g_assert_cmpint (region[0], ==, 0);
+
+	/* Nested batch edits: the signal is emitted only at the end of the
+	 * outermost one, with the region containing all the changes.
+	 */
+	gtk_source_buffer_begin_batch_edit (buffer);
+	gtk_source_buffer_begin_batch_edit (buffer);
+
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &start, 4);
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &end, 8);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+
+	gtk_text_buffer_get_start_iter (text_buffer, &start);
+	gtk_text_buffer_insert (text_buffer, &start, "XY", -1);
+
+	gtk_source_buffer_end_batch_edit (buffer);
+	g_assert (gtk_source_buffer_is_in_batch_edit (buffer));
+	g_assert_cmpint (region[0], ==, 0);
+
+	gtk_text_buffer_get_end_iter (text_buffer, &end);
+	gtk_text_buffer_insert (text_buffer, &end, "Z", -1);
+
+	gtk_source_buffer_end_batch_edit (buffer);
+	g_assert_cmpint (region[0], ==, 1);
+	g_assert_cmpint (region[1], ==, 0);
+	g_assert_cmpint (region[2], ==, 14);
+
+	/* Only a deletion: empty region. */
+	gtk_source_buffer_begin_batch_edit (buffer);
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &start, 2);
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &end, 5);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+	gtk_source_buffer_end_batch_edit (buffer);
+	g_assert_cmpint (region[0], ==, 2);
+	g_assert_cmpint (region[1], ==, 2);
+	g_assert_cmpint (region[2], ==, 2);
+
+	g_object_unref (buffer);
+}
+
+static void
+test_batch_edit_set_language (void)
+{
+	GtkSourceBuffer *buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	GtkSourceLanguageManager *lm;
+	GtkSourceLanguage *language;
+	gchar **lang_dirs;
+	GtkTextIter start;
+	GtkTextIter end;
+	GtkTextIter iter;
+
+	lm = gtk_source_language_manager_new ();
+
+	lang_dirs = g_new0 (gchar *, 2);
+	lang_dirs[0] = g_build_filename (TOP_SRCDIR, "data", "language-specs", NULL);
+	gtk_source_language_manager_set_search_path (lm, lang_dirs);
+	g_strfreev (lang_dirs);
+
+	language = gtk_source_language_manager_get_language (lm, "c");
+	g_assert (language != NULL);
+
+	gtk_text_buffer_set_text (text_buffer, "aaaaaaaaaaaaaaaaaaaaaaaaa", -1);
+
+	/* The engine created during the batch edit already knows the new
+	 * text, it must not be notified again at the end of the batch.
+	 */
+	gtk_source_buffer_begin_batch_edit (buffer);
+
+	gtk_text_buffer_get_bounds (text_buffer, &start, &end);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+
+	gtk_source_buffer_set_language (buffer, language);
+
+	gtk_text_buffer_get_start_iter (text_buffer, &start);
+	gtk_text_buffer_insert (text_buffer, &start, "int a; /* b */", -1);
+
+	gtk_source_buffer_end_batch_edit (buffer);
+
+	gtk_text_buffer_get_bounds (text_buffer, &start, &end);
+	gtk_source_buffer_ensure_highlight (buffer, &start, &end);
+
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &iter, 1);
+	g_assert (!gtk_source_buffer_iter_has_context_class (buffer, &iter, "comment"));
+
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &iter, 10);
+	g_assert (gtk_source_buffer_iter_has_context_class (buffer, &iter, "comment"));
+
+	g_object_unref (buffer);
+	g_object_unref (lm);
+}
+
 int
 main (int argc, char** argv)
 {
 	gtk_test_init (&argc, &argv);
 
 	g_test_add_func ("/Buffer/bug-634510", test_get_buffer);
+	g_test_add_func ("/Buffer/batch-edit", test_batch_edit);
+	g_test_add_func ("/Buffer/batch-edit-set-language", test_batch_edit_set_language);
 
 	return g_test_run();
 }
@@ -0,0 +1,161 @@
+/*
+ * test-completion-matcher.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+
+static GList *
+create_proposals (const gchar **labels)
+{
+	GList *proposals = NULL;
+	gint i;
+
+	for (i = 0; labels[i] != NULL; i++)
+	{
+		proposals = g_list_append (proposals,
+					   gtk_source_completion_item_new (labels[i], labels[i], NULL, NULL));
+	}
+
+	return proposals;
+}
+
+/* Checks the labels of @proposals, a NULL-terminated array. */
+static void
+check_labels (GList        *proposals,
+	      const gchar **expected)
+{
+	GList *l;
+	gint i = 0;
+
+	for (l = proposals; l != NULL; l = l->next)
+	{
+		gchar *label = gtk_source_completion_proposal_get_label (l->data);
+
+		g_assert (expected[i] != NULL);
+		g_assert_cmpstr (label, ==, expected[i]);
+
+		g_free (label);
+		i++;
+	}
+
+	g_assert (expected[i] == NULL);
+}
+
+static void
+test_fuzzy_match (void)
+{
+	gint score1;
+	gint score2;
+
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("gsv", "GtkSourceView", NULL));
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("gsv", "gtk_source_view", NULL));
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("GS", "get_string", NULL));
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("", "foo", NULL));
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("\303\251t", "\303\211T\303\211", NULL));
+
+	g_assert (!gtk_source_completion_matcher_fuzzy_match ("vs", "GtkSourceView", NULL));
+	g_assert (!gtk_source_completion_matcher_fuzzy_match ("foo", "fo", NULL));
+	g_assert (!gtk_source_completion_matcher_fuzzy_match ("a", "", NULL));
+
+	/* Start of a word better than in the middle of a word. */
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("gs", "get_string", &score1));
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("gs", "bugs", &score2));
+	g_assert_cmpint (score1, >, score2);
+
+	/* Consecutive matches better than spread ones. */
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("foo", "foobar", &score1));
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("foo", "fxoxo", &score2));
+	g_assert_cmpint (score1, >, score2);
+
+	/* Shorter label better. */
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("foo", "foo", &score1));
+	g_assert (gtk_source_completion_matcher_fuzzy_match ("foo", "foobar", &score2));
+	g_assert_cmpint (score1, >, score2);
+}
+
+static void
+test_filter (void)
+{
+	const gchar *labels[] = { "bugs", "gas", "get_string", "nothing", NULL };
+	const gchar *all[] = { "bugs", "gas", "get_string", "nothing", NULL };
+	const gchar *gs[] = { "get_string", "gas", "bugs", NULL };
+	const gchar *gst[] = { "get_string", NULL };
+	const gchar *b[] = { "bugs", NULL };
+	const gchar *none[] = { NULL };
+	GtkSourceCompletionMatcher *matcher = gtk_source_completion_matcher_new ();
+	GtkSourceCompletionMatcher *matcher2 = gtk_source_completion_matcher_new ();
+	GList *proposals = create_proposals (labels);
+	GList *result;
+	GList *result2;
+
+	gtk_source_completion_matcher_set_proposals (matcher, proposals);
+	gtk_source_completion_matcher_set_proposals (matcher2, proposals);
+
+	result = gtk_source_completion_matcher_filter (matcher, "");
+	check_labels (result, all);
+	g_list_free (result);
+
+	/* Incremental filtering, with the same result as from scratch. */
+	result = gtk_source_completion_matcher_filter (matcher, "g");
+	g_list_free (result);
+
+	result = gtk_source_completion_matcher_filter (matcher, "gs");
+	check_labels (result, gs);
+
+	result2 = gtk_source_completion_matcher_filter (matcher2, "gs");
+	check_labels (result2, gs);
+	g_list_free (result);
+	g_list_free (result2);
+
+	result = gtk_source_completion_matcher_filter (matcher, "gst");
+	check_labels (result, gst);
+	g_list_free (result);
+
+	result = gtk_source_completion_matcher_filter (matcher, "gstx");
+	check_labels (result, none);
+	g_list_free (result);
+
+	/* Not an extension of the previous query. */
+	result = gtk_source_completion_matcher_filter (matcher, "b");
+	check_labels (result, b);
+	g_list_free (result);
+
+	/* New proposals. */
+	gtk_source_completion_matcher_set_proposals (matcher, NULL);
+	result = gtk_source_completion_matcher_filter (matcher, "");
+	check_labels (result, none);
+	g_list_free (result);
+
+	g_list_free_full (proposals, g_object_unref);
+	g_object_unref (matcher);
+	g_object_unref (matcher2);
+}
+
+int
+main (int argc, char **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/CompletionMatcher/fuzzy-match", test_fuzzy_match);
+	g_test_add_func ("/CompletionMatcher/filter", test_filter);
+
+	return g_test_run ();
+}
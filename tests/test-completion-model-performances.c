@@ -0,0 +1,228 @@
+/*
+ * test-completion-model-performances.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+#include "gtksourceview/gtksourcecompletionmodel.h"
+
+/* This measures the execution times of the GtkTreeModel operations used by
+ * the completion window, with a lot of proposals (for example from a ctags
+ * provider): filling the model in several batches, like the providers do,
+ * then accessing each row by its index, getting the path of each row, and
+ * iterating over the proposals.
+ *
+ * There are NB_PROVIDERS providers, the proposals are spread among them, and
+ * the headers are shown.
+ */
+
+#define NB_PROPOSALS 100000
+#define NB_PROVIDERS 3
+#define BATCH_SIZE 500
+
+typedef struct _TestProvider      TestProvider;
+typedef struct _TestProviderClass TestProviderClass;
+
+struct _TestProvider
+{
+	GObject parent_instance;
+	gint priority;
+};
+
+struct _TestProviderClass
+{
+	GObjectClass parent_class;
+};
+
+GType test_provider_get_type (void);
+
+static void test_provider_iface_init (GtkSourceCompletionProviderIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (TestProvider,
+			 test_provider,
+			 G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (GTK_SOURCE_TYPE_COMPLETION_PROVIDER,
+						test_provider_iface_init));
+
+static gchar *
+test_provider_get_name (GtkSourceCompletionProvider *provider)
+{
+	return g_strdup ("Tags");
+}
+
+static gint
+test_provider_get_priority (GtkSourceCompletionProvider *provider)
+{
+	return ((TestProvider *)provider)->priority;
+}
+
+static void
+test_provider_iface_init (GtkSourceCompletionProviderIface *iface)
+{
+	iface->get_name = test_provider_get_name;
+	iface->get_priority = test_provider_get_priority;
+}
+
+static void
+test_provider_class_init (TestProviderClass *klass)
+{
+}
+
+static void
+test_provider_init (TestProvider *self)
+{
+}
+
+int
+main (int argc, char *argv[])
+{
+	GtkSourceCompletionModel *model;
+	GtkTreeModel *tree_model;
+	TestProvider *providers[NB_PROVIDERS];
+	GTimer *timer;
+	GtkTreeIter iter;
+	gint nb_rows;
+	gint nb_found;
+	gint i;
+
+	gtk_init (&argc, &argv);
+
+	model = gtk_source_completion_model_new ();
+	tree_model = GTK_TREE_MODEL (model);
+
+	for (i = 0; i < NB_PROVIDERS; i++)
+	{
+		providers[i] = g_object_new (test_provider_get_type (), NULL);
+		providers[i]->priority = i;
+	}
+
+	/* Fill the model */
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < NB_PROPOSALS; i += BATCH_SIZE)
+	{
+		GList *proposals = NULL;
+		gint j;
+
+		for (j = i; j < i + BATCH_SIZE && j < NB_PROPOSALS; j++)
+		{
+			gchar *label = g_strdup_printf ("tag_%d", j);
+
+			proposals = g_list_prepend (proposals,
+						    gtk_source_completion_item_new (label, label, NULL, NULL));
+			g_free (label);
+		}
+
+		proposals = g_list_reverse (proposals);
+
+		gtk_source_completion_model_add_proposals (model,
+							   GTK_SOURCE_COMPLETION_PROVIDER (providers[(i / BATCH_SIZE) % NB_PROVIDERS]),
+							   proposals);
+
+		/* The completion window asks for the number of rows after each
+		 * batch.
+		 */
+		gtk_tree_model_iter_n_children (tree_model, NULL);
+
+		g_list_free_full (proposals, g_object_unref);
+	}
+
+	g_timer_stop (timer);
+	g_print ("add %d proposals in batches of %d: %lf seconds.\n",
+		 NB_PROPOSALS,
+		 BATCH_SIZE,
+		 g_timer_elapsed (timer, NULL));
+
+	nb_rows = gtk_tree_model_iter_n_children (tree_model, NULL);
+
+	/* Row-by-row access by index, like GtkTreeView does */
+
+	g_timer_start (timer);
+
+	for (i = 0; i < nb_rows; i++)
+	{
+		gtk_tree_model_iter_nth_child (tree_model, &iter, NULL, i);
+	}
+
+	g_timer_stop (timer);
+	g_print ("get the iter of each of the %d rows by index: %lf seconds.\n",
+		 nb_rows,
+		 g_timer_elapsed (timer, NULL));
+
+	/* Path of each row */
+
+	g_timer_start (timer);
+
+	gtk_tree_model_get_iter_first (tree_model, &iter);
+
+	do
+	{
+		GtkTreePath *path = gtk_tree_model_get_path (tree_model, &iter);
+		gtk_tree_path_free (path);
+	}
+	while (gtk_tree_model_iter_next (tree_model, &iter));
+
+	g_timer_stop (timer);
+	g_print ("get the path of each row: %lf seconds.\n",
+		 g_timer_elapsed (timer, NULL));
+
+	/* Navigation between the proposals, headers skipped */
+
+	g_timer_start (timer);
+
+	nb_found = 0;
+
+	if (gtk_source_completion_model_last_proposal (model, &iter))
+	{
+		nb_found++;
+
+		while (gtk_source_completion_model_previous_proposal (model, &iter))
+		{
+			nb_found++;
+		}
+	}
+
+	g_timer_stop (timer);
+	g_print ("backward iteration through %d proposals: %lf seconds.\n",
+		 nb_found,
+		 g_timer_elapsed (timer, NULL));
+
+	/* Hide and show the headers, the model emits the signals */
+
+	g_timer_start (timer);
+
+	gtk_source_completion_model_set_show_headers (model, FALSE);
+	gtk_source_completion_model_set_show_headers (model, TRUE);
+
+	g_timer_stop (timer);
+	g_print ("hide and show the headers: %lf seconds.\n",
+		 g_timer_elapsed (timer, NULL));
+
+	g_timer_destroy (timer);
+	g_object_unref (model);
+
+	for (i = 0; i < NB_PROVIDERS; i++)
+	{
+		g_object_unref (providers[i]);
+	}
+
+	return 0;
+}
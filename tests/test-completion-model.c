@@ -603,6 +603,116 @@ test_row_changed (void)
 	g_list_free_full (proposals, g_object_unref);
 }
 
+static gboolean
+label_begins_with (GtkSourceCompletionProposal *proposal,
+		   const gchar                 *prefix)
+{
+	gchar *label = gtk_source_completion_proposal_get_label (proposal);
+	gboolean ret = g_str_has_prefix (label, prefix);
+
+	g_free (label);
+	return ret;
+}
+
+typedef struct
+{
+	gint row;
+
+	/* The number of rows of the model when the signal is emitted. */
+	gint n_rows;
+} DeletedRow;
+
+static void
+on_row_deleted (GtkTreeModel *model,
+		GtkTreePath  *path,
+		GArray       *deleted_rows)
+{
+	DeletedRow deleted_row;
+
+	deleted_row.row = gtk_tree_path_get_indices (path)[0];
+	deleted_row.n_rows = gtk_tree_model_iter_n_children (model, NULL);
+
+	g_array_append_val (deleted_rows, deleted_row);
+}
+
+static void
+test_filter_proposals (void)
+{
+	GtkSourceCompletionModel *model = gtk_source_completion_model_new ();
+	GList *all_providers = NULL;
+	GList *all_list_proposals = NULL;
+	GList *first_proposals;
+	GList *second_proposals;
+	GList *kept_first_proposals;
+	GList *kept_list_proposals;
+	GList *remaining_providers;
+	GList *remaining_list_proposals;
+	GList *providers_get;
+	GArray *deleted_rows = g_array_new (FALSE, FALSE, sizeof (DeletedRow));
+
+	create_providers (&all_providers, &all_list_proposals);
+	populate_model (model, all_providers, all_list_proposals);
+
+	first_proposals = all_list_proposals->data;
+	second_proposals = all_list_proposals->next->data;
+
+	g_signal_connect (model,
+			  "row-deleted",
+			  G_CALLBACK (on_row_deleted),
+			  deleted_rows);
+
+	/* Rows: header, Frodo, Bilbo, header, Frodo, Bilbo.
+	 * Keep only Frodo for the first provider.
+	 */
+	gtk_source_completion_model_filter_proposals (model,
+						      all_providers->data,
+						      (GtkSourceCompletionModelFilterFunc) label_begins_with,
+						      "F");
+
+	g_assert_cmpint (deleted_rows->len, ==, 1);
+	g_assert_cmpint (g_array_index (deleted_rows, DeletedRow, 0).row, ==, 2);
+	g_assert_cmpint (g_array_index (deleted_rows, DeletedRow, 0).n_rows, ==, 5);
+
+	kept_first_proposals = g_list_append (NULL, first_proposals->data);
+	kept_list_proposals = g_list_append (NULL, kept_first_proposals);
+	kept_list_proposals = g_list_append (kept_list_proposals, second_proposals);
+
+	check_all_providers_with_and_without_headers (model, all_providers, kept_list_proposals);
+
+	/* Remove all the proposals of the first provider. The provider is
+	 * removed with its header. The header is deleted first, and each
+	 * signal is emitted when its row has been removed from the model.
+	 * Rows: header, Frodo, header, Frodo, Bilbo.
+	 */
+	gtk_source_completion_model_set_show_headers (model, TRUE);
+	g_array_set_size (deleted_rows, 0);
+
+	gtk_source_completion_model_filter_proposals (model, all_providers->data, NULL, NULL);
+
+	g_assert_cmpint (deleted_rows->len, ==, 2);
+	g_assert_cmpint (g_array_index (deleted_rows, DeletedRow, 0).row, ==, 0);
+	g_assert_cmpint (g_array_index (deleted_rows, DeletedRow, 0).n_rows, ==, 4);
+	g_assert_cmpint (g_array_index (deleted_rows, DeletedRow, 1).row, ==, 0);
+	g_assert_cmpint (g_array_index (deleted_rows, DeletedRow, 1).n_rows, ==, 3);
+
+	remaining_providers = g_list_append (NULL, all_providers->next->data);
+	remaining_list_proposals = g_list_append (NULL, second_proposals);
+
+	providers_get = gtk_source_completion_model_get_providers (model);
+	g_assert (same_list_contents (remaining_providers, providers_get));
+
+	check_all_providers_with_and_without_headers (model, remaining_providers, remaining_list_proposals);
+
+	g_object_unref (model);
+	free_providers (all_providers, all_list_proposals);
+	g_list_free (kept_first_proposals);
+	g_list_free (kept_list_proposals);
+	g_list_free (remaining_providers);
+	g_list_free (remaining_list_proposals);
+	g_list_free (providers_get);
+	g_array_free (deleted_rows, TRUE);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -632,5 +742,8 @@ main (int argc, char **argv)
 	g_test_add_func ("/CompletionModel/row-changed",
 			 test_row_changed);
 
+	g_test_add_func ("/CompletionModel/filter-proposals",
+			 test_filter_proposals);
+
 	return g_test_run ();
 }
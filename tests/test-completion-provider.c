@@ -0,0 +1,377 @@
+/*
+ * test-completion-provider.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+
+/* Asynchronous provider. The populations are not finished by the provider, the
+ * tests return the proposals of the pending tasks when they want.
+ */
+
+typedef struct _TestProvider      TestProvider;
+typedef struct _TestProviderClass TestProviderClass;
+
+struct _TestProvider
+{
+	GObject parent_instance;
+
+	/* The pending populations, array of GTask. */
+	GPtrArray *tasks;
+};
+
+struct _TestProviderClass
+{
+	GObjectClass parent_class;
+};
+
+GType test_provider_get_type (void);
+
+static void test_provider_iface_init (GtkSourceCompletionProviderIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (TestProvider,
+			 test_provider,
+			 G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (GTK_SOURCE_TYPE_COMPLETION_PROVIDER,
+						test_provider_iface_init));
+
+static void
+test_provider_populate_async (GtkSourceCompletionProvider *provider,
+			      GtkSourceCompletionContext  *context,
+			      GCancellable                *cancellable,
+			      GAsyncReadyCallback          callback,
+			      gpointer                     user_data)
+{
+	TestProvider *test_provider = (TestProvider *) provider;
+	GTask *task;
+
+	task = g_task_new (provider, cancellable, callback, user_data);
+	g_ptr_array_add (test_provider->tasks, task);
+}
+
+static GList *
+test_provider_populate_finish (GtkSourceCompletionProvider  *provider,
+			       GAsyncResult                 *result,
+			       GError                      **error)
+{
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+test_provider_iface_init (GtkSourceCompletionProviderIface *iface)
+{
+	iface->populate_async = test_provider_populate_async;
+	iface->populate_finish = test_provider_populate_finish;
+}
+
+static void
+test_provider_finalize (GObject *object)
+{
+	TestProvider *provider = (TestProvider *) object;
+
+	g_ptr_array_free (provider->tasks, TRUE);
+
+	G_OBJECT_CLASS (test_provider_parent_class)->finalize (object);
+}
+
+static void
+test_provider_class_init (TestProviderClass *klass)
+{
+	G_OBJECT_CLASS (klass)->finalize = test_provider_finalize;
+}
+
+static void
+test_provider_init (TestProvider *provider)
+{
+	provider->tasks = g_ptr_array_new_with_free_func (g_object_unref);
+}
+
+/* Provider without populate_async(). */
+
+typedef struct _SyncProvider      SyncProvider;
+typedef struct _SyncProviderClass SyncProviderClass;
+
+struct _SyncProvider
+{
+	GObject parent_instance;
+};
+
+struct _SyncProviderClass
+{
+	GObjectClass parent_class;
+};
+
+GType sync_provider_get_type (void);
+
+static void sync_provider_iface_init (GtkSourceCompletionProviderIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (SyncProvider,
+			 sync_provider,
+			 G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (GTK_SOURCE_TYPE_COMPLETION_PROVIDER,
+						sync_provider_iface_init));
+
+static void
+sync_provider_iface_init (GtkSourceCompletionProviderIface *iface)
+{
+}
+
+static void
+sync_provider_class_init (SyncProviderClass *klass)
+{
+}
+
+static void
+sync_provider_init (SyncProvider *provider)
+{
+}
+
+/* Utilities */
+
+typedef struct
+{
+	GtkWidget *window;
+	GtkSourceView *view;
+	GtkSourceCompletion *completion;
+	TestProvider *provider;
+	gint n_shown;
+} Fixture;
+
+static void
+free_proposals (GList *proposals)
+{
+	g_list_free_full (proposals, g_object_unref);
+}
+
+static void
+flush_queue (void)
+{
+	while (gtk_events_pending ())
+	{
+		gtk_main_iteration ();
+	}
+}
+
+/* The "show" signal is emitted when the proposals are displayed. */
+static void
+show_cb (GtkSourceCompletion *completion,
+	 Fixture             *fixture)
+{
+	fixture->n_shown++;
+}
+
+static void
+fixture_setup (Fixture *fixture)
+{
+	GtkTextBuffer *buffer;
+
+	fixture->window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+	fixture->view = GTK_SOURCE_VIEW (gtk_source_view_new ());
+	gtk_container_add (GTK_CONTAINER (fixture->window), GTK_WIDGET (fixture->view));
+	gtk_widget_show_all (fixture->window);
+
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (fixture->view));
+	gtk_text_buffer_set_text (buffer, "Fro", -1);
+
+	fixture->completion = gtk_source_view_get_completion (fixture->view);
+	fixture->provider = g_object_new (test_provider_get_type (), NULL);
+	fixture->n_shown = 0;
+
+	g_signal_connect (fixture->completion,
+			  "show",
+			  G_CALLBACK (show_cb),
+			  fixture);
+}
+
+static void
+fixture_teardown (Fixture *fixture)
+{
+	gtk_source_completion_hide (fixture->completion);
+	gtk_widget_destroy (fixture->window);
+	g_object_unref (fixture->provider);
+	flush_queue ();
+}
+
+static void
+show_completion (Fixture *fixture)
+{
+	GtkSourceCompletionContext *context;
+	GList *providers;
+	gboolean shown;
+
+	context = gtk_source_completion_create_context (fixture->completion, NULL);
+	g_object_set (context,
+		      "activation", GTK_SOURCE_COMPLETION_ACTIVATION_USER_REQUESTED,
+		      NULL);
+
+	providers = g_list_append (NULL, fixture->provider);
+
+	shown = gtk_source_completion_show (fixture->completion, providers, context);
+	g_assert (shown);
+
+	g_list_free (providers);
+}
+
+/* Returns a proposal from the pending population at @index. */
+static void
+return_proposal (TestProvider *provider,
+		 guint         index)
+{
+	GTask *task = g_ptr_array_index (provider->tasks, index);
+	GList *proposals;
+
+	proposals = g_list_append (NULL, gtk_source_completion_item_new ("Frodo", "Frodo", NULL, NULL));
+
+	g_task_return_pointer (task, proposals, (GDestroyNotify) free_proposals);
+}
+
+/* Tests */
+
+static void
+test_populate_async (void)
+{
+	Fixture fixture;
+
+	fixture_setup (&fixture);
+
+	show_completion (&fixture);
+	flush_queue ();
+
+	g_assert_cmpuint (fixture.provider->tasks->len, ==, 1);
+	g_assert_cmpint (fixture.n_shown, ==, 0);
+
+	/* The proposals are displayed when the provider has finished. */
+	return_proposal (fixture.provider, 0);
+	flush_queue ();
+
+	g_assert_cmpint (fixture.n_shown, ==, 1);
+
+	fixture_teardown (&fixture);
+}
+
+static void
+test_populate_async_stale (void)
+{
+	Fixture fixture;
+	GCancellable *first_cancellable;
+	GCancellable *second_cancellable;
+
+	fixture_setup (&fixture);
+
+	show_completion (&fixture);
+
+	/* A new completion replaces the cancellable of the first population,
+	 * which is cancelled.
+	 */
+	show_completion (&fixture);
+	flush_queue ();
+
+	g_assert_cmpuint (fixture.provider->tasks->len, ==, 2);
+
+	first_cancellable = g_task_get_cancellable (g_ptr_array_index (fixture.provider->tasks, 0));
+	second_cancellable = g_task_get_cancellable (g_ptr_array_index (fixture.provider->tasks, 1));
+
+	g_assert (first_cancellable != second_cancellable);
+	g_assert (g_cancellable_is_cancelled (first_cancellable));
+	g_assert (!g_cancellable_is_cancelled (second_cancellable));
+
+	/* The provider ignores the cancellation. The stale proposals must not
+	 * end the running population.
+	 */
+	return_proposal (fixture.provider, 0);
+	flush_queue ();
+
+	g_assert_cmpint (fixture.n_shown, ==, 0);
+
+	return_proposal (fixture.provider, 1);
+	flush_queue ();
+
+	g_assert_cmpint (fixture.n_shown, ==, 1);
+
+	fixture_teardown (&fixture);
+}
+
+static void
+populate_not_supported_cb (GtkSourceCompletionProvider *provider,
+			   GAsyncResult                *result,
+			   gboolean                    *finished)
+{
+	GList *proposals;
+	GError *error = NULL;
+
+	proposals = gtk_source_completion_provider_populate_finish (provider, result, &error);
+
+	g_assert (proposals == NULL);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+	g_error_free (error);
+
+	*finished = TRUE;
+}
+
+static void
+test_populate_async_not_supported (void)
+{
+	GtkSourceView *view;
+	GtkSourceCompletion *completion;
+	GtkSourceCompletionContext *context;
+	GtkSourceCompletionProvider *provider;
+	gboolean finished = FALSE;
+
+	view = GTK_SOURCE_VIEW (gtk_source_view_new ());
+	g_object_ref_sink (view);
+
+	completion = gtk_source_view_get_completion (view);
+	context = gtk_source_completion_create_context (completion, NULL);
+	g_object_ref_sink (context);
+
+	provider = g_object_new (sync_provider_get_type (), NULL);
+
+	gtk_source_completion_provider_populate_async (provider,
+						       context,
+						       NULL,
+						       (GAsyncReadyCallback) populate_not_supported_cb,
+						       &finished);
+
+	while (!finished)
+	{
+		gtk_main_iteration ();
+	}
+
+	g_object_unref (provider);
+	g_object_unref (context);
+	g_object_unref (view);
+}
+
+int
+main (int argc, char **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/CompletionProvider/populate-async",
+			 test_populate_async);
+
+	g_test_add_func ("/CompletionProvider/populate-async-stale",
+			 test_populate_async_stale);
+
+	g_test_add_func ("/CompletionProvider/populate-async-not-supported",
+			 test_populate_async_not_supported);
+
+	return g_test_run ();
+}
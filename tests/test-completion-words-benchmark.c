@@ -0,0 +1,231 @@
+/*
+ * test-completion-words-benchmark.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gtk/gtk.h>
+#include "gtksourceview/completion-providers/words/gtksourcecompletionwordsutils.h"
+
+/* Micro-benchmark of the word scanning of the words completion provider, which
+ * is the hottest path when a big buffer is registered.
+ *
+ * Each corpus is scanned line by line, like the provider does, --repeat times.
+ * The corpora are the files given on the command line. Without arguments, the
+ * C files of the GtkSourceView sources are used, and a text with a lot of
+ * non-ASCII words, for the slow path.
+ *
+ * The results are printed on stdout, one line per corpus, as CSV with a
+ * header. The time is in milliseconds per scan of the whole corpus.
+ */
+
+static gint repeat = 10;
+static gint minimum_word_size = 2;
+
+static GOptionEntry entries[] =
+{
+	{ "repeat", 0, 0, G_OPTION_ARG_INT, &repeat,
+	  "Number of scans of each corpus (default: 10)", "N" },
+	{ "minimum-word-size", 0, 0, G_OPTION_ARG_INT, &minimum_word_size,
+	  "Minimum word size (default: 2)", "N" },
+	{ NULL }
+};
+
+static gchar *
+get_sources_corpus (void)
+{
+	const gchar *dirname = TOP_SRCDIR "/gtksourceview";
+	GString *corpus = g_string_new (NULL);
+	GDir *dir;
+	const gchar *filename;
+
+	dir = g_dir_open (dirname, 0, NULL);
+
+	if (dir == NULL)
+	{
+		g_printerr ("Can not open %s.\n", dirname);
+		return g_string_free (corpus, FALSE);
+	}
+
+	while ((filename = g_dir_read_name (dir)) != NULL)
+	{
+		gchar *path;
+		gchar *contents;
+
+		if (!g_str_has_suffix (filename, ".c"))
+		{
+			continue;
+		}
+
+		path = g_build_filename (dirname, filename, NULL);
+
+		if (g_file_get_contents (path, &contents, NULL, NULL))
+		{
+			g_string_append (corpus, contents);
+			g_free (contents);
+		}
+
+		g_free (path);
+	}
+
+	g_dir_close (dir);
+	return g_string_free (corpus, FALSE);
+}
+
+static gchar *
+get_non_ascii_corpus (void)
+{
+	const gchar *line =
+		"Les \303\251l\303\250ves d\303\251j\303\240 pr\303\251sents ont "
+		"re\303\247u leur dipl\303\264me, \316\261\316\273\316\257\316\272\316\267 "
+		"\316\272\316\261\316\271 \316\262\316\271\316\262\316\273\316\257\316\261.\n";
+	GString *corpus = g_string_new (NULL);
+	gint i;
+
+	for (i = 0; i < 50000; i++)
+	{
+		g_string_append (corpus, line);
+	}
+
+	return g_string_free (corpus, FALSE);
+}
+
+/* Returns the number of words found. @text is modified during the scan, and
+ * restored.
+ */
+static guint
+scan_corpus (gchar *text)
+{
+	gchar *line = text;
+	guint nb_words = 0;
+
+	while (line != NULL)
+	{
+		gchar *line_end = strchr (line, '\n');
+		GSList *words;
+
+		if (line_end != NULL)
+		{
+			*line_end = '\0';
+		}
+
+		words = _gtk_source_completion_words_utils_scan_words (line, minimum_word_size);
+		nb_words += g_slist_length (words);
+		g_slist_free_full (words, g_free);
+
+		if (line_end != NULL)
+		{
+			*line_end = '\n';
+			line = line_end + 1;
+		}
+		else
+		{
+			line = NULL;
+		}
+	}
+
+	return nb_words;
+}
+
+static void
+run_benchmark (const gchar *name,
+	       gchar       *text)
+{
+	gsize nb_bytes = strlen (text);
+	GTimer *timer;
+	gdouble elapsed;
+	guint nb_words = 0;
+	gint i;
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < repeat; i++)
+	{
+		nb_words = scan_corpus (text);
+	}
+
+	elapsed = g_timer_elapsed (timer, NULL) / repeat;
+
+	g_print ("%s,%" G_GSIZE_FORMAT ",%u,%.3lf,%.1lf\n",
+		 name,
+		 nb_bytes,
+		 nb_words,
+		 elapsed * 1000.0,
+		 elapsed > 0.0 ? nb_bytes / elapsed / (1024.0 * 1024.0) : 0.0);
+
+	g_timer_destroy (timer);
+}
+
+int
+main (int argc, char *argv[])
+{
+	GOptionContext *option_context;
+	GError *error = NULL;
+	gchar *text;
+	gint i;
+
+	option_context = g_option_context_new ("[FILE...] - benchmark of the words scanning");
+	g_option_context_add_main_entries (option_context, entries, NULL);
+
+	if (!g_option_context_parse (option_context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return EXIT_FAILURE;
+	}
+
+	g_option_context_free (option_context);
+
+	if (repeat < 1 || minimum_word_size < 1)
+	{
+		g_printerr ("Invalid option value.\n");
+		return EXIT_FAILURE;
+	}
+
+	g_print ("corpus,bytes,nb_words,ms_per_scan,mb_per_s\n");
+
+	if (argc < 2)
+	{
+		text = get_sources_corpus ();
+		run_benchmark ("sources", text);
+		g_free (text);
+
+		text = get_non_ascii_corpus ();
+		run_benchmark ("non-ascii", text);
+		g_free (text);
+
+		return EXIT_SUCCESS;
+	}
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!g_file_get_contents (argv[i], &text, NULL, &error))
+		{
+			g_printerr ("%s\n", error->message);
+			g_clear_error (&error);
+			continue;
+		}
+
+		run_benchmark (argv[i], text);
+		g_free (text);
+	}
+
+	return EXIT_SUCCESS;
+}
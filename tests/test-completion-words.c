@@ -19,28 +19,53 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <string.h>
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 #include <gtksourceview/gtksource.h>
 #include "gtksourceview/completion-providers/words/gtksourcecompletionwordslibrary.h"
+#include "gtksourceview/completion-providers/words/gtksourcecompletionwordsbuffer.h"
+#include "gtksourceview/completion-providers/words/gtksourcecompletionwordsindex.h"
+#include "gtksourceview/completion-providers/words/gtksourcecompletionwordsutils.h"
+#include "gtksourceview/gtksourcecompletionmodel.h"
 
 static void
 library_add_words (GtkSourceCompletionWordsLibrary *library)
 {
-	gtk_source_completion_words_library_add_word (library, "bb");
-	gtk_source_completion_words_library_add_word (library, "bbc");
-	gtk_source_completion_words_library_add_word (library, "bbd");
-	gtk_source_completion_words_library_add_word (library, "dd");
-	gtk_source_completion_words_library_add_word (library, "dde");
-	gtk_source_completion_words_library_add_word (library, "ddf");
+	gtk_source_completion_words_library_add_word (library, "bb", TRUE);
+	gtk_source_completion_words_library_add_word (library, "bbc", TRUE);
+	gtk_source_completion_words_library_add_word (library, "bbd", TRUE);
+	gtk_source_completion_words_library_add_word (library, "dd", TRUE);
+	gtk_source_completion_words_library_add_word (library, "dde", TRUE);
+	gtk_source_completion_words_library_add_word (library, "ddf", TRUE);
+}
+
+static void
+check_iter_word (GtkSourceCompletionWordsLibraryIter *iter,
+		 const gchar                         *expected_word)
+{
+	GtkSourceCompletionWordsProposal *proposal;
+	GString *word;
+
+	g_assert (iter != NULL);
+
+	word = g_string_new ("previous contents");
+	gtk_source_completion_words_library_get_word (iter, word);
+	g_assert_cmpstr (word->str, ==, expected_word);
+	g_string_free (word, TRUE);
+
+	proposal = gtk_source_completion_words_library_get_proposal (iter);
+	g_assert_cmpstr (gtk_source_completion_words_proposal_get_word (proposal), ==, expected_word);
+	g_assert_cmpuint (gtk_source_completion_words_library_get_word_length (iter), ==, strlen (expected_word));
+
+	g_object_unref (proposal);
 }
 
 static void
 test_library_find (void)
 {
 	GtkSourceCompletionWordsLibrary *library = gtk_source_completion_words_library_new ();
-	GtkSourceCompletionWordsProposal *proposal;
-	GSequenceIter *iter;
-	const gchar *word;
+	GtkSourceCompletionWordsLibraryIter *iter;
 
 	library_add_words (library);
 
@@ -51,22 +76,607 @@ test_library_find (void)
 	g_assert (iter == NULL);
 
 	iter = gtk_source_completion_words_library_find_first (library, "b", -1);
-	g_assert (iter != NULL);
+	check_iter_word (iter, "bb");
 
+	iter = gtk_source_completion_words_library_find_first (library, "dd", -1);
+	check_iter_word (iter, "dd");
+
+	g_assert (gtk_source_completion_words_library_find (library, "bbc") != NULL);
+	g_assert (gtk_source_completion_words_library_find (library, "bbcd") == NULL);
+	g_assert (gtk_source_completion_words_library_find (library, "b") == NULL);
+
+	g_object_unref (library);
+}
+
+static void
+test_library_find_next (void)
+{
+	GtkSourceCompletionWordsLibrary *library = gtk_source_completion_words_library_new ();
+	GtkSourceCompletionWordsLibraryIter *iter;
+
+	library_add_words (library);
+	gtk_source_completion_words_library_add_word (library, "b", TRUE);
+
+	/* All the words, in the sorted order. */
+	iter = gtk_source_completion_words_library_find_first (library, "", -1);
+	check_iter_word (iter, "b");
+	iter = gtk_source_completion_words_library_find_next (iter, "", -1);
+	check_iter_word (iter, "bb");
+	iter = gtk_source_completion_words_library_find_next (iter, "", -1);
+	check_iter_word (iter, "bbc");
+	iter = gtk_source_completion_words_library_find_next (iter, "", -1);
+	check_iter_word (iter, "bbd");
+	iter = gtk_source_completion_words_library_find_next (iter, "", -1);
+	check_iter_word (iter, "dd");
+	iter = gtk_source_completion_words_library_find_next (iter, "", -1);
+	check_iter_word (iter, "dde");
+	iter = gtk_source_completion_words_library_find_next (iter, "", -1);
+	check_iter_word (iter, "ddf");
+	iter = gtk_source_completion_words_library_find_next (iter, "", -1);
+	g_assert (iter == NULL);
+
+	/* The prefix ends in the middle of a node. */
+	iter = gtk_source_completion_words_library_find_first (library, "bb", -1);
+	check_iter_word (iter, "bb");
+	iter = gtk_source_completion_words_library_find_next (iter, "bb", -1);
+	check_iter_word (iter, "bbc");
+	iter = gtk_source_completion_words_library_find_next (iter, "bb", -1);
+	check_iter_word (iter, "bbd");
+	iter = gtk_source_completion_words_library_find_next (iter, "bb", -1);
+	g_assert (iter == NULL);
+
+	iter = gtk_source_completion_words_library_find_first (library, "dde", -1);
+	check_iter_word (iter, "dde");
+	iter = gtk_source_completion_words_library_find_next (iter, "dde", -1);
+	g_assert (iter == NULL);
+
+	g_object_unref (library);
+}
+
+static void
+test_library_remove (void)
+{
+	GtkSourceCompletionWordsLibrary *library = gtk_source_completion_words_library_new ();
+	GtkSourceCompletionWordsLibraryIter *iter;
+	GtkSourceCompletionWordsProposal *proposal;
+	GtkSourceCompletionWordsProposal *merged_proposal;
+
+	library_add_words (library);
+
+	/* Two occurrences */
+	gtk_source_completion_words_library_add_word (library, "bbc", TRUE);
+
+	gtk_source_completion_words_library_remove_word (library, "bbc");
+	g_assert (gtk_source_completion_words_library_find (library, "bbc") != NULL);
+
+	gtk_source_completion_words_library_remove_word (library, "bbc");
+	g_assert (gtk_source_completion_words_library_find (library, "bbc") == NULL);
+
+	iter = gtk_source_completion_words_library_find_first (library, "bbc", -1);
+	g_assert (iter == NULL);
+
+	/* A proposal can outlive its word. */
+	iter = gtk_source_completion_words_library_find (library, "bbd");
 	proposal = gtk_source_completion_words_library_get_proposal (iter);
-	word = gtk_source_completion_words_proposal_get_word (proposal);
-	g_assert_cmpstr (word, ==, "bb");
+	gtk_source_completion_words_library_remove_word (library, "bbd");
+	g_assert_cmpstr (gtk_source_completion_words_proposal_get_word (proposal), ==, "bbd");
+	g_object_unref (proposal);
 
+	/* While the library is locked, a new word is not added, and the iters
+	 * stay valid.
+	 */
 	iter = gtk_source_completion_words_library_find_first (library, "dd", -1);
-	g_assert (iter != NULL);
+	gtk_source_completion_words_library_lock (library);
+
+	g_assert (!gtk_source_completion_words_library_add_word (library, "ddd", TRUE));
+	g_assert (gtk_source_completion_words_library_add_word (library, "dd", TRUE));
 
+	gtk_source_completion_words_library_remove_word (library, "dde");
+	iter = gtk_source_completion_words_library_find_next (iter, "dd", -1);
+	check_iter_word (iter, "ddf");
+
+	gtk_source_completion_words_library_unlock (library);
+
+	iter = gtk_source_completion_words_library_find_first (library, "d", -1);
+	check_iter_word (iter, "dd");
+	iter = gtk_source_completion_words_library_find_next (iter, "d", -1);
+	check_iter_word (iter, "ddf");
+	iter = gtk_source_completion_words_library_find_next (iter, "d", -1);
+	g_assert (iter == NULL);
+
+	/* The node of "abc" is left with one child, and is merged with it
+	 * before its own turn to be pruned. The proposal follows the merge.
+	 */
+	gtk_source_completion_words_library_add_word (library, "abc", TRUE);
+	gtk_source_completion_words_library_add_word (library, "abcd", TRUE);
+	gtk_source_completion_words_library_add_word (library, "abce", TRUE);
+
+	iter = gtk_source_completion_words_library_find (library, "abcd");
 	proposal = gtk_source_completion_words_library_get_proposal (iter);
-	word = gtk_source_completion_words_proposal_get_word (proposal);
-	g_assert_cmpstr (word, ==, "dd");
+
+	gtk_source_completion_words_library_lock (library);
+	gtk_source_completion_words_library_remove_word (library, "abce");
+	gtk_source_completion_words_library_remove_word (library, "abc");
+	gtk_source_completion_words_library_unlock (library);
+
+	iter = gtk_source_completion_words_library_find_first (library, "a", -1);
+	check_iter_word (iter, "abcd");
+
+	merged_proposal = gtk_source_completion_words_library_get_proposal (iter);
+	g_assert (merged_proposal == proposal);
+	g_object_unref (merged_proposal);
+	g_object_unref (proposal);
+
+	iter = gtk_source_completion_words_library_find_next (iter, "a", -1);
+	g_assert (iter == NULL);
+
+	g_assert (gtk_source_completion_words_library_find (library, "abc") == NULL);
+	g_assert (gtk_source_completion_words_library_find (library, "abce") == NULL);
+
+	/* Splitting the merged node again. */
+	gtk_source_completion_words_library_add_word (library, "ab", TRUE);
+	gtk_source_completion_words_library_remove_word (library, "abcd");
+
+	iter = gtk_source_completion_words_library_find_first (library, "a", -1);
+	check_iter_word (iter, "ab");
+	iter = gtk_source_completion_words_library_find_next (iter, "a", -1);
+	g_assert (iter == NULL);
+
+	g_object_unref (library);
+}
+
+static void
+test_library_score (void)
+{
+	GtkSourceCompletionWordsLibrary *library = gtk_source_completion_words_library_new ();
+	GtkSourceCompletionWordsLibraryIter *frequent;
+	GtkSourceCompletionWordsLibraryIter *recent;
+	guint frequent_score;
+	guint recent_score;
+
+	/* Like the initial scan of a buffer. */
+	gtk_source_completion_words_library_add_word_occurrences (library, "frequent", 5);
+	frequent = gtk_source_completion_words_library_find (library, "frequent");
+	g_assert_cmpuint (gtk_source_completion_words_library_get_score (library, frequent), ==, 5);
+
+	/* Like a batch scan. */
+	gtk_source_completion_words_library_add_word (library, "frequent", FALSE);
+	g_assert_cmpuint (gtk_source_completion_words_library_get_score (library, frequent), ==, 6);
+
+	/* Like a word typed by the user. */
+	gtk_source_completion_words_library_add_word (library, "recent", TRUE);
+	recent = gtk_source_completion_words_library_find (library, "recent");
+	recent_score = gtk_source_completion_words_library_get_score (library, recent);
+	g_assert_cmpuint (recent_score, >, 6);
+
+	/* The most recent word has the best bonus. */
+	gtk_source_completion_words_library_add_word (library, "frequent", TRUE);
+	frequent_score = gtk_source_completion_words_library_get_score (library, frequent);
+	g_assert_cmpuint (frequent_score, >, recent_score);
+
+	g_assert_cmpuint (gtk_source_completion_words_library_get_score (library, recent), <, recent_score);
 
 	g_object_unref (library);
 }
 
+static void
+check_index_word (GtkSourceCompletionWordsIndex *index,
+		  const gchar                   *word,
+		  guint                          expected_count)
+{
+	guint end;
+	guint pos = gtk_source_completion_words_index_find_prefix (index, word, -1, &end);
+
+	if (expected_count == 0)
+	{
+		g_assert (pos == end ||
+			  strcmp (gtk_source_completion_words_index_get_word (index, pos), word) != 0);
+		return;
+	}
+
+	g_assert_cmpuint (pos, <, end);
+	g_assert_cmpstr (gtk_source_completion_words_index_get_word (index, pos), ==, word);
+	g_assert_cmpuint (gtk_source_completion_words_index_get_count (index, pos), ==, expected_count);
+}
+
+static void
+test_index (void)
+{
+	GtkSourceCompletionWordsIndex *index;
+	GError *error = NULL;
+	gchar *directory;
+	gchar *subdirectory;
+	gchar *file1;
+	gchar *file2;
+	gchar *index_filename;
+	guint pos;
+	guint end;
+	gboolean ok;
+
+	directory = g_dir_make_tmp ("test-completion-words-XXXXXX", &error);
+	g_assert_no_error (error);
+
+	subdirectory = g_build_filename (directory, "src", NULL);
+	g_assert_cmpint (g_mkdir (subdirectory, 0700), ==, 0);
+
+	file1 = g_build_filename (directory, "file1.txt", NULL);
+	file2 = g_build_filename (subdirectory, "file2.c", NULL);
+	index_filename = g_build_filename (directory, ".index", NULL);
+
+	g_file_set_contents (file1, "alpha beta\nalphabet alpha", -1, &error);
+	g_assert_no_error (error);
+	g_file_set_contents (file2, "beta gamma", -1, &error);
+	g_assert_no_error (error);
+
+	ok = gtk_source_completion_words_index_update (index_filename, directory, 2, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	index = gtk_source_completion_words_index_new (index_filename);
+	ok = gtk_source_completion_words_index_load (index, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	g_assert_cmpuint (gtk_source_completion_words_index_get_n_words (index), ==, 4);
+	check_index_word (index, "alpha", 2);
+	check_index_word (index, "beta", 2);
+	check_index_word (index, "gamma", 1);
+
+	pos = gtk_source_completion_words_index_find_prefix (index, "alp", -1, &end);
+	g_assert_cmpuint (end - pos, ==, 2);
+	g_assert_cmpstr (gtk_source_completion_words_index_get_word (index, pos + 1), ==, "alphabet");
+
+	pos = gtk_source_completion_words_index_find_prefix (index, "delta", -1, &end);
+	g_assert_cmpuint (pos, ==, end);
+
+	/* Incremental update: file1 is modified, file2 is reused. */
+	g_file_set_contents (file1, "delta beta beta", -1, &error);
+	g_assert_no_error (error);
+
+	ok = gtk_source_completion_words_index_update (index_filename, directory, 2, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	ok = gtk_source_completion_words_index_load (index, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	g_assert_cmpuint (gtk_source_completion_words_index_get_n_words (index), ==, 3);
+	check_index_word (index, "alpha", 0);
+	check_index_word (index, "beta", 3);
+	check_index_word (index, "delta", 1);
+	check_index_word (index, "gamma", 1);
+
+	g_object_unref (index);
+
+	/* Invalid index */
+	g_file_set_contents (index_filename, "GSVWORDS and garbage", -1, &error);
+	g_assert_no_error (error);
+
+	index = gtk_source_completion_words_index_new (index_filename);
+	ok = gtk_source_completion_words_index_load (index, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+	g_assert (!ok);
+	g_clear_error (&error);
+	g_object_unref (index);
+
+	g_remove (index_filename);
+	g_remove (file1);
+	g_remove (file2);
+	g_rmdir (subdirectory);
+	g_rmdir (directory);
+
+	g_free (index_filename);
+	g_free (file1);
+	g_free (file2);
+	g_free (subdirectory);
+	g_free (directory);
+}
+
+static void
+test_utils_scan_words (void)
+{
+	/* ASCII and non-ASCII characters are mixed, within the words too. */
+	gchar *text = g_strdup ("foo_bar 2abc \303\251t\303\251, x1 "
+				"\316\261\316\262\316\263;d\303\251j\303\240_vu\tz");
+	const gchar *expected_words[] = { "foo_bar",
+					  "\303\251t\303\251",
+					  "x1",
+					  "\316\261\316\262\316\263",
+					  "d\303\251j\303\240_vu" };
+	GSList *words;
+	GSList *item;
+	guint i;
+
+	words = _gtk_source_completion_words_utils_scan_words (text, 2);
+	words = g_slist_reverse (words);
+
+	g_assert_cmpuint (g_slist_length (words), ==, G_N_ELEMENTS (expected_words));
+
+	for (item = words, i = 0; item != NULL; item = g_slist_next (item), i++)
+	{
+		g_assert_cmpstr (item->data, ==, expected_words[i]);
+	}
+
+	g_slist_free_full (words, g_free);
+	g_free (text);
+}
+
+static void
+test_buffer_initial_scan (void)
+{
+	GtkSourceCompletionWordsLibrary *library = gtk_source_completion_words_library_new ();
+	GtkTextBuffer *text_buffer = gtk_text_buffer_new (NULL);
+	GtkSourceCompletionWordsBuffer *words_buffer;
+
+	gtk_text_buffer_set_text (text_buffer, "foo bar foo\nbaz a\n", -1);
+
+	words_buffer = gtk_source_completion_words_buffer_new (library, text_buffer);
+
+	/* The initial scan runs in a thread. */
+	while (gtk_source_completion_words_library_find (library, "foo") == NULL)
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+
+	g_assert (gtk_source_completion_words_library_find (library, "bar") != NULL);
+	g_assert (gtk_source_completion_words_library_find (library, "baz") != NULL);
+	g_assert (gtk_source_completion_words_library_find (library, "a") == NULL);
+
+	/* All the occurrences are removed with the buffer. */
+	g_object_unref (words_buffer);
+
+	g_assert (gtk_source_completion_words_library_find (library, "foo") == NULL);
+	g_assert (gtk_source_completion_words_library_find (library, "bar") == NULL);
+	g_assert (gtk_source_completion_words_library_find (library, "baz") == NULL);
+
+	g_object_unref (text_buffer);
+	g_object_unref (library);
+}
+
+static void
+test_buffer_initial_scan_edits (void)
+{
+	GtkSourceCompletionWordsLibrary *library = gtk_source_completion_words_library_new ();
+	GtkTextBuffer *text_buffer = gtk_text_buffer_new (NULL);
+	GtkSourceCompletionWordsBuffer *words_buffer;
+	const gchar *words[] = { "foo", "baz", "quux", "qux", "zzz" };
+	GtkTextIter start;
+	GtkTextIter end;
+	guint i;
+
+	gtk_text_buffer_set_text (text_buffer, "foo bar\nbaz qux\nzzz\n", -1);
+
+	words_buffer = gtk_source_completion_words_buffer_new (library, text_buffer);
+
+	/* Edit the buffer while the initial scan runs: its result is kept,
+	 * and only the modified lines are scanned again.
+	 */
+	gtk_text_buffer_get_iter_at_line_offset (text_buffer, &start, 0, 3);
+	gtk_text_buffer_get_iter_at_line_offset (text_buffer, &end, 0, 7);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+
+	gtk_text_buffer_get_iter_at_line (text_buffer, &start, 1);
+	gtk_text_buffer_insert (text_buffer, &start, "quux ", -1);
+
+	/* The unmodified line comes from the initial scan. */
+	while (gtk_source_completion_words_library_find (library, "zzz") == NULL)
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+
+	g_assert (gtk_source_completion_words_library_find (library, "bar") == NULL);
+
+	/* The modified lines are scanned afterwards. */
+	while (gtk_source_completion_words_library_find (library, "foo") == NULL ||
+	       gtk_source_completion_words_library_find (library, "quux") == NULL)
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (words); i++)
+	{
+		g_assert (gtk_source_completion_words_library_find (library, words[i]) != NULL);
+	}
+
+	g_assert (gtk_source_completion_words_library_find (library, "bar") == NULL);
+
+	/* Each occurrence has been counted once. */
+	g_object_unref (words_buffer);
+
+	for (i = 0; i < G_N_ELEMENTS (words); i++)
+	{
+		g_assert (gtk_source_completion_words_library_find (library, words[i]) == NULL);
+	}
+
+	g_object_unref (text_buffer);
+	g_object_unref (library);
+}
+
+static void
+find_tree_view (GtkWidget    *widget,
+		GtkTreeView **tree_view)
+{
+	if (GTK_IS_TREE_VIEW (widget))
+	{
+		*tree_view = GTK_TREE_VIEW (widget);
+	}
+	else if (GTK_IS_CONTAINER (widget))
+	{
+		gtk_container_forall (GTK_CONTAINER (widget),
+				      (GtkCallback) find_tree_view,
+				      tree_view);
+	}
+}
+
+/* Returns the labels of the proposals displayed by @completion, separated by
+ * spaces.
+ */
+static gchar *
+get_proposals (GtkSourceCompletion *completion)
+{
+	GtkTreeView *tree_view = NULL;
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	GList *toplevels;
+	GList *l;
+	GString *labels;
+
+	toplevels = gtk_window_list_toplevels ();
+
+	for (l = toplevels; l != NULL && tree_view == NULL; l = l->next)
+	{
+		find_tree_view (l->data, &tree_view);
+	}
+
+	g_list_free (toplevels);
+	g_assert (tree_view != NULL);
+
+	model = gtk_tree_view_get_model (tree_view);
+	labels = g_string_new (NULL);
+
+	if (model != NULL && gtk_tree_model_get_iter_first (model, &iter))
+	{
+		do
+		{
+			GtkSourceCompletionProposal *proposal = NULL;
+			gchar *label;
+
+			gtk_tree_model_get (model, &iter,
+					    GTK_SOURCE_COMPLETION_MODEL_COLUMN_PROPOSAL, &proposal,
+					    -1);
+
+			/* A header */
+			if (proposal == NULL)
+			{
+				continue;
+			}
+
+			label = gtk_source_completion_proposal_get_label (proposal);
+
+			if (labels->len > 0)
+			{
+				g_string_append_c (labels, ' ');
+			}
+
+			g_string_append (labels, label);
+
+			g_free (label);
+			g_object_unref (proposal);
+		}
+		while (gtk_tree_model_iter_next (model, &iter));
+	}
+
+	return g_string_free (labels, FALSE);
+}
+
+static gchar *
+populate (GtkSourceCompletion      *completion,
+	  GtkSourceCompletionWords *words)
+{
+	GtkSourceCompletionContext *context;
+	GList *providers;
+	gchar *proposals;
+
+	context = gtk_source_completion_create_context (completion, NULL);
+	g_object_set (context,
+		      "activation", GTK_SOURCE_COMPLETION_ACTIVATION_USER_REQUESTED,
+		      NULL);
+
+	providers = g_list_append (NULL, words);
+	gtk_source_completion_show (completion, providers, context);
+	g_list_free (providers);
+
+	while (gtk_events_pending ())
+	{
+		gtk_main_iteration ();
+	}
+
+	proposals = get_proposals (completion);
+	gtk_source_completion_hide (completion);
+
+	return proposals;
+}
+
+static void
+test_provider_index (void)
+{
+	GtkWidget *window;
+	GtkSourceView *view;
+	GtkTextBuffer *buffer;
+	GtkSourceCompletion *completion;
+	GtkSourceCompletionWords *words;
+	GError *error = NULL;
+	gchar *directory;
+	gchar *file;
+	gchar *index_filename;
+	gchar *proposals;
+	gboolean ok;
+
+	directory = g_dir_make_tmp ("test-completion-words-XXXXXX", &error);
+	g_assert_no_error (error);
+
+	file = g_build_filename (directory, "file.txt", NULL);
+	index_filename = g_build_filename (directory, ".index", NULL);
+
+	g_file_set_contents (file, "alpha alpha alpha alphabet alpine alb", -1, &error);
+	g_assert_no_error (error);
+
+	ok = gtk_source_completion_words_update_index (index_filename, directory, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+	view = GTK_SOURCE_VIEW (gtk_source_view_new ());
+	gtk_container_add (GTK_CONTAINER (window), GTK_WIDGET (view));
+	gtk_widget_show_all (window);
+
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+	gtk_text_buffer_set_text (buffer, "alphabet alphabet alpha alto\nal", -1);
+
+	completion = gtk_source_view_get_completion (view);
+
+	/* "alb" is in the index, but is too short. */
+	words = gtk_source_completion_words_new (NULL, NULL);
+	g_object_set (words, "minimum-word-size", 4, NULL);
+
+	ok = gtk_source_completion_words_register_index (words, index_filename, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	gtk_source_completion_words_register (words, buffer);
+
+	/* The initial scan of the buffer runs in a thread. */
+	proposals = populate (completion, words);
+
+	while (strstr (proposals, "alto") == NULL)
+	{
+		g_free (proposals);
+		proposals = populate (completion, words);
+	}
+
+	/* The occurrences in the buffer and in the index are added. */
+	g_assert_cmpstr (proposals, ==, "alpha alphabet alto alpine");
+	g_free (proposals);
+
+	gtk_source_completion_words_unregister (words, buffer);
+
+	proposals = populate (completion, words);
+	g_assert_cmpstr (proposals, ==, "alpha alphabet alpine");
+	g_free (proposals);
+
+	gtk_widget_destroy (window);
+	g_object_unref (words);
+
+	g_remove (index_filename);
+	g_remove (file);
+	g_rmdir (directory);
+
+	g_free (index_filename);
+	g_free (file);
+	g_free (directory);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -75,5 +685,29 @@ main (int argc, char **argv)
 	g_test_add_func ("/CompletionWords/library/find",
 			 test_library_find);
 
+	g_test_add_func ("/CompletionWords/library/find-next",
+			 test_library_find_next);
+
+	g_test_add_func ("/CompletionWords/library/remove",
+			 test_library_remove);
+
+	g_test_add_func ("/CompletionWords/library/score",
+			 test_library_score);
+
+	g_test_add_func ("/CompletionWords/index",
+			 test_index);
+
+	g_test_add_func ("/CompletionWords/utils/scan-words",
+			 test_utils_scan_words);
+
+	g_test_add_func ("/CompletionWords/buffer/initial-scan",
+			 test_buffer_initial_scan);
+
+	g_test_add_func ("/CompletionWords/buffer/initial-scan-edits",
+			 test_buffer_initial_scan_edits);
+
+	g_test_add_func ("/CompletionWords/provider/index",
+			 test_provider_index);
+
 	return g_test_run ();
 }
@@ -72,6 +72,21 @@ test_provider_get_priority (GtkSourceCompletionProvider *provider)
 	return ((TestProvider *)provider)->priority;
 }
 
+/* The proposals don't depend on the word under the cursor, so they can not be
+ * narrowed when the word is extended.
+ */
+static gboolean
+test_provider_get_repopulate (GtkSourceCompletionProvider *provider)
+{
+	return TRUE;
+}
+
+static void
+free_proposals (GList *proposals)
+{
+	g_list_free_full (proposals, g_object_unref);
+}
+
 static GList *
 select_random_proposals (GList *all_proposals)
 {
@@ -89,26 +104,64 @@ select_random_proposals (GList *all_proposals)
 	return selection;
 }
 
+/* Simulates an expensive provider, like a ctags index, that runs in a worker
+ * thread. The task data is a copy of the proposals.
+ */
 static void
-test_provider_populate (GtkSourceCompletionProvider *completion_provider,
-                        GtkSourceCompletionContext  *context)
+select_random_proposals_thread (GTask        *task,
+				gpointer      source_object,
+				gpointer      task_data,
+				GCancellable *cancellable)
+{
+	GList *selection;
+
+	g_usleep (G_USEC_PER_SEC / 5);
+
+	if (g_task_return_error_if_cancelled (task))
+	{
+		return;
+	}
+
+	selection = select_random_proposals (task_data);
+	g_list_foreach (selection, (GFunc)g_object_ref, NULL);
+
+	g_task_return_pointer (task, selection, (GDestroyNotify)free_proposals);
+}
+
+static void
+test_provider_populate_async (GtkSourceCompletionProvider *completion_provider,
+			      GtkSourceCompletionContext  *context,
+			      GCancellable                *cancellable,
+			      GAsyncReadyCallback          callback,
+			      gpointer                     user_data)
 {
 	TestProvider *provider = (TestProvider *)completion_provider;
+	GTask *task;
 	GList *proposals;
 
+	task = g_task_new (provider, cancellable, callback, user_data);
+
+	proposals = g_list_copy_deep (provider->proposals, (GCopyFunc)g_object_ref, NULL);
+
 	if (provider->is_random)
 	{
-		proposals = select_random_proposals (provider->proposals);
+		g_task_set_task_data (task, proposals, (GDestroyNotify)free_proposals);
+		g_task_run_in_thread (task, select_random_proposals_thread);
 	}
 	else
 	{
-		proposals = provider->proposals;
+		g_task_return_pointer (task, proposals, (GDestroyNotify)free_proposals);
 	}
 
-	gtk_source_completion_context_add_proposals (context,
-						     completion_provider,
-						     proposals,
-						     TRUE);
+	g_object_unref (task);
+}
+
+static GList *
+test_provider_populate_finish (GtkSourceCompletionProvider  *provider,
+			       GAsyncResult                 *result,
+			       GError                      **error)
+{
+	return g_task_propagate_pointer (G_TASK (result), error);
 }
 
 static GdkPixbuf *
@@ -129,8 +182,10 @@ static void
 test_provider_iface_init (GtkSourceCompletionProviderIface *iface)
 {
 	iface->get_name = test_provider_get_name;
-	iface->populate = test_provider_populate;
+	iface->populate_async = test_provider_populate_async;
+	iface->populate_finish = test_provider_populate_finish;
 	iface->get_priority = test_provider_get_priority;
+	iface->get_repopulate = test_provider_get_repopulate;
 	/* iface->get_icon = test_provider_get_icon; */
 }
 
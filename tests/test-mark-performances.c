@@ -0,0 +1,186 @@
+/*
+ * test-mark-performances.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+
+/* This measures the execution times of the main GtkSourceMark operations, with
+ * a lot of marks (for example diagnostics or code coverage marks): creation in
+ * a random order, moving, navigation, retrieval at each line and removal.
+ * There is one mark per line, and two categories.
+ */
+
+#define NB_MARKS 100000
+
+static const gchar *
+get_category (gint line)
+{
+	return line % 2 == 0 ? "error" : "coverage";
+}
+
+int
+main (int argc, char *argv[])
+{
+	GtkSourceBuffer *buffer;
+	GtkTextBuffer *text_buffer;
+	GtkSourceMark **marks;
+	GString *text;
+	GTimer *timer;
+	GtkTextIter iter;
+	GtkTextIter end;
+	gint *lines;
+	gint nb_found;
+	gint i;
+
+	gtk_init (&argc, &argv);
+
+	buffer = gtk_source_buffer_new (NULL);
+	text_buffer = GTK_TEXT_BUFFER (buffer);
+
+	text = g_string_new (NULL);
+
+	for (i = 0; i < NB_MARKS; i++)
+	{
+		g_string_append (text, "A line of text to fill the text buffer.\n");
+	}
+
+	gtk_text_buffer_set_text (text_buffer, text->str, text->len);
+	g_string_free (text, TRUE);
+
+	/* Shuffle the lines, the marks are not always added in order. */
+	lines = g_new (gint, NB_MARKS);
+
+	for (i = 0; i < NB_MARKS; i++)
+	{
+		lines[i] = i;
+	}
+
+	for (i = NB_MARKS - 1; i > 0; i--)
+	{
+		gint j = g_random_int_range (0, i + 1);
+		gint tmp = lines[i];
+
+		lines[i] = lines[j];
+		lines[j] = tmp;
+	}
+
+	marks = g_new (GtkSourceMark *, NB_MARKS);
+
+	/* Creation */
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < NB_MARKS; i++)
+	{
+		gtk_text_buffer_get_iter_at_line (text_buffer, &iter, lines[i]);
+		marks[i] = gtk_source_buffer_create_source_mark (buffer,
+								 NULL,
+								 get_category (lines[i]),
+								 &iter);
+	}
+
+	g_timer_stop (timer);
+	g_print ("create %d marks in random order: %lf seconds.\n",
+		 NB_MARKS,
+		 g_timer_elapsed (timer, NULL));
+
+	/* Move every mark to the end of its line */
+
+	g_timer_start (timer);
+
+	for (i = 0; i < NB_MARKS; i++)
+	{
+		gtk_text_buffer_get_iter_at_line (text_buffer, &iter, lines[i]);
+		gtk_text_iter_forward_to_line_end (&iter);
+		gtk_text_buffer_move_mark (text_buffer, GTK_TEXT_MARK (marks[i]), &iter);
+	}
+
+	g_timer_stop (timer);
+	g_print ("move %d marks: %lf seconds.\n",
+		 NB_MARKS,
+		 g_timer_elapsed (timer, NULL));
+
+	/* Navigation */
+
+	g_timer_start (timer);
+
+	gtk_text_buffer_get_start_iter (text_buffer, &iter);
+	nb_found = 0;
+
+	while (gtk_source_buffer_forward_iter_to_source_mark (buffer, &iter, "error"))
+	{
+		nb_found++;
+	}
+
+	g_timer_stop (timer);
+	g_print ("forward iteration through %d marks of one category: %lf seconds.\n",
+		 nb_found,
+		 g_timer_elapsed (timer, NULL));
+
+	g_timer_start (timer);
+
+	nb_found = 0;
+
+	for (i = 0; i < NB_MARKS; i++)
+	{
+		if (gtk_source_mark_next (marks[i], NULL) != NULL)
+		{
+			nb_found++;
+		}
+	}
+
+	g_timer_stop (timer);
+	g_print ("gtk_source_mark_next() for each mark: %lf seconds.\n",
+		 g_timer_elapsed (timer, NULL));
+
+	/* Retrieval at each line, like the gutter does */
+
+	g_timer_start (timer);
+
+	for (i = 0; i < NB_MARKS; i++)
+	{
+		GSList *list = gtk_source_buffer_get_source_marks_at_line (buffer, i, NULL);
+		g_slist_free (list);
+	}
+
+	g_timer_stop (timer);
+	g_print ("get the marks at each line: %lf seconds.\n",
+		 g_timer_elapsed (timer, NULL));
+
+	/* Removal */
+
+	g_timer_start (timer);
+
+	gtk_text_buffer_get_bounds (text_buffer, &iter, &end);
+	gtk_source_buffer_remove_source_marks (buffer, &iter, &end, "coverage");
+	gtk_source_buffer_remove_source_marks (buffer, &iter, &end, NULL);
+
+	g_timer_stop (timer);
+	g_print ("remove all the marks: %lf seconds.\n",
+		 g_timer_elapsed (timer, NULL));
+
+	g_timer_destroy (timer);
+	g_free (lines);
+	g_free (marks);
+	g_object_unref (buffer);
+
+	return 0;
+}
@@ -45,6 +45,182 @@ test_add_to_buffer (void)
 	g_object_unref (b);
 }
 
+static void
+test_marks_at_line (void)
+{
+	GtkSourceBuffer *b;
+	GtkTextBuffer *tb;
+	GtkSourceMark *m1, *m2, *m3, *m4;
+	GtkTextIter i;
+	GtkTextIter end;
+	GSList *list;
+
+	b = gtk_source_buffer_new (NULL);
+	tb = GTK_TEXT_BUFFER (b);
+	gtk_text_buffer_set_text (tb, "line 0\nline 1\nline 2\n", -1);
+
+	/* Added out of order. */
+	gtk_text_buffer_get_iter_at_line_offset (tb, &i, 1, 3);
+	m1 = gtk_source_buffer_create_source_mark (b, NULL, "test", &i);
+	gtk_text_buffer_get_iter_at_line (tb, &i, 2);
+	m2 = gtk_source_buffer_create_source_mark (b, NULL, "test", &i);
+	gtk_text_buffer_get_iter_at_line (tb, &i, 1);
+	m3 = gtk_source_buffer_create_source_mark (b, NULL, "test2", &i);
+	gtk_text_buffer_get_iter_at_line (tb, &i, 0);
+	m4 = gtk_source_buffer_create_source_mark (b, NULL, "test", &i);
+
+	list = gtk_source_buffer_get_source_marks_at_line (b, 1, NULL);
+	g_assert_cmpint (g_slist_length (list), ==, 2);
+	g_assert (list->data == m3);
+	g_assert (list->next->data == m1);
+	g_slist_free (list);
+
+	list = gtk_source_buffer_get_source_marks_at_line (b, 1, "test");
+	g_assert_cmpint (g_slist_length (list), ==, 1);
+	g_assert (list->data == m1);
+	g_slist_free (list);
+
+	g_assert (m1 == gtk_source_mark_next (m4, "test"));
+	g_assert (m3 == gtk_source_mark_next (m4, "test2"));
+	g_assert (m1 == gtk_source_mark_next (m3, "test"));
+	g_assert (m4 == gtk_source_mark_prev (m3, "test"));
+
+	gtk_text_buffer_get_start_iter (tb, &i);
+	g_assert (gtk_source_buffer_forward_iter_to_source_mark (b, &i, "test"));
+	g_assert_cmpint (gtk_text_iter_get_line (&i), ==, 1);
+	g_assert_cmpint (gtk_text_iter_get_line_offset (&i), ==, 3);
+	g_assert (gtk_source_buffer_backward_iter_to_source_mark (b, &i, NULL));
+	g_assert_cmpint (gtk_text_iter_get_line (&i), ==, 1);
+	g_assert_cmpint (gtk_text_iter_get_line_offset (&i), ==, 0);
+
+	/* Moving a mark keeps the order. */
+	gtk_text_buffer_get_iter_at_line (tb, &i, 2);
+	gtk_text_iter_forward_to_line_end (&i);
+	gtk_text_buffer_move_mark (tb, GTK_TEXT_MARK (m4), &i);
+	g_assert (m4 == gtk_source_mark_next (m2, NULL));
+
+	gtk_text_buffer_get_bounds (tb, &i, &end);
+	gtk_source_buffer_remove_source_marks (b, &i, &end, "test");
+	list = gtk_source_buffer_get_source_marks_at_line (b, 1, NULL);
+	g_assert_cmpint (g_slist_length (list), ==, 1);
+	g_assert (list->data == m3);
+	g_slist_free (list);
+	g_assert (NULL == gtk_source_mark_next (m3, "test"));
+
+	g_object_unref (b);
+}
+
+static void
+test_next_prev_other_category (void)
+{
+	GtkSourceBuffer *b;
+	GtkTextBuffer *tb;
+	GtkSourceMark *m1, *m2, *m3;
+	GtkTextIter i;
+
+	b = gtk_source_buffer_new (NULL);
+	tb = GTK_TEXT_BUFFER (b);
+	gtk_text_buffer_set_text (tb, "line 0\nline 1\nline 2", -1);
+
+	gtk_text_buffer_get_iter_at_line (tb, &i, 1);
+	m1 = gtk_source_buffer_create_source_mark (b, NULL, "bookmark", &i);
+	gtk_text_buffer_get_iter_at_line (tb, &i, 2);
+	m2 = gtk_source_buffer_create_source_mark (b, NULL, "error", &i);
+
+	g_assert (m2 == gtk_source_mark_next (m1, "error"));
+	g_assert (m2 == gtk_source_mark_next (m1, "error"));
+	g_assert (NULL == gtk_source_mark_prev (m1, "error"));
+	g_assert (NULL == gtk_source_mark_prev (m1, "error"));
+
+	/* After adding a mark... */
+	gtk_text_buffer_get_iter_at_line (tb, &i, 0);
+	m3 = gtk_source_buffer_create_source_mark (b, NULL, "error", &i);
+	g_assert (m3 == gtk_source_mark_prev (m1, "error"));
+	g_assert (m2 == gtk_source_mark_next (m1, "error"));
+
+	/* ...or moved. */
+	gtk_text_buffer_get_end_iter (tb, &i);
+	gtk_text_buffer_move_mark (tb, GTK_TEXT_MARK (m3), &i);
+	g_assert (NULL == gtk_source_mark_prev (m1, "error"));
+	g_assert (m2 == gtk_source_mark_next (m1, "error"));
+
+	gtk_text_buffer_delete_mark (tb, GTK_TEXT_MARK (m2));
+	g_assert (m3 == gtk_source_mark_next (m1, "error"));
+
+	g_object_unref (b);
+}
+
+static void
+source_mark_updated_cb (GtkSourceBuffer *buffer,
+			GtkSourceMark   *mark,
+			gint            *count)
+{
+	(*count)++;
+}
+
+static void
+source_marks_updated_cb (GtkSourceBuffer *buffer,
+			 GtkTextIter     *start,
+			 GtkTextIter     *end,
+			 gint            *count)
+{
+	(*count)++;
+}
+
+static void
+test_bulk (void)
+{
+	GtkSourceBuffer *b;
+	GtkTextBuffer *tb;
+	GtkTextIter start;
+	GtkTextIter end;
+	GSList *marks;
+	GSList *list;
+	gint lines[] = { 3, 0, 2 };
+	gint nb_mark_updated = 0;
+	gint nb_marks_updated = 0;
+
+	b = gtk_source_buffer_new (NULL);
+	tb = GTK_TEXT_BUFFER (b);
+	gtk_text_buffer_set_text (tb, "line 0\nline 1\nline 2\nline 3", -1);
+
+	g_signal_connect (b, "source-mark-updated",
+			  G_CALLBACK (source_mark_updated_cb), &nb_mark_updated);
+	g_signal_connect (b, "source-marks-updated",
+			  G_CALLBACK (source_marks_updated_cb), &nb_marks_updated);
+
+	marks = gtk_source_buffer_create_source_marks (b, "test", lines, G_N_ELEMENTS (lines));
+	g_assert_cmpint (g_slist_length (marks), ==, 3);
+	g_assert_cmpint (nb_mark_updated, ==, 0);
+	g_assert_cmpint (nb_marks_updated, ==, 1);
+
+	/* Sorted by line. */
+	g_assert (gtk_source_mark_next (marks->data, "test") == marks->next->data);
+	gtk_text_buffer_get_iter_at_mark (tb, &start, marks->next->next->data);
+	g_assert_cmpint (gtk_text_iter_get_line (&start), ==, 3);
+	g_slist_free (marks);
+
+	list = gtk_source_buffer_get_source_marks_at_line (b, 2, "test");
+	g_assert_cmpint (g_slist_length (list), ==, 1);
+	g_slist_free (list);
+
+	/* The removal still emits one signal per mark. */
+	gtk_text_buffer_get_bounds (tb, &start, &end);
+	gtk_source_buffer_remove_source_marks (b, &start, &end, NULL);
+	g_assert_cmpint (nb_mark_updated, ==, 3);
+	g_assert_cmpint (nb_marks_updated, ==, 1);
+
+	gtk_text_buffer_get_start_iter (tb, &start);
+	g_assert (!gtk_source_buffer_forward_iter_to_source_mark (b, &start, NULL));
+
+	/* Outside a bulk operation, one signal per mark. */
+	gtk_source_buffer_create_source_mark (b, NULL, "test", &start);
+	g_assert_cmpint (nb_mark_updated, ==, 4);
+	g_assert_cmpint (nb_marks_updated, ==, 1);
+
+	g_object_unref (b);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -52,6 +228,9 @@ main (int argc, char** argv)
 
 	g_test_add_func ("/Mark/create", test_create);
 	g_test_add_func ("/Mark/add-to-buffer", test_add_to_buffer);
+	g_test_add_func ("/Mark/marks-at-line", test_marks_at_line);
+	g_test_add_func ("/Mark/bulk", test_bulk);
+	g_test_add_func ("/Mark/next-prev-other-category", test_next_prev_other_category);
 
 	return g_test_run();
 }
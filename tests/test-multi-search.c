@@ -0,0 +1,246 @@
+/*
+ * test-multi-search.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+
+typedef struct
+{
+	GtkSourceBuffer *buffer1;
+	GtkSourceBuffer *buffer2;
+
+	gint nb_matches_buffer1;
+	gint nb_matches_buffer2;
+
+	/* Check the first match of buffer2. */
+	gint first_offset;
+	gint first_line;
+	gchar *first_preview;
+
+	gint total;
+	gboolean finished;
+	gboolean cancelled;
+} TestData;
+
+static void
+match_found_cb (GtkSourceMultiSearch *search,
+		GtkSourceBuffer      *buffer,
+		gint                  offset,
+		gint                  length,
+		gint                  line,
+		const gchar          *preview,
+		TestData             *data)
+{
+	g_assert_cmpint (length, ==, 3);
+
+	if (buffer == data->buffer1)
+	{
+		data->nb_matches_buffer1++;
+	}
+	else if (buffer == data->buffer2)
+	{
+		if (data->nb_matches_buffer2 == 0)
+		{
+			data->first_offset = offset;
+			data->first_line = line;
+			data->first_preview = g_strdup (preview);
+		}
+
+		data->nb_matches_buffer2++;
+	}
+	else
+	{
+		g_assert_not_reached ();
+	}
+}
+
+static void
+run_finished_cb (GtkSourceMultiSearch *search,
+		 GAsyncResult         *result,
+		 TestData             *data)
+{
+	GError *error = NULL;
+
+	data->total = gtk_source_multi_search_run_finish (search, result, &error);
+
+	if (error != NULL)
+	{
+		data->cancelled = g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+		g_error_free (error);
+	}
+
+	data->finished = TRUE;
+}
+
+static void
+wait_finished (TestData *data)
+{
+	while (!data->finished)
+	{
+		gtk_main_iteration ();
+	}
+}
+
+static void
+test_run (void)
+{
+	GtkSourceSearchSettings *settings = gtk_source_search_settings_new ();
+	GtkSourceMultiSearch *search = gtk_source_multi_search_new (settings);
+	TestData data = { 0 };
+
+	data.buffer1 = gtk_source_buffer_new (NULL);
+	data.buffer2 = gtk_source_buffer_new (NULL);
+
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (data.buffer1), "foo bar\nFoo foo", -1);
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (data.buffer2), "bar\r\nbar éfoo\n", -1);
+
+	gtk_source_multi_search_add_buffer (search, data.buffer1);
+	gtk_source_multi_search_add_buffer (search, data.buffer2);
+	gtk_source_multi_search_add_buffer (search, data.buffer2);
+
+	gtk_source_search_settings_set_search_text (settings, "foo");
+
+	g_signal_connect (search, "match-found", G_CALLBACK (match_found_cb), &data);
+
+	gtk_source_multi_search_run_async (search,
+					   NULL,
+					   (GAsyncReadyCallback)run_finished_cb,
+					   &data);
+	wait_finished (&data);
+
+	g_assert_cmpint (data.total, ==, 4);
+	g_assert_cmpint (data.nb_matches_buffer1, ==, 3);
+	g_assert_cmpint (data.nb_matches_buffer2, ==, 1);
+	g_assert_cmpint (data.first_offset, ==, 10);
+	g_assert_cmpint (data.first_line, ==, 1);
+	g_assert_cmpstr (data.first_preview, ==, "bar éfoo");
+
+	/* Case sensitive, only in buffer1. */
+	gtk_source_search_settings_set_case_sensitive (settings, TRUE);
+	gtk_source_multi_search_remove_buffer (search, data.buffer2);
+
+	data.finished = FALSE;
+	data.nb_matches_buffer1 = 0;
+	data.nb_matches_buffer2 = 0;
+
+	gtk_source_multi_search_run_async (search,
+					   NULL,
+					   (GAsyncReadyCallback)run_finished_cb,
+					   &data);
+	wait_finished (&data);
+
+	g_assert_cmpint (data.total, ==, 2);
+	g_assert_cmpint (data.nb_matches_buffer1, ==, 2);
+	g_assert_cmpint (data.nb_matches_buffer2, ==, 0);
+
+	g_free (data.first_preview);
+	g_object_unref (data.buffer1);
+	g_object_unref (data.buffer2);
+	g_object_unref (search);
+	g_object_unref (settings);
+}
+
+static void
+test_cancel (void)
+{
+	GtkSourceMultiSearch *search = gtk_source_multi_search_new (NULL);
+	GtkSourceSearchSettings *settings = gtk_source_multi_search_get_settings (search);
+	GCancellable *cancellable = g_cancellable_new ();
+	TestData data = { 0 };
+
+	data.buffer1 = gtk_source_buffer_new (NULL);
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (data.buffer1), "foo foo foo", -1);
+	gtk_source_multi_search_add_buffer (search, data.buffer1);
+	gtk_source_search_settings_set_search_text (settings, "foo");
+
+	g_signal_connect (search, "match-found", G_CALLBACK (match_found_cb), &data);
+
+	gtk_source_multi_search_run_async (search,
+					   cancellable,
+					   (GAsyncReadyCallback)run_finished_cb,
+					   &data);
+	g_cancellable_cancel (cancellable);
+	wait_finished (&data);
+
+	g_assert (data.cancelled);
+	g_assert_cmpint (data.nb_matches_buffer1, ==, 0);
+
+	g_object_unref (cancellable);
+	g_object_unref (data.buffer1);
+	g_object_unref (search);
+}
+
+static void
+test_buffer_modified (void)
+{
+	GtkSourceMultiSearch *search = gtk_source_multi_search_new (NULL);
+	GtkSourceSearchSettings *settings = gtk_source_multi_search_get_settings (search);
+	TestData data = { 0 };
+	GtkTextIter iter;
+
+	data.buffer1 = gtk_source_buffer_new (NULL);
+	data.buffer2 = gtk_source_buffer_new (NULL);
+
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (data.buffer1), "foo foo foo", -1);
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (data.buffer2), "bar foo", -1);
+
+	gtk_source_multi_search_add_buffer (search, data.buffer1);
+	gtk_source_multi_search_add_buffer (search, data.buffer2);
+	gtk_source_search_settings_set_search_text (settings, "foo");
+
+	g_signal_connect (search, "match-found", G_CALLBACK (match_found_cb), &data);
+
+	gtk_source_multi_search_run_async (search,
+					   NULL,
+					   (GAsyncReadyCallback)run_finished_cb,
+					   &data);
+
+	/* The matches are emitted in the main loop, so none of buffer1 is
+	 * emitted: their offsets would refer to the old contents.
+	 */
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (data.buffer1), &iter);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (data.buffer1), &iter, "x", -1);
+
+	wait_finished (&data);
+
+	g_assert (!data.cancelled);
+	g_assert_cmpint (data.total, ==, 1);
+	g_assert_cmpint (data.nb_matches_buffer1, ==, 0);
+	g_assert_cmpint (data.nb_matches_buffer2, ==, 1);
+	g_assert_cmpint (data.first_offset, ==, 4);
+
+	g_free (data.first_preview);
+	g_object_unref (data.buffer1);
+	g_object_unref (data.buffer2);
+	g_object_unref (search);
+}
+
+int
+main (int argc, char **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/MultiSearch/run", test_run);
+	g_test_add_func ("/MultiSearch/cancel", test_cancel);
+	g_test_add_func ("/MultiSearch/buffer-modified", test_buffer_modified);
+
+	return g_test_run ();
+}
@@ -0,0 +1,246 @@
+/*
+ * test-search-benchmark.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+#include "benchmark-utils.h"
+
+/* Benchmark of GtkSourceSearchContext, to detect performance regressions.
+ *
+ * For each buffer size (the number of lines is multiplied by 10 between
+ * --min-lines and --max-lines) and for each kind of search (literal, case
+ * insensitive, at word boundaries and regex), this measures:
+ * - the time to find the first match with an asynchronous forward search;
+ * - the time to count all the occurrences (the whole buffer is scanned);
+ * - the time of a replace-all;
+ * - the memory used by the search context, i.e. the increase of the resident
+ *   set size after the full count (Linux only, -1 elsewhere).
+ *
+ * The results are printed on stdout, one line per measurement, as CSV with a
+ * header. The times are in milliseconds, the memory in kilobytes.
+ */
+
+/* One line out of NEEDLE_INTERVAL contains the needle. */
+#define NEEDLE_INTERVAL 100
+
+typedef struct
+{
+	const gchar *name;
+	const gchar *search_text;
+	gboolean case_sensitive;
+	gboolean at_word_boundaries;
+	gboolean regex_enabled;
+} SearchMode;
+
+/* All the modes match exactly "needle", so replacing the occurrences by
+ * "needle" doesn't modify the buffer content, and the buffer can be reused.
+ */
+static const SearchMode modes[] =
+{
+	{ "literal", "needle", TRUE, FALSE, FALSE },
+	{ "case-insensitive", "NEEDLE", FALSE, FALSE, FALSE },
+	{ "whole-word", "needle", TRUE, TRUE, FALSE },
+	{ "regex", "ne+dle", TRUE, FALSE, TRUE }
+};
+
+static gint min_lines = 1000;
+static gint max_lines = 1000000;
+static gboolean skip_replace = FALSE;
+
+static GOptionEntry entries[] =
+{
+	{ "min-lines", 0, 0, G_OPTION_ARG_INT, &min_lines,
+	  "Number of lines of the smallest buffer (default: 1000)", "N" },
+	{ "max-lines", 0, 0, G_OPTION_ARG_INT, &max_lines,
+	  "Number of lines of the biggest buffer (default: 1000000)", "N" },
+	{ "skip-replace", 0, 0, G_OPTION_ARG_NONE, &skip_replace,
+	  "Don't measure replace-all", NULL },
+	{ NULL }
+};
+
+static void
+fill_buffer (GtkTextBuffer *buffer,
+	     gint           nb_lines)
+{
+	GString *text = g_string_new (NULL);
+	gint i;
+
+	for (i = 0; i < nb_lines; i++)
+	{
+		if (i % NEEDLE_INTERVAL == NEEDLE_INTERVAL / 2)
+		{
+			g_string_append (text, "The needle is in this line, needles are not whole words.\n");
+		}
+		else
+		{
+			g_string_append (text, "A line of text to fill the text buffer. Is it long enough?\n");
+		}
+	}
+
+	gtk_text_buffer_set_text (buffer, text->str, text->len);
+	g_string_free (text, TRUE);
+}
+
+static void
+forward_search_finished_cb (GtkSourceSearchContext *context,
+			    GAsyncResult           *result,
+			    gboolean               *finished)
+{
+	gtk_source_search_context_forward_finish (context, result, NULL, NULL, NULL);
+	*finished = TRUE;
+}
+
+static void
+run_benchmark (GtkSourceBuffer  *buffer,
+	       gint              nb_lines,
+	       const SearchMode *mode)
+{
+	GtkSourceSearchSettings *settings;
+	GtkSourceSearchContext *context;
+	GtkTextIter start;
+	GTimer *timer;
+	gdouble first_match_time;
+	gdouble full_count_time;
+	gdouble replace_all_time = -1.0;
+	gboolean finished = FALSE;
+	glong memory_before;
+	glong memory_after;
+	glong memory = -1;
+	gint count;
+
+	memory_before = benchmark_get_resident_memory ();
+
+	settings = gtk_source_search_settings_new ();
+	gtk_source_search_settings_set_case_sensitive (settings, mode->case_sensitive);
+	gtk_source_search_settings_set_at_word_boundaries (settings, mode->at_word_boundaries);
+	gtk_source_search_settings_set_regex_enabled (settings, mode->regex_enabled);
+	gtk_source_search_settings_set_wrap_around (settings, FALSE);
+
+	context = gtk_source_search_context_new (buffer, settings);
+
+	timer = g_timer_new ();
+
+	gtk_source_search_settings_set_search_text (settings, mode->search_text);
+
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (buffer), &start);
+	gtk_source_search_context_forward_async (context,
+						 &start,
+						 NULL,
+						 (GAsyncReadyCallback)forward_search_finished_cb,
+						 &finished);
+
+	while (!finished)
+	{
+		gtk_main_iteration ();
+	}
+
+	first_match_time = g_timer_elapsed (timer, NULL);
+
+	while (gtk_source_search_context_get_occurrences_count (context) == -1)
+	{
+		gtk_main_iteration ();
+	}
+
+	full_count_time = g_timer_elapsed (timer, NULL);
+	count = gtk_source_search_context_get_occurrences_count (context);
+
+	memory_after = benchmark_get_resident_memory ();
+
+	if (memory_before != -1 && memory_after != -1)
+	{
+		memory = memory_after - memory_before;
+	}
+
+	if (!skip_replace)
+	{
+		g_timer_start (timer);
+		gtk_source_search_context_replace_all (context, "needle", -1);
+		replace_all_time = g_timer_elapsed (timer, NULL);
+	}
+
+	g_print ("%s,%d,%d,%.3lf,%.3lf,%.3lf,%ld\n",
+		 mode->name,
+		 nb_lines,
+		 count,
+		 first_match_time * 1000.0,
+		 full_count_time * 1000.0,
+		 replace_all_time * 1000.0,
+		 memory);
+
+	g_timer_destroy (timer);
+	g_object_unref (context);
+	g_object_unref (settings);
+}
+
+int
+main (int argc, char *argv[])
+{
+	GOptionContext *option_context;
+	GError *error = NULL;
+	gint nb_lines;
+
+	option_context = g_option_context_new ("- benchmark of GtkSourceSearchContext");
+	g_option_context_add_main_entries (option_context, entries, NULL);
+	g_option_context_add_group (option_context, gtk_get_option_group (TRUE));
+
+	if (!g_option_context_parse (option_context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return EXIT_FAILURE;
+	}
+
+	g_option_context_free (option_context);
+
+	if (min_lines < 1 || max_lines < min_lines)
+	{
+		g_printerr ("Invalid number of lines.\n");
+		return EXIT_FAILURE;
+	}
+
+	g_print ("mode,nb_lines,occurrences,first_match_ms,full_count_ms,replace_all_ms,memory_kb\n");
+
+	for (nb_lines = min_lines; nb_lines <= max_lines; nb_lines *= 10)
+	{
+		GtkSourceBuffer *buffer = gtk_source_buffer_new (NULL);
+		guint i;
+
+		/* The undo history would be measured too. */
+		gtk_source_buffer_set_max_undo_levels (buffer, 0);
+
+		fill_buffer (GTK_TEXT_BUFFER (buffer), nb_lines);
+
+		for (i = 0; i < G_N_ELEMENTS (modes); i++)
+		{
+			run_benchmark (buffer, nb_lines, &modes[i]);
+		}
+
+		g_object_unref (buffer);
+
+		/* Avoid an overflow. */
+		if (nb_lines > G_MAXINT / 10)
+		{
+			break;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
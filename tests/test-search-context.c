@@ -255,6 +255,59 @@ test_occurrences_count_with_delete (void)
 	g_object_unref (context);
 }
 
+static void
+test_occurrences_count_with_batch_edit (void)
+{
+	GtkSourceBuffer *source_buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (source_buffer);
+	GtkSourceSearchSettings *settings = gtk_source_search_settings_new ();
+	GtkSourceSearchContext *context = gtk_source_search_context_new (source_buffer, settings);
+	GtkTextIter start;
+	GtkTextIter end;
+	gint occurrences_count;
+
+	gtk_source_search_settings_set_search_text (settings, "foo");
+
+	gtk_text_buffer_set_text (text_buffer, "foo fo o foo", -1);
+	flush_queue ();
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 2);
+
+	gtk_source_buffer_begin_batch_edit (source_buffer);
+
+	/* Contents: "foo fo[ ]o foo" -> "foo foo foo", a new occurrence. */
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &start, 6);
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &end, 7);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+
+	/* Contents: "[f]oo foo foo" -> "oo foo foo" */
+	gtk_text_buffer_get_start_iter (text_buffer, &start);
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &end, 1);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+
+	/* An occurrence inserted and removed during the batch edit. */
+	gtk_text_buffer_get_start_iter (text_buffer, &start);
+	gtk_text_buffer_insert (text_buffer, &start, "foo", -1);
+
+	gtk_text_buffer_get_start_iter (text_buffer, &start);
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &end, 3);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+
+	gtk_text_buffer_get_end_iter (text_buffer, &end);
+	gtk_text_buffer_insert (text_buffer, &end, "bar", -1);
+
+	gtk_source_buffer_end_batch_edit (source_buffer);
+
+	/* Contents: "oo foo foobar" */
+	flush_queue ();
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 2);
+
+	g_object_unref (source_buffer);
+	g_object_unref (settings);
+	g_object_unref (context);
+}
+
 static void
 test_occurrences_count_multiple_lines (void)
 {
@@ -744,6 +797,281 @@ test_async_backward_search_wrap_around (void)
 	g_object_unref (context);
 }
 
+typedef struct
+{
+	gint nb_finished;
+	gboolean first_cancelled;
+	gboolean second_found;
+	gboolean third_found;
+	gint third_match_start;
+	gint nb_scanned_chars;
+	gint nb_total_chars;
+} MultipleAsyncData;
+
+static void
+multiple_async_first_cb (GtkSourceSearchContext *context,
+			 GAsyncResult           *result,
+			 MultipleAsyncData      *data)
+{
+	GError *error = NULL;
+
+	gtk_source_search_context_forward_finish (context, result, NULL, NULL, &error);
+
+	data->first_cancelled = g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_clear_error (&error);
+	data->nb_finished++;
+}
+
+static void
+multiple_async_second_cb (GtkSourceSearchContext *context,
+			  GAsyncResult           *result,
+			  MultipleAsyncData      *data)
+{
+	data->second_found = gtk_source_search_context_forward_finish (context, result, NULL, NULL, NULL);
+	data->nb_finished++;
+}
+
+static void
+multiple_async_third_cb (GtkSourceSearchContext *context,
+			 GAsyncResult           *result,
+			 MultipleAsyncData      *data)
+{
+	GtkTextIter match_start;
+
+	data->third_found = gtk_source_search_context_backward_finish (context,
+								       result,
+								       &match_start,
+								       NULL,
+								       NULL);
+
+	if (data->third_found)
+	{
+		data->third_match_start = gtk_text_iter_get_offset (&match_start);
+	}
+
+	data->nb_finished++;
+}
+
+static void
+multiple_async_progress_cb (gint               nb_scanned_chars,
+			    gint               nb_total_chars,
+			    MultipleAsyncData *data)
+{
+	g_assert_cmpint (nb_scanned_chars, <=, nb_total_chars);
+
+	data->nb_scanned_chars = nb_scanned_chars;
+	data->nb_total_chars = nb_total_chars;
+}
+
+static void
+test_async_multiple_requests (void)
+{
+	GtkSourceBuffer *source_buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (source_buffer);
+	GtkSourceSearchSettings *settings = gtk_source_search_settings_new ();
+	GtkSourceSearchContext *context = gtk_source_search_context_new (source_buffer, settings);
+	GCancellable *cancellable = g_cancellable_new ();
+	MultipleAsyncData data = { 0 };
+	GtkTextIter iter;
+
+	gtk_text_buffer_set_text (text_buffer, "aaaa", -1);
+	gtk_source_search_settings_set_search_text (settings, "aa");
+	gtk_source_search_settings_set_wrap_around (settings, FALSE);
+
+	/* The three requests are running at the same time, the first one is
+	 * cancelled.
+	 */
+	gtk_text_buffer_get_start_iter (text_buffer, &iter);
+	gtk_source_search_context_forward_async_full (context,
+						      &iter,
+						      G_PRIORITY_LOW,
+						      cancellable,
+						      NULL, NULL, NULL,
+						      (GAsyncReadyCallback)multiple_async_first_cb,
+						      &data);
+
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &iter, 3);
+	gtk_source_search_context_forward_async (context,
+						 &iter,
+						 NULL,
+						 (GAsyncReadyCallback)multiple_async_second_cb,
+						 &data);
+
+	gtk_text_buffer_get_end_iter (text_buffer, &iter);
+	gtk_source_search_context_backward_async_full (context,
+						       &iter,
+						       G_PRIORITY_HIGH,
+						       NULL,
+						       (GtkSourceSearchProgressCallback)multiple_async_progress_cb,
+						       &data,
+						       NULL,
+						       (GAsyncReadyCallback)multiple_async_third_cb,
+						       &data);
+
+	g_cancellable_cancel (cancellable);
+
+	while (data.nb_finished < 3)
+	{
+		gtk_main_iteration ();
+	}
+
+	g_assert (data.first_cancelled);
+	g_assert (!data.second_found);
+	g_assert (data.third_found);
+	g_assert_cmpint (data.third_match_start, ==, 2);
+	g_assert_cmpint (data.nb_total_chars, ==, 4);
+	g_assert_cmpint (data.nb_scanned_chars, ==, 4);
+
+	g_object_unref (cancellable);
+	g_object_unref (source_buffer);
+	g_object_unref (settings);
+	g_object_unref (context);
+}
+
+typedef struct
+{
+	gint finish_order[3];
+	gint nb_finished;
+} PriorityAsyncData;
+
+typedef struct
+{
+	PriorityAsyncData *data;
+	gint request_num;
+} PriorityRequest;
+
+static void
+priority_async_cb (GtkSourceSearchContext *context,
+		   GAsyncResult           *result,
+		   PriorityRequest        *request)
+{
+	PriorityAsyncData *data = request->data;
+	gboolean found;
+
+	found = gtk_source_search_context_forward_finish (context, result, NULL, NULL, NULL);
+	g_assert (found);
+
+	data->finish_order[data->nb_finished] = request->request_num;
+	data->nb_finished++;
+}
+
+/* The requests need to scan the whole buffer. The request with the highest
+ * priority is served first, and the requests with the same priority in the
+ * order of creation.
+ */
+static void
+test_async_priorities (void)
+{
+	GtkSourceBuffer *source_buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (source_buffer);
+	GtkSourceSearchSettings *settings = gtk_source_search_settings_new ();
+	GtkSourceSearchContext *context = gtk_source_search_context_new (source_buffer, settings);
+	PriorityAsyncData data = { { 0 } };
+	PriorityRequest requests[3];
+	gint priorities[3] = { G_PRIORITY_LOW, G_PRIORITY_DEFAULT, G_PRIORITY_HIGH };
+	GtkTextIter iter;
+	gint i;
+
+	for (i = 0; i < 1000; i++)
+	{
+		gtk_text_buffer_get_end_iter (text_buffer, &iter);
+		gtk_text_buffer_insert (text_buffer, &iter, "line\n", -1);
+	}
+
+	gtk_text_buffer_get_end_iter (text_buffer, &iter);
+	gtk_text_buffer_insert (text_buffer, &iter, "needle", -1);
+
+	gtk_source_search_settings_set_search_text (settings, "needle");
+	gtk_source_search_settings_set_wrap_around (settings, FALSE);
+
+	for (i = 0; i < 3; i++)
+	{
+		requests[i].data = &data;
+		requests[i].request_num = i;
+
+		gtk_text_buffer_get_start_iter (text_buffer, &iter);
+		gtk_source_search_context_forward_async_full (context,
+							      &iter,
+							      priorities[i],
+							      NULL,
+							      NULL, NULL, NULL,
+							      (GAsyncReadyCallback)priority_async_cb,
+							      &requests[i]);
+	}
+
+	while (data.nb_finished < 3)
+	{
+		gtk_main_iteration ();
+	}
+
+	g_assert_cmpint (data.finish_order[0], ==, 2);
+	g_assert_cmpint (data.finish_order[1], ==, 1);
+	g_assert_cmpint (data.finish_order[2], ==, 0);
+
+	g_object_unref (source_buffer);
+	g_object_unref (settings);
+	g_object_unref (context);
+}
+
+static void
+modified_search_async_cb (GtkSourceSearchContext *context,
+			  GAsyncResult           *result,
+			  gboolean               *cancelled)
+{
+	GError *error = NULL;
+
+	gtk_source_search_context_forward_finish (context, result, NULL, NULL, &error);
+
+	*cancelled = g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_clear_error (&error);
+}
+
+/* When the search is modified, the running requests return
+ * G_IO_ERROR_CANCELLED, even without a cancellable. The cancellable of the
+ * caller is not cancelled.
+ */
+static void
+test_async_search_modified (void)
+{
+	GtkSourceBuffer *source_buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (source_buffer);
+	GtkSourceSearchSettings *settings = gtk_source_search_settings_new ();
+	GtkSourceSearchContext *context = gtk_source_search_context_new (source_buffer, settings);
+	GCancellable *cancellable = g_cancellable_new ();
+	gboolean cancelled[2] = { FALSE, FALSE };
+	GtkTextIter iter;
+
+	gtk_text_buffer_set_text (text_buffer, "aaaa", -1);
+	gtk_source_search_settings_set_search_text (settings, "aa");
+
+	gtk_text_buffer_get_start_iter (text_buffer, &iter);
+	gtk_source_search_context_forward_async (context,
+						 &iter,
+						 NULL,
+						 (GAsyncReadyCallback)modified_search_async_cb,
+						 &cancelled[0]);
+
+	gtk_source_search_context_forward_async (context,
+						 &iter,
+						 cancellable,
+						 (GAsyncReadyCallback)modified_search_async_cb,
+						 &cancelled[1]);
+
+	gtk_source_search_settings_set_search_text (settings, "b");
+
+	while (!cancelled[0] || !cancelled[1])
+	{
+		gtk_main_iteration ();
+	}
+
+	g_assert (!g_cancellable_is_cancelled (cancellable));
+
+	g_object_unref (cancellable);
+	g_object_unref (source_buffer);
+	g_object_unref (settings);
+	g_object_unref (context);
+}
+
 static void
 test_highlight (void)
 {
@@ -765,6 +1093,215 @@ test_highlight (void)
 	g_object_unref (context2);
 }
 
+/* The search text is typed character by character, and then removed. The
+ * occurrences must be the same as with a full scan of the buffer.
+ */
+static void
+test_incremental_search (void)
+{
+	GtkSourceBuffer *source_buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (source_buffer);
+	GtkSourceSearchSettings *settings = gtk_source_search_settings_new ();
+	GtkSourceSearchContext *context = gtk_source_search_context_new (source_buffer, settings);
+	GtkTextIter iter;
+	GtkTextIter match_start;
+	GtkTextIter match_end;
+	gint occurrences_count;
+	gint offset;
+
+	gtk_text_buffer_set_text (text_buffer, "aaab aab", -1);
+
+	gtk_source_search_settings_set_search_text (settings, "a");
+	flush_queue ();
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 5);
+
+	gtk_source_search_settings_set_search_text (settings, "aa");
+	flush_queue ();
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 2);
+
+	/* The first occurrence doesn't start at an occurrence of "aa". */
+	gtk_source_search_settings_set_search_text (settings, "aab");
+	flush_queue ();
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 2);
+
+	gtk_text_buffer_get_start_iter (text_buffer, &iter);
+	gtk_source_search_context_forward (context, &iter, &match_start, &match_end);
+	offset = gtk_text_iter_get_offset (&match_start);
+	g_assert_cmpint (offset, ==, 1);
+
+	gtk_source_search_settings_set_search_text (settings, "aabx");
+	flush_queue ();
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 0);
+
+	/* From the history. */
+	gtk_source_search_settings_set_search_text (settings, "aab");
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 2);
+
+	gtk_source_search_settings_set_search_text (settings, "aa");
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 2);
+
+	gtk_source_search_settings_set_search_text (settings, "a");
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 5);
+
+	/* The history is cleared when the buffer is modified. */
+	gtk_text_buffer_get_end_iter (text_buffer, &iter);
+	gtk_text_buffer_insert (text_buffer, &iter, " aab", -1);
+	flush_queue ();
+
+	gtk_source_search_settings_set_search_text (settings, "aab");
+	flush_queue ();
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 3);
+
+	/* Case insensitive, not an extension of the previous search text. */
+	gtk_source_search_settings_set_search_text (settings, "AAB");
+	flush_queue ();
+	occurrences_count = gtk_source_search_context_get_occurrences_count (context);
+	g_assert_cmpint (occurrences_count, ==, 3);
+
+	g_object_unref (source_buffer);
+	g_object_unref (settings);
+	g_object_unref (context);
+}
+
+static void
+test_scan_visible_only (void)
+{
+	GtkSourceBuffer *source_buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (source_buffer);
+	GtkSourceSearchSettings *settings = gtk_source_search_settings_new ();
+	GtkSourceSearchContext *context = gtk_source_search_context_new (source_buffer, settings);
+	GtkTextIter iter;
+	GtkTextIter match_start;
+	GtkTextIter match_end;
+	GString *text = g_string_new (NULL);
+	gboolean found;
+	gint i;
+
+	/* More lines than a counting batch. */
+	for (i = 0; i < 3000; i++)
+	{
+		g_string_append (text, "ab\n");
+	}
+
+	gtk_text_buffer_set_text (text_buffer, text->str, -1);
+	g_string_free (text, TRUE);
+
+	gtk_source_search_context_set_scan_visible_only (context, TRUE);
+	gtk_source_search_settings_set_search_text (settings, "a");
+	flush_queue ();
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 3000);
+	g_assert (!gtk_source_search_context_get_occurrences_count_capped (context));
+
+	/* The occurrences are found even if they are not highlighted. */
+	gtk_text_buffer_get_iter_at_line (text_buffer, &iter, 2500);
+	found = gtk_source_search_context_forward (context, &iter, &match_start, &match_end);
+	g_assert (found);
+	g_assert_cmpint (gtk_text_iter_get_line (&match_start), ==, 2500);
+
+	/* Occurrences crossing the counting batches. */
+	gtk_source_search_settings_set_search_text (settings, "b\na");
+	flush_queue ();
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 2999);
+
+	gtk_source_search_context_set_occurrences_count_limit (context, 10);
+	flush_queue ();
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 10);
+	g_assert (gtk_source_search_context_get_occurrences_count_capped (context));
+
+	gtk_source_search_context_set_occurrences_count_limit (context, 0);
+	flush_queue ();
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, -1);
+
+	gtk_source_search_context_set_scan_visible_only (context, FALSE);
+	flush_queue ();
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 2999);
+
+	g_object_unref (source_buffer);
+	g_object_unref (settings);
+	g_object_unref (context);
+}
+
+/* In scan-visible-only mode, the count is updated for the edited lines only,
+ * without restarting the counting pass.
+ */
+static void
+test_scan_visible_only_edits (void)
+{
+	GtkSourceBuffer *source_buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (source_buffer);
+	GtkSourceSearchSettings *settings = gtk_source_search_settings_new ();
+	GtkSourceSearchContext *context = gtk_source_search_context_new (source_buffer, settings);
+	GtkTextIter start;
+	GtkTextIter end;
+	GString *text = g_string_new (NULL);
+	gint i;
+
+	for (i = 0; i < 3000; i++)
+	{
+		g_string_append (text, "ab\n");
+	}
+
+	gtk_text_buffer_set_text (text_buffer, text->str, -1);
+	g_string_free (text, TRUE);
+
+	gtk_source_search_context_set_scan_visible_only (context, TRUE);
+	gtk_source_search_settings_set_search_text (settings, "a");
+	flush_queue ();
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 3000);
+
+	/* The count is known directly after the edits. */
+	gtk_text_buffer_get_iter_at_line (text_buffer, &start, 100);
+	gtk_text_buffer_insert (text_buffer, &start, "aa", -1);
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 3002);
+
+	gtk_text_buffer_get_iter_at_line (text_buffer, &start, 2000);
+	end = start;
+	gtk_text_iter_forward_lines (&end, 10);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 2992);
+
+	flush_queue ();
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 2992);
+
+	/* An occurrence of a multi-line search text, created by an edit. */
+	gtk_source_search_settings_set_search_text (settings, "b\nc");
+	flush_queue ();
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 0);
+
+	gtk_text_buffer_get_iter_at_line (text_buffer, &start, 500);
+	gtk_text_buffer_insert (text_buffer, &start, "c", -1);
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 1);
+
+	/* Capped count: removing occurrences before the limit continues the
+	 * counting pass.
+	 */
+	gtk_source_search_settings_set_search_text (settings, "a");
+	gtk_source_search_context_set_occurrences_count_limit (context, 10);
+	flush_queue ();
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 10);
+	g_assert (gtk_source_search_context_get_occurrences_count_capped (context));
+
+	gtk_text_buffer_get_start_iter (text_buffer, &start);
+	end = start;
+	gtk_text_iter_forward_lines (&end, 5);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+	flush_queue ();
+	g_assert_cmpint (gtk_source_search_context_get_occurrences_count (context), ==, 10);
+	g_assert (gtk_source_search_context_get_occurrences_count_capped (context));
+
+	g_object_unref (source_buffer);
+	g_object_unref (settings);
+	g_object_unref (context);
+}
+
 static void
 test_get_search_text (void)
 {
@@ -862,6 +1399,15 @@ test_replace (void)
 	g_object_unref (context);
 }
 
+static void
+batch_edit_finished_cb (GtkSourceBuffer *buffer,
+			GtkTextIter     *start,
+			GtkTextIter     *end,
+			gint            *nb_batch_edits)
+{
+	(*nb_batch_edits)++;
+}
+
 static void
 test_replace_all (void)
 {
@@ -870,6 +1416,7 @@ test_replace_all (void)
 	GtkSourceSearchSettings *settings = gtk_source_search_settings_new ();
 	GtkSourceSearchContext *context = gtk_source_search_context_new (source_buffer, settings);
 	gint nb_replacements;
+	gint nb_batch_edits = 0;
 	GtkTextIter start;
 	GtkTextIter end;
 	gchar *contents;
@@ -878,8 +1425,15 @@ test_replace_all (void)
 	gtk_source_search_settings_set_search_text (settings, "aa");
 	flush_queue ();
 
+	g_signal_connect (source_buffer,
+			  "batch-edit-finished",
+			  G_CALLBACK (batch_edit_finished_cb),
+			  &nb_batch_edits);
+
+	/* All the replacements are done in one batch edit. */
 	nb_replacements = gtk_source_search_context_replace_all (context, "bb", 2);
 	g_assert_cmpint (nb_replacements, ==, 2);
+	g_assert_cmpint (nb_batch_edits, ==, 1);
 
 	gtk_text_buffer_get_start_iter (text_buffer, &start);
 	gtk_text_buffer_get_end_iter (text_buffer, &end);
@@ -1005,6 +1559,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/Search/occurrences-count/simple", test_occurrences_count_simple);
 	g_test_add_func ("/Search/occurrences-count/with-insert", test_occurrences_count_with_insert);
 	g_test_add_func ("/Search/occurrences-count/with-delete", test_occurrences_count_with_delete);
+	g_test_add_func ("/Search/occurrences-count/with-batch-edit", test_occurrences_count_with_batch_edit);
 	g_test_add_func ("/Search/occurrences-count/multiple-lines", test_occurrences_count_multiple_lines);
 	g_test_add_func ("/Search/case-sensitivity", test_case_sensitivity);
 	g_test_add_func ("/Search/at-word-boundaries", test_search_at_word_boundaries);
@@ -1014,7 +1569,13 @@ main (int argc, char **argv)
 	g_test_add_func ("/Search/backward", test_backward_search);
 	g_test_add_func ("/Search/backward/subprocess/async-normal", test_async_backward_search_normal);
 	g_test_add_func ("/Search/backward/subprocess/async-wrap-around", test_async_backward_search_wrap_around);
+	g_test_add_func ("/Search/async-multiple-requests", test_async_multiple_requests);
+	g_test_add_func ("/Search/async-priorities", test_async_priorities);
+	g_test_add_func ("/Search/async-search-modified", test_async_search_modified);
 	g_test_add_func ("/Search/highlight", test_highlight);
+	g_test_add_func ("/Search/incremental", test_incremental_search);
+	g_test_add_func ("/Search/scan-visible-only", test_scan_visible_only);
+	g_test_add_func ("/Search/scan-visible-only-edits", test_scan_visible_only_edits);
 	g_test_add_func ("/Search/get-search-text", test_get_search_text);
 	g_test_add_func ("/Search/occurrence-position", test_occurrence_position);
 	g_test_add_func ("/Search/replace", test_replace);
@@ -0,0 +1,406 @@
+/*
+ * test-undo-benchmark.c
+ * This file is part of GtkSourceView
+ *
+ * Copyright (C) 2026 - agent <agent@local>
+ *
+ * GtkSourceView is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GtkSourceView is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <string.h>
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+#include "benchmark-utils.h"
+
+/* Benchmark and stress test of the undo history, to evaluate the changes in
+ * how the actions are stored.
+ *
+ * Each scenario runs in a new buffer:
+ * - typing: a text typed one character at a time, with a typo corrected with
+ *   the backspace key every TYPO_INTERVAL characters;
+ * - backspace: a long word deleted one character at a time with the backspace
+ *   key, the deletions are merged in a single undo step;
+ * - delete-all: a big text deleted at once;
+ * - paste: blocks of PASTE_LINES lines pasted one after the other;
+ * - replace-all: several replace-all on a big buffer, alternating between two
+ *   words.
+ *
+ * Then everything is undone and redone, one step at a time.
+ *
+ * For each scenario, this prints on stdout, as CSV with a header:
+ * - the number of edits, i.e. the insertions and deletions done by the user;
+ * - the number of bytes inserted or deleted, that the history has to store;
+ * - the time per edit, in microseconds;
+ * - the number of undo steps, and the merge rate: the proportion of edits that
+ *   did not create a new undo step. With a maximum number of levels or a
+ *   maximum size, the discarded steps are not counted;
+ * - the increase of the resident set size (Linux only, -1 elsewhere) during
+ *   the edits, per stored byte. It includes the growth of the buffer itself:
+ *   run with --max-undo-levels=0 to get the baseline;
+ * - the time per undo step and per redo step, in microseconds.
+ */
+
+#define TYPO_INTERVAL 50
+#define PASTE_LINES 100
+
+typedef struct
+{
+	const gchar *name;
+
+	/* Does the edits and returns the number of stored bytes. */
+	gsize (*run) (GtkSourceBuffer *buffer,
+		      gint            *nb_edits);
+} Scenario;
+
+static const gchar *paragraph =
+	"Lorem ipsum dolor sit amet, consectetur adipisicing elit, sed do eiusmod "
+	"tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim "
+	"veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea "
+	"commodo consequat.\n";
+
+static gint scale = 1;
+static gint max_undo_levels = -1;
+static gint max_undo_size = -1;
+
+static GOptionEntry entries[] =
+{
+	{ "scale", 0, 0, G_OPTION_ARG_INT, &scale,
+	  "Multiply the size of all the scenarios (default: 1)", "N" },
+	{ "max-undo-levels", 0, 0, G_OPTION_ARG_INT, &max_undo_levels,
+	  "Maximum number of undo levels (default: -1, unlimited)", "N" },
+	{ "max-undo-size", 0, 0, G_OPTION_ARG_INT, &max_undo_size,
+	  "Maximum size of the undo history in bytes (default: -1, unlimited)", "N" },
+	{ NULL }
+};
+
+static void
+type_char (GtkTextBuffer *buffer,
+	   const gchar   *c)
+{
+	gtk_text_buffer_begin_user_action (buffer);
+	gtk_text_buffer_insert_at_cursor (buffer, c, 1);
+	gtk_text_buffer_end_user_action (buffer);
+}
+
+static void
+backspace (GtkTextBuffer *buffer)
+{
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+	gtk_text_buffer_backspace (buffer, &iter, TRUE, TRUE);
+}
+
+static gsize
+run_typing (GtkSourceBuffer *buffer,
+	    gint            *nb_edits)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	gint paragraph_length = strlen (paragraph);
+	gint nb_chars = scale * 100000;
+	gsize stored_bytes = 0;
+	gint i;
+
+	*nb_edits = 0;
+
+	for (i = 0; i < nb_chars; i++)
+	{
+		if (i % TYPO_INTERVAL == TYPO_INTERVAL - 1)
+		{
+			type_char (text_buffer, "x");
+			backspace (text_buffer);
+
+			*nb_edits += 2;
+			stored_bytes += 2;
+		}
+
+		type_char (text_buffer, paragraph + (i % paragraph_length));
+
+		(*nb_edits)++;
+		stored_bytes++;
+	}
+
+	return stored_bytes;
+}
+
+/* The initial contents is not part of the benchmark. */
+static void
+set_initial_text (GtkSourceBuffer *buffer,
+		  const gchar     *pattern,
+		  gint             nb_chars)
+{
+	GString *text = g_string_sized_new (nb_chars);
+	gint pattern_length = strlen (pattern);
+	gint i;
+
+	for (i = 0; i < nb_chars; i++)
+	{
+		g_string_append_c (text, pattern[i % pattern_length]);
+	}
+
+	gtk_source_buffer_begin_not_undoable_action (buffer);
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), text->str, text->len);
+	gtk_source_buffer_end_not_undoable_action (buffer);
+
+	g_string_free (text, TRUE);
+}
+
+static gsize
+run_backspace (GtkSourceBuffer *buffer,
+	       gint            *nb_edits)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	gint nb_chars = scale * 100000;
+	GtkTextIter end;
+	gint i;
+
+	set_initial_text (buffer, "x", nb_chars);
+
+	gtk_text_buffer_get_end_iter (text_buffer, &end);
+	gtk_text_buffer_place_cursor (text_buffer, &end);
+
+	for (i = 0; i < nb_chars; i++)
+	{
+		backspace (text_buffer);
+	}
+
+	*nb_edits = nb_chars;
+	return nb_chars;
+}
+
+static gsize
+run_delete_all (GtkSourceBuffer *buffer,
+		gint            *nb_edits)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	gint nb_chars = scale * 1000000;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	set_initial_text (buffer, paragraph, nb_chars);
+
+	gtk_text_buffer_get_bounds (text_buffer, &start, &end);
+	gtk_text_buffer_begin_user_action (text_buffer);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+	gtk_text_buffer_end_user_action (text_buffer);
+
+	*nb_edits = 1;
+	return nb_chars;
+}
+
+static gsize
+run_paste (GtkSourceBuffer *buffer,
+	   gint            *nb_edits)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	GString *block = g_string_new (NULL);
+	gint nb_pastes = scale * 200;
+	gsize stored_bytes;
+	gint i;
+
+	for (i = 0; i < PASTE_LINES; i++)
+	{
+		g_string_append (block, paragraph);
+	}
+
+	for (i = 0; i < nb_pastes; i++)
+	{
+		gtk_text_buffer_begin_user_action (text_buffer);
+		gtk_text_buffer_insert_at_cursor (text_buffer, block->str, block->len);
+		gtk_text_buffer_end_user_action (text_buffer);
+	}
+
+	*nb_edits = nb_pastes;
+	stored_bytes = (gsize) nb_pastes * block->len;
+
+	g_string_free (block, TRUE);
+	return stored_bytes;
+}
+
+static gsize
+run_replace_all (GtkSourceBuffer *buffer,
+		 gint            *nb_edits)
+{
+	static const gchar *words[] = { "needle", "pin" };
+	GtkSourceSearchSettings *settings;
+	GtkSourceSearchContext *context;
+	GString *text = g_string_new (NULL);
+	gint nb_lines = scale * 10000;
+	gsize stored_bytes = 0;
+	gint i;
+
+	for (i = 0; i < nb_lines; i++)
+	{
+		g_string_append (text, "A needle in a line of text, and another needle.\n");
+	}
+
+	/* The initial contents is not part of the benchmark. */
+	gtk_source_buffer_begin_not_undoable_action (buffer);
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), text->str, text->len);
+	gtk_source_buffer_end_not_undoable_action (buffer);
+	g_string_free (text, TRUE);
+
+	settings = gtk_source_search_settings_new ();
+	gtk_source_search_settings_set_case_sensitive (settings, TRUE);
+	context = gtk_source_search_context_new (buffer, settings);
+	gtk_source_search_context_set_highlight (context, FALSE);
+
+	*nb_edits = 0;
+
+	for (i = 0; i < 10; i++)
+	{
+		const gchar *search_text = words[i % 2];
+		const gchar *replace = words[(i + 1) % 2];
+		gint nb_replaced;
+
+		gtk_source_search_settings_set_search_text (settings, search_text);
+		nb_replaced = gtk_source_search_context_replace_all (context, replace, -1);
+
+		/* A deletion and an insertion per occurrence. */
+		*nb_edits += 2 * nb_replaced;
+		stored_bytes += nb_replaced * (strlen (search_text) + strlen (replace));
+	}
+
+	g_object_unref (context);
+	g_object_unref (settings);
+
+	return stored_bytes;
+}
+
+static const Scenario scenarios[] =
+{
+	{ "typing", run_typing },
+	{ "backspace", run_backspace },
+	{ "delete-all", run_delete_all },
+	{ "paste", run_paste },
+	{ "replace-all", run_replace_all }
+};
+
+static void
+run_scenario (const Scenario *scenario)
+{
+	GtkSourceBuffer *buffer = gtk_source_buffer_new (NULL);
+	GTimer *timer;
+	gdouble edit_time;
+	gdouble undo_time;
+	gdouble redo_time;
+	glong memory_before;
+	glong memory_after;
+	gdouble memory_per_byte = -1.0;
+	gsize stored_bytes;
+	gint nb_edits;
+	gint nb_undo_steps = 0;
+	gint nb_redo_steps = 0;
+	gdouble merge_rate = 0.0;
+
+	gtk_source_buffer_set_max_undo_levels (buffer, max_undo_levels);
+	gtk_source_buffer_set_max_undo_size (buffer, max_undo_size);
+
+	memory_before = benchmark_get_resident_memory ();
+	timer = g_timer_new ();
+
+	stored_bytes = scenario->run (buffer, &nb_edits);
+
+	edit_time = g_timer_elapsed (timer, NULL);
+	memory_after = benchmark_get_resident_memory ();
+
+	if (memory_before != -1 && memory_after != -1 && stored_bytes > 0)
+	{
+		memory_per_byte = (memory_after - memory_before) * 1024.0 / stored_bytes;
+	}
+
+	g_timer_start (timer);
+
+	while (gtk_source_buffer_can_undo (buffer))
+	{
+		gtk_source_buffer_undo (buffer);
+		nb_undo_steps++;
+	}
+
+	undo_time = g_timer_elapsed (timer, NULL);
+	g_timer_start (timer);
+
+	while (gtk_source_buffer_can_redo (buffer))
+	{
+		gtk_source_buffer_redo (buffer);
+		nb_redo_steps++;
+	}
+
+	redo_time = g_timer_elapsed (timer, NULL);
+
+	if (nb_undo_steps != nb_redo_steps)
+	{
+		g_printerr ("%s: %d undo steps but %d redo steps.\n",
+			    scenario->name,
+			    nb_undo_steps,
+			    nb_redo_steps);
+	}
+
+	if (nb_edits > 0)
+	{
+		merge_rate = 1.0 - (gdouble) nb_undo_steps / nb_edits;
+	}
+
+	g_print ("%s,%d,%" G_GSIZE_FORMAT ",%.3lf,%d,%.3lf,%.2lf,%.3lf,%.3lf\n",
+		 scenario->name,
+		 nb_edits,
+		 stored_bytes,
+		 nb_edits > 0 ? edit_time * 1e6 / nb_edits : 0.0,
+		 nb_undo_steps,
+		 merge_rate,
+		 memory_per_byte,
+		 nb_undo_steps > 0 ? undo_time * 1e6 / nb_undo_steps : 0.0,
+		 nb_redo_steps > 0 ? redo_time * 1e6 / nb_redo_steps : 0.0);
+
+	g_timer_destroy (timer);
+	g_object_unref (buffer);
+}
+
+int
+main (int argc, char *argv[])
+{
+	GOptionContext *option_context;
+	GError *error = NULL;
+	guint i;
+
+	option_context = g_option_context_new ("- benchmark of the undo history");
+	g_option_context_add_main_entries (option_context, entries, NULL);
+	g_option_context_add_group (option_context, gtk_get_option_group (TRUE));
+
+	if (!g_option_context_parse (option_context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return EXIT_FAILURE;
+	}
+
+	g_option_context_free (option_context);
+
+	if (scale < 1)
+	{
+		g_printerr ("Invalid scale.\n");
+		return EXIT_FAILURE;
+	}
+
+	g_print ("scenario,nb_edits,stored_bytes,us_per_edit,undo_steps,merge_rate,"
+		 "memory_per_stored_byte,us_per_undo,us_per_redo\n");
+
+	for (i = 0; i < G_N_ELEMENTS (scenarios); i++)
+	{
+		run_scenario (&scenarios[i]);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -19,6 +19,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <string.h>
 #include <gtk/gtk.h>
 #include <gtksourceview/gtksource.h>
 
@@ -73,6 +74,15 @@ get_contents (GtkSourceBuffer *buffer)
 	return gtk_text_buffer_get_text (GTK_TEXT_BUFFER (buffer), &start, &end, TRUE);
 }
 
+static void
+set_contents_not_undoable (GtkSourceBuffer *buffer,
+			   const gchar     *contents)
+{
+	gtk_source_buffer_begin_not_undoable_action (buffer);
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), contents, -1);
+	gtk_source_buffer_end_not_undoable_action (buffer);
+}
+
 static void
 check_max_undo_levels (GtkSourceBuffer *buffer)
 {
@@ -223,6 +233,97 @@ test_max_undo_levels (void)
 	g_object_unref (buffer);
 }
 
+static void
+test_max_undo_size (void)
+{
+	GtkSourceBuffer *buffer = gtk_source_buffer_new (NULL);
+	GList *contents_history = NULL;
+	GFileIOStream *stream;
+	GFile *file;
+	GError *error = NULL;
+	gboolean ok;
+	gchar *text;
+	gint i;
+
+	gtk_source_buffer_set_max_undo_levels (buffer, -1);
+	gtk_source_buffer_set_max_undo_size (buffer, 100);
+
+	text = g_strnfill (60, 'a');
+	insert_text (buffer, text);
+	g_free (text);
+
+	text = g_strnfill (60, 'b');
+	insert_text (buffer, text);
+	g_free (text);
+
+	/* The first insertion has been discarded. */
+	g_assert (gtk_source_buffer_can_undo (buffer));
+	gtk_source_buffer_undo (buffer);
+	g_assert (!gtk_source_buffer_can_undo (buffer));
+	gtk_source_buffer_redo (buffer);
+
+	/* The most recent group is kept, even if it is too big. */
+	text = g_strnfill (200, 'c');
+	insert_text (buffer, text);
+	g_free (text);
+
+	g_assert (gtk_source_buffer_can_undo (buffer));
+	gtk_source_buffer_undo (buffer);
+	g_assert (!gtk_source_buffer_can_undo (buffer));
+
+	/* Enough text for the old actions to be compressed. */
+	gtk_source_buffer_begin_not_undoable_action (buffer);
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), "", -1);
+	gtk_source_buffer_end_not_undoable_action (buffer);
+
+	gtk_source_buffer_set_max_undo_size (buffer, G_MAXINT);
+	contents_history = g_list_append (contents_history, get_contents (buffer));
+
+	for (i = 0; i < 30; i++)
+	{
+		text = g_strnfill (24 * 1024, 'a' + i % 26);
+		insert_text (buffer, text);
+		g_free (text);
+
+		contents_history = g_list_append (contents_history, get_contents (buffer));
+	}
+
+	check_contents_history (buffer, contents_history);
+
+	/* The decompressed actions are compressed again. */
+	insert_text (buffer, "end");
+	contents_history = g_list_append (contents_history, get_contents (buffer));
+	check_contents_history (buffer, contents_history);
+
+	/* Save and load a history with compressed actions. */
+	file = g_file_new_tmp ("test-undo-manager-XXXXXX", &stream, &error);
+	g_assert_no_error (error);
+	g_object_unref (stream);
+
+	ok = gtk_source_buffer_save_undo_history (buffer, file, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	text = get_contents (buffer);
+	g_object_unref (buffer);
+
+	buffer = gtk_source_buffer_new (NULL);
+	gtk_source_buffer_set_max_undo_levels (buffer, -1);
+	set_contents_not_undoable (buffer, text);
+	g_free (text);
+
+	ok = gtk_source_buffer_load_undo_history (buffer, file, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	check_contents_history (buffer, contents_history);
+
+	g_file_delete (file, NULL, NULL);
+	g_object_unref (file);
+	g_list_free_full (contents_history, g_free);
+	g_object_unref (buffer);
+}
+
 static void
 test_not_undoable_action (void)
 {
@@ -484,6 +585,407 @@ test_merge_actions (void)
 	g_object_unref (buffer);
 }
 
+/* Type a lot of words one character at a time, with a few undo levels, so the
+ * text of the freed actions must be reclaimed.
+ */
+static void
+test_long_typing (void)
+{
+	GtkSourceBuffer *buffer = gtk_source_buffer_new (NULL);
+	GList *contents_history = NULL;
+	gint max_levels = 5;
+	gint nb_words = 2000;
+	gint i;
+
+	gtk_source_buffer_set_max_undo_levels (buffer, max_levels);
+
+	for (i = 0; i < nb_words; i++)
+	{
+		gchar *word = g_strdup_printf ("word%d ", i);
+		gchar *p;
+
+		if (i == nb_words - max_levels)
+		{
+			contents_history = g_list_append (contents_history,
+							  get_contents (buffer));
+		}
+
+		for (p = word; *p != '\0'; p++)
+		{
+			gchar str[2] = { *p, '\0' };
+			insert_text (buffer, str);
+		}
+
+		if (i >= nb_words - max_levels)
+		{
+			contents_history = g_list_append (contents_history,
+							  get_contents (buffer));
+		}
+
+		g_free (word);
+	}
+
+	check_contents_history (buffer, contents_history);
+
+	/* Backspace: the text of the action is prepended. The oldest level is
+	 * lost.
+	 */
+	for (i = 0; i < 5; i++)
+	{
+		gint offset = gtk_text_buffer_get_char_count (GTK_TEXT_BUFFER (buffer)) - 2;
+		delete_char_at_offset (buffer, offset);
+	}
+
+	g_free (contents_history->data);
+	contents_history = g_list_delete_link (contents_history, contents_history);
+	contents_history = g_list_append (contents_history, get_contents (buffer));
+
+	check_contents_history (buffer, contents_history);
+
+	g_list_free_full (contents_history, g_free);
+	g_object_unref (buffer);
+}
+
+typedef struct
+{
+	gint nb_inserts;
+	gint nb_deletes;
+	gint nb_batch_edits;
+} SignalCounts;
+
+static void
+insert_text_cb (GtkTextBuffer *buffer,
+		GtkTextIter   *location,
+		gchar         *text,
+		gint           length,
+		SignalCounts  *counts)
+{
+	counts->nb_inserts++;
+}
+
+static void
+delete_range_cb (GtkTextBuffer *buffer,
+		 GtkTextIter   *start,
+		 GtkTextIter   *end,
+		 SignalCounts  *counts)
+{
+	counts->nb_deletes++;
+}
+
+static void
+batch_edit_finished_cb (GtkSourceBuffer *buffer,
+			GtkTextIter     *start,
+			GtkTextIter     *end,
+			SignalCounts    *counts)
+{
+	counts->nb_batch_edits++;
+}
+
+static void
+delete_offsets (GtkTextBuffer *buffer,
+		gint           start_offset,
+		gint           end_offset)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, start_offset);
+	gtk_text_buffer_get_iter_at_offset (buffer, &end, end_offset);
+	gtk_text_buffer_delete (buffer, &start, &end);
+}
+
+/* Undoes and redoes the last group, and checks the number of insertions and
+ * deletions done on the buffer when undoing. Redoing does the opposite ones.
+ * The group is applied in one batch edit.
+ */
+static void
+check_group_edits (GtkSourceBuffer *buffer,
+		   SignalCounts    *counts,
+		   const gchar     *contents_before,
+		   const gchar     *contents_after,
+		   gint             nb_inserts,
+		   gint             nb_deletes)
+{
+	gchar *contents;
+
+	contents = get_contents (buffer);
+	g_assert_cmpstr (contents, ==, contents_after);
+	g_free (contents);
+
+	counts->nb_inserts = 0;
+	counts->nb_deletes = 0;
+	counts->nb_batch_edits = 0;
+	gtk_source_buffer_undo (buffer);
+	g_assert_cmpint (counts->nb_inserts, ==, nb_inserts);
+	g_assert_cmpint (counts->nb_deletes, ==, nb_deletes);
+	g_assert_cmpint (counts->nb_batch_edits, ==, 1);
+
+	contents = get_contents (buffer);
+	g_assert_cmpstr (contents, ==, contents_before);
+	g_free (contents);
+
+	counts->nb_inserts = 0;
+	counts->nb_deletes = 0;
+	counts->nb_batch_edits = 0;
+	gtk_source_buffer_redo (buffer);
+	g_assert_cmpint (counts->nb_inserts, ==, nb_deletes);
+	g_assert_cmpint (counts->nb_deletes, ==, nb_inserts);
+	g_assert_cmpint (counts->nb_batch_edits, ==, 1);
+
+	contents = get_contents (buffer);
+	g_assert_cmpstr (contents, ==, contents_after);
+	g_free (contents);
+}
+
+static void
+test_group_merged_edits (void)
+{
+	GtkSourceBuffer *buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	SignalCounts counts = { 0 };
+	GtkTextIter iter;
+
+	gtk_source_buffer_set_max_undo_levels (buffer, -1);
+
+	g_signal_connect (buffer, "insert-text", G_CALLBACK (insert_text_cb), &counts);
+	g_signal_connect (buffer, "delete-range", G_CALLBACK (delete_range_cb), &counts);
+	g_signal_connect (buffer, "batch-edit-finished", G_CALLBACK (batch_edit_finished_cb), &counts);
+
+	/* Contiguous insertions */
+	gtk_text_buffer_begin_user_action (text_buffer);
+	gtk_text_buffer_insert_at_cursor (text_buffer, "hello ", -1);
+	gtk_text_buffer_insert_at_cursor (text_buffer, "world\n", -1);
+	gtk_text_buffer_insert_at_cursor (text_buffer, "foo\n", -1);
+	gtk_text_buffer_end_user_action (text_buffer);
+
+	check_group_edits (buffer, &counts, "", "hello world\nfoo\n", 0, 1);
+
+	/* Contiguous deletions, with the delete key */
+	gtk_text_buffer_begin_user_action (text_buffer);
+	delete_offsets (text_buffer, 6, 9);
+	delete_offsets (text_buffer, 6, 8);
+	gtk_text_buffer_end_user_action (text_buffer);
+
+	check_group_edits (buffer, &counts, "hello world\nfoo\n", "hello \nfoo\n", 1, 0);
+
+	/* Contiguous deletions, with the backspace key */
+	gtk_text_buffer_begin_user_action (text_buffer);
+	delete_offsets (text_buffer, 3, 5);
+	delete_offsets (text_buffer, 1, 3);
+	gtk_text_buffer_end_user_action (text_buffer);
+
+	check_group_edits (buffer, &counts, "hello \nfoo\n", "h \nfoo\n", 1, 0);
+
+	/* Non-contiguous replacements, like a replace all */
+	gtk_text_buffer_begin_user_action (text_buffer);
+	delete_offsets (text_buffer, 0, 1);
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &iter, 0);
+	gtk_text_buffer_insert (text_buffer, &iter, "H", -1);
+	delete_offsets (text_buffer, 3, 4);
+	gtk_text_buffer_get_iter_at_offset (text_buffer, &iter, 3);
+	gtk_text_buffer_insert (text_buffer, &iter, "F", -1);
+	gtk_text_buffer_end_user_action (text_buffer);
+
+	check_group_edits (buffer, &counts, "h \nfoo\n", "H \nFoo\n", 2, 2);
+
+	g_object_unref (buffer);
+}
+
+static void
+test_big_deletion (void)
+{
+	GtkSourceBuffer *buffer = gtk_source_buffer_new (NULL);
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (buffer);
+	GtkTextIter start;
+	GtkTextIter end;
+	GString *text = g_string_new (NULL);
+	gchar *contents;
+	gint i;
+
+	gtk_source_buffer_set_max_undo_levels (buffer, -1);
+
+	/* More than one chunk, with non-ASCII characters at the chunk
+	 * boundaries.
+	 */
+	for (i = 0; i < 50000; i++)
+	{
+		g_string_append (text, "\303\251t\303\251\n");
+	}
+
+	insert_text (buffer, "a");
+	insert_text (buffer, text->str);
+	insert_text (buffer, "b");
+
+	gtk_text_buffer_get_bounds (text_buffer, &start, &end);
+	gtk_text_iter_forward_char (&start);
+	gtk_text_iter_backward_char (&end);
+
+	gtk_text_buffer_begin_user_action (text_buffer);
+	gtk_text_buffer_delete (text_buffer, &start, &end);
+	gtk_text_buffer_end_user_action (text_buffer);
+
+	contents = get_contents (buffer);
+	g_assert_cmpstr (contents, ==, "ab");
+	g_free (contents);
+
+	gtk_source_buffer_undo (buffer);
+	contents = get_contents (buffer);
+	g_assert (g_str_has_prefix (contents, "a"));
+	g_assert (g_str_has_suffix (contents, "b"));
+	g_assert_cmpint (strlen (contents), ==, text->len + 2);
+	g_assert (strncmp (contents + 1, text->str, text->len) == 0);
+	g_free (contents);
+
+	gtk_source_buffer_redo (buffer);
+	contents = get_contents (buffer);
+	g_assert_cmpstr (contents, ==, "ab");
+	g_free (contents);
+
+	g_string_free (text, TRUE);
+	g_object_unref (buffer);
+}
+
+static void
+test_persistent_history (void)
+{
+	GtkSourceBuffer *buffer = gtk_source_buffer_new (NULL);
+	GList *contents_history = g_list_append (NULL, get_contents (buffer));
+	GFileIOStream *stream;
+	GFile *file;
+	gchar *contents;
+	GError *error = NULL;
+	gboolean ok;
+
+	gtk_source_buffer_set_max_undo_levels (buffer, -1);
+
+	insert_text (buffer, "hello\n");
+	contents_history = g_list_append (contents_history, get_contents (buffer));
+
+	insert_text (buffer, "world\n");
+	contents_history = g_list_append (contents_history, get_contents (buffer));
+
+	delete_first_line (buffer);
+	contents_history = g_list_append (contents_history, get_contents (buffer));
+
+	/* With a redo action. */
+	gtk_source_buffer_undo (buffer);
+
+	file = g_file_new_tmp ("test-undo-manager-XXXXXX", &stream, &error);
+	g_assert_no_error (error);
+	g_object_unref (stream);
+
+	ok = gtk_source_buffer_save_undo_history (buffer, file, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	contents = get_contents (buffer);
+	g_object_unref (buffer);
+
+	/* Same contents */
+	buffer = gtk_source_buffer_new (NULL);
+	set_contents_not_undoable (buffer, contents);
+
+	ok = gtk_source_buffer_load_undo_history (buffer, file, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+	g_assert (gtk_source_buffer_can_undo (buffer));
+	g_assert (gtk_source_buffer_can_redo (buffer));
+
+	check_contents_history (buffer, contents_history);
+	g_object_unref (buffer);
+
+	/* Different contents: the history is discarded when needed. */
+	buffer = gtk_source_buffer_new (NULL);
+	set_contents_not_undoable (buffer, "other contents");
+
+	ok = gtk_source_buffer_load_undo_history (buffer, file, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+	g_assert (gtk_source_buffer_can_undo (buffer));
+
+	gtk_source_buffer_undo (buffer);
+	g_assert (!gtk_source_buffer_can_undo (buffer));
+	g_assert (!gtk_source_buffer_can_redo (buffer));
+	g_free (contents);
+	contents = get_contents (buffer);
+	g_assert_cmpstr (contents, ==, "other contents");
+
+	g_file_delete (file, NULL, NULL);
+	g_object_unref (file);
+	g_free (contents);
+	g_list_free_full (contents_history, g_free);
+	g_object_unref (buffer);
+}
+
+static void
+test_persistent_history_corrupted (void)
+{
+	GtkSourceBuffer *buffer = gtk_source_buffer_new (NULL);
+	GFileIOStream *stream;
+	GFile *file;
+	gchar *file_contents;
+	gsize length;
+	gchar *contents;
+	GError *error = NULL;
+	gboolean ok;
+
+	gtk_source_buffer_set_max_undo_levels (buffer, -1);
+
+	insert_text (buffer, "hello\n");
+	insert_text (buffer, "world\n");
+
+	file = g_file_new_tmp ("test-undo-manager-XXXXXX", &stream, &error);
+	g_assert_no_error (error);
+	g_object_unref (stream);
+
+	ok = gtk_source_buffer_save_undo_history (buffer, file, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	/* Change the last byte of the compressed payload, which is part of
+	 * its checksum.
+	 */
+	ok = g_file_load_contents (file, NULL, &file_contents, &length, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+
+	file_contents[length - 1] ^= 0xff;
+
+	ok = g_file_replace_contents (file, file_contents, length, NULL, FALSE,
+				      G_FILE_CREATE_NONE, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+	g_free (file_contents);
+
+	contents = get_contents (buffer);
+	g_object_unref (buffer);
+
+	buffer = gtk_source_buffer_new (NULL);
+	set_contents_not_undoable (buffer, contents);
+
+	ok = gtk_source_buffer_load_undo_history (buffer, file, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ok);
+	g_assert (gtk_source_buffer_can_undo (buffer));
+
+	/* The history is discarded when it is read. */
+	g_test_expect_message ("GtkSourceView", G_LOG_LEVEL_WARNING,
+			       "Error when loading the undo history:*");
+	gtk_source_buffer_undo (buffer);
+	g_test_assert_expected_messages ();
+
+	g_assert (!gtk_source_buffer_can_undo (buffer));
+	g_assert (!gtk_source_buffer_can_redo (buffer));
+	g_free (contents);
+	contents = get_contents (buffer);
+	g_assert_cmpstr (contents, ==, "hello\nworld\n");
+
+	g_file_delete (file, NULL, NULL);
+	g_object_unref (file);
+	g_free (contents);
+	g_object_unref (buffer);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -501,6 +1003,21 @@ main (int argc, char **argv)
 	g_test_add_func ("/UndoManager/test-max-undo-levels",
 			 test_max_undo_levels);
 
+	g_test_add_func ("/UndoManager/test-max-undo-size",
+			 test_max_undo_size);
+
+	g_test_add_func ("/UndoManager/test-group-merged-edits",
+			 test_group_merged_edits);
+
+	g_test_add_func ("/UndoManager/test-big-deletion",
+			 test_big_deletion);
+
+	g_test_add_func ("/UndoManager/test-persistent-history",
+			 test_persistent_history);
+
+	g_test_add_func ("/UndoManager/test-persistent-history-corrupted",
+			 test_persistent_history_corrupted);
+
 	g_test_add_func ("/UndoManager/test-not-undoable-action",
 			 test_not_undoable_action);
 
@@ -510,5 +1027,8 @@ main (int argc, char **argv)
 	g_test_add_func ("/UndoManager/test-merge-actions",
 			 test_merge_actions);
 
+	g_test_add_func ("/UndoManager/test-long-typing",
+			 test_long_typing);
+
 	return g_test_run ();
 }